@@ -57,6 +57,7 @@
 
 #include <wiretap/wtap.h>
 
+#include <wsutil/clopts_common.h>
 #include <wsutil/cmdarg_err.h>
 #include <wsutil/filesystem.h>
 #include <wsutil/privileges.h>
@@ -91,6 +92,18 @@
 
 static gboolean stop_after_failure = FALSE;
 
+/*
+ * Number of worker threads used to read input files. Files are still
+ * reported in command line order.
+ */
+static guint num_threads = 1;
+
+/*
+ * Use per-interface statistics recorded at the end of the file, when
+ * present, instead of reading every record.
+ */
+static gboolean fast_mode = FALSE;
+
 /*
  * table report variables
  */
@@ -147,16 +160,8 @@ static gboolean cap_file_hashes    = TRUE;  /* Calculate file hashes */
 #define HASH_STR_SIZE (65) /* Max hash size * 2 + '\0' */
 #define HASH_BUF_SIZE (1024 * 1024)
 
-
-static gchar file_sha256[HASH_STR_SIZE];
-static gchar file_sha1[HASH_STR_SIZE];
-
-static char  *hash_buf = NULL;
-static gcry_md_hd_t hd = NULL;
-
-static guint num_ipv4_addresses;
-static guint num_ipv6_addresses;
-static guint num_decryption_secrets;
+/* Number of records to read at a time when scanning a file */
+#define SCAN_BATCH_SIZE 256
 
 /*
  * If we have at least two packets with time stamps, and they're not in
@@ -180,6 +185,13 @@ typedef struct _pkt_cmt {
   struct _pkt_cmt *next;
 } pkt_cmt;
 
+typedef enum {
+    SCAN_OK,
+    SCAN_OPEN_FAILED,
+    SCAN_READ_FAILED,
+    SCAN_SIZE_FAILED
+} scan_failure_t;
+
 typedef struct _capture_info {
     const char           *filename;
     guint16               file_type;
@@ -217,8 +229,42 @@ typedef struct _capture_info {
     GArray               *interface_packet_counts;  /* array of per_packet interface_id counts; one entry per file IDB */
     guint32               pkt_interface_id_unknown; /* counts if packet interface_id didn't match a known one */
     GArray               *idb_info_strings;         /* array of IDB info strings */
+
+    gboolean              data_size_known;          /* FALSE if counts came from interface statistics */
+    gchar                 file_sha256[HASH_STR_SIZE];
+    gchar                 file_sha1[HASH_STR_SIZE];
+    guint                 num_ipv4_addresses;
+    guint                 num_ipv6_addresses;
+    guint                 num_decryption_secrets;
+
+    /* Results of scanning the file, reported in command line order */
+    gboolean              scanned;                  /* TRUE once scan_cap_file() is done */
+    int                   status;                   /* 0 = OK, 1 = short read, 2 = failure */
+    scan_failure_t        failure;
+    int                   err;
+    gchar                *err_info;
 } capture_info;
 
+/*
+ * The file being scanned by the current thread, for the wiretap
+ * callbacks, which don't take a user data pointer.
+ */
+static WS_THREAD_LOCAL capture_info *cur_cf_info;
+
+/* Completion signalling between the scanning threads and the reporter. */
+typedef struct _scan_pool_t {
+    GMutex        mutex;
+    GCond         cond;
+} scan_pool_t;
+
+/* Incremental file hashing, done in step with reading the records. */
+typedef struct _hash_state {
+    FILE         *fh;
+    gcry_md_hd_t  hd;
+    char         *buf;
+    gint64        pos;      /* Offset of the data not yet hashed */
+} hash_state;
+
 static char *decimal_point;
 
 static void
@@ -541,7 +587,9 @@ print_stats(const gchar *filename, capture_info *cf_info)
     }
     if (cap_data_size) {
         printf     ("Data size:           ");
-        if (machine_readable) {
+        if (!cf_info->data_size_known) {
+            printf     ("(unknown)\n");
+        } else if (machine_readable) {
             printf     ("%" PRIu64 " bytes\n", cf_info->packet_bytes);
         } else {
             size_string = format_size(cf_info->packet_bytes, FORMAT_SIZE_UNIT_BYTES, 0);
@@ -558,7 +606,9 @@ print_stats(const gchar *filename, capture_info *cf_info)
             printf("Last packet time:    %s\n", absolute_time_string(&cf_info->stop_time, cf_info->stop_time_tsprec, cf_info));
         if (cap_data_rate_byte) {
             printf("Data byte rate:      ");
-            if (machine_readable) {
+            if (!cf_info->data_size_known) {
+                printf("(unknown)\n");
+            } else if (machine_readable) {
                 print_value("", 2, " bytes/sec",   cf_info->data_rate);
             } else {
                 size_string = format_size((int64_t)cf_info->data_rate, FORMAT_SIZE_UNIT_BYTES_S, 0);
@@ -568,7 +618,9 @@ print_stats(const gchar *filename, capture_info *cf_info)
         }
         if (cap_data_rate_bit) {
             printf("Data bit rate:       ");
-            if (machine_readable) {
+            if (!cf_info->data_size_known) {
+                printf("(unknown)\n");
+            } else if (machine_readable) {
                 print_value("", 2, " bits/sec",    cf_info->data_rate*8);
             } else {
                 size_string = format_size((int64_t)(cf_info->data_rate*8), FORMAT_SIZE_UNIT_BITS_S, 0);
@@ -577,7 +629,12 @@ print_stats(const gchar *filename, capture_info *cf_info)
             }
         }
     }
-    if (cap_packet_size)    printf("Average packet size: %.2f bytes\n",        cf_info->packet_size);
+    if (cap_packet_size) {
+        if (cf_info->data_size_known)
+            printf("Average packet size: %.2f bytes\n",        cf_info->packet_size);
+        else
+            printf("Average packet size: (unknown)\n");
+    }
     if (cf_info->times_known) {
         if (cap_packet_rate) {
             printf("Average packet rate: ");
@@ -591,8 +648,8 @@ print_stats(const gchar *filename, capture_info *cf_info)
         }
     }
     if (cap_file_hashes) {
-        printf     ("SHA256:              %s\n", file_sha256);
-        printf     ("SHA1:                %s\n", file_sha1);
+        printf     ("SHA256:              %s\n", cf_info->file_sha256);
+        printf     ("SHA1:                %s\n", cf_info->file_sha1);
     }
     if (cap_order)          printf     ("Strict time order:   %s\n", order_string(cf_info->order));
 
@@ -637,6 +694,7 @@ print_stats(const gchar *filename, capture_info *cf_info)
                 }
                 g_free(p->cmt);
               }
+              cf_info->pkt_cmts = NULL;
             }
 
             if (cap_file_idb && cf_info->num_interfaces != 0) {
@@ -656,14 +714,14 @@ print_stats(const gchar *filename, capture_info *cf_info)
         }
 
         if (cap_file_nrb) {
-            if (num_ipv4_addresses != 0)
-                printf   ("Number of resolved IPv4 addresses in file: %u\n", num_ipv4_addresses);
-            if (num_ipv6_addresses != 0)
-                printf   ("Number of resolved IPv6 addresses in file: %u\n", num_ipv6_addresses);
+            if (cf_info->num_ipv4_addresses != 0)
+                printf   ("Number of resolved IPv4 addresses in file: %u\n", cf_info->num_ipv4_addresses);
+            if (cf_info->num_ipv6_addresses != 0)
+                printf   ("Number of resolved IPv6 addresses in file: %u\n", cf_info->num_ipv6_addresses);
         }
         if (cap_file_dsb) {
-            if (num_decryption_secrets != 0)
-                printf   ("Number of decryption secrets in file: %u\n", num_decryption_secrets);
+            if (cf_info->num_decryption_secrets != 0)
+                printf   ("Number of decryption secrets in file: %u\n", cf_info->num_decryption_secrets);
         }
     }
 }
@@ -831,7 +889,10 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
     if (cap_data_size) {
         putsep();
         putquote();
-        printf("%" PRIu64, cf_info->packet_bytes);
+        if (cf_info->data_size_known)
+            printf("%" PRIu64, cf_info->packet_bytes);
+        else
+            printf("n/a");
         putquote();
     }
 
@@ -859,7 +920,7 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
     if (cap_data_rate_byte) {
         putsep();
         putquote();
-        if (cf_info->times_known)
+        if (cf_info->times_known && cf_info->data_size_known)
             printf("%.2f", cf_info->data_rate);
         else
             printf("n/a");
@@ -869,7 +930,7 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
     if (cap_data_rate_bit) {
         putsep();
         putquote();
-        if (cf_info->times_known)
+        if (cf_info->times_known && cf_info->data_size_known)
             printf("%.2f", cf_info->data_rate*8);
         else
             printf("n/a");
@@ -879,7 +940,10 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
     if (cap_packet_size) {
         putsep();
         putquote();
-        printf("%.2f", cf_info->packet_size);
+        if (cf_info->data_size_known)
+            printf("%.2f", cf_info->packet_size);
+        else
+            printf("n/a");
         putquote();
     }
 
@@ -896,12 +960,12 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
     if (cap_file_hashes) {
         putsep();
         putquote();
-        printf("%s", file_sha256);
+        printf("%s", cf_info->file_sha256);
         putquote();
 
         putsep();
         putquote();
-        printf("%s", file_sha1);
+        printf("%s", cf_info->file_sha1);
         putquote();
     }
 
@@ -994,6 +1058,7 @@ print_stats_table(const gchar *filename, capture_info *cf_info)
         g_free(p->cmt);
         putquote();
       }
+      cf_info->pkt_cmts = NULL;
     }
 
     printf("\n");
@@ -1008,7 +1073,8 @@ cleanup_capture_info(capture_info *cf_info)
     g_free(cf_info->encap_counts);
     cf_info->encap_counts = NULL;
 
-    g_array_free(cf_info->interface_packet_counts, TRUE);
+    if (cf_info->interface_packet_counts)
+        g_array_free(cf_info->interface_packet_counts, TRUE);
     cf_info->interface_packet_counts = NULL;
 
     if (cf_info->idb_info_strings) {
@@ -1019,18 +1085,34 @@ cleanup_capture_info(capture_info *cf_info)
         g_array_free(cf_info->idb_info_strings, TRUE);
     }
     cf_info->idb_info_strings = NULL;
+
+    /* Packet comments are normally freed as they're printed. */
+    while (cf_info->pkt_cmts != NULL) {
+        pkt_cmt *p = cf_info->pkt_cmts;
+        cf_info->pkt_cmts = p->next;
+        g_free(p->cmt);
+        g_free(p);
+    }
+
+    g_free(cf_info->err_info);
+    cf_info->err_info = NULL;
+
+    if (cf_info->wth) {
+        wtap_close(cf_info->wth);
+        cf_info->wth = NULL;
+    }
 }
 
 static void
 count_ipv4_address(const guint addr _U_, const gchar *name _U_, const gboolean static_entry _U_)
 {
-    num_ipv4_addresses++;
+    cur_cf_info->num_ipv4_addresses++;
 }
 
 static void
 count_ipv6_address(const void *addrp _U_, const gchar *name _U_, const gboolean static_entry _U_)
 {
-    num_ipv6_addresses++;
+    cur_cf_info->num_ipv6_addresses++;
 }
 
 static void
@@ -1038,7 +1120,7 @@ count_decryption_secret(guint32 secrets_type _U_, const void *secrets _U_, guint
 {
     /* XXX - count them based on the secrets type (which is an opaque code,
        not a small integer)? */
-    num_decryption_secrets++;
+    cur_cf_info->num_decryption_secrets++;
 }
 
 static void
@@ -1051,46 +1133,196 @@ hash_to_str(const unsigned char *hash, size_t length, char *str)
     }
 }
 
+/*
+ * The hashes are calculated from the raw file contents while the
+ * records are read, so that each file only has to be read from disk
+ * once; the hash reader trails the wiretap reader and finds the data
+ * in the page cache.
+ */
+static void
+hash_init(hash_state *hs, const char *filename)
+{
+    hs->fh = NULL;
+    hs->hd = NULL;
+    hs->buf = NULL;
+    hs->pos = 0;
+
+    if (!cap_file_hashes)
+        return;
+
+    gcry_md_open(&hs->hd, GCRY_MD_SHA256, 0);
+    if (!hs->hd)
+        return;
+    gcry_md_enable(hs->hd, GCRY_MD_SHA1);
+
+    hs->fh = ws_fopen(filename, "rb");
+    if (!hs->fh) {
+        gcry_md_close(hs->hd);
+        hs->hd = NULL;
+        return;
+    }
+    hs->buf = (char *)g_malloc(HASH_BUF_SIZE);
+}
+
+/* Hash file data up to (roughly) offset, or to the end if offset is -1. */
 static void
-calculate_hashes(const char *filename)
+hash_update(hash_state *hs, gint64 offset)
 {
-    FILE  *fh;
     size_t hash_bytes;
 
-    (void) g_strlcpy(file_sha256, "<unknown>", HASH_STR_SIZE);
-    (void) g_strlcpy(file_sha1, "<unknown>", HASH_STR_SIZE);
+    if (!hs->fh)
+        return;
+
+    /* This is called for every record, so it mustn't cost more than a
+     * comparison until a whole chunk can be hashed. */
+    while (offset == -1 || hs->pos + HASH_BUF_SIZE <= offset) {
+        hash_bytes = fread(hs->buf, 1, HASH_BUF_SIZE, hs->fh);
+        if (hash_bytes == 0)
+            break;
+        gcry_md_write(hs->hd, hs->buf, hash_bytes);
+        hs->pos += hash_bytes;
+    }
+}
 
-    if (cap_file_hashes) {
-        fh = ws_fopen(filename, "rb");
-        if (fh && hd) {
-            while((hash_bytes = fread(hash_buf, 1, HASH_BUF_SIZE, fh)) > 0) {
-                gcry_md_write(hd, hash_buf, hash_bytes);
-            }
-            gcry_md_final(hd);
-            hash_to_str(gcry_md_read(hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, file_sha256);
-            hash_to_str(gcry_md_read(hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, file_sha1);
+static void
+hash_finish(hash_state *hs, capture_info *cf_info)
+{
+    (void) g_strlcpy(cf_info->file_sha256, "<unknown>", HASH_STR_SIZE);
+    (void) g_strlcpy(cf_info->file_sha1, "<unknown>", HASH_STR_SIZE);
+
+    if (hs->fh) {
+        hash_update(hs, -1);
+        gcry_md_final(hs->hd);
+        hash_to_str(gcry_md_read(hs->hd, GCRY_MD_SHA256), HASH_SIZE_SHA256, cf_info->file_sha256);
+        hash_to_str(gcry_md_read(hs->hd, GCRY_MD_SHA1), HASH_SIZE_SHA1, cf_info->file_sha1);
+        fclose(hs->fh);
+        hs->fh = NULL;
+    }
+    gcry_md_close(hs->hd);
+    hs->hd = NULL;
+    g_free(hs->buf);
+    hs->buf = NULL;
+}
+
+/* The same conversion pcapng does for packet time stamps, so that the
+ * times match those of a full scan. */
+static void
+ts_units_to_nstime(nstime_t *ts, guint64 units, guint64 units_per_second)
+{
+    ts->secs = (time_t)(units / units_per_second);
+    ts->nsecs = (int)(((units % units_per_second) * 1000000000) / units_per_second);
+}
+
+/*
+ * --fast: try to get the packet counts and times from the last
+ * Interface Statistics Block for each interface, without reading
+ * the records.  Every interface must have an ISB with the start time,
+ * end time and the number of packets delivered to the user (i.e.,
+ * written to the file); otherwise we fall back on a full scan.
+ *
+ * Packet and data sizes, time order, and packet comments aren't
+ * available this way.
+ */
+static gboolean
+scan_trailing_if_stats(capture_info *cf_info)
+{
+    wtapng_iface_descriptions_t *idb_info;
+    GArray       *if_stats;
+    wtap_block_t *last_isb;
+    gboolean      have_all = FALSE;
+    guint32       packet = 0;
+    guint         i;
+    int           err;
+    gchar        *err_info;
+
+    if (cf_info->num_interfaces == 0)
+        return FALSE;
+
+    if_stats = wtap_file_get_trailing_if_stats(cf_info->wth, &err, &err_info);
+    if (if_stats == NULL) {
+        g_free(err_info);
+        return FALSE;
+    }
+
+    last_isb = g_new0(wtap_block_t, cf_info->num_interfaces);
+    for (i = 0; i < if_stats->len; i++) {
+        wtap_block_t isb = g_array_index(if_stats, wtap_block_t, i);
+        wtapng_if_stats_mandatory_t *isb_mand = (wtapng_if_stats_mandatory_t*)wtap_block_get_mandatory_data(isb);
+
+        if (isb_mand->interface_id < cf_info->num_interfaces)
+            last_isb[isb_mand->interface_id] = isb;
+    }
+
+    idb_info = wtap_file_get_idb_info(cf_info->wth);
+    for (i = 0; i < cf_info->num_interfaces; i++) {
+        wtap_block_t idb = g_array_index(idb_info->interface_data, wtap_block_t, i);
+        wtapng_if_descr_mandatory_t *idb_mand = (wtapng_if_descr_mandatory_t*)wtap_block_get_mandatory_data(idb);
+        guint64 starttime, endtime, usrdeliv;
+        nstime_t if_start, if_stop;
+
+        if (last_isb[i] == NULL ||
+            wtap_block_get_uint64_option_value(last_isb[i], OPT_ISB_STARTTIME, &starttime) != WTAP_OPTTYPE_SUCCESS ||
+            wtap_block_get_uint64_option_value(last_isb[i], OPT_ISB_ENDTIME, &endtime) != WTAP_OPTTYPE_SUCCESS ||
+            wtap_block_get_uint64_option_value(last_isb[i], OPT_ISB_USRDELIV, &usrdeliv) != WTAP_OPTTYPE_SUCCESS ||
+            idb_mand->time_units_per_second == 0)
+            goto done;
+
+        ts_units_to_nstime(&if_start, starttime, idb_mand->time_units_per_second);
+        ts_units_to_nstime(&if_stop, endtime, idb_mand->time_units_per_second);
+        if (i == 0 || nstime_cmp(&if_start, &cf_info->start_time) < 0) {
+            cf_info->start_time = if_start;
+            cf_info->start_time_tsprec = idb_mand->tsprecision;
+        }
+        if (i == 0 || nstime_cmp(&if_stop, &cf_info->stop_time) > 0) {
+            cf_info->stop_time = if_stop;
+            cf_info->stop_time_tsprec = idb_mand->tsprecision;
         }
-        if (fh) fclose(fh);
-        if (hd) gcry_md_reset(hd);
+
+        packet += (guint32)usrdeliv;
+        g_array_index(cf_info->interface_packet_counts, guint32, i) = (guint32)usrdeliv;
+        if (idb_mand->wtap_encap > 0 && idb_mand->wtap_encap < WTAP_NUM_ENCAP_TYPES)
+            cf_info->encap_counts[idb_mand->wtap_encap] += (int)usrdeliv;
     }
+    have_all = TRUE;
+    cf_info->packet_count = packet;
+
+done:
+    if (!have_all) {
+        /* Undo any partial results. */
+        memset(cf_info->encap_counts, 0, WTAP_NUM_ENCAP_TYPES * sizeof(int));
+        for (i = 0; i < cf_info->num_interfaces; i++)
+            g_array_index(cf_info->interface_packet_counts, guint32, i) = 0;
+        nstime_set_zero(&cf_info->start_time);
+        nstime_set_zero(&cf_info->stop_time);
+        cf_info->start_time_tsprec = WTAP_TSPREC_UNKNOWN;
+        cf_info->stop_time_tsprec = WTAP_TSPREC_UNKNOWN;
+    }
+    g_free(idb_info);
+    g_free(last_isb);
+    wtap_block_array_free(if_stats);
+    return have_all;
 }
 
-static int
-process_cap_file(const char *filename, gboolean need_separator)
+/*
+ * Open a capture file and gather its infos.  This doesn't print
+ * anything to the standard output, so that it can run on a worker
+ * thread; report_cap_file() prints the results.
+ */
+static void
+scan_cap_file(capture_info *cf_info)
 {
-    int                   status = 0;
+    const char           *filename = cf_info->filename;
     int                   err;
     gchar                *err_info;
     gint64                size;
-    gint64                data_offset;
 
     guint32               packet = 0;
     gint64                bytes  = 0;
     guint32               snaplen_min_inferred = 0xffffffff;
     guint32               snaplen_max_inferred =          0;
-    wtap_rec              rec;
-    Buffer                buf;
-    capture_info          cf_info;
+    wtap_batch_t          batch;
+    wtap_rec             *rec;
+    guint                 j;
     gboolean              have_times = TRUE;
     nstime_t              start_time;
     int                   start_time_tsprec;
@@ -1102,25 +1334,25 @@ process_cap_file(const char *filename, gboolean need_separator)
     order_t               order = IN_ORDER;
     guint                 i;
     wtapng_iface_descriptions_t *idb_info;
+    hash_state            hs;
 
     pkt_cmt *pc = NULL, *prev = NULL;
 
-    cf_info.wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
-    if (!cf_info.wth) {
-        cfile_open_failure_message(filename, err, err_info);
-        return 2;
+    cf_info->wth = wtap_open_offline(filename, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+    if (!cf_info->wth) {
+        cf_info->failure = SCAN_OPEN_FAILED;
+        cf_info->err = err;
+        cf_info->err_info = err_info;
+        cf_info->status = 2;
+        return;
     }
 
     /*
-     * Calculate the checksums. Do this after wtap_open_offline, so we don't
-     * bother calculating them for files that are not known capture types
-     * where we wouldn't print them anyway.
+     * Calculate the checksums as we go. Do this after wtap_open_offline,
+     * so we don't bother calculating them for files that are not known
+     * capture types where we wouldn't print them anyway.
      */
-    calculate_hashes(filename);
-
-    if (need_separator && long_report) {
-        printf("\n");
-    }
+    hash_init(&hs, filename);
 
     nstime_set_zero(&start_time);
     start_time_tsprec = WTAP_TSPREC_UNKNOWN;
@@ -1129,145 +1361,164 @@ process_cap_file(const char *filename, gboolean need_separator)
     nstime_set_zero(&cur_time);
     nstime_set_zero(&prev_time);
 
-    cf_info.encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
+    cf_info->encap_counts = g_new0(int,WTAP_NUM_ENCAP_TYPES);
 
-    idb_info = wtap_file_get_idb_info(cf_info.wth);
+    idb_info = wtap_file_get_idb_info(cf_info->wth);
 
     ws_assert(idb_info->interface_data != NULL);
 
-    cf_info.pkt_cmts = NULL;
-    cf_info.num_interfaces = idb_info->interface_data->len;
-    cf_info.interface_packet_counts  = g_array_sized_new(FALSE, TRUE, sizeof(guint32), cf_info.num_interfaces);
-    g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
-    cf_info.pkt_interface_id_unknown = 0;
+    cf_info->pkt_cmts = NULL;
+    cf_info->num_interfaces = idb_info->interface_data->len;
+    cf_info->interface_packet_counts  = g_array_sized_new(FALSE, TRUE, sizeof(guint32), cf_info->num_interfaces);
+    g_array_set_size(cf_info->interface_packet_counts, cf_info->num_interfaces);
+    cf_info->pkt_interface_id_unknown = 0;
 
     g_free(idb_info);
     idb_info = NULL;
 
     /* Zero out the counters for the callbacks. */
-    num_ipv4_addresses = 0;
-    num_ipv6_addresses = 0;
-    num_decryption_secrets = 0;
+    cf_info->num_ipv4_addresses = 0;
+    cf_info->num_ipv6_addresses = 0;
+    cf_info->num_decryption_secrets = 0;
+    cf_info->data_size_known = TRUE;
+    cur_cf_info = cf_info;
 
     /* Register callbacks for new name<->address maps from the file and
        decryption secrets from the file. */
-    wtap_set_cb_new_ipv4(cf_info.wth, count_ipv4_address);
-    wtap_set_cb_new_ipv6(cf_info.wth, count_ipv6_address);
-    wtap_set_cb_new_secrets(cf_info.wth, count_decryption_secret);
+    wtap_set_cb_new_ipv4(cf_info->wth, count_ipv4_address);
+    wtap_set_cb_new_ipv6(cf_info->wth, count_ipv6_address);
+    wtap_set_cb_new_secrets(cf_info->wth, count_decryption_secret);
+
+    err = 0;
+    err_info = NULL;
+    if (fast_mode && scan_trailing_if_stats(cf_info)) {
+        packet = cf_info->packet_count;
+        start_time = cf_info->start_time;
+        start_time_tsprec = cf_info->start_time_tsprec;
+        stop_time = cf_info->stop_time;
+        stop_time_tsprec = cf_info->stop_time_tsprec;
+        order = ORDER_UNKNOWN;
+        cf_info->data_size_known = FALSE;
+        goto scanned;
+    }
 
     /* Tally up data that we need to parse through the file to find */
-    wtap_rec_init(&rec);
-    ws_buffer_init(&buf, 1514);
-    while (wtap_read(cf_info.wth, &rec, &buf, &err, &err_info, &data_offset))  {
-        if (rec.presence_flags & WTAP_HAS_TS) {
-            prev_time = cur_time;
-            cur_time = rec.ts;
-            if (packet == 0) {
-                start_time = rec.ts;
-                start_time_tsprec = rec.tsprec;
-                stop_time  = rec.ts;
-                stop_time_tsprec = rec.tsprec;
-                prev_time  = rec.ts;
-            }
-            if (nstime_cmp(&cur_time, &prev_time) < 0) {
-                order = NOT_IN_ORDER;
-            }
-            if (nstime_cmp(&cur_time, &start_time) < 0) {
-                start_time = cur_time;
-                start_time_tsprec = rec.tsprec;
-            }
-            if (nstime_cmp(&cur_time, &stop_time) > 0) {
-                stop_time = cur_time;
-                stop_time_tsprec = rec.tsprec;
-            }
-        } else {
-            have_times = FALSE; /* at least one packet has no time stamp */
-            if (order != NOT_IN_ORDER)
-                order = ORDER_UNKNOWN;
-        }
-
-        if (rec.rec_type == REC_TYPE_PACKET) {
-            bytes += rec.rec_header.packet_header.len;
-            packet++;
-            /* packet comments */
-            if (pkt_comments && wtap_block_count_option(rec.block, OPT_COMMENT) > 0) {
-              char *cmt_buff;
-              for (i = 0; wtap_block_get_nth_string_option_value(rec.block, OPT_COMMENT, i, &cmt_buff) == WTAP_OPTTYPE_SUCCESS; i++) {
-                pc = g_new0(pkt_cmt, 1);
-
-                pc->recno = packet;
-                pc->cmt = g_strdup(cmt_buff);
-                pc->next = NULL;
-
-                if (prev == NULL)
-                  cf_info.pkt_cmts = pc;
-                else
-                  prev->next = pc;
-
-                prev = pc;
-              }
-            }
-
-            /* If caplen < len for a rcd, then presumably           */
-            /* 'Limit packet capture length' was done for this rcd. */
-            /* Keep track as to the min/max actual snapshot lengths */
-            /*  seen for this file.                                 */
-            if (rec.rec_header.packet_header.caplen < rec.rec_header.packet_header.len) {
-                if (rec.rec_header.packet_header.caplen < snaplen_min_inferred)
-                    snaplen_min_inferred = rec.rec_header.packet_header.caplen;
-                if (rec.rec_header.packet_header.caplen > snaplen_max_inferred)
-                    snaplen_max_inferred = rec.rec_header.packet_header.caplen;
-            }
-
-            if ((rec.rec_header.packet_header.pkt_encap > 0) &&
-                    (rec.rec_header.packet_header.pkt_encap < WTAP_NUM_ENCAP_TYPES)) {
-                cf_info.encap_counts[rec.rec_header.packet_header.pkt_encap] += 1;
+    wtap_batch_init(&batch, SCAN_BATCH_SIZE);
+    while (wtap_read_batch(cf_info->wth, &batch, &err, &err_info))  {
+        for (j = 0; j < batch.count; j++) {
+            rec = &batch.recs[j];
+            if (rec->presence_flags & WTAP_HAS_TS) {
+                prev_time = cur_time;
+                cur_time = rec->ts;
+                if (packet == 0) {
+                    start_time = rec->ts;
+                    start_time_tsprec = rec->tsprec;
+                    stop_time  = rec->ts;
+                    stop_time_tsprec = rec->tsprec;
+                    prev_time  = rec->ts;
+                }
+                if (nstime_cmp(&cur_time, &prev_time) < 0) {
+                    order = NOT_IN_ORDER;
+                }
+                if (nstime_cmp(&cur_time, &start_time) < 0) {
+                    start_time = cur_time;
+                    start_time_tsprec = rec->tsprec;
+                }
+                if (nstime_cmp(&cur_time, &stop_time) > 0) {
+                    stop_time = cur_time;
+                    stop_time_tsprec = rec->tsprec;
+                }
             } else {
-                fprintf(stderr, "capinfos: Unknown packet encapsulation %d in frame %u of file \"%s\"\n",
-                        rec.rec_header.packet_header.pkt_encap, packet, filename);
+                have_times = FALSE; /* at least one packet has no time stamp */
+                if (order != NOT_IN_ORDER)
+                    order = ORDER_UNKNOWN;
             }
 
-            /* Packet interface_id info */
-            if (rec.presence_flags & WTAP_HAS_INTERFACE_ID) {
-                /* cf_info.num_interfaces is size, not index, so it's one more than max index */
-                if (rec.rec_header.packet_header.interface_id >= cf_info.num_interfaces) {
-                    /*
-                     * OK, re-fetch the number of interfaces, as there might have
-                     * been an interface that was in the middle of packets, and
-                     * grow the array to be big enough for the new number of
-                     * interfaces.
-                     */
-                    idb_info = wtap_file_get_idb_info(cf_info.wth);
-
-                    cf_info.num_interfaces = idb_info->interface_data->len;
-                    g_array_set_size(cf_info.interface_packet_counts, cf_info.num_interfaces);
-
-                    g_free(idb_info);
-                    idb_info = NULL;
+            if (rec->rec_type == REC_TYPE_PACKET) {
+                bytes += rec->rec_header.packet_header.len;
+                packet++;
+                /* packet comments */
+                if (pkt_comments && wtap_block_count_option(rec->block, OPT_COMMENT) > 0) {
+                  char *cmt_buff;
+                  for (i = 0; wtap_block_get_nth_string_option_value(rec->block, OPT_COMMENT, i, &cmt_buff) == WTAP_OPTTYPE_SUCCESS; i++) {
+                    pc = g_new0(pkt_cmt, 1);
+
+                    pc->recno = packet;
+                    pc->cmt = g_strdup(cmt_buff);
+                    pc->next = NULL;
+
+                    if (prev == NULL)
+                      cf_info->pkt_cmts = pc;
+                    else
+                      prev->next = pc;
+
+                    prev = pc;
+                  }
                 }
-                if (rec.rec_header.packet_header.interface_id < cf_info.num_interfaces) {
-                    g_array_index(cf_info.interface_packet_counts, guint32,
-                            rec.rec_header.packet_header.interface_id) += 1;
+
+                /* If caplen < len for a rcd, then presumably           */
+                /* 'Limit packet capture length' was done for this rcd. */
+                /* Keep track as to the min/max actual snapshot lengths */
+                /*  seen for this file.                                 */
+                if (rec->rec_header.packet_header.caplen < rec->rec_header.packet_header.len) {
+                    if (rec->rec_header.packet_header.caplen < snaplen_min_inferred)
+                        snaplen_min_inferred = rec->rec_header.packet_header.caplen;
+                    if (rec->rec_header.packet_header.caplen > snaplen_max_inferred)
+                        snaplen_max_inferred = rec->rec_header.packet_header.caplen;
                 }
-                else {
-                    cf_info.pkt_interface_id_unknown += 1;
+
+                if ((rec->rec_header.packet_header.pkt_encap > 0) &&
+                        (rec->rec_header.packet_header.pkt_encap < WTAP_NUM_ENCAP_TYPES)) {
+                    cf_info->encap_counts[rec->rec_header.packet_header.pkt_encap] += 1;
+                } else {
+                    fprintf(stderr, "capinfos: Unknown packet encapsulation %d in frame %u of file \"%s\"\n",
+                            rec->rec_header.packet_header.pkt_encap, packet, filename);
                 }
-            }
-            else {
-                /* it's for interface_id 0 */
-                if (cf_info.num_interfaces != 0) {
-                    g_array_index(cf_info.interface_packet_counts, guint32, 0) += 1;
+
+                /* Packet interface_id info */
+                if (rec->presence_flags & WTAP_HAS_INTERFACE_ID) {
+                    /* cf_info->num_interfaces is size, not index, so it's one more than max index */
+                    if (rec->rec_header.packet_header.interface_id >= cf_info->num_interfaces) {
+                        /*
+                         * OK, re-fetch the number of interfaces, as there might have
+                         * been an interface that was in the middle of packets, and
+                         * grow the array to be big enough for the new number of
+                         * interfaces.
+                         */
+                        idb_info = wtap_file_get_idb_info(cf_info->wth);
+
+                        cf_info->num_interfaces = idb_info->interface_data->len;
+                        g_array_set_size(cf_info->interface_packet_counts, cf_info->num_interfaces);
+
+                        g_free(idb_info);
+                        idb_info = NULL;
+                    }
+                    if (rec->rec_header.packet_header.interface_id < cf_info->num_interfaces) {
+                        g_array_index(cf_info->interface_packet_counts, guint32,
+                                rec->rec_header.packet_header.interface_id) += 1;
+                    }
+                    else {
+                        cf_info->pkt_interface_id_unknown += 1;
+                    }
                 }
                 else {
-                    cf_info.pkt_interface_id_unknown += 1;
+                    /* it's for interface_id 0 */
+                    if (cf_info->num_interfaces != 0) {
+                        g_array_index(cf_info->interface_packet_counts, guint32, 0) += 1;
+                    }
+                    else {
+                        cf_info->pkt_interface_id_unknown += 1;
+                    }
                 }
             }
         }
-
-        wtap_rec_reset(&rec);
+        hash_update(&hs, wtap_read_so_far(cf_info->wth));
     } /* while */
-    wtap_rec_cleanup(&rec);
-    ws_buffer_free(&buf);
+    wtap_batch_cleanup(&batch);
+
+scanned:
+    hash_finish(&hs, cf_info);
+    cur_cf_info = NULL;
 
     /*
      * Get IDB info strings.
@@ -1276,116 +1527,244 @@ process_cap_file(const char *filename, gboolean need_separator)
      * we get, for example, a count of the number of statistics entries
      * for each interface as of the *end* of the file.
      */
-    idb_info = wtap_file_get_idb_info(cf_info.wth);
+    idb_info = wtap_file_get_idb_info(cf_info->wth);
 
-    cf_info.idb_info_strings = g_array_sized_new(FALSE, FALSE, sizeof(gchar*), cf_info.num_interfaces);
-    cf_info.num_interfaces = idb_info->interface_data->len;
-    for (i = 0; i < cf_info.num_interfaces; i++) {
+    cf_info->idb_info_strings = g_array_sized_new(FALSE, FALSE, sizeof(gchar*), cf_info->num_interfaces);
+    cf_info->num_interfaces = idb_info->interface_data->len;
+    for (i = 0; i < cf_info->num_interfaces; i++) {
         const wtap_block_t if_descr = g_array_index(idb_info->interface_data, wtap_block_t, i);
         gchar *s = wtap_get_debug_if_descr(if_descr, 21, "\n");
-        g_array_append_val(cf_info.idb_info_strings, s);
+        g_array_append_val(cf_info->idb_info_strings, s);
     }
 
     g_free(idb_info);
     idb_info = NULL;
 
     if (err != 0) {
-        fprintf(stderr,
-                "capinfos: An error occurred after reading %u packets from \"%s\".\n",
-                packet, filename);
-        cfile_read_failure_message(filename, err, err_info);
+        cf_info->failure = SCAN_READ_FAILED;
+        cf_info->err = err;
+        cf_info->err_info = err_info;
+        cf_info->packet_count = packet;
         if (err == WTAP_ERR_SHORT_READ) {
             /* Don't give up completely with this one. */
-            status = 1;
-            fprintf(stderr,
-                    "  (will continue anyway, checksums might be incorrect)\n");
+            cf_info->status = 1;
         } else {
-            cleanup_capture_info(&cf_info);
-            wtap_close(cf_info.wth);
-            return 2;
+            cf_info->status = 2;
+            return;
         }
     }
 
     /* File size */
-    size = wtap_file_size(cf_info.wth, &err);
+    size = wtap_file_size(cf_info->wth, &err);
     if (size == -1) {
-        fprintf(stderr,
-                "capinfos: Can't get size of \"%s\": %s.\n",
-                filename, g_strerror(err));
-        cleanup_capture_info(&cf_info);
-        wtap_close(cf_info.wth);
-        return 2;
+        cf_info->failure = SCAN_SIZE_FAILED;
+        cf_info->err = err;
+        cf_info->status = 2;
+        return;
     }
 
-    cf_info.filesize = size;
+    cf_info->filesize = size;
 
     /* File Type */
-    cf_info.file_type = wtap_file_type_subtype(cf_info.wth);
-    cf_info.compression_type = wtap_get_compression_type(cf_info.wth);
+    cf_info->file_type = wtap_file_type_subtype(cf_info->wth);
+    cf_info->compression_type = wtap_get_compression_type(cf_info->wth);
 
     /* File Encapsulation */
-    cf_info.file_encap = wtap_file_encap(cf_info.wth);
+    cf_info->file_encap = wtap_file_encap(cf_info->wth);
 
-    cf_info.file_tsprec = wtap_file_tsprec(cf_info.wth);
+    cf_info->file_tsprec = wtap_file_tsprec(cf_info->wth);
 
     /* Packet size limit (snaplen) */
-    cf_info.snaplen = wtap_snapshot_length(cf_info.wth);
-    if (cf_info.snaplen > 0)
-        cf_info.snap_set = TRUE;
+    cf_info->snaplen = wtap_snapshot_length(cf_info->wth);
+    if (cf_info->snaplen > 0)
+        cf_info->snap_set = TRUE;
     else
-        cf_info.snap_set = FALSE;
+        cf_info->snap_set = FALSE;
 
-    cf_info.snaplen_min_inferred = snaplen_min_inferred;
-    cf_info.snaplen_max_inferred = snaplen_max_inferred;
+    cf_info->snaplen_min_inferred = snaplen_min_inferred;
+    cf_info->snaplen_max_inferred = snaplen_max_inferred;
 
     /* # of packets */
-    cf_info.packet_count = packet;
+    cf_info->packet_count = packet;
 
     /* File Times */
-    cf_info.times_known = have_times;
-    cf_info.start_time = start_time;
-    cf_info.start_time_tsprec = start_time_tsprec;
-    cf_info.stop_time = stop_time;
-    cf_info.stop_time_tsprec = stop_time_tsprec;
-    nstime_delta(&cf_info.duration, &stop_time, &start_time);
+    cf_info->times_known = have_times;
+    cf_info->start_time = start_time;
+    cf_info->start_time_tsprec = start_time_tsprec;
+    cf_info->stop_time = stop_time;
+    cf_info->stop_time_tsprec = stop_time_tsprec;
+    nstime_delta(&cf_info->duration, &stop_time, &start_time);
     /* Duration precision is the higher of the start and stop time precisions. */
-    if (cf_info.stop_time_tsprec > cf_info.start_time_tsprec)
-        cf_info.duration_tsprec = cf_info.stop_time_tsprec;
+    if (cf_info->stop_time_tsprec > cf_info->start_time_tsprec)
+        cf_info->duration_tsprec = cf_info->stop_time_tsprec;
     else
-        cf_info.duration_tsprec = cf_info.start_time_tsprec;
-    cf_info.know_order = know_order;
-    cf_info.order = order;
+        cf_info->duration_tsprec = cf_info->start_time_tsprec;
+    cf_info->know_order = know_order;
+    cf_info->order = order;
 
     /* Number of packet bytes */
-    cf_info.packet_bytes = bytes;
+    cf_info->packet_bytes = bytes;
 
-    cf_info.data_rate   = 0.0;
-    cf_info.packet_rate = 0.0;
-    cf_info.packet_size = 0.0;
+    cf_info->data_rate   = 0.0;
+    cf_info->packet_rate = 0.0;
+    cf_info->packet_size = 0.0;
 
     if (packet > 0) {
         double delta_time = nstime_to_sec(&stop_time) - nstime_to_sec(&start_time);
         if (delta_time > 0.0) {
-            cf_info.data_rate   = (double)bytes  / delta_time; /* Data rate per second */
-            cf_info.packet_rate = (double)packet / delta_time; /* packet rate per second */
+            cf_info->data_rate   = (double)bytes  / delta_time; /* Data rate per second */
+            cf_info->packet_rate = (double)packet / delta_time; /* packet rate per second */
+        }
+        cf_info->packet_size = (double)bytes / packet;                  /* Avg packet size      */
+    }
+}
+
+/*
+ * Print the infos gathered by scan_cap_file(), and any errors it got,
+ * then release the file.
+ */
+static int
+report_cap_file(capture_info *cf_info, gboolean need_separator)
+{
+    const char *filename = cf_info->filename;
+
+    switch (cf_info->failure) {
+
+    case SCAN_OK:
+        break;
+
+    case SCAN_OPEN_FAILED:
+        cfile_open_failure_message(filename, cf_info->err, cf_info->err_info);
+        cf_info->err_info = NULL;
+        return cf_info->status;
+
+    case SCAN_READ_FAILED:
+        fprintf(stderr,
+                "capinfos: An error occurred after reading %u packets from \"%s\".\n",
+                cf_info->packet_count, filename);
+        cfile_read_failure_message(filename, cf_info->err, cf_info->err_info);
+        cf_info->err_info = NULL;
+        if (cf_info->status == 1) {
+            fprintf(stderr,
+                    "  (will continue anyway, checksums might be incorrect)\n");
         }
-        cf_info.packet_size = (double)bytes / packet;                  /* Avg packet size      */
+        break;
+
+    case SCAN_SIZE_FAILED:
+        fprintf(stderr,
+                "capinfos: Can't get size of \"%s\": %s.\n",
+                filename, g_strerror(cf_info->err));
+        break;
     }
 
-    if (!long_report && table_report_header) {
-      print_stats_table_header(&cf_info);
+    if (cf_info->status != 2) {
+        if (need_separator && long_report) {
+            printf("\n");
+        }
+
+        if (!long_report && table_report_header) {
+          print_stats_table_header(cf_info);
+        }
+
+        if (long_report) {
+            print_stats(filename, cf_info);
+        } else {
+            print_stats_table(filename, cf_info);
+        }
     }
 
-    if (long_report) {
-        print_stats(filename, &cf_info);
-    } else {
-        print_stats_table(filename, &cf_info);
+    cleanup_capture_info(cf_info);
+
+    return cf_info->status;
+}
+
+static void
+scan_cap_file_worker(gpointer data, gpointer user_data)
+{
+    capture_info *cf_info = (capture_info *)data;
+    scan_pool_t  *scan_pool = (scan_pool_t *)user_data;
+
+    scan_cap_file(cf_info);
+
+    g_mutex_lock(&scan_pool->mutex);
+    cf_info->scanned = TRUE;
+    g_cond_broadcast(&scan_pool->cond);
+    g_mutex_unlock(&scan_pool->mutex);
+}
+
+/*
+ * Scan the files on a pool of worker threads, keeping at most a few
+ * files per thread open, and report them in order as they complete.
+ */
+static int
+process_cap_files(char **filenames, int num_files)
+{
+    capture_info *cf_infos;
+    scan_pool_t   scan_pool;
+    GThreadPool  *pool = NULL;
+    gboolean      need_separator = FALSE;
+    int           overall_error_status = 0;
+    int           status;
+    int           window;
+    int           next_scan = 0;
+    int           i;
+
+    cf_infos = g_new0(capture_info, num_files);
+    for (i = 0; i < num_files; i++)
+        cf_infos[i].filename = filenames[i];
+
+    if (num_threads > 1 && num_files > 1) {
+        g_mutex_init(&scan_pool.mutex);
+        g_cond_init(&scan_pool.cond);
+        pool = g_thread_pool_new(scan_cap_file_worker, &scan_pool, (gint)num_threads, FALSE, NULL);
     }
+    window = 2 * (int)num_threads;
 
-    cleanup_capture_info(&cf_info);
-    wtap_close(cf_info.wth);
+    for (i = 0; i < num_files; i++) {
+        if (pool) {
+            while (next_scan < num_files && next_scan < i + window) {
+                g_thread_pool_push(pool, &cf_infos[next_scan], NULL);
+                next_scan++;
+            }
+            g_mutex_lock(&scan_pool.mutex);
+            while (!cf_infos[i].scanned)
+                g_cond_wait(&scan_pool.cond, &scan_pool.mutex);
+            g_mutex_unlock(&scan_pool.mutex);
+        } else {
+            scan_cap_file(&cf_infos[i]);
+        }
+
+        status = report_cap_file(&cf_infos[i], need_separator);
+        if (status) {
+            /* Something failed.  It's been reported; remember that processing
+               one file failed and, if -C was specified, stop. */
+            overall_error_status = status;
+            if (stop_after_failure)
+                break;
+        }
+        if (status != 2) {
+            /* Either it succeeded or it got a "short read" but printed
+               information anyway.  Note that we need a blank line before
+               the next file's information, to separate it from the
+               previous file. */
+            need_separator = TRUE;
+        }
+    }
+
+    if (pool) {
+        /* Drop any queued files and wait for the ones in progress. */
+        g_thread_pool_free(pool, TRUE, TRUE);
+        g_mutex_clear(&scan_pool.mutex);
+        g_cond_clear(&scan_pool.cond);
+    }
 
-    return status;
+    /* Release any files we scanned but didn't report. */
+    for (; i < num_files; i++) {
+        cleanup_capture_info(&cf_infos[i]);
+    }
+    g_free(cf_infos);
+
+    return overall_error_status;
 }
 
 static void
@@ -1447,6 +1826,11 @@ print_usage(FILE *output)
     fprintf(output, "  -h, --help               display this help and exit\n");
     fprintf(output, "  -v, --version            display version info and exit\n");
     fprintf(output, "  -C cancel processing if file open fails (default is to continue)\n");
+    fprintf(output, "  --threads <n>            read up to <n> files in parallel (default 1, 0 = one\n");
+    fprintf(output, "                           per processor); output stays in input file order\n");
+    fprintf(output, "  --fast                   take packet counts and times from the pcapng\n");
+    fprintf(output, "                           interface statistics, if present, instead of\n");
+    fprintf(output, "                           reading every packet\n");
     fprintf(output, "  -A generate all infos (default)\n");
     fprintf(output, "  -K disable displaying the capture comment\n");
     fprintf(output, "  -P disable displaying individual packet comments\n");
@@ -1495,17 +1879,18 @@ main(int argc, char *argv[])
         cfile_write_failure_message,
         cfile_close_failure_message
     };
-    gboolean need_separator = FALSE;
     int    opt;
     int    overall_error_status = EXIT_SUCCESS;
+#define LONGOPT_THREADS              LONGOPT_BASE_APPLICATION+1
+#define LONGOPT_FAST                 LONGOPT_BASE_APPLICATION+2
     static const struct ws_option long_options[] = {
         {"help", ws_no_argument, NULL, 'h'},
         {"version", ws_no_argument, NULL, 'v'},
+        {"threads", ws_required_argument, NULL, LONGOPT_THREADS},
+        {"fast", ws_no_argument, NULL, LONGOPT_FAST},
         {0, 0, 0, 0 }
     };
 
-    int status = 0;
-
     /*
      * Set the C-language locale to the native environment and set the
      * code page to UTF-8 on Windows.
@@ -1731,6 +2116,21 @@ main(int argc, char *argv[])
                 field_separator = ' ';
                 break;
 
+            case LONGOPT_THREADS:
+                if (sscanf(ws_optarg, "%u", &num_threads) != 1) {
+                    fprintf(stderr, "capinfos: \"%s\" isn't a valid number of threads\n",
+                            ws_optarg);
+                    overall_error_status = WS_EXIT_INVALID_OPTION;
+                    goto exit;
+                }
+                if (num_threads == 0)
+                    num_threads = g_get_num_processors();
+                break;
+
+            case LONGOPT_FAST:
+                fast_mode = TRUE;
+                break;
+
             case 'h':
                 show_help_header("Print various information (infos) about capture files.");
                 print_usage(stdout);
@@ -1757,38 +2157,13 @@ main(int argc, char *argv[])
     }
 
     if (cap_file_hashes) {
+        /* Must be done before any threads use libgcrypt. */
         gcry_check_version(NULL);
-        gcry_md_open(&hd, GCRY_MD_SHA256, 0);
-        if (hd)
-            gcry_md_enable(hd, GCRY_MD_SHA1);
-
-        hash_buf = (char *)g_malloc(HASH_BUF_SIZE);
     }
 
-    overall_error_status = 0;
-
-    for (opt = ws_optind; opt < argc; opt++) {
-
-        status = process_cap_file(argv[opt], need_separator);
-        if (status) {
-            /* Something failed.  It's been reported; remember that processing
-               one file failed and, if -C was specified, stop. */
-            overall_error_status = status;
-            if (stop_after_failure)
-                goto exit;
-        }
-        if (status != 2) {
-            /* Either it succeeded or it got a "short read" but printed
-               information anyway.  Note that we need a blank line before
-               the next file's information, to separate it from the
-               previous file. */
-            need_separator = TRUE;
-        }
-    }
+    overall_error_status = process_cap_files(&argv[ws_optind], argc - ws_optind);
 
 exit:
-    g_free(hash_buf);
-    gcry_md_close(hd);
     wtap_cleanup();
     free_progdirs();
     return overall_error_status;
@@ -62,6 +62,7 @@ struct packet_provider_data {
     frame_data  *prev_cap;
     frame_data_sequence *frames;         /* Sequence of frames, if we're keeping that information */
     GTree       *frames_modified_blocks; /* BST with modified blocks for frames (key = frame_data) */
+    struct frame_read_cache *read_cache; /* Records read ahead; see cap_file_provider_read_record() */
 };
 
 typedef struct _capture_file {
@@ -136,6 +137,25 @@ const char *cap_file_provider_get_interface_description(struct packet_provider_d
 wtap_block_t cap_file_provider_get_modified_block(struct packet_provider_data *prov, const frame_data *fd);
 void cap_file_provider_set_modified_block(struct packet_provider_data *prov, frame_data *fd, const wtap_block_t new_block);
 
+/*
+ * Read the record of a frame, as wtap_seek_read() would.  When frames
+ * are read in order (forwards or backwards), the records of the frames
+ * that follow are read ahead in one run and kept, up to a fixed amount
+ * of memory, for later calls.
+ *
+ * A memory-mapped file is read with wtap_seek_read() and nothing is
+ * cached, as reading it is already just a copy out of the mapping.
+ * Frame tvbuffs of a memory-mapped file don't use this at all; they
+ * read with wtap_seek_read_ptr(), which wraps the data instead of
+ * copying it.
+ */
+gboolean cap_file_provider_read_record(struct packet_provider_data *prov,
+    guint32 frame_num, gint64 file_off, wtap_rec *rec, Buffer *buf,
+    int *err, gchar **err_info);
+
+/* Drop the records read ahead; call before prov->wth is closed. */
+void cap_file_provider_clear_read_cache(struct packet_provider_data *prov);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
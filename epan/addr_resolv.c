@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 #include <wsutil/strtoi.h>
 #include <wsutil/ws_assert.h>
@@ -92,6 +93,7 @@
 
 #include <epan/strutil.h>
 #include <epan/to_str.h>
+#include <epan/conversation.h>
 #include <epan/maxmind_db.h>
 #include <epan/prefs.h>
 #include <epan/uat.h>
@@ -107,31 +109,34 @@
 #define ENAME_VLANS     "vlans"
 #define ENAME_SS7PCS    "ss7pcs"
 #define ENAME_ENTERPRISES "enterprises"
+#define ENAME_DNS_CACHE "dns_cache"
 
 #define HASHETHSIZE      2048
-#define HASHHOSTSIZE     2048
 #define HASHIPXNETSIZE    256
-#define SUBNETLENGTHSIZE   32  /*1-32 inc.*/
 
-/* hash table used for IPv4 lookup */
+/* Longest-prefix-match trie used for subnets and well-known MAC address
+ * ranges. Each level consumes PREFIX_TRIE_STRIDE bits of the key. A prefix
+ * whose length isn't a multiple of the stride is expanded into every slot
+ * it covers at its last level, so a lookup visits at most one node per
+ * stride and remembers the last entry it passed. */
+#define PREFIX_TRIE_STRIDE  4
+#define PREFIX_TRIE_FANOUT  (1 << PREFIX_TRIE_STRIDE)
+
+typedef struct prefix_trie_entry {
+    struct prefix_trie_entry *next; /* All entries in the trie */
+    void             *data;
+    guint             prefix_len;
+} prefix_trie_entry_t;
+
+typedef struct prefix_trie_node {
+    struct prefix_trie_node *child[PREFIX_TRIE_FANOUT];
+    prefix_trie_entry_t     *entry[PREFIX_TRIE_FANOUT]; /* Longest prefix ending at this level */
+} prefix_trie_node_t;
 
-#define HASH_IPV4_ADDRESS(addr) (g_htonl(addr) & (HASHHOSTSIZE - 1))
-
-
-typedef struct sub_net_hashipv4 {
-    guint             addr;
-    /* XXX: No longer needed?*/
-    guint8            flags;          /* B0 dummy_entry, B1 resolve, B2 If the address is used in the trace */
-    struct sub_net_hashipv4   *next;
-    gchar             name[MAXNAMELEN];
-} sub_net_hashipv4_t;
-
-/* Array of entries of subnets of different lengths */
 typedef struct {
-    gsize        mask_length;      /*1-32*/
-    guint32      mask;             /* e.g. 255.255.255.*/
-    sub_net_hashipv4_t** subnet_addresses; /* Hash table of subnet addresses */
-} subnet_length_entry_t;
+    prefix_trie_node_t  *root;
+    prefix_trie_entry_t *entries;
+} prefix_trie_t;
 
 
 /* hash table used for IPX network lookup */
@@ -224,6 +229,7 @@ struct cb_serv_data {
 // Maps guint -> hashmanuf_t*
 static wmem_map_t *manuf_hashtable = NULL;
 static wmem_map_t *wka_hashtable = NULL;
+static prefix_trie_t wka_trie;
 static wmem_map_t *eth_hashtable = NULL;
 // Maps guint -> serv_port_t*
 static wmem_map_t *serv_port_hashtable = NULL;
@@ -231,8 +237,12 @@ static wmem_map_t *serv_port_hashtable = NULL;
 // Maps enterprise-id -> enterprise-desc (only used for user additions)
 static GHashTable *enterprises_hashtable = NULL;
 
-static subnet_length_entry_t subnet_length_entries[SUBNETLENGTHSIZE]; /* Ordered array of entries */
-static gboolean have_subnet_entry = FALSE;
+// Maps IPv4 subnet -> subnet name
+static prefix_trie_t subnet_trie;
+
+// Maps printable address -> dns_cache_entry_t*, for names resolved via DNS
+static wmem_map_t *dns_cache_table = NULL;
+static gboolean dns_cache_changed = FALSE;
 
 static gboolean new_resolved_objects = FALSE;
 
@@ -291,6 +301,9 @@ e_addr_resolve gbl_resolv_flags = {
 };
 static guint name_resolve_concurrency = 500;
 static gboolean resolve_synchronously = FALSE;
+static gboolean name_resolve_prefetch = FALSE;
+static gboolean name_resolve_cache = FALSE;
+static guint name_resolve_cache_ttl = 86400;
 
 /*
  *  Global variables (can be changed in GUI sections)
@@ -350,6 +363,19 @@ typedef struct _sync_dns_data
     gboolean        *completed;
 } sync_dns_data_t;
 
+/*
+ * Names resolved via DNS are kept in ENAME_DNS_CACHE in the personal
+ * configuration directory if name_resolve_cache is set, so that they
+ * are available right away the next time. c-ares doesn't tell us the
+ * TTL of PTR records, so entries expire name_resolve_cache_ttl seconds
+ * after they were resolved.
+ */
+typedef struct _dns_cache_entry
+{
+    gchar           *name;
+    gint64           expires;   /* Seconds since the Epoch */
+} dns_cache_entry_t;
+
 static ares_channel ghba_chan; /* ares_gethostbyaddr -- Usually non-interactive, no timeout */
 static ares_channel ghbn_chan; /* ares_gethostbyname -- Usually interactive, timeout */
 
@@ -428,6 +454,40 @@ dnsserver_uat_fld_port_chk_cb(void* r _U_, const char* p, guint len _U_, const v
     return TRUE;
 }
 
+static void
+dns_cache_add(const char *addr_str, const char *name, gint64 expires)
+{
+    dns_cache_entry_t *entry;
+
+    entry = (dns_cache_entry_t *)wmem_map_lookup(dns_cache_table, addr_str);
+    if (entry == NULL) {
+        entry = wmem_new(addr_resolv_scope, dns_cache_entry_t);
+        wmem_map_insert(dns_cache_table, wmem_strdup(addr_resolv_scope, addr_str), entry);
+    } else {
+        wmem_free(addr_resolv_scope, entry->name);
+    }
+    entry->name = wmem_strdup(addr_resolv_scope, name);
+    entry->expires = expires;
+}
+
+/* Remember a name we got from DNS. */
+static void
+dns_cache_record(int family, const void *addrp, const char *name)
+{
+    char addr_str[WS_INET6_ADDRSTRLEN];
+
+    if (!name_resolve_cache || dns_cache_table == NULL || !name || name[0] == '\0')
+        return;
+
+    if (family == AF_INET) {
+        ws_inet_ntop4(addrp, addr_str, sizeof(addr_str));
+    } else {
+        ws_inet_ntop6(addrp, addr_str, sizeof(addr_str));
+    }
+    dns_cache_add(addr_str, name, (gint64)time(NULL) + name_resolve_cache_ttl);
+    dns_cache_changed = TRUE;
+}
+
 static void
 c_ares_ghba_sync_cb(void *arg, int status, int timeouts _U_, struct hostent *he) {
     sync_dns_data_t *sdd = (sync_dns_data_t *)arg;
@@ -447,7 +507,7 @@ c_ares_ghba_sync_cb(void *arg, int status, int timeouts _U_, struct hostent *he)
                     break;
             }
         }
-
+        dns_cache_record(sdd->family, &sdd->addr, he->h_name);
     }
 
     /*
@@ -653,6 +713,125 @@ fgetline(char *buf, int size, FILE *fp)
 
 } /* fgetline */
 
+static inline guint
+prefix_trie_index(const guint8 *key, guint level)
+{
+    return (key[level / 2] >> ((level & 1) ? 0 : 4)) & (PREFIX_TRIE_FANOUT - 1);
+}
+
+/* Add a prefix of the given length in bits. If the same prefix is already
+ * present, its data is replaced if replace is set and kept otherwise.
+ * Returns TRUE if data was stored. */
+static gboolean
+prefix_trie_insert(prefix_trie_t *trie, const guint8 *key, guint prefix_len, void *data, gboolean replace)
+{
+    prefix_trie_node_t *node;
+    prefix_trie_entry_t *entry;
+    guint level, first, count, i;
+
+    ws_assert(prefix_len > 0);
+
+    if (trie->root == NULL) {
+        trie->root = wmem_new0(addr_resolv_scope, prefix_trie_node_t);
+    }
+    node = trie->root;
+
+    for (level = 0; prefix_len > (level + 1) * PREFIX_TRIE_STRIDE; level++) {
+        i = prefix_trie_index(key, level);
+        if (node->child[i] == NULL) {
+            node->child[i] = wmem_new0(addr_resolv_scope, prefix_trie_node_t);
+        }
+        node = node->child[i];
+    }
+
+    /* The slots covered by the bits of the prefix at this level */
+    count = 1 << ((level + 1) * PREFIX_TRIE_STRIDE - prefix_len);
+    first = prefix_trie_index(key, level) & ~(count - 1);
+
+    /* The same prefix may have been added before. Its entry can have been
+     * replaced by longer prefixes in some of its slots, so look in all of
+     * them. The one entry is shared by every slot it's in, so replacing its
+     * data replaces it everywhere. (If longer prefixes have replaced it in
+     * all of its slots, lookups can't find it, and it isn't found here
+     * either.) */
+    for (i = first; i < first + count; i++) {
+        entry = node->entry[i];
+        if (entry != NULL && entry->prefix_len == prefix_len) {
+            if (replace) {
+                entry->data = data;
+            }
+            return replace;
+        }
+    }
+
+    entry = wmem_new(addr_resolv_scope, prefix_trie_entry_t);
+    entry->data = data;
+    entry->prefix_len = prefix_len;
+    entry->next = trie->entries;
+    trie->entries = entry;
+
+    for (i = first; i < first + count; i++) {
+        if (node->entry[i] == NULL || node->entry[i]->prefix_len < prefix_len) {
+            node->entry[i] = entry;
+        }
+    }
+    return TRUE;
+}
+
+/* Find the longest prefix matching a key of key_len bits. */
+static void *
+prefix_trie_lookup(const prefix_trie_t *trie, const guint8 *key, guint key_len, guint *prefix_len)
+{
+    const prefix_trie_node_t *node = trie->root;
+    const prefix_trie_entry_t *best = NULL;
+    guint level, i;
+
+    for (level = 0; node != NULL && level < key_len / PREFIX_TRIE_STRIDE; level++) {
+        i = prefix_trie_index(key, level);
+        if (node->entry[i] != NULL) {
+            best = node->entry[i];
+        }
+        node = node->child[i];
+    }
+
+    if (best == NULL) {
+        *prefix_len = 0;
+        return NULL;
+    }
+    *prefix_len = best->prefix_len;
+    return best->data;
+}
+
+static void
+prefix_trie_node_free(prefix_trie_node_t *node)
+{
+    for (guint i = 0; i < PREFIX_TRIE_FANOUT; i++) {
+        if (node->child[i] != NULL) {
+            prefix_trie_node_free(node->child[i]);
+        }
+    }
+    wmem_free(addr_resolv_scope, node);
+}
+
+static void
+prefix_trie_free(prefix_trie_t *trie, gboolean free_data)
+{
+    prefix_trie_entry_t *entry, *next_entry;
+
+    if (trie->root != NULL) {
+        prefix_trie_node_free(trie->root);
+        trie->root = NULL;
+    }
+    for (entry = trie->entries; entry != NULL; entry = next_entry) {
+        next_entry = entry->next;
+        if (free_data) {
+            wmem_free(addr_resolv_scope, entry->data);
+        }
+        wmem_free(addr_resolv_scope, entry);
+    }
+    trie->entries = NULL;
+}
+
 
 /*
  *  Local function definitions
@@ -1107,6 +1286,7 @@ c_ares_ghba_cb(void *arg, int status, int timeouts _U_, struct hostent *he) {
                     break;
             }
         }
+        dns_cache_record(caqm->family, &caqm->addr, he->h_name);
     }
     wmem_free(addr_resolv_scope, caqm);
 }
@@ -1123,21 +1303,43 @@ new_ipv4(const guint addr)
     return tp;
 }
 
+static void
+async_dns_queue_ipv4(const guint addr)
+{
+    async_dns_queue_msg_t *caqm;
+
+    caqm = wmem_new(addr_resolv_scope, async_dns_queue_msg_t);
+    caqm->family = AF_INET;
+    caqm->addr.ip4 = addr;
+    wmem_list_append(async_dns_queue_head, (gpointer) caqm);
+}
+
+/* Find or create the entry for an address. */
 static hashipv4_t *
-host_lookup(const guint addr)
+host_lookup_entry(const guint addr)
 {
-    hashipv4_t * volatile tp;
+    hashipv4_t *tp;
 
     tp = (hashipv4_t *)wmem_map_lookup(ipv4_hash_table, GUINT_TO_POINTER(addr));
     if (tp == NULL) {
-        /*
-         * We don't already have an entry for this host name; create one,
-         * and then try to resolve it.
-         */
         tp = new_ipv4(addr);
         fill_dummy_ip4(addr, tp);
         wmem_map_insert(ipv4_hash_table, GUINT_TO_POINTER(addr), tp);
-    } else if (tp->flags & TRIED_OR_RESOLVED_MASK) {
+    }
+    return tp;
+}
+
+static hashipv4_t *
+host_lookup(const guint addr)
+{
+    hashipv4_t * volatile tp;
+
+    /*
+     * If we don't already have an entry for this host name, create one,
+     * and then try to resolve it.
+     */
+    tp = host_lookup_entry(addr);
+    if (tp->flags & TRIED_OR_RESOLVED_MASK) {
         return tp;
     }
 
@@ -1167,12 +1369,7 @@ host_lookup(const guint addr)
                  * allow at least one asynchronous request in flight;
                  * post an asynchronous request.
                  */
-                async_dns_queue_msg_t *caqm;
-
-                caqm = wmem_new(addr_resolv_scope, async_dns_queue_msg_t);
-                caqm->family = AF_INET;
-                caqm->addr.ip4 = addr;
-                wmem_list_append(async_dns_queue_head, (gpointer) caqm);
+                async_dns_queue_ipv4(addr);
             }
         }
     }
@@ -1193,18 +1390,25 @@ new_ipv6(const ws_in6_addr *addr)
     return tp;
 }
 
-/* ------------------------------------ */
+static void
+async_dns_queue_ipv6(const ws_in6_addr *addr)
+{
+    async_dns_queue_msg_t *caqm;
+
+    caqm = wmem_new(addr_resolv_scope, async_dns_queue_msg_t);
+    caqm->family = AF_INET6;
+    memcpy(&caqm->addr.ip6, addr, sizeof(caqm->addr.ip6));
+    wmem_list_append(async_dns_queue_head, (gpointer) caqm);
+}
+
+/* Find or create the entry for an address. */
 static hashipv6_t *
-host_lookup6(const ws_in6_addr *addr)
+host_lookup6_entry(const ws_in6_addr *addr)
 {
-    hashipv6_t * volatile tp;
+    hashipv6_t *tp;
 
     tp = (hashipv6_t *)wmem_map_lookup(ipv6_hash_table, addr);
     if (tp == NULL) {
-        /*
-         * We don't already have an entry for this host name; create one,
-         * and then try to resolve it.
-         */
         ws_in6_addr *addr_key;
 
         addr_key = wmem_new(addr_resolv_scope, ws_in6_addr);
@@ -1212,7 +1416,22 @@ host_lookup6(const ws_in6_addr *addr)
         memcpy(addr_key, addr, 16);
         fill_dummy_ip6(tp);
         wmem_map_insert(ipv6_hash_table, addr_key, tp);
-    } else if (tp->flags & TRIED_OR_RESOLVED_MASK) {
+    }
+    return tp;
+}
+
+/* ------------------------------------ */
+static hashipv6_t *
+host_lookup6(const ws_in6_addr *addr)
+{
+    hashipv6_t * volatile tp;
+
+    /*
+     * If we don't already have an entry for this host name, create one,
+     * and then try to resolve it.
+     */
+    tp = host_lookup6_entry(addr);
+    if (tp->flags & TRIED_OR_RESOLVED_MASK) {
         return tp;
     }
 
@@ -1242,12 +1461,7 @@ host_lookup6(const ws_in6_addr *addr)
                  * allow at least one asynchronous request in flight;
                  * post an asynchronous request.
                  */
-                async_dns_queue_msg_t *caqm;
-
-                caqm = wmem_new(addr_resolv_scope, async_dns_queue_msg_t);
-                caqm->family = AF_INET6;
-                memcpy(&caqm->addr.ip6, addr, sizeof(caqm->addr.ip6));
-                wmem_list_append(async_dns_queue_head, (gpointer) caqm);
+                async_dns_queue_ipv6(addr);
             }
         }
     }
@@ -1633,14 +1847,17 @@ manuf_hash_new_entry(const guint8 *addr, const char* name, const char* longname)
 }
 
 static void
-wka_hash_new_entry(const guint8 *addr, char* name)
+wka_hash_new_entry(const guint8 *addr, unsigned int mask, char* name)
 {
     guint8 *wka_key;
+    gchar *wka_name;
 
     wka_key = (guint8 *)wmem_alloc(addr_resolv_scope, 6);
     memcpy(wka_key, addr, 6);
+    wka_name = wmem_strdup(addr_resolv_scope, name);
 
-    wmem_map_insert(wka_hashtable, wka_key, wmem_strdup(addr_resolv_scope, name));
+    wmem_map_insert(wka_hashtable, wka_key, wka_name);
+    prefix_trie_insert(&wka_trie, addr, mask, wka_name, TRUE);
 }
 
 static void
@@ -1660,7 +1877,7 @@ add_manuf_name(const guint8 *addr, unsigned int mask, gchar *name, gchar *longna
 
     default:
         /* This is a range of well-known addresses; add it to the well-known-address table */
-        wka_hash_new_entry(addr, name);
+        wka_hash_new_entry(addr, mask, name);
         break;
     }
 } /* add_manuf_name */
@@ -1716,32 +1933,29 @@ manuf_name_lookup(const guint8 *addr, size_t size)
 
 } /* manuf_name_lookup */
 
+/* Find the longest well-known address range containing addr. */
 static gchar *
-wka_name_lookup(const guint8 *addr, const unsigned int mask)
+wka_name_lookup(const guint8 *addr, unsigned int *mask)
 {
-    guint8     masked_addr[6];
-    guint      num;
-    gint       i;
-    gchar     *name;
-
-    if (wka_hashtable == NULL) {
-        return NULL;
-    }
-    /* Get the part of the address covered by the mask. */
-    for (i = 0, num = mask; num >= 8; i++, num -= 8)
-        masked_addr[i] = addr[i];   /* copy octets entirely covered by the mask */
-    /* Mask out the first masked octet */
-    masked_addr[i] = addr[i] & (0xFF << (8 - num));
-    i++;
-    /* Zero out completely-masked-out octets */
-    for (; i < 6; i++)
-        masked_addr[i] = 0;
+    return (gchar *)prefix_trie_lookup(&wka_trie, addr, 48, mask);
 
-    name = (gchar *)wmem_map_lookup(wka_hashtable, masked_addr);
+} /* wka_name_lookup */
 
-    return name;
+/* Name an address in a well-known range: the range name followed by the
+ * bits of the address not covered by the mask. */
+static void
+wka_name_format(hashether_t *tp, const gchar *name, unsigned int mask)
+{
+    const guint8 *addr = tp->addr;
+    guint i = mask / 8;
+    int len;
 
-} /* wka_name_lookup */
+    len = snprintf(tp->resolved_name, MAXNAMELEN, "%s_%02x", name, addr[i] & (0xFF >> (mask % 8)));
+    for (i++; i < 6 && len > 0 && len < MAXNAMELEN; i++) {
+        len += snprintf(tp->resolved_name + len, MAXNAMELEN - len, ":%02x", addr[i]);
+    }
+    tp->status = HASHETHER_STATUS_RESOLVED_DUMMY;
+}
 
 
 guint get_hash_ether_status(hashether_t* ether)
@@ -1848,6 +2062,7 @@ initialize_ethers(void)
 static void
 ethers_cleanup(void)
 {
+    prefix_trie_free(&wka_trie, FALSE);
     wka_hashtable = NULL;
     manuf_hashtable = NULL;
     eth_hashtable = NULL;
@@ -1880,40 +2095,14 @@ eth_addr_resolve(hashether_t *tp) {
         gchar        *name;
         address       ether_addr;
 
-        /* Unknown name.  Try looking for it in the well-known-address
-           tables for well-known address ranges smaller than 2^24. */
-        mask = 7;
-        do {
-            /* Only the topmost 5 bytes participate fully */
-            if ((name = wka_name_lookup(addr, mask+40)) != NULL) {
-                snprintf(tp->resolved_name, MAXNAMELEN, "%s_%02x",
-                        name, addr[5] & (0xFF >> mask));
-                tp->status = HASHETHER_STATUS_RESOLVED_DUMMY;
-                return tp;
-            }
-        } while (mask--);
-
-        mask = 7;
-        do {
-            /* Only the topmost 4 bytes participate fully */
-            if ((name = wka_name_lookup(addr, mask+32)) != NULL) {
-                snprintf(tp->resolved_name, MAXNAMELEN, "%s_%02x:%02x",
-                        name, addr[4] & (0xFF >> mask), addr[5]);
-                tp->status = HASHETHER_STATUS_RESOLVED_DUMMY;
-                return tp;
-            }
-        } while (mask--);
-
-        mask = 7;
-        do {
-            /* Only the topmost 3 bytes participate fully */
-            if ((name = wka_name_lookup(addr, mask+24)) != NULL) {
-                snprintf(tp->resolved_name, MAXNAMELEN, "%s_%02x:%02x:%02x",
-                        name, addr[3] & (0xFF >> mask), addr[4], addr[5]);
-                tp->status = HASHETHER_STATUS_RESOLVED_DUMMY;
-                return tp;
-            }
-        } while (mask--);
+        /* Unknown name.  Look for the longest well-known address range
+           containing it, preferring ranges smaller than 2^24 to the
+           manufacturer table. */
+        name = wka_name_lookup(addr, &mask);
+        if (name != NULL && mask >= 24) {
+            wka_name_format(tp, name, mask);
+            return tp;
+        }
 
         /* Now try looking in the manufacturer table. */
         manuf_value = manuf_name_lookup(addr, addr_size);
@@ -1924,43 +2113,11 @@ eth_addr_resolve(hashether_t *tp) {
             return tp;
         }
 
-        /* Now try looking for it in the well-known-address
-           tables for well-known address ranges larger than 2^24. */
-        mask = 7;
-        do {
-            /* Only the topmost 2 bytes participate fully */
-            if ((name = wka_name_lookup(addr, mask+16)) != NULL) {
-                snprintf(tp->resolved_name, MAXNAMELEN, "%s_%02x:%02x:%02x:%02x",
-                        name, addr[2] & (0xFF >> mask), addr[3], addr[4],
-                        addr[5]);
-                tp->status = HASHETHER_STATUS_RESOLVED_DUMMY;
-                return tp;
-            }
-        } while (mask--);
-
-        mask = 7;
-        do {
-            /* Only the topmost byte participates fully */
-            if ((name = wka_name_lookup(addr, mask+8)) != NULL) {
-                snprintf(tp->resolved_name, MAXNAMELEN, "%s_%02x:%02x:%02x:%02x:%02x",
-                        name, addr[1] & (0xFF >> mask), addr[2], addr[3],
-                        addr[4], addr[5]);
-                tp->status = HASHETHER_STATUS_RESOLVED_DUMMY;
-                return tp;
-            }
-        } while (mask--);
-
-        mask = 7;
-        do {
-            /* Not even the topmost byte participates fully */
-            if ((name = wka_name_lookup(addr, mask)) != NULL) {
-                snprintf(tp->resolved_name, MAXNAMELEN, "%s_%02x:%02x:%02x:%02x:%02x:%02x",
-                        name, addr[0] & (0xFF >> mask), addr[1], addr[2],
-                        addr[3], addr[4], addr[5]);
-                tp->status = HASHETHER_STATUS_RESOLVED_DUMMY;
-                return tp;
-            }
-        } while (--mask); /* Work down to the last bit */
+        /* Otherwise use a well-known address range larger than 2^24. */
+        if (name != NULL) {
+            wka_name_format(tp, name, mask);
+            return tp;
+        }
 
         /* No match whatsoever. */
         set_address(&ether_addr, AT_ETHER, 6, addr);
@@ -2415,6 +2572,95 @@ read_hosts_file (const char *hostspath, gboolean store_entries)
     return entry_found ? TRUE : FALSE;
 } /* read_hosts_file */
 
+/*
+ * Read the names saved from earlier DNS lookups. Each line has the form
+ * <address> <host name> <expiration time in seconds since the Epoch>.
+ */
+static void
+read_dns_cache_file(const char *cachepath)
+{
+    FILE *cf;
+    char line[MAX_LINELEN];
+    gchar *addr_str, *name, *cp;
+    union {
+        guint32 ip4_addr;
+        ws_in6_addr ip6_addr;
+    } host_addr;
+    int64_t expires, now = (int64_t)time(NULL);
+
+    if ((cf = ws_fopen(cachepath, "r")) == NULL)
+        return;
+
+    while (fgetline(line, sizeof(line), cf) >= 0) {
+        if ((cp = strchr(line, '#')))
+            *cp = '\0';
+
+        if ((addr_str = strtok(line, " \t")) == NULL)
+            continue;
+        if ((name = strtok(NULL, " \t")) == NULL)
+            continue;
+        if ((cp = strtok(NULL, " \t")) == NULL || !ws_strtoi64(cp, NULL, &expires))
+            continue;
+        if (expires <= now)
+            continue;
+
+        if (ws_inet_pton6(addr_str, &host_addr.ip6_addr)) {
+            add_ipv6_name(&host_addr.ip6_addr, name, FALSE);
+        } else if (ws_inet_pton4(addr_str, &host_addr.ip4_addr)) {
+            add_ipv4_name(host_addr.ip4_addr, name, FALSE);
+        } else {
+            continue;
+        }
+        dns_cache_add(addr_str, name, expires);
+    }
+
+    fclose(cf);
+} /* read_dns_cache_file */
+
+static void
+write_dns_cache_entry(gpointer key, gpointer value, gpointer user_data)
+{
+    const dns_cache_entry_t *entry = (const dns_cache_entry_t *)value;
+    FILE *cf = (FILE *)user_data;
+
+    if (entry->expires > (gint64)time(NULL)) {
+        fprintf(cf, "%s\t%s\t%" G_GINT64_FORMAT "\n", (const char *)key, entry->name, entry->expires);
+    }
+}
+
+static void
+write_dns_cache_file(void)
+{
+    char *pf_dir_path;
+    char *cachepath;
+    FILE *cf;
+
+    if (!dns_cache_changed || dns_cache_table == NULL)
+        return;
+    dns_cache_changed = FALSE;
+
+    if (create_persconffile_dir(&pf_dir_path) == -1) {
+        ws_warning("Can't create directory \"%s\" for the DNS cache: %s",
+                pf_dir_path, g_strerror(errno));
+        g_free(pf_dir_path);
+        return;
+    }
+
+    cachepath = get_persconffile_path(ENAME_DNS_CACHE, FALSE);
+    if ((cf = ws_fopen(cachepath, "w")) == NULL) {
+        ws_warning("Can't write the DNS cache \"%s\": %s", cachepath, g_strerror(errno));
+        g_free(cachepath);
+        return;
+    }
+
+    fputs("# This file is automatically generated, DO NOT MODIFY.\n", cf);
+    fputs("# Host names resolved via DNS: <address> <name> <expiration time>\n", cf);
+    wmem_map_foreach(dns_cache_table, write_dns_cache_entry, cf);
+
+    fclose(cf);
+    g_free(cachepath);
+} /* write_dns_cache_file */
+
 gboolean
 add_hosts_file (const char *hosts_file)
 {
@@ -2622,47 +2868,18 @@ static subnet_entry_t
 subnet_lookup(const guint32 addr)
 {
     subnet_entry_t subnet_entry;
-    guint32 i;
-
-    /* Search mask lengths linearly, longest first */
-
-    i = SUBNETLENGTHSIZE;
-    while(have_subnet_entry && i > 0) {
-        guint32 masked_addr;
-        subnet_length_entry_t* length_entry;
-
-        /* Note that we run from 31 (length 32)  to 0 (length 1)  */
-        --i;
-        ws_assert(i < SUBNETLENGTHSIZE);
-
-
-        length_entry = &subnet_length_entries[i];
-
-        if (NULL != length_entry->subnet_addresses) {
-            sub_net_hashipv4_t * tp;
-            guint32 hash_idx;
+    guint prefix_len;
 
-            masked_addr = addr & length_entry->mask;
-            hash_idx = HASH_IPV4_ADDRESS(masked_addr);
-
-            tp = length_entry->subnet_addresses[hash_idx];
-            while(tp != NULL && tp->addr != masked_addr) {
-                tp = tp->next;
-            }
-
-            if (NULL != tp) {
-                subnet_entry.mask = length_entry->mask;
-                subnet_entry.mask_length = i + 1; /* Length is offset + 1 */
-                subnet_entry.name = tp->name;
-                return subnet_entry;
-            }
-        }
+    /* addr is in network byte order, so its bytes are in prefix order */
+    subnet_entry.name = (const gchar *)prefix_trie_lookup(&subnet_trie, (const guint8 *)&addr, 32, &prefix_len);
+    if (subnet_entry.name == NULL) {
+        subnet_entry.mask = 0;
+        subnet_entry.mask_length = 0;
+        return subnet_entry;
     }
 
-    subnet_entry.mask = 0;
-    subnet_entry.mask_length = 0;
-    subnet_entry.name = NULL;
-
+    subnet_entry.mask = g_htonl(ws_ipv4_get_subnet_mask(prefix_len));
+    subnet_entry.mask_length = prefix_len;
     return subnet_entry;
 }
 
@@ -2673,59 +2890,21 @@ subnet_lookup(const guint32 addr)
 static void
 subnet_entry_set(guint32 subnet_addr, const guint8 mask_length, const gchar* name)
 {
-    subnet_length_entry_t* entry;
-    sub_net_hashipv4_t * tp;
-    gsize hash_idx;
+    gchar *subnet_name;
 
     ws_assert(mask_length > 0 && mask_length <= 32);
 
-    entry = &subnet_length_entries[mask_length - 1];
-
-    subnet_addr &= entry->mask;
-
-    hash_idx = HASH_IPV4_ADDRESS(subnet_addr);
-
-    if (NULL == entry->subnet_addresses) {
-        entry->subnet_addresses = (sub_net_hashipv4_t**)wmem_alloc0(addr_resolv_scope, sizeof(sub_net_hashipv4_t*) * HASHHOSTSIZE);
+    subnet_name = wmem_strndup(addr_resolv_scope, name, MAXNAMELEN - 1); /* This is longer than subnet names can actually be */
+    if (!prefix_trie_insert(&subnet_trie, (const guint8 *)&subnet_addr, mask_length, subnet_name, FALSE)) {
+        /* XXX provide warning that an address was repeated? */
+        wmem_free(addr_resolv_scope, subnet_name);
     }
-
-    if (NULL != (tp = entry->subnet_addresses[hash_idx])) {
-        sub_net_hashipv4_t * new_tp;
-
-        while (tp->next) {
-            if (tp->addr == subnet_addr) {
-                return; /* XXX provide warning that an address was repeated? */
-            } else {
-                tp = tp->next;
-            }
-        }
-
-        new_tp = wmem_new(addr_resolv_scope, sub_net_hashipv4_t);
-        tp->next = new_tp;
-        tp = new_tp;
-    } else {
-        tp = entry->subnet_addresses[hash_idx] = wmem_new(addr_resolv_scope, sub_net_hashipv4_t);
-    }
-
-    tp->next = NULL;
-    tp->addr = subnet_addr;
-    (void) g_strlcpy(tp->name, name, MAXNAMELEN); /* This is longer than subnet names can actually be */
-    have_subnet_entry = TRUE;
 }
 
 static void
 subnet_name_lookup_init(void)
 {
     gchar* subnetspath;
-    guint32 i;
-
-    for(i = 0; i < SUBNETLENGTHSIZE; ++i) {
-        guint32 length = i + 1;
-
-        subnet_length_entries[i].subnet_addresses  = NULL;
-        subnet_length_entries[i].mask_length  = length;
-        subnet_length_entries[i].mask = g_htonl(ws_ipv4_get_subnet_mask(length));
-    }
 
     /* Check profile directory before personal configuration */
     subnetspath = get_persconffile_path(ENAME_SUBNETS, TRUE);
@@ -2978,6 +3157,28 @@ addr_resolve_pref_init(module_t *nameres)
             10,
             &name_resolve_concurrency);
 
+    prefs_register_bool_preference(nameres, "name_resolve_prefetch",
+            "Look up all addresses after reading a file",
+            "After a capture file has been read, send reverse DNS"
+            " requests for every IPv4 and IPv6 address in its"
+            " conversations at once instead of as they are"
+            " displayed.",
+            &name_resolve_prefetch);
+
+    prefs_register_bool_preference(nameres, "name_resolve_cache",
+            "Save resolved names",
+            "Save names resolved via DNS in the \"" ENAME_DNS_CACHE "\""
+            " file in the personal configuration directory and"
+            " use them the next time a capture file is opened.",
+            &name_resolve_cache);
+
+    prefs_register_uint_preference(nameres, "name_resolve_cache_ttl",
+            "Saved name lifetime",
+            "The number of seconds saved names are used before"
+            " they are looked up again.",
+            10,
+            &name_resolve_cache_ttl);
+
     prefs_register_obsolete_preference(nameres, "hosts_file_handling");
 
     prefs_register_bool_preference(nameres, "vlan_name",
@@ -3014,39 +3215,47 @@ disable_name_resolution(void) {
     gbl_resolv_flags.maxmind_geoip                      = FALSE;
 }
 
-gboolean
-host_name_lookup_process(void) {
+/* Send queued requests, up to name_resolve_concurrency in flight. */
+static void
+async_dns_send_queued(void) {
     async_dns_queue_msg_t *caqm;
-    struct timeval tv = { 0, 0 };
-    int nfds;
-    fd_set rfds, wfds;
-    gboolean nro = new_resolved_objects;
     wmem_list_frame_t* head;
 
-    new_resolved_objects = FALSE;
-    nro |= maxmind_db_lookup_process();
-
-    if (!async_dns_initialized)
-        /* c-ares not initialized. Bail out and cancel timers. */
-        return nro;
-
     head = wmem_list_head(async_dns_queue_head);
 
     while (head != NULL && async_dns_in_flight <= name_resolve_concurrency) {
         caqm = (async_dns_queue_msg_t *)wmem_list_frame_data(head);
         wmem_list_remove_frame(async_dns_queue_head, head);
+        /* The callback may be called before ares_gethostbyaddr returns. */
         if (caqm->family == AF_INET) {
+            async_dns_in_flight++;
             ares_gethostbyaddr(ghba_chan, &caqm->addr.ip4, sizeof(guint32), AF_INET,
                     c_ares_ghba_cb, caqm);
-            async_dns_in_flight++;
         } else if (caqm->family == AF_INET6) {
+            async_dns_in_flight++;
             ares_gethostbyaddr(ghba_chan, &caqm->addr.ip6, sizeof(ws_in6_addr),
                     AF_INET6, c_ares_ghba_cb, caqm);
-            async_dns_in_flight++;
         }
 
         head = wmem_list_head(async_dns_queue_head);
     }
+}
+
+gboolean
+host_name_lookup_process(void) {
+    struct timeval tv = { 0, 0 };
+    int nfds;
+    fd_set rfds, wfds;
+    gboolean nro = new_resolved_objects;
+
+    new_resolved_objects = FALSE;
+    nro |= maxmind_db_lookup_process();
+
+    if (!async_dns_initialized)
+        /* c-ares not initialized. Bail out and cancel timers. */
+        return nro;
+
+    async_dns_send_queued();
 
     FD_ZERO(&rfds);
     FD_ZERO(&wfds);
@@ -3065,6 +3274,96 @@ host_name_lookup_process(void) {
     return nro;
 }
 
+void
+host_name_lookup_wait(void) {
+    struct timeval tv, *tvp;
+    int nfds;
+    fd_set rfds, wfds;
+
+    if (!async_dns_initialized)
+        return;
+
+    for (;;) {
+        async_dns_send_queued();
+        if (async_dns_in_flight == 0)
+            break;
+
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        nfds = ares_fds(ghba_chan, &rfds, &wfds);
+        if (nfds == 0)
+            break;
+        tvp = ares_timeout(ghba_chan, NULL, &tv);
+        if (select(nfds, &rfds, &wfds, NULL, tvp) == -1) { /* call to select() failed */
+            /* If it's interrupted by a signal, no need to put out a message */
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "Warning: call to select() failed, error is %s\n", g_strerror(errno));
+            break;
+        }
+        ares_process(ghba_chan, &rfds, &wfds);
+    }
+}
+
+static void
+prefetch_conversation_addresses(gpointer key, gpointer value _U_, gpointer user_data)
+{
+    const conversation_element_t *elements = (const conversation_element_t *)key;
+    guint *queued = (guint *)user_data;
+
+    for (; elements->type != CE_CONVERSATION_TYPE; elements++) {
+        const address *addr = &elements->addr_val;
+
+        if (elements->type != CE_ADDRESS)
+            continue;
+
+        if (addr->type == AT_IPv4) {
+            guint32 ip4;
+            hashipv4_t *tp;
+
+            memcpy(&ip4, addr->data, sizeof(ip4));
+            tp = host_lookup_entry(ip4);
+            if (!(tp->flags & TRIED_OR_RESOLVED_MASK)) {
+                tp->flags |= TRIED_RESOLVE_ADDRESS;
+                async_dns_queue_ipv4(ip4);
+                (*queued)++;
+            }
+        } else if (addr->type == AT_IPv6) {
+            hashipv6_t *tp;
+
+            tp = host_lookup6_entry((const ws_in6_addr *)addr->data);
+            if (!(tp->flags & TRIED_OR_RESOLVED_MASK)) {
+                tp->flags |= TRIED_RESOLVE_ADDRESS;
+                async_dns_queue_ipv6((const ws_in6_addr *)addr->data);
+                (*queued)++;
+            }
+        }
+    }
+}
+
+static void
+prefetch_conversation_table(gpointer key _U_, gpointer value, gpointer user_data)
+{
+    wmem_map_foreach((wmem_map_t *)value, prefetch_conversation_addresses, user_data);
+}
+
+guint
+host_name_lookup_prefetch(void) {
+    wmem_map_t *conversation_tables;
+    guint queued = 0;
+
+    if (!name_resolve_prefetch || !gbl_resolv_flags.network_name ||
+            !gbl_resolv_flags.use_external_net_name_resolver || !async_dns_initialized)
+        return 0;
+
+    conversation_tables = get_conversation_hashtables();
+    if (conversation_tables == NULL)
+        return 0;
+
+    wmem_map_foreach(conversation_tables, prefetch_conversation_table, &queued);
+    return queued;
+}
+
 static void
 _host_name_lookup_cleanup(void) {
     async_dns_queue_head = NULL;
@@ -3246,6 +3545,17 @@ host_name_lookup_init(void)
         report_open_failure(hostspath, errno, FALSE);
     }
     g_free(hostspath);
+
+    /*
+     * Load the names we saved from earlier DNS lookups.
+     */
+    ws_assert(dns_cache_table == NULL);
+    dns_cache_table = wmem_map_new(addr_resolv_scope, wmem_str_hash, g_str_equal);
+    if (name_resolve_cache && gbl_resolv_flags.use_external_net_name_resolver) {
+        hostspath = get_persconffile_path(ENAME_DNS_CACHE, FALSE);
+        read_dns_cache_file(hostspath);
+        g_free(hostspath);
+    }
 #ifdef CARES_HAVE_ARES_LIBRARY_INIT
     if (ares_library_init(ARES_LIB_INIT_ALL) == ARES_SUCCESS) {
 #endif
@@ -3273,31 +3583,17 @@ host_name_lookup_init(void)
 static void
 host_name_lookup_cleanup(void)
 {
-    guint32 i, j;
-    sub_net_hashipv4_t *entry, *next_entry;
-
     _host_name_lookup_cleanup();
 
+    write_dns_cache_file();
+    dns_cache_table = NULL;
+
     ipxnet_hash_table = NULL;
     ipv4_hash_table = NULL;
     ipv6_hash_table = NULL;
     ss7pc_hash_table = NULL;
 
-    for(i = 0; i < SUBNETLENGTHSIZE; ++i) {
-        if (subnet_length_entries[i].subnet_addresses != NULL) {
-            for (j = 0; j < HASHHOSTSIZE; j++) {
-                for (entry = subnet_length_entries[i].subnet_addresses[j];
-                     entry != NULL; entry = next_entry) {
-                    next_entry = entry->next;
-                    wmem_free(addr_resolv_scope, entry);
-                }
-            }
-            wmem_free(addr_resolv_scope, subnet_length_entries[i].subnet_addresses);
-            subnet_length_entries[i].subnet_addresses = NULL;
-        }
-    }
-
-    have_subnet_entry = FALSE;
+    prefix_trie_free(&subnet_trie, TRUE);
     new_resolved_objects = FALSE;
 }
 
@@ -195,6 +195,20 @@ WS_DLL_PUBLIC void disable_name_resolution(void);
  */
 WS_DLL_PUBLIC gboolean host_name_lookup_process(void);
 
+/** Send reverse DNS requests for every IPv4 and IPv6 address in the
+ *  current file's conversations that hasn't been looked up yet. This
+ *  is meant to be called once after a file has been read, and does
+ *  nothing unless the "name_resolve_prefetch" preference is set.
+ *
+ * @return The number of requests queued.
+ */
+WS_DLL_PUBLIC guint host_name_lookup_prefetch(void);
+
+/** Block until all outstanding asynchronous host name lookups have
+ *  completed or timed out.
+ */
+WS_DLL_PUBLIC void host_name_lookup_wait(void);
+
 /* get_hostname returns the host name or "%d.%d.%d.%d" if not found */
 WS_DLL_PUBLIC const gchar *get_hostname(const guint addr);
 
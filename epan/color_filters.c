@@ -48,6 +48,11 @@ static GSList *color_filter_list = NULL;
 static GSList *color_filter_deleted_list = NULL;
 static GSList *color_filter_valid_list   = NULL;
 
+/* the enabled filters of color_filter_list, evaluated together;
+ * rebuilt on demand after the list or one of its filters changes */
+static dfilter_set_t *color_filter_set = NULL;
+static GPtrArray *color_filter_set_filters = NULL;
+
 /* Color Filters can en-/disabled. */
 static gboolean filters_enabled = TRUE;
 
@@ -56,6 +61,17 @@ static gboolean filters_enabled = TRUE;
  */
 static gboolean tmp_colors_set = FALSE;
 
+static void
+color_filter_set_invalidate(void)
+{
+    dfilter_set_free(color_filter_set);
+    color_filter_set = NULL;
+    if (color_filter_set_filters) {
+        g_ptr_array_free(color_filter_set_filters, TRUE);
+        color_filter_set_filters = NULL;
+    }
+}
+
 /* Create a new filter */
 color_filter_t *
 color_filter_new(const gchar *name,          /* The name of the filter to create */
@@ -159,6 +175,9 @@ color_filters_set_tmp(guint8 filt_nr, const gchar *filter, gboolean disabled, gc
     dfilter_t      *compiled_filter;
     guint8         i;
     df_error_t     *df_err = NULL;
+
+    color_filter_set_invalidate();
+
     /* Go through the temporary filters and look for the same filter string.
      * If found, clear it so that a filter can be "moved" up and down the list
      */
@@ -305,6 +324,8 @@ color_filters_get(gchar** err_msg, color_filter_add_cb_func add_cb)
     FILE     *f;
     int       ret;
 
+    color_filter_set_invalidate();
+
     /* start the list with the temporary colorizing rules */
     color_filters_add_tmp(&color_filter_list);
 
@@ -351,6 +372,7 @@ gboolean
 color_filters_init(gchar** err_msg, color_filter_add_cb_func add_cb)
 {
     /* delete all currently existing filters */
+    color_filter_set_invalidate();
     color_filter_list_delete(&color_filter_list);
 
     /* now try to construct the filters list */
@@ -374,6 +396,8 @@ color_filters_cleanup(void)
 {
     /* delete the previously deleted filters */
     color_filter_list_delete(&color_filter_deleted_list);
+    /* and the filter set built from the current ones */
+    color_filter_set_invalidate();
 }
 
 typedef struct _color_clone
@@ -458,6 +482,8 @@ color_filters_apply(GSList *tmp_cfl, GSList *edit_cfl, gchar** err_msg)
 
     *err_msg = NULL;
 
+    color_filter_set_invalidate();
+
     /* "move" old entries to the deleted list
      * we must keep them until the dissection no longer needs them */
     color_filter_deleted_list = g_slist_concat(color_filter_deleted_list, color_filter_list);
@@ -565,26 +591,38 @@ color_filters_use_proto(int proto_id)
     return (item != NULL);
 }
 
+static void
+color_filter_set_build(void)
+{
+    GSList         *curr;
+    color_filter_t *colorf;
+
+    color_filter_set = dfilter_set_new();
+    color_filter_set_filters = g_ptr_array_new();
+
+    for (curr = color_filter_list; curr != NULL; curr = g_slist_next(curr)) {
+        colorf = (color_filter_t *)curr->data;
+        if ((!colorf->disabled) && (colorf->c_colorfilter != NULL)) {
+            dfilter_set_add(color_filter_set, colorf->c_colorfilter);
+            g_ptr_array_add(color_filter_set_filters, colorf);
+        }
+    }
+}
+
 /* * Return the color_t for later use */
 const color_filter_t *
 color_filters_colorize_packet(epan_dissect_t *edt)
 {
-    GSList         *curr;
-    color_filter_t *colorf;
+    int idx;
 
     /* If we have color filters, "search" for the matching one. */
     if ((edt->tree != NULL) && (color_filters_used())) {
-        curr = color_filter_list;
-
-        while(curr != NULL) {
-            colorf = (color_filter_t *)curr->data;
-            if ( (!colorf->disabled) &&
-                 (colorf->c_colorfilter != NULL) &&
-                 dfilter_apply_edt(colorf->c_colorfilter, edt)) {
-                return colorf;
-            }
-            curr = g_slist_next(curr);
-        }
+        if (color_filter_set == NULL)
+            color_filter_set_build();
+
+        idx = dfilter_set_apply_first_edt(color_filter_set, edt);
+        if (idx >= 0)
+            return (const color_filter_t *)g_ptr_array_index(color_filter_set_filters, idx);
     }
 
     return NULL;
@@ -286,8 +286,13 @@ reset_conversation_table_data(conv_hash_t *ch)
         g_hash_table_destroy(ch->hashtable);
     }
 
+    if (ch->conv_id_map != NULL) {
+        g_array_free(ch->conv_id_map, TRUE);
+    }
+
     ch->conv_array=NULL;
     ch->hashtable=NULL;
+    ch->conv_id_map=NULL;
 }
 
 void reset_endpoint_table_data(conv_hash_t *ch)
@@ -655,8 +660,34 @@ add_conversation_table_data_with_conv_id(
                                               conversation_equal, /* key_equal_func */
                                               g_free,             /* key_destroy_func */
                                               NULL);              /* value_destroy_func */
+        ch->conv_id_map = g_array_new(FALSE, TRUE, sizeof(guint32));
+
+    } else if (conv_id != CONV_ID_UNSET && conv_id < ch->conv_id_map->len) {
+        /*
+         * Dissectors pass their stream index as the conversation ID,
+         * which numbers conversations densely from 0, so look it up
+         * directly and only compare the addresses and ports.
+         */
+        guint32 conversation_idx = g_array_index(ch->conv_id_map, guint32, conv_id);
+
+        if (conversation_idx != 0) {
+            conv_item_t *item = &g_array_index(ch->conv_array, conv_item_t, conversation_idx - 1);
+
+            if (item->src_port == src_port && item->dst_port == dst_port &&
+                addresses_equal(&item->src_address, src) &&
+                addresses_equal(&item->dst_address, dst)) {
+                conv_item = item;
+                is_fwd_direction = TRUE;
+            } else if (item->src_port == dst_port && item->dst_port == src_port &&
+                addresses_equal(&item->src_address, dst) &&
+                addresses_equal(&item->dst_address, src)) {
+                conv_item = item;
+            }
+        }
+    }
 
-    } else { /* try to find it among the existing known conversations */
+    if (conv_item == NULL && ch->conv_array->len != 0) {
+        /* try to find it among the existing known conversations */
         /* first, check in the fwd conversations */
         conv_key_t existing_key;
         gpointer conversation_idx_hash_val;
@@ -729,6 +760,19 @@ add_conversation_table_data_with_conv_id(
         new_key->conv_id = conv_id;
         g_hash_table_insert(ch->hashtable, new_key, GUINT_TO_POINTER(conversation_idx));
 
+        /*
+         * Don't let a sparse conversation ID blow up the map; those
+         * conversations are still found through the hash table.
+         */
+        if (conv_id != CONV_ID_UNSET && conv_id < 2 * (guint64) ch->conv_array->len + 1024) {
+            if (conv_id >= ch->conv_id_map->len) {
+                g_array_set_size(ch->conv_id_map, conv_id + 1);
+            }
+            if (g_array_index(ch->conv_id_map, guint32, conv_id) == 0) {
+                g_array_index(ch->conv_id_map, guint32, conv_id) = conversation_idx + 1;
+            }
+        }
+
         /* update the conversation struct */
         conv_item->tx_frames_total += num_frames;
         conv_item->tx_bytes_total += num_bytes;
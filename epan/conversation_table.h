@@ -49,12 +49,15 @@ typedef enum {
 
 /** Conversation hash + value storage
  * Hash table keys are conv_key_t. Hash table values are indexes into conv_array.
+ * Conversations with a conv_id are also found through conv_id_map, which
+ * avoids hashing the addresses when conv_id is a dense stream index.
  */
 typedef struct _conversation_hash_t {
     GHashTable  *hashtable;       /**< conversations hash table */
     GArray      *conv_array;      /**< array of conversation values */
     void        *user_data;       /**< "GUI" specifics (if necessary) */
     guint       flags;            /**< flags given to the tap packet */
+    GArray      *conv_id_map;     /**< conv_array index + 1 of each conv_id, 0 if none (guint32) */
 } conv_hash_t;
 
 /** Key for hash lookups */
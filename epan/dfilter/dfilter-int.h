@@ -47,6 +47,7 @@ struct epan_dfilter {
 	/* Used to pass arguments to functions. List of Lists (list of registers). */
 	GSList		*function_stack;
 	GSList		*set_stack;
+	int		ref_count;
 };
 
 typedef struct {
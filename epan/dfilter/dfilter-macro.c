@@ -27,6 +27,7 @@
 static uat_t* dfilter_macro_uat = NULL;
 static dfilter_macro_t* macros = NULL;
 static unsigned num_macros;
+static unsigned macro_generation;
 
 /* #define DUMP_DFILTER_MACRO */
 #ifdef DUMP_DFILTER_MACRO
@@ -498,6 +499,11 @@ static void macro_post_update(void) {
 	for (unsigned i = 0; i < num_macros; i++) {
 		macro_parse(&macros[i]);
 	}
+	macro_generation++;
+}
+
+unsigned dfilter_macro_generation(void) {
+	return macro_generation;
 }
 
 static bool macro_name_chk(void *mp, const char *in_name, unsigned name_len,
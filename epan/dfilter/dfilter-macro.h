@@ -32,6 +32,9 @@ typedef struct _dfilter_macro_t {
 /* applies all macros to the given text and returns the resulting string or NULL on failure */
 char* dfilter_macro_apply(const char* text, df_error_t** error);
 
+/* returns a counter that changes whenever the macros are updated */
+unsigned dfilter_macro_generation(void);
+
 void dfilter_macro_init(void);
 
 struct epan_uat;
@@ -19,6 +19,7 @@
 #include "dfvm.h"
 #include <epan/epan_dissect.h>
 #include <epan/exceptions.h>
+#include <epan/prefs.h>
 #include "dfilter.h"
 #include "dfunctions.h"
 #include "dfilter-macro.h"
@@ -36,6 +37,25 @@ static void*	ParserObj = NULL;
 
 df_loc_t loc_empty = {-1, 0};
 
+/*
+ * Cache of compiled filters, in least recently used order. Entries are
+ * keyed by the text and compile flags. The whole cache is dropped when the
+ * macros, the registered fields or the preferences change, since any of
+ * those can change what a text compiles to.
+ */
+#define DFILTER_CACHE_SIZE	64
+
+typedef struct {
+	char		*key;
+	dfilter_t	*df;
+} dfilter_cache_entry_t;
+
+static GHashTable *dfilter_cache_table;	/* key -> GList link in dfilter_cache_lru */
+static GQueue dfilter_cache_lru = G_QUEUE_INIT;
+static unsigned dfilter_cache_macro_gen;
+static unsigned dfilter_cache_registrar_gen;
+static unsigned dfilter_cache_prefs_gen;
+
 void
 dfilter_vfail(void *state, int code, df_loc_t loc,
 				const char *format, va_list args)
@@ -124,6 +144,11 @@ dfilter_init(void)
 void
 dfilter_cleanup(void)
 {
+	dfilter_cache_clear();
+	if (dfilter_cache_table) {
+		g_hash_table_destroy(dfilter_cache_table);
+		dfilter_cache_table = NULL;
+	}
 	dfilter_plugins_cleanup();
 	dfilter_macro_cleanup();
 	df_func_cleanup();
@@ -143,6 +168,7 @@ dfilter_new(GPtrArray *deprecated)
 	dfilter_t	*df;
 
 	df = g_new0(dfilter_t, 1);
+	df->ref_count = 1;
 	df->insns = NULL;
 	df->function_stack = NULL;
 	df->set_stack = NULL;
@@ -167,12 +193,24 @@ free_insns(GPtrArray *insns)
 	g_ptr_array_free(insns, true);
 }
 
+dfilter_t *
+dfilter_ref(dfilter_t *df)
+{
+	if (df)
+		df->ref_count++;
+	return df;
+}
+
 void
 dfilter_free(dfilter_t *df)
 {
 	if (!df)
 		return;
 
+	ws_assert(df->ref_count > 0);
+	if (--df->ref_count > 0)
+		return;
+
 	if (df->insns) {
 		free_insns(df->insns);
 	}
@@ -327,6 +365,7 @@ const char *tokenstr(int token)
 		case TOKEN_TEST_GT:	return "TEST_GT";
 		case TOKEN_TEST_GE:	return "TEST_GE";
 		case TOKEN_TEST_CONTAINS: return "TEST_CONTAINS";
+		case TOKEN_TEST_CONTAINS_ANY: return "TEST_CONTAINS_ANY";
 		case TOKEN_TEST_MATCHES: return "TEST_MATCHES";
 		case TOKEN_BITWISE_AND: return "BITWISE_AND";
 		case TOKEN_PLUS:	return "PLUS";
@@ -587,6 +626,104 @@ FAILURE:
 	return NULL;
 }
 
+static void
+dfilter_cache_entry_free(dfilter_cache_entry_t *entry)
+{
+	dfilter_free(entry->df);
+	g_free(entry->key);
+	g_free(entry);
+}
+
+void
+dfilter_cache_clear(void)
+{
+	dfilter_cache_entry_t *entry;
+
+	while ((entry = g_queue_pop_head(&dfilter_cache_lru)) != NULL) {
+		g_hash_table_remove(dfilter_cache_table, entry->key);
+		dfilter_cache_entry_free(entry);
+	}
+}
+
+static void
+dfilter_cache_check_generation(void)
+{
+	unsigned macro_gen = dfilter_macro_generation();
+	unsigned registrar_gen = proto_registrar_get_generation();
+	unsigned prefs_gen = prefs_get_generation();
+
+	if (macro_gen != dfilter_cache_macro_gen ||
+			registrar_gen != dfilter_cache_registrar_gen ||
+			prefs_gen != dfilter_cache_prefs_gen) {
+		dfilter_cache_clear();
+		dfilter_cache_macro_gen = macro_gen;
+		dfilter_cache_registrar_gen = registrar_gen;
+		dfilter_cache_prefs_gen = prefs_gen;
+	}
+}
+
+static char *
+dfilter_cache_key(const char *text, unsigned flags)
+{
+	return ws_strdup_printf("%x:%s", flags, text);
+}
+
+/* Returns a new reference to the cached dfilter, or NULL. */
+static dfilter_t *
+dfilter_cache_lookup(const char *text, unsigned flags)
+{
+	GList *link;
+	char *key;
+
+	if (dfilter_cache_table == NULL)
+		return NULL;
+
+	dfilter_cache_check_generation();
+
+	key = dfilter_cache_key(text, flags);
+	link = g_hash_table_lookup(dfilter_cache_table, key);
+	g_free(key);
+	if (link == NULL)
+		return NULL;
+
+	g_queue_unlink(&dfilter_cache_lru, link);
+	g_queue_push_head_link(&dfilter_cache_lru, link);
+	return dfilter_ref(((dfilter_cache_entry_t *)link->data)->df);
+}
+
+static void
+dfilter_cache_insert(const char *text, unsigned flags, dfilter_t *df)
+{
+	dfilter_cache_entry_t *entry;
+
+	/* Field references are loaded into the dfilter by each user
+	 * before applying it, so don't share those. */
+	if (g_hash_table_size(df->references) > 0 ||
+			g_hash_table_size(df->raw_references) > 0)
+		return;
+
+	if (dfilter_cache_table == NULL)
+		dfilter_cache_table = g_hash_table_new(g_str_hash, g_str_equal);
+
+	dfilter_cache_check_generation();
+
+	entry = g_new(dfilter_cache_entry_t, 1);
+	entry->key = dfilter_cache_key(text, flags);
+	entry->df = dfilter_ref(df);
+	if (g_hash_table_contains(dfilter_cache_table, entry->key)) {
+		dfilter_cache_entry_free(entry);
+		return;
+	}
+	g_queue_push_head(&dfilter_cache_lru, entry);
+	g_hash_table_insert(dfilter_cache_table, entry->key, dfilter_cache_lru.head);
+
+	if (g_queue_get_length(&dfilter_cache_lru) > DFILTER_CACHE_SIZE) {
+		entry = g_queue_pop_tail(&dfilter_cache_lru);
+		g_hash_table_remove(dfilter_cache_table, entry->key);
+		dfilter_cache_entry_free(entry);
+	}
+}
+
 static inline bool
 compile_failure(df_error_t *error, df_error_t **err_ptr)
 {
@@ -626,6 +763,19 @@ dfilter_compile_full(const char *text, dfilter_t **dfp,
 
 	ws_debug("Called from %s() with filter: %s", caller, text);
 
+	/* Debug traces are only produced by an actual compile. */
+	if (flags & (DF_DEBUG_FLEX | DF_DEBUG_LEMON))
+		flags |= DF_NO_CACHE;
+
+	if (!(flags & DF_NO_CACHE)) {
+		dfcode = dfilter_cache_lookup(text, flags);
+		if (dfcode != NULL) {
+			*dfp = dfcode;
+			ws_info("Reusing compiled display filter: %s", text);
+			return true;
+		}
+	}
+
 	if (flags & DF_EXPAND_MACROS) {
 		expanded_text = dfilter_macro_apply(text, &error);
 		if (expanded_text == NULL) {
@@ -646,6 +796,10 @@ dfilter_compile_full(const char *text, dfilter_t **dfp,
 		return compile_failure(error, err_ptr);
 	}
 
+	if (dfcode != NULL && !(flags & DF_NO_CACHE)) {
+		dfilter_cache_insert(text, flags, dfcode);
+	}
+
 	*dfp = dfcode;
 	ws_info("Compiled display filter: %s", text);
 	return true;
@@ -664,6 +818,268 @@ dfilter_apply_edt(dfilter_t *df, epan_dissect_t* edt)
 	return dfvm_apply(df, edt->tree);
 }
 
+/* Per-packet state of a field or program in a dfilter set. */
+#define DFS_UNKNOWN	0
+#define DFS_TRUE	1
+#define DFS_FALSE	2
+
+typedef struct {
+	dfilter_t	*df;
+	/* Indexes into dfs->fields of the fields the program requires. */
+	unsigned	*fields;
+	unsigned	num_fields;
+} dfilter_set_prog_t;
+
+struct epan_dfilter_set {
+	/* Index of the program for each dfilter added. */
+	GArray		*filter_prog;
+	/* dfilter_set_prog_t, one per distinct dfilter. */
+	GArray		*progs;
+	/* header_field_info *, union of the required fields of all programs. */
+	GPtrArray	*fields;
+	uint8_t		*field_state;
+	uint8_t		*prog_state;
+};
+
+dfilter_set_t *
+dfilter_set_new(void)
+{
+	dfilter_set_t *dfs = g_new0(dfilter_set_t, 1);
+
+	dfs->filter_prog = g_array_new(false, false, sizeof(unsigned));
+	dfs->progs = g_array_new(false, false, sizeof(dfilter_set_prog_t));
+	dfs->fields = g_ptr_array_new();
+	return dfs;
+}
+
+void
+dfilter_set_free(dfilter_set_t *dfs)
+{
+	if (!dfs)
+		return;
+
+	for (unsigned i = 0; i < dfs->progs->len; i++) {
+		g_free(g_array_index(dfs->progs, dfilter_set_prog_t, i).fields);
+	}
+	g_array_free(dfs->filter_prog, true);
+	g_array_free(dfs->progs, true);
+	g_ptr_array_free(dfs->fields, true);
+	g_free(dfs->field_state);
+	g_free(dfs->prog_state);
+	g_free(dfs);
+}
+
+unsigned
+dfilter_set_count(const dfilter_set_t *dfs)
+{
+	return dfs->filter_prog->len;
+}
+
+static unsigned
+dfilter_set_field_index(dfilter_set_t *dfs, header_field_info *hfinfo)
+{
+	unsigned i;
+
+	for (i = 0; i < dfs->fields->len; i++) {
+		if (g_ptr_array_index(dfs->fields, i) == hfinfo)
+			return i;
+	}
+	g_ptr_array_add(dfs->fields, hfinfo);
+	dfs->field_state = g_realloc(dfs->field_state, dfs->fields->len);
+	return i;
+}
+
+/* Returns true if the instruction at 'target' returns without doing
+ * anything else. */
+static bool
+insn_is_return(dfilter_t *df, unsigned target)
+{
+	dfvm_insn_t *insn;
+
+	while (target < df->insns->len) {
+		insn = g_ptr_array_index(df->insns, target);
+		if (insn->op == DFVM_RETURN)
+			return true;
+		if (insn->op != DFVM_NO_OP)
+			return false;
+		target++;
+	}
+	return false;
+}
+
+/* Returns true for instructions that fail if the field in arg1 is absent:
+ * READ_TREE/CHECK_EXISTS (without a range) and the FIELD_* instructions. */
+static bool
+insn_requires_field(dfvm_insn_t *insn)
+{
+	switch (insn->op) {
+		case DFVM_READ_TREE:
+		case DFVM_CHECK_EXISTS:
+		case DFVM_FIELD_ANY_EQ:
+		case DFVM_FIELD_ALL_NE:
+		case DFVM_FIELD_ANY_GT:
+		case DFVM_FIELD_ANY_GE:
+		case DFVM_FIELD_ANY_LT:
+		case DFVM_FIELD_ANY_LE:
+		case DFVM_FIELD_ANY_IN:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/* Collect the fields the program cannot match without: the leading
+ * instructions that fail if a field is absent and that are followed
+ * by a jump to RETURN, or by RETURN itself. */
+static void
+dfilter_set_collect_fields(dfilter_set_t *dfs, dfilter_set_prog_t *prog)
+{
+	dfilter_t *df = prog->df;
+	dfvm_insn_t *insn, *next;
+	unsigned i, j;
+
+	prog->fields = g_new(unsigned, df->insns->len / 2 + 1);
+	prog->num_fields = 0;
+
+	for (i = 0; i + 1 < df->insns->len; i = j + 1) {
+		insn = g_ptr_array_index(df->insns, i);
+		if (!insn_requires_field(insn))
+			break;
+
+		/* Skip the no-ops left behind by fused instructions. */
+		for (j = i + 1; j + 1 < df->insns->len; j++) {
+			if (((dfvm_insn_t *)g_ptr_array_index(df->insns, j))->op != DFVM_NO_OP)
+				break;
+		}
+		next = g_ptr_array_index(df->insns, j);
+
+		if (next->op == DFVM_IF_FALSE_GOTO) {
+			if (!insn_is_return(df, next->arg1->value.numeric))
+				break;
+		}
+		else if (next->op != DFVM_RETURN) {
+			break;
+		}
+		prog->fields[prog->num_fields++] =
+			dfilter_set_field_index(dfs, insn->arg1->value.hfinfo);
+		if (next->op == DFVM_RETURN)
+			break;
+	}
+}
+
+unsigned
+dfilter_set_add(dfilter_set_t *dfs, dfilter_t *df)
+{
+	dfilter_set_prog_t prog;
+	unsigned idx;
+
+	/* Programs using field references depend on state outside the
+	 * text, so only share programs without them. */
+	if (g_hash_table_size(df->references) == 0 &&
+			g_hash_table_size(df->raw_references) == 0) {
+		for (idx = 0; idx < dfs->progs->len; idx++) {
+			dfilter_t *other = g_array_index(dfs->progs, dfilter_set_prog_t, idx).df;
+			if (other == df ||
+					(g_hash_table_size(other->references) == 0 &&
+					 g_hash_table_size(other->raw_references) == 0 &&
+					 g_strcmp0(other->expanded_text, df->expanded_text) == 0))
+				break;
+		}
+	}
+	else {
+		idx = dfs->progs->len;
+	}
+
+	if (idx == dfs->progs->len) {
+		prog.df = df;
+		dfilter_set_collect_fields(dfs, &prog);
+		g_array_append_val(dfs->progs, prog);
+		dfs->prog_state = g_realloc(dfs->prog_state, dfs->progs->len);
+	}
+
+	g_array_append_val(dfs->filter_prog, idx);
+	return dfs->filter_prog->len - 1;
+}
+
+static bool
+dfilter_set_field_present(dfilter_set_t *dfs, unsigned idx, proto_tree *tree)
+{
+	header_field_info *hfinfo;
+	GPtrArray *finfos;
+
+	if (dfs->field_state[idx] == DFS_UNKNOWN) {
+		dfs->field_state[idx] = DFS_FALSE;
+		for (hfinfo = g_ptr_array_index(dfs->fields, idx); hfinfo; hfinfo = hfinfo->same_name_next) {
+			finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+			if (finfos != NULL && g_ptr_array_len(finfos) > 0) {
+				dfs->field_state[idx] = DFS_TRUE;
+				break;
+			}
+		}
+	}
+	return dfs->field_state[idx] == DFS_TRUE;
+}
+
+static bool
+dfilter_set_apply_prog(dfilter_set_t *dfs, unsigned idx, proto_tree *tree)
+{
+	dfilter_set_prog_t *prog;
+	bool passed = true;
+
+	if (dfs->prog_state[idx] != DFS_UNKNOWN)
+		return dfs->prog_state[idx] == DFS_TRUE;
+
+	prog = &g_array_index(dfs->progs, dfilter_set_prog_t, idx);
+	for (unsigned i = 0; i < prog->num_fields; i++) {
+		if (!dfilter_set_field_present(dfs, prog->fields[i], tree)) {
+			passed = false;
+			break;
+		}
+	}
+	if (passed)
+		passed = dfvm_apply(prog->df, tree);
+
+	dfs->prog_state[idx] = passed ? DFS_TRUE : DFS_FALSE;
+	return passed;
+}
+
+static void
+dfilter_set_reset_state(dfilter_set_t *dfs)
+{
+	if (dfs->fields->len > 0)
+		memset(dfs->field_state, DFS_UNKNOWN, dfs->fields->len);
+	if (dfs->progs->len > 0)
+		memset(dfs->prog_state, DFS_UNKNOWN, dfs->progs->len);
+}
+
+void
+dfilter_set_apply_edt(dfilter_set_t *dfs, epan_dissect_t *edt, uint64_t *matches)
+{
+	unsigned i;
+
+	dfilter_set_reset_state(dfs);
+	memset(matches, 0, ((dfs->filter_prog->len + 63) / 64) * sizeof(uint64_t));
+
+	for (i = 0; i < dfs->filter_prog->len; i++) {
+		if (dfilter_set_apply_prog(dfs, g_array_index(dfs->filter_prog, unsigned, i), edt->tree))
+			matches[i / 64] |= UINT64_C(1) << (i % 64);
+	}
+}
+
+int
+dfilter_set_apply_first_edt(dfilter_set_t *dfs, epan_dissect_t *edt)
+{
+	unsigned i;
+
+	dfilter_set_reset_state(dfs);
+
+	for (i = 0; i < dfs->filter_prog->len; i++) {
+		if (dfilter_set_apply_prog(dfs, g_array_index(dfs->filter_prog, unsigned, i), edt->tree))
+			return (int)i;
+	}
+	return -1;
+}
+
 
 void
 dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree)
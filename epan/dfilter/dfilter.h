@@ -73,6 +73,8 @@ dfilter_expand(const char *expr, df_error_t **err_ret);
 #define DF_DEBUG_FLEX		(1U << 3)
 /* Enable debug trace for lemon. */
 #define DF_DEBUG_LEMON		(1U << 4)
+/* Always compile a new dfilter instead of sharing a cached one. */
+#define DF_NO_CACHE		(1U << 5)
 
 /* Compiles a string to a dfilter_t.
  * On success, sets the dfilter* pointed to by dfp
@@ -81,6 +83,12 @@ dfilter_expand(const char *expr, df_error_t **err_ret);
  * a pointer to the newly-allocated dfilter_t
  * structure.
  *
+ * Compiled filters are kept in a cache keyed by the text
+ * and flags, so the dfilter_t may be shared with other
+ * callers that compiled the same text (unless DF_NO_CACHE
+ * is passed). A shared dfilter_t must not be applied from
+ * several threads at once.
+ *
  * On failure, *err_msg is set to point to the error
  * message.  This error message is allocated with
  * g_malloc(), and must be freed with g_free().
@@ -100,11 +108,23 @@ dfilter_compile_full(const char *text, dfilter_t **dfp,
 				__func__)
 
 /* Frees all memory used by dfilter, and frees
- * the dfilter itself. */
+ * the dfilter itself, once the last reference to
+ * it is dropped. */
 WS_DLL_PUBLIC
 void
 dfilter_free(dfilter_t *df);
 
+/* Adds a reference to a dfilter. Each reference must be
+ * released with dfilter_free(). */
+WS_DLL_PUBLIC
+dfilter_t *
+dfilter_ref(dfilter_t *df);
+
+/* Drops all cached compiled dfilters. */
+WS_DLL_PUBLIC
+void
+dfilter_cache_clear(void);
+
 /* Apply compiled dfilter */
 WS_DLL_PUBLIC
 bool
@@ -114,6 +134,43 @@ dfilter_apply_edt(dfilter_t *df, struct epan_dissect *edt);
 bool
 dfilter_apply(dfilter_t *df, proto_tree *tree);
 
+/* A set of compiled dfilters evaluated together against the same tree.
+ * Programs with identical text are evaluated once, and the fields a
+ * program cannot match without are looked up once per packet and shared
+ * by every program in the set. The set does not take ownership of the
+ * dfilters added to it; they must outlive the set. */
+typedef struct epan_dfilter_set dfilter_set_t;
+
+WS_DLL_PUBLIC
+dfilter_set_t *
+dfilter_set_new(void);
+
+WS_DLL_PUBLIC
+void
+dfilter_set_free(dfilter_set_t *dfs);
+
+/* Adds a dfilter to the set. Returns its index in the set. */
+WS_DLL_PUBLIC
+unsigned
+dfilter_set_add(dfilter_set_t *dfs, dfilter_t *df);
+
+WS_DLL_PUBLIC
+unsigned
+dfilter_set_count(const dfilter_set_t *dfs);
+
+/* Apply all the dfilters in the set. Bit (i % 64) of matches[i / 64] is
+ * set if the dfilter with index i matches; matches must hold at least
+ * (dfilter_set_count(dfs) + 63) / 64 elements. */
+WS_DLL_PUBLIC
+void
+dfilter_set_apply_edt(dfilter_set_t *dfs, struct epan_dissect *edt, uint64_t *matches);
+
+/* Apply the dfilters in the set in order, stopping at the first match.
+ * Returns the index of the matching dfilter, or -1 if none matches. */
+WS_DLL_PUBLIC
+int
+dfilter_set_apply_first_edt(dfilter_set_t *dfs, struct epan_dissect *edt);
+
 /* Prime a proto_tree using the fields/protocols used in a dfilter. */
 void
 dfilter_prime_proto_tree(const dfilter_t *df, proto_tree *tree);
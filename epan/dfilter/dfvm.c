@@ -12,6 +12,7 @@
 #include "dfvm.h"
 
 #include <ftypes/ftypes.h>
+#include <wsutil/str_util.h>
 #include <wsutil/ws_assert.h>
 
 static void
@@ -47,6 +48,8 @@ dfvm_opcode_tostr(dfvm_opcode_t code)
 		case DFVM_ANY_LE:		return "ANY_LE";
 		case DFVM_ALL_CONTAINS:		return "ALL_CONTAINS";
 		case DFVM_ANY_CONTAINS:		return "ANY_CONTAINS";
+		case DFVM_ALL_CONTAINS_ANY:	return "ALL_CONTAINS_ANY";
+		case DFVM_ANY_CONTAINS_ANY:	return "ANY_CONTAINS_ANY";
 		case DFVM_ALL_MATCHES:		return "ALL_MATCHES";
 		case DFVM_ANY_MATCHES:		return "ANY_MATCHES";
 		case DFVM_SET_ALL_IN:		return "SET_ALL_IN";
@@ -70,6 +73,13 @@ dfvm_opcode_tostr(dfvm_opcode_t code)
 		case DFVM_STACK_PUSH:		return "STACK_PUSH";
 		case DFVM_STACK_POP:		return "STACK_POP";
 		case DFVM_NOT_ALL_ZERO:		return "NOT_ALL_ZERO";
+		case DFVM_FIELD_ANY_EQ:		return "FIELD_ANY_EQ";
+		case DFVM_FIELD_ALL_NE:		return "FIELD_ALL_NE";
+		case DFVM_FIELD_ANY_GT:		return "FIELD_ANY_GT";
+		case DFVM_FIELD_ANY_GE:		return "FIELD_ANY_GE";
+		case DFVM_FIELD_ANY_LT:		return "FIELD_ANY_LT";
+		case DFVM_FIELD_ANY_LE:		return "FIELD_ANY_LE";
+		case DFVM_FIELD_ANY_IN:		return "FIELD_ANY_IN";
 		case DFVM_NO_OP:		return "NO_OP";
 	}
 	return "(fix-opcode-string)";
@@ -88,6 +98,12 @@ dfvm_value_free(dfvm_value_t *v)
 		case PCRE:
 			ws_regex_free(v->value.pcre);
 			break;
+		case UINTEGER64_SET:
+			g_array_unref(v->value.uint_ranges);
+			break;
+		case MULTISEARCH:
+			ws_multisearch_free(v->value.multisearch);
+			break;
 		case EMPTY:
 		case HFINFO:
 		case RAW_HFINFO:
@@ -95,6 +111,8 @@ dfvm_value_free(dfvm_value_t *v)
 		case REGISTER:
 		case INTEGER:
 		case FUNCTION_DEF:
+		case UINTEGER64:
+		case SINTEGER64:
 			break;
 	}
 	g_free(v);
@@ -239,6 +257,77 @@ dfvm_value_new_guint(unsigned num)
 	return v;
 }
 
+dfvm_value_t*
+dfvm_value_new_uinteger64(uint64_t num)
+{
+	dfvm_value_t *v = dfvm_value_new(UINTEGER64);
+	v->value.uinteger64 = num;
+	return v;
+}
+
+dfvm_value_t*
+dfvm_value_new_sinteger64(int64_t num)
+{
+	dfvm_value_t *v = dfvm_value_new(SINTEGER64);
+	v->value.sinteger64 = num;
+	return v;
+}
+
+dfvm_value_t*
+dfvm_value_new_uint_ranges(GArray *ranges)
+{
+	dfvm_value_t *v = dfvm_value_new(UINTEGER64_SET);
+	v->value.uint_ranges = ranges;
+	return v;
+}
+
+dfvm_value_t*
+dfvm_value_new_multisearch(ws_multisearch_t *ms)
+{
+	dfvm_value_t *v = dfvm_value_new(MULTISEARCH);
+	v->value.multisearch = ms;
+	return v;
+}
+
+static char *
+uint_ranges_tostr(GArray *ranges)
+{
+	wmem_strbuf_t *buf = wmem_strbuf_new(NULL, "{");
+	dfvm_uint_range_t *r;
+
+	for (unsigned i = 0; i < ranges->len; i++) {
+		r = &g_array_index(ranges, dfvm_uint_range_t, i);
+		if (i != 0)
+			wmem_strbuf_append_c(buf, ' ');
+		if (r->lo == r->hi)
+			wmem_strbuf_append_printf(buf, "%"PRIu64, r->lo);
+		else
+			wmem_strbuf_append_printf(buf, "%"PRIu64"..%"PRIu64, r->lo, r->hi);
+	}
+	wmem_strbuf_append_c(buf, '}');
+	return wmem_strbuf_finalize(buf);
+}
+
+static char *
+multisearch_tostr(const ws_multisearch_t *ms)
+{
+	wmem_strbuf_t *buf = wmem_strbuf_new(NULL, "{");
+	const uint8_t *pattern;
+	size_t length;
+	char *str;
+
+	for (unsigned i = 0; i < ws_multisearch_count(ms); i++) {
+		if (i != 0)
+			wmem_strbuf_append_c(buf, ' ');
+		pattern = ws_multisearch_pattern(ms, i, &length);
+		str = ws_escape_string_len(NULL, (const char *)pattern, length, true);
+		wmem_strbuf_append(buf, str);
+		g_free(str);
+	}
+	wmem_strbuf_append_c(buf, '}');
+	return wmem_strbuf_finalize(buf);
+}
+
 static char *
 dfvm_value_tostr(dfvm_value_t *v)
 {
@@ -278,6 +367,18 @@ dfvm_value_tostr(dfvm_value_t *v)
 		case INSN_NUMBER:
 			s = ws_strdup_printf("INSN(%"PRIu32")", v->value.numeric);
 			break;
+		case UINTEGER64:
+			s = ws_strdup_printf("%"PRIu64, v->value.uinteger64);
+			break;
+		case SINTEGER64:
+			s = ws_strdup_printf("%"PRId64, v->value.sinteger64);
+			break;
+		case UINTEGER64_SET:
+			s = uint_ranges_tostr(v->value.uint_ranges);
+			break;
+		case MULTISEARCH:
+			s = multisearch_tostr(v->value.multisearch);
+			break;
 	}
 	return s;
 }
@@ -534,12 +635,53 @@ append_op_args(wmem_strbuf_t *buf, dfvm_insn_t *insn, GSList **stack_print,
 						arg1_str, arg1_str_type);
 			break;
 
+		case DFVM_FIELD_ANY_EQ:
+			wmem_strbuf_append_printf(buf, "%s%s == %s%s",
+						arg1_str, arg1_str_type, arg2_str, arg2_str_type);
+			break;
+
+		case DFVM_FIELD_ALL_NE:
+			wmem_strbuf_append_printf(buf, "%s%s != %s%s",
+						arg1_str, arg1_str_type, arg2_str, arg2_str_type);
+			break;
+
+		case DFVM_FIELD_ANY_GT:
+			wmem_strbuf_append_printf(buf, "%s%s > %s%s",
+						arg1_str, arg1_str_type, arg2_str, arg2_str_type);
+			break;
+
+		case DFVM_FIELD_ANY_GE:
+			wmem_strbuf_append_printf(buf, "%s%s >= %s%s",
+						arg1_str, arg1_str_type, arg2_str, arg2_str_type);
+			break;
+
+		case DFVM_FIELD_ANY_LT:
+			wmem_strbuf_append_printf(buf, "%s%s < %s%s",
+						arg1_str, arg1_str_type, arg2_str, arg2_str_type);
+			break;
+
+		case DFVM_FIELD_ANY_LE:
+			wmem_strbuf_append_printf(buf, "%s%s <= %s%s",
+						arg1_str, arg1_str_type, arg2_str, arg2_str_type);
+			break;
+
+		case DFVM_FIELD_ANY_IN:
+			wmem_strbuf_append_printf(buf, "%s%s in %s",
+						arg1_str, arg1_str_type, arg2_str);
+			break;
+
 		case DFVM_ALL_CONTAINS:
 		case DFVM_ANY_CONTAINS:
 			wmem_strbuf_append_printf(buf, "%s%s contains %s%s",
 						arg1_str, arg1_str_type, arg2_str, arg2_str_type);
 			break;
 
+		case DFVM_ALL_CONTAINS_ANY:
+		case DFVM_ANY_CONTAINS_ANY:
+			wmem_strbuf_append_printf(buf, "%s%s contains_any %s",
+						arg1_str, arg1_str_type, arg2_str);
+			break;
+
 		case DFVM_ALL_MATCHES:
 		case DFVM_ANY_MATCHES:
 			wmem_strbuf_append_printf(buf, "%s%s matches %s%s",
@@ -1139,6 +1281,38 @@ all_matches(dfilter_t *df, dfvm_value_t *arg1, dfvm_value_t *arg2)
 	return true;
 }
 
+static bool
+any_contains_any(dfilter_t *df, dfvm_value_t *arg1, dfvm_value_t *arg2)
+{
+	df_cell_t *rp = &df->registers[arg1->value.numeric];
+	ws_multisearch_t *ms = arg2->value.multisearch;
+
+	const fvalue_t **fv_ptr = (const fvalue_t **)df_cell_array(rp);
+
+	for (size_t idx = 0; idx < df_cell_size(rp); idx++) {
+		if (fvalue_contains_any(fv_ptr[idx], ms) == FT_TRUE) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool
+all_contains_any(dfilter_t *df, dfvm_value_t *arg1, dfvm_value_t *arg2)
+{
+	df_cell_t *rp = &df->registers[arg1->value.numeric];
+	ws_multisearch_t *ms = arg2->value.multisearch;
+
+	const fvalue_t **fv_ptr = (const fvalue_t **)df_cell_array(rp);
+
+	for (size_t idx = 0; idx < df_cell_size(rp); idx++) {
+		if (fvalue_contains_any(fv_ptr[idx], ms) == FT_FALSE) {
+			return false;
+		}
+	}
+	return true;
+}
+
 static bool
 test_in_internal(fvalue_t *fv, GPtrArray *range[2])
 {
@@ -1628,6 +1802,191 @@ check_exists(proto_tree *tree, dfvm_value_t *arg1, dfvm_value_t *arg2)
 	return false;
 }
 
+/* The FIELD_* superinstructions read the values of a field straight from
+ * the tree instead of loading them into a register first. */
+static bool
+field_test_fvalue(proto_tree *tree, dfvm_opcode_t op,
+			header_field_info *hfinfo, const fvalue_t *fv2)
+{
+	DFVMCompareFunc cmp;
+	bool want_all = (op == DFVM_FIELD_ALL_NE);
+	bool found = false;
+	GPtrArray *finfos;
+	ft_bool_t have_match;
+
+	switch (op) {
+		case DFVM_FIELD_ANY_EQ:	cmp = fvalue_eq; break;
+		case DFVM_FIELD_ALL_NE:	cmp = fvalue_ne; break;
+		case DFVM_FIELD_ANY_GT:	cmp = fvalue_gt; break;
+		case DFVM_FIELD_ANY_GE:	cmp = fvalue_ge; break;
+		case DFVM_FIELD_ANY_LT:	cmp = fvalue_lt; break;
+		case DFVM_FIELD_ANY_LE:	cmp = fvalue_le; break;
+		default:
+			ASSERT_DFVM_OP_NOT_REACHED(op);
+	}
+
+	for (; hfinfo; hfinfo = hfinfo->same_name_next) {
+		finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+		if (finfos == NULL)
+			continue;
+		for (unsigned i = 0; i < finfos->len; i++) {
+			found = true;
+			have_match = cmp(((field_info *)finfos->pdata[i])->value, fv2);
+			if (want_all && have_match == FT_FALSE) {
+				return false;
+			}
+			else if (!want_all && have_match == FT_TRUE) {
+				return true;
+			}
+		}
+	}
+	return found && want_all;
+}
+
+static inline bool
+uinteger_relation(dfvm_opcode_t op, uint64_t a, uint64_t b)
+{
+	switch (op) {
+		case DFVM_FIELD_ANY_EQ:	return a == b;
+		case DFVM_FIELD_ALL_NE:	return a != b;
+		case DFVM_FIELD_ANY_GT:	return a > b;
+		case DFVM_FIELD_ANY_GE:	return a >= b;
+		case DFVM_FIELD_ANY_LT:	return a < b;
+		case DFVM_FIELD_ANY_LE:	return a <= b;
+		default:
+			ASSERT_DFVM_OP_NOT_REACHED(op);
+	}
+	ws_assert_not_reached();
+}
+
+static inline bool
+sinteger_relation(dfvm_opcode_t op, int64_t a, int64_t b)
+{
+	switch (op) {
+		case DFVM_FIELD_ANY_EQ:	return a == b;
+		case DFVM_FIELD_ALL_NE:	return a != b;
+		case DFVM_FIELD_ANY_GT:	return a > b;
+		case DFVM_FIELD_ANY_GE:	return a >= b;
+		case DFVM_FIELD_ANY_LT:	return a < b;
+		case DFVM_FIELD_ANY_LE:	return a <= b;
+		default:
+			ASSERT_DFVM_OP_NOT_REACHED(op);
+	}
+	ws_assert_not_reached();
+}
+
+/* Unboxed comparison for fields whose values are all unsigned integers. */
+static bool
+field_test_uinteger(proto_tree *tree, dfvm_opcode_t op,
+			header_field_info *hfinfo, uint64_t b)
+{
+	bool want_all = (op == DFVM_FIELD_ALL_NE);
+	bool found = false;
+	GPtrArray *finfos;
+	uint64_t a;
+
+	for (; hfinfo; hfinfo = hfinfo->same_name_next) {
+		finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+		if (finfos == NULL)
+			continue;
+		for (unsigned i = 0; i < finfos->len; i++) {
+			if (fvalue_to_uinteger64(((field_info *)finfos->pdata[i])->value, &a) != FT_OK)
+				continue;
+			found = true;
+			if (uinteger_relation(op, a, b) != want_all) {
+				return !want_all;
+			}
+		}
+	}
+	return found && want_all;
+}
+
+/* Unboxed comparison for fields whose values are all signed integers. */
+static bool
+field_test_sinteger(proto_tree *tree, dfvm_opcode_t op,
+			header_field_info *hfinfo, int64_t b)
+{
+	bool want_all = (op == DFVM_FIELD_ALL_NE);
+	bool found = false;
+	GPtrArray *finfos;
+	int64_t a;
+
+	for (; hfinfo; hfinfo = hfinfo->same_name_next) {
+		finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+		if (finfos == NULL)
+			continue;
+		for (unsigned i = 0; i < finfos->len; i++) {
+			if (fvalue_to_sinteger64(((field_info *)finfos->pdata[i])->value, &a) != FT_OK)
+				continue;
+			found = true;
+			if (sinteger_relation(op, a, b) != want_all) {
+				return !want_all;
+			}
+		}
+	}
+	return found && want_all;
+}
+
+static bool
+field_test(proto_tree *tree, dfvm_opcode_t op,
+			dfvm_value_t *arg1, dfvm_value_t *arg2)
+{
+	header_field_info *hfinfo = arg1->value.hfinfo;
+
+	switch (arg2->type) {
+		case UINTEGER64:
+			return field_test_uinteger(tree, op, hfinfo, arg2->value.uinteger64);
+		case SINTEGER64:
+			return field_test_sinteger(tree, op, hfinfo, arg2->value.sinteger64);
+		case FVALUE:
+			return field_test_fvalue(tree, op, hfinfo, dfvm_value_get_fvalue(arg2));
+		default:
+			ws_assert_not_reached();
+	}
+	return false;
+}
+
+static bool
+uint_ranges_contain(GArray *ranges, uint64_t a)
+{
+	unsigned lo = 0, hi = ranges->len, mid;
+	dfvm_uint_range_t *r;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		r = &g_array_index(ranges, dfvm_uint_range_t, mid);
+		if (a < r->lo)
+			hi = mid;
+		else if (a > r->hi)
+			lo = mid + 1;
+		else
+			return true;
+	}
+	return false;
+}
+
+static bool
+field_test_in(proto_tree *tree, dfvm_value_t *arg1, dfvm_value_t *arg2)
+{
+	header_field_info *hfinfo = arg1->value.hfinfo;
+	GArray *ranges = arg2->value.uint_ranges;
+	GPtrArray *finfos;
+	uint64_t a;
+
+	for (; hfinfo; hfinfo = hfinfo->same_name_next) {
+		finfos = proto_get_finfo_ptr_array(tree, hfinfo->id);
+		if (finfos == NULL)
+			continue;
+		for (unsigned i = 0; i < finfos->len; i++) {
+			if (fvalue_to_uinteger64(((field_info *)finfos->pdata[i])->value, &a) != FT_OK)
+				continue;
+			if (uint_ranges_contain(ranges, a))
+				return true;
+		}
+	}
+	return false;
+}
+
 bool
 dfvm_apply(dfilter_t *df, proto_tree *tree)
 {
@@ -1779,6 +2138,19 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				accum = !all_test_unary(df, fvalue_is_zero, arg1);
 				break;
 
+			case DFVM_FIELD_ANY_EQ:
+			case DFVM_FIELD_ALL_NE:
+			case DFVM_FIELD_ANY_GT:
+			case DFVM_FIELD_ANY_GE:
+			case DFVM_FIELD_ANY_LT:
+			case DFVM_FIELD_ANY_LE:
+				accum = field_test(tree, insn->op, arg1, arg2);
+				break;
+
+			case DFVM_FIELD_ANY_IN:
+				accum = field_test_in(tree, arg1, arg2);
+				break;
+
 			case DFVM_ALL_CONTAINS:
 				accum = all_test(df, fvalue_contains, arg1, arg2);
 				break;
@@ -1787,6 +2159,14 @@ dfvm_apply(dfilter_t *df, proto_tree *tree)
 				accum = any_test(df, fvalue_contains, arg1, arg2);
 				break;
 
+			case DFVM_ALL_CONTAINS_ANY:
+				accum = all_contains_any(df, arg1, arg2);
+				break;
+
+			case DFVM_ANY_CONTAINS_ANY:
+				accum = any_contains_any(df, arg1, arg2);
+				break;
+
 			case DFVM_ALL_MATCHES:
 				accum = all_matches(df, arg1, arg2);
 				break;
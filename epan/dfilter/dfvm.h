@@ -11,6 +11,7 @@
 #define DFVM_H
 
 #include <wsutil/regex.h>
+#include <wsutil/multisearch.h>
 #include <epan/proto.h>
 #include "dfilter-int.h"
 #include "syntax-tree.h"
@@ -31,8 +32,18 @@ typedef enum {
 	DRANGE,
 	FUNCTION_DEF,
 	PCRE,
+	UINTEGER64,
+	SINTEGER64,
+	UINTEGER64_SET,
+	MULTISEARCH,
 } dfvm_value_type_t;
 
+/* Closed range of unsigned integers, used by UINTEGER64_SET. */
+typedef struct {
+	uint64_t	lo;
+	uint64_t	hi;
+} dfvm_uint_range_t;
+
 typedef struct {
 	dfvm_value_type_t	type;
 
@@ -43,6 +54,10 @@ typedef struct {
 		header_field_info	*hfinfo;
 		df_func_def_t		*funcdef;
 		ws_regex_t		*pcre;
+		uint64_t		uinteger64;
+		int64_t			sinteger64;
+		GArray			*uint_ranges; /* Sorted and disjoint */
+		ws_multisearch_t	*multisearch;
 	} value;
 
 	int ref_count;
@@ -77,6 +92,8 @@ typedef enum {
 	DFVM_ANY_LE,
 	DFVM_ALL_CONTAINS,
 	DFVM_ANY_CONTAINS,
+	DFVM_ALL_CONTAINS_ANY,
+	DFVM_ANY_CONTAINS_ANY,
 	DFVM_ALL_MATCHES,
 	DFVM_ANY_MATCHES,
 	DFVM_SET_ALL_IN,
@@ -100,6 +117,15 @@ typedef enum {
 	DFVM_STACK_PUSH,
 	DFVM_STACK_POP,
 	DFVM_NOT_ALL_ZERO,
+	/* Superinstructions: read a field from the tree and test it against
+	 * a constant in one step. Only generated by the optimizer. */
+	DFVM_FIELD_ANY_EQ,
+	DFVM_FIELD_ALL_NE,
+	DFVM_FIELD_ANY_GT,
+	DFVM_FIELD_ANY_GE,
+	DFVM_FIELD_ANY_LT,
+	DFVM_FIELD_ANY_LE,
+	DFVM_FIELD_ANY_IN,
 	DFVM_NO_OP,
 } dfvm_opcode_t;
 
@@ -153,6 +179,18 @@ dfvm_value_new_pcre(ws_regex_t *re);
 dfvm_value_t*
 dfvm_value_new_guint(unsigned num);
 
+dfvm_value_t*
+dfvm_value_new_uinteger64(uint64_t num);
+
+dfvm_value_t*
+dfvm_value_new_sinteger64(int64_t num);
+
+dfvm_value_t*
+dfvm_value_new_uint_ranges(GArray *ranges);
+
+dfvm_value_t*
+dfvm_value_new_multisearch(ws_multisearch_t *ms);
+
 void
 dfvm_dump(FILE *f, dfilter_t *df, uint16_t flags);
 
@@ -42,6 +42,7 @@ select_opcode(dfvm_opcode_t op, stmatch_t how)
 		case DFVM_ALL_LT:
 		case DFVM_ALL_LE:
 		case DFVM_ALL_CONTAINS:
+		case DFVM_ALL_CONTAINS_ANY:
 		case DFVM_ALL_MATCHES:
 		case DFVM_SET_ALL_IN:
 		case DFVM_SET_ALL_NOT_IN:
@@ -53,6 +54,7 @@ select_opcode(dfvm_opcode_t op, stmatch_t how)
 		case DFVM_ANY_LT:
 		case DFVM_ANY_LE:
 		case DFVM_ANY_CONTAINS:
+		case DFVM_ANY_CONTAINS_ANY:
 		case DFVM_ANY_MATCHES:
 		case DFVM_SET_ANY_IN:
 		case DFVM_SET_ANY_NOT_IN:
@@ -499,6 +501,59 @@ gen_relation_in(dfwork_t *dfw, dfvm_opcode_t op, stmatch_t how,
 	jumps = NULL;
 }
 
+/* Add the constant patterns of a contains or contains_any test to ms. */
+static void
+add_contains_patterns(ws_multisearch_t *ms, stnode_t *st_node)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_arg2;
+	GSList		*nodelist;
+	bool		ok;
+
+	sttype_oper_get(st_node, &st_op, NULL, &st_arg2);
+	if (st_op == STNODE_OP_CONTAINS) {
+		ok = fvalue_add_contains_pattern(ms, stnode_data(st_arg2));
+		ws_assert(ok);
+		return;
+	}
+	ws_assert(st_op == STNODE_OP_CONTAINS_ANY);
+	/* Set elements come in pairs; the upper value is always NULL,
+	 * since ranges were rejected by the semantic check. */
+	for (nodelist = stnode_data(st_arg2); nodelist; nodelist = nodelist->next->next) {
+		ok = fvalue_add_contains_pattern(ms, stnode_data(nodelist->data));
+		ws_assert(ok);
+	}
+}
+
+/* Generate the code for the contains_any operator, or for several
+ * contains and contains_any tests of the same field joined by "or". The
+ * patterns of all the tests in nodes are searched for in one pass. */
+static void
+gen_relation_contains_any(dfwork_t *dfw, stmatch_t how, stnode_t *st_arg1,
+				GPtrArray *nodes)
+{
+	GSList		*jumps = NULL;
+	dfvm_value_t	*val1, *val2;
+	ws_multisearch_t *ms;
+
+	/* Create code for the LHS of the relation */
+	val1 = gen_entity(dfw, st_arg1, &jumps);
+
+	ms = ws_multisearch_new();
+	for (unsigned i = 0; i < nodes->len; i++) {
+		add_contains_patterns(ms, g_ptr_array_index(nodes, i));
+	}
+	ws_multisearch_compile(ms);
+	val2 = dfvm_value_new_multisearch(ms);
+
+	gen_relation_insn(dfw, select_opcode(DFVM_ANY_CONTAINS_ANY, how), val1, val2, NULL);
+
+	/* Jump here if the LHS entity was not present */
+	g_slist_foreach(jumps, fixup_jumps, dfw);
+	g_slist_free(jumps);
+	jumps = NULL;
+}
+
 static dfvm_value_t *
 gen_arithmetic(dfwork_t *dfw, stnode_t *st_arg, GSList **jumps_ptr)
 {
@@ -531,6 +586,7 @@ gen_arithmetic(dfwork_t *dfw, stnode_t *st_arg, GSList **jumps_ptr)
 		case STNODE_OP_LT:
 		case STNODE_OP_LE:
 		case STNODE_OP_CONTAINS:
+		case STNODE_OP_CONTAINS_ANY:
 		case STNODE_OP_MATCHES:
 		case STNODE_OP_IN:
 		case STNODE_OP_NOT_IN:
@@ -695,6 +751,155 @@ gen_notzero_slice(dfwork_t *dfw, stnode_t *st_node)
 	g_slist_free(jumps);
 }
 
+/* Returns the field of a contains or contains_any test that may be
+ * searched for together with other tests of the same field, or NULL. */
+static header_field_info *
+contains_test_field(stnode_t *st_node)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+	header_field_info *hfinfo;
+
+	if (stnode_type_id(st_node) != STTYPE_TEST)
+		return NULL;
+	sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
+	if (st_op != STNODE_OP_CONTAINS && st_op != STNODE_OP_CONTAINS_ANY)
+		return NULL;
+	/* "all" does not distribute over "or". */
+	if (sttype_test_get_match(st_node) == STNODE_MATCH_ALL)
+		return NULL;
+	if (stnode_type_id(st_arg1) != STTYPE_FIELD ||
+			sttype_field_drange(st_arg1) != NULL ||
+			sttype_field_value_string(st_arg1))
+		return NULL;
+	/* contains_any never matches an empty pattern, but a
+	 * byte string contains an empty one. */
+	if (st_op == STNODE_OP_CONTAINS &&
+			(stnode_type_id(st_arg2) != STTYPE_FVALUE ||
+			fvalue_length2(stnode_data(st_arg2)) == 0))
+		return NULL;
+
+	hfinfo = sttype_field_hfinfo(st_arg1);
+	/* "contains" on a protocol compares each pair of values in its
+	 * own way (see cmp_contains() in ftype-protocol.c), which one
+	 * search for all the patterns can't do. */
+	if (hfinfo->type == FT_PROTOCOL)
+		return NULL;
+	while (hfinfo->same_name_prev_id != -1) {
+		hfinfo = proto_registrar_get_nth(hfinfo->same_name_prev_id);
+	}
+	return hfinfo;
+}
+
+static bool
+same_contains_field(stnode_t *a, stnode_t *b)
+{
+	header_field_info *hfinfo_a = contains_test_field(a);
+	stnode_t	*field_a, *field_b;
+
+	if (hfinfo_a == NULL || hfinfo_a != contains_test_field(b))
+		return false;
+	sttype_oper_get(a, NULL, &field_a, NULL);
+	sttype_oper_get(b, NULL, &field_b, NULL);
+	return sttype_field_raw(field_a) == sttype_field_raw(field_b);
+}
+
+static void
+collect_or_terms(stnode_t *st_node, GPtrArray *terms)
+{
+	stnode_op_t	st_op;
+	stnode_t	*st_arg1, *st_arg2;
+
+	if (stnode_type_id(st_node) == STTYPE_TEST) {
+		sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
+		if (st_op == STNODE_OP_OR) {
+			collect_or_terms(st_arg1, terms);
+			collect_or_terms(st_arg2, terms);
+			return;
+		}
+	}
+	g_ptr_array_add(terms, st_node);
+}
+
+/* Generate the code for a chain of "or" tests where several terms are
+ * contains or contains_any tests of the same field. Each such group of
+ * terms becomes one contains_any instruction, so the field value is
+ * only searched once. Returns false, without generating any code, if
+ * there is nothing to combine. */
+static bool
+gen_or_contains(dfwork_t *dfw, stnode_t *st_node)
+{
+	GPtrArray	*terms, *group;
+	GPtrArray	*jumps;
+	bool		*done;
+	bool		found = false;
+	stnode_t	*term, *st_arg1;
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*jmp;
+	unsigned	i, j, remaining;
+
+	terms = g_ptr_array_new();
+	collect_or_terms(st_node, terms);
+	for (i = 0; i < terms->len && !found; i++) {
+		for (j = i + 1; j < terms->len && !found; j++) {
+			found = same_contains_field(g_ptr_array_index(terms, i),
+							g_ptr_array_index(terms, j));
+		}
+	}
+	if (!found) {
+		g_ptr_array_free(terms, true);
+		return false;
+	}
+
+	done = g_new0(bool, terms->len);
+	group = g_ptr_array_new();
+	jumps = g_ptr_array_new();
+	remaining = terms->len;
+	for (i = 0; i < terms->len; i++) {
+		if (done[i])
+			continue;
+		term = g_ptr_array_index(terms, i);
+		done[i] = true;
+		remaining--;
+
+		g_ptr_array_set_size(group, 0);
+		g_ptr_array_add(group, term);
+		for (j = i + 1; j < terms->len; j++) {
+			if (!done[j] && same_contains_field(term, g_ptr_array_index(terms, j))) {
+				g_ptr_array_add(group, g_ptr_array_index(terms, j));
+				done[j] = true;
+				remaining--;
+			}
+		}
+
+		if (group->len > 1) {
+			sttype_oper_get(term, NULL, &st_arg1, NULL);
+			gen_relation_contains_any(dfw, STNODE_MATCH_ANY, st_arg1, group);
+		}
+		else {
+			gencode(dfw, term);
+		}
+
+		if (remaining > 0) {
+			insn = dfvm_insn_new(DFVM_IF_TRUE_GOTO);
+			jmp = dfvm_value_new(INSN_NUMBER);
+			insn->arg1 = dfvm_value_ref(jmp);
+			dfw_append_insn(dfw, insn);
+			g_ptr_array_add(jumps, jmp);
+		}
+	}
+	for (i = 0; i < jumps->len; i++) {
+		jmp = g_ptr_array_index(jumps, i);
+		jmp->value.numeric = dfw->next_insn_id;
+	}
+
+	g_ptr_array_free(jumps, true);
+	g_ptr_array_free(group, true);
+	g_free(done);
+	g_ptr_array_free(terms, true);
+	return true;
+}
+
 static void
 gen_test(dfwork_t *dfw, stnode_t *st_node)
 {
@@ -703,6 +908,7 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 	stnode_t	*st_arg1, *st_arg2;
 	dfvm_insn_t	*insn;
 	dfvm_value_t	*jmp;
+	GPtrArray	*group;
 
 
 	sttype_oper_get(st_node, &st_op, &st_arg1, &st_arg2);
@@ -728,6 +934,9 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 			break;
 
 		case STNODE_OP_OR:
+			if ((dfw->flags & DF_OPTIMIZE) && gen_or_contains(dfw, st_node))
+				break;
+
 			gencode(dfw, st_arg1);
 
 			insn = dfvm_insn_new(DFVM_IF_TRUE_GOTO);
@@ -775,6 +984,13 @@ gen_test(dfwork_t *dfw, stnode_t *st_node)
 			gen_relation(dfw, DFVM_ANY_CONTAINS, st_how, st_arg1, st_arg2);
 			break;
 
+		case STNODE_OP_CONTAINS_ANY:
+			group = g_ptr_array_new();
+			g_ptr_array_add(group, st_node);
+			gen_relation_contains_any(dfw, st_how, st_arg1, group);
+			g_ptr_array_free(group, true);
+			break;
+
 		case STNODE_OP_MATCHES:
 			gen_relation(dfw, DFVM_ANY_MATCHES, st_how, st_arg1, st_arg2);
 			break;
@@ -875,6 +1091,261 @@ optimize(dfwork_t *dfw)
 	}
 }
 
+/* Returns true if an instruction outside [first, last] needs the contents
+ * of the register. Other loads of the same field into it don't count, since
+ * READ_TREE loads the register itself if it is still empty. */
+static bool
+register_used_elsewhere(dfwork_t *dfw, uint32_t reg, int first, int last)
+{
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*args[3];
+	int		id, length;
+
+	length = dfw->insns->len;
+	for (id = 0; id < length; id++) {
+		if (id >= first && id <= last)
+			continue;
+		insn = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id);
+		if (insn->op == DFVM_READ_TREE)
+			continue;
+		args[0] = insn->arg1;
+		args[1] = insn->arg2;
+		args[2] = insn->arg3;
+		for (int i = 0; i < 3; i++) {
+			if (args[i] && args[i]->type == REGISTER &&
+					args[i]->value.numeric == reg)
+				return true;
+		}
+	}
+	return false;
+}
+
+/* Returns true if any instruction jumps into (first, last]. */
+static bool
+jumps_into(dfwork_t *dfw, int first, int last)
+{
+	dfvm_insn_t	*insn;
+	dfvm_value_t	*arg1;
+	int		id, length;
+
+	length = dfw->insns->len;
+	for (id = 0; id < length; id++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id);
+		arg1 = insn->arg1;
+		if (arg1 && arg1->type == INSN_NUMBER &&
+				(int)arg1->value.numeric > first &&
+				(int)arg1->value.numeric <= last)
+			return true;
+	}
+	return false;
+}
+
+static bool
+field_is_uinteger(header_field_info *hfinfo)
+{
+	for (; hfinfo; hfinfo = hfinfo->same_name_next) {
+		if (!FT_IS_UINT(hfinfo->type))
+			return false;
+	}
+	return true;
+}
+
+static bool
+field_is_sinteger(header_field_info *hfinfo)
+{
+	for (; hfinfo; hfinfo = hfinfo->same_name_next) {
+		if (!FT_IS_INT(hfinfo->type))
+			return false;
+	}
+	return true;
+}
+
+/* Unbox an integer constant if every field with this name is an integer
+ * of the same signedness. Otherwise keep the fvalue. */
+static dfvm_value_t *
+fuse_constant(header_field_info *hfinfo, dfvm_value_t *val)
+{
+	fvalue_t	*fv = dfvm_value_get_fvalue(val);
+	enum ftenum	ftype = fvalue_type_ftenum(fv);
+	uint64_t	uval;
+	int64_t		sval;
+
+	if (FT_IS_UINT(ftype) && field_is_uinteger(hfinfo) &&
+			fvalue_to_uinteger64(fv, &uval) == FT_OK)
+		return dfvm_value_new_uinteger64(uval);
+	if (FT_IS_INT(ftype) && field_is_sinteger(hfinfo) &&
+			fvalue_to_sinteger64(fv, &sval) == FT_OK)
+		return dfvm_value_new_sinteger64(sval);
+	return val;
+}
+
+static dfvm_opcode_t
+fused_opcode(dfvm_opcode_t op)
+{
+	switch (op) {
+		case DFVM_ANY_EQ:	return DFVM_FIELD_ANY_EQ;
+		case DFVM_ALL_NE:	return DFVM_FIELD_ALL_NE;
+		case DFVM_ANY_GT:	return DFVM_FIELD_ANY_GT;
+		case DFVM_ANY_GE:	return DFVM_FIELD_ANY_GE;
+		case DFVM_ANY_LT:	return DFVM_FIELD_ANY_LT;
+		case DFVM_ANY_LE:	return DFVM_FIELD_ANY_LE;
+		default:		return DFVM_NULL;
+	}
+}
+
+/* READ_TREE field -> R; IF_FALSE_GOTO; <cmp> R, constant
+ * becomes FIELD_<cmp> field, constant. */
+static bool
+fuse_relation(dfwork_t *dfw, int id)
+{
+	dfvm_insn_t	*read, *jump, *cmp;
+	dfvm_opcode_t	op;
+	dfvm_value_t	*val;
+
+	if (id + 2 >= (int)dfw->insns->len)
+		return false;
+	read = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id);
+	jump = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id + 1);
+	cmp = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id + 2);
+
+	if (read->op != DFVM_READ_TREE || read->arg1->type != HFINFO)
+		return false;
+	if (jump->op != DFVM_IF_FALSE_GOTO)
+		return false;
+	op = fused_opcode(cmp->op);
+	if (op == DFVM_NULL)
+		return false;
+	if (cmp->arg1->type != REGISTER ||
+			cmp->arg1->value.numeric != read->arg2->value.numeric ||
+			cmp->arg2->type != FVALUE)
+		return false;
+	if (register_used_elsewhere(dfw, read->arg2->value.numeric, id, id + 2) ||
+			jumps_into(dfw, id, id + 2))
+		return false;
+
+	val = dfvm_value_ref(fuse_constant(read->arg1->value.hfinfo, cmp->arg2));
+	dfvm_value_unref(read->arg2);
+	read->arg2 = val;
+	read->op = op;
+	dfvm_insn_replace_no_op(jump);
+	dfvm_insn_replace_no_op(cmp);
+	return true;
+}
+
+static int
+compare_uint_range(gconstpointer _a, gconstpointer _b)
+{
+	const dfvm_uint_range_t *a = _a;
+	const dfvm_uint_range_t *b = _b;
+
+	if (a->lo != b->lo)
+		return a->lo < b->lo ? -1 : 1;
+	return 0;
+}
+
+static bool
+set_element_uinteger(dfvm_value_t *val, uint64_t *ret)
+{
+	if (val == NULL || val->type != FVALUE)
+		return false;
+	if (!FT_IS_UINT(fvalue_type_ftenum(dfvm_value_get_fvalue(val))))
+		return false;
+	return fvalue_to_uinteger64(dfvm_value_get_fvalue(val), ret) == FT_OK;
+}
+
+/* READ_TREE field -> R; IF_FALSE_GOTO; SET_ADD[_RANGE] constant...;
+ * SET_ANY_IN R; SET_CLEAR becomes FIELD_ANY_IN field, {ranges}, if the field
+ * and all members of the set are unsigned integers. */
+static bool
+fuse_set(dfwork_t *dfw, int id)
+{
+	dfvm_insn_t		*read, *insn;
+	GArray			*ranges;
+	dfvm_uint_range_t	range, *last;
+	int			id1, length;
+
+	length = dfw->insns->len;
+	if (id + 2 >= length)
+		return false;
+	read = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id);
+	insn = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id + 1);
+
+	if (read->op != DFVM_READ_TREE || read->arg1->type != HFINFO)
+		return false;
+	if (insn->op != DFVM_IF_FALSE_GOTO)
+		return false;
+	if (!field_is_uinteger(read->arg1->value.hfinfo))
+		return false;
+
+	ranges = g_array_new(false, false, sizeof(dfvm_uint_range_t));
+	for (id1 = id + 2; id1 < length; id1++) {
+		insn = (dfvm_insn_t *)g_ptr_array_index(dfw->insns, id1);
+		if (insn->op == DFVM_SET_ADD) {
+			if (!set_element_uinteger(insn->arg1, &range.lo))
+				break;
+			range.hi = range.lo;
+		}
+		else if (insn->op == DFVM_SET_ADD_RANGE) {
+			if (!set_element_uinteger(insn->arg1, &range.lo) ||
+					!set_element_uinteger(insn->arg2, &range.hi))
+				break;
+			if (range.lo > range.hi)
+				continue;
+		}
+		else {
+			break;
+		}
+		g_array_append_val(ranges, range);
+	}
+
+	if (id1 + 1 >= length || insn->op != DFVM_SET_ANY_IN ||
+			insn->arg1->type != REGISTER ||
+			insn->arg1->value.numeric != read->arg2->value.numeric ||
+			((dfvm_insn_t *)g_ptr_array_index(dfw->insns, id1 + 1))->op != DFVM_SET_CLEAR ||
+			register_used_elsewhere(dfw, read->arg2->value.numeric, id, id1 + 1) ||
+			jumps_into(dfw, id, id1 + 1)) {
+		g_array_unref(ranges);
+		return false;
+	}
+
+	/* Merge overlapping and adjacent ranges so they can be searched. */
+	g_array_sort(ranges, compare_uint_range);
+	for (unsigned i = 1; i < ranges->len; ) {
+		last = &g_array_index(ranges, dfvm_uint_range_t, i - 1);
+		range = g_array_index(ranges, dfvm_uint_range_t, i);
+		if (last->hi == UINT64_MAX || range.lo <= last->hi + 1) {
+			if (range.hi > last->hi)
+				last->hi = range.hi;
+			g_array_remove_index(ranges, i);
+		}
+		else {
+			i++;
+		}
+	}
+
+	dfvm_value_unref(read->arg2);
+	read->arg2 = dfvm_value_ref(dfvm_value_new_uint_ranges(ranges));
+	read->op = DFVM_FIELD_ANY_IN;
+	for (int i = id + 1; i <= id1 + 1; i++) {
+		dfvm_insn_replace_no_op(g_ptr_array_index(dfw->insns, i));
+	}
+	return true;
+}
+
+/* Replace common instruction sequences with superinstructions. The
+ * replaced instructions become no-ops so jump targets stay valid. */
+static void
+fuse(dfwork_t *dfw)
+{
+	int		id, length;
+
+	length = dfw->insns->len;
+	for (id = 0; id < length; id++) {
+		if (!fuse_relation(dfw, id))
+			fuse_set(dfw, id);
+	}
+}
+
 void
 dfw_gencode(dfwork_t *dfw)
 {
@@ -886,6 +1357,7 @@ dfw_gencode(dfwork_t *dfw)
 	dfw_append_insn(dfw, dfvm_insn_new(DFVM_RETURN));
 	if (dfw->flags & DF_OPTIMIZE) {
 		optimize(dfw);
+		fuse(dfw);
 	}
 }
 
@@ -1509,6 +1509,45 @@ check_relation_contains(dfwork_t *dfw, stnode_t *st_node,
 	}
 }
 
+static void
+check_relation_contains_any(dfwork_t *dfw, stnode_t *st_node,
+		stnode_t *st_arg1, stnode_t *st_arg2)
+{
+	GSList *nodelist;
+	stnode_t *node_left, *node_right;
+
+	LOG_NODE(st_node);
+
+	if (stnode_type_id(st_arg1) != STTYPE_FIELD) {
+		FAIL(dfw, st_arg1, "Only a field may be tested with %s.",
+				stnode_todisplay(st_node));
+	}
+	/* Checked in the grammar parser. */
+	ws_assert(stnode_type_id(st_arg2) == STTYPE_SET);
+
+	nodelist = stnode_data(st_arg2);
+	while (nodelist) {
+		node_left = nodelist->data;
+		nodelist = g_slist_next(nodelist);
+		ws_assert(nodelist);
+		node_right = nodelist->data;
+		if (node_right) {
+			FAIL(dfw, node_right, "A range may not appear in a %s set.",
+					stnode_todisplay(st_node));
+		}
+
+		check_relation_LHS_FIELD(dfw, STNODE_OP_CONTAINS, ftype_can_contains,
+				true, st_node, st_arg1, node_left);
+		/* The patterns are compiled into one automaton, so they
+		 * must be known now. */
+		if (stnode_type_id(node_left) != STTYPE_FVALUE) {
+			FAIL(dfw, node_left, "Only constant values may appear in a %s set, not %s.",
+					stnode_todisplay(st_node), stnode_todisplay(node_left));
+		}
+		nodelist = g_slist_next(nodelist);
+	}
+}
+
 
 static void
 check_relation_matches(dfwork_t *dfw, stnode_t *st_node,
@@ -1637,6 +1676,9 @@ check_test(dfwork_t *dfw, stnode_t *st_node)
 		case STNODE_OP_CONTAINS:
 			check_relation_contains(dfw, st_node, st_arg1, st_arg2);
 			break;
+		case STNODE_OP_CONTAINS_ANY:
+			check_relation_contains_any(dfw, st_node, st_arg1, st_arg2);
+			break;
 		case STNODE_OP_MATCHES:
 			check_relation_matches(dfw, st_node, st_arg1, st_arg2);
 			break;
@@ -128,6 +128,9 @@ oper_todisplay(const oper_t *oper)
 		case STNODE_OP_CONTAINS:
 			s = "contains";
 			break;
+		case STNODE_OP_CONTAINS_ANY:
+			s = "contains_any";
+			break;
 		case STNODE_OP_MATCHES:
 			s = "matches";
 			break;
@@ -190,6 +193,7 @@ num_operands(stnode_op_t op)
 		case STNODE_OP_DIVIDE:
 		case STNODE_OP_MODULO:
 		case STNODE_OP_CONTAINS:
+		case STNODE_OP_CONTAINS_ANY:
 		case STNODE_OP_MATCHES:
 		case STNODE_OP_IN:
 		case STNODE_OP_NOT_IN:
@@ -160,6 +160,9 @@ stnode_op_name(stnode_op_t op)
 		case STNODE_OP_CONTAINS:
 			s = "TEST_CONTAINS";
 			break;
+		case STNODE_OP_CONTAINS_ANY:
+			s = "TEST_CONTAINS_ANY";
+			break;
 		case STNODE_OP_MATCHES:
 			s = "TEST_MATCHES";
 			break;
@@ -95,6 +95,7 @@ typedef enum {
 	STNODE_OP_LT,
 	STNODE_OP_LE,
 	STNODE_OP_CONTAINS,
+	STNODE_OP_CONTAINS_ANY,
 	STNODE_OP_MATCHES,
 	STNODE_OP_IN,
 	STNODE_OP_NOT_IN,
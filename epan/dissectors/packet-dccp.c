@@ -573,7 +573,7 @@ guint32 get_dccp_stream_count(void)
 static gboolean
 dccp_filter_valid(packet_info *pinfo, void *user_data _U_)
 {
-    return proto_is_frame_protocol(pinfo->layers, "dccp");
+    return packet_has_layer(pinfo, proto_dccp);
 }
 
 static gchar*
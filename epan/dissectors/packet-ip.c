@@ -542,7 +542,7 @@ ip_endpoint_packet(void *pit, packet_info *pinfo, epan_dissect_t *edt _U_, const
 static gboolean
 ip_filter_valid(packet_info *pinfo, void *user_data _U_)
 {
-    return proto_is_frame_protocol(pinfo->layers, "ip");
+    return packet_has_layer(pinfo, proto_ip);
 }
 
 static gchar*
@@ -687,7 +687,7 @@ ipv6_endpoint_packet(void *pit, packet_info *pinfo, epan_dissect_t *edt _U_, con
 static gboolean
 ipv6_filter_valid(packet_info *pinfo, void *user_data _U_)
 {
-    return proto_is_frame_protocol(pinfo->layers, "ipv6");
+    return packet_has_layer(pinfo, proto_ipv6);
 }
 
 static gchar*
@@ -29,9 +29,31 @@
 #define LOG2_NODES_PER_LEVEL    10
 #define NODES_PER_LEVEL         (1<<LOG2_NODES_PER_LEVEL)
 
+/*
+ * To answer time-bounded queries without looking at every frame, we
+ * also keep the smallest and largest absolute time stamp of the frames
+ * in every leaf node, and of the frames in every group of
+ * NODES_PER_LEVEL leaf nodes.  Time stamps aren't necessarily
+ * monotonic, so a range query has to visit every leaf whose bounds
+ * overlap the range, but it can skip all others; if the time stamps
+ * do happen to be monotonic, which is the common case, the first leaf
+ * can be found with a binary search.
+ */
+typedef struct {
+  nstime_t     min_ts;
+  nstime_t     max_ts;
+} frame_time_bounds;
+
+#define LOG2_FRAMES_PER_GROUP   (2*LOG2_NODES_PER_LEVEL)
+
 struct _frame_data_sequence {
   guint32      count;           /* Total number of frames */
   void        *ptree_root;      /* Pointer to the root node */
+  GArray      *leaf_bounds;     /* frame_time_bounds of each leaf node */
+  GArray      *group_bounds;    /* frame_time_bounds of each group of leaf nodes */
+  gboolean     time_index_valid; /* FALSE if the bounds must be rebuilt */
+  gboolean     ts_monotonic;    /* TRUE if no frame is older than its predecessor */
+  nstime_t     last_ts;         /* Time stamp of the last indexed frame */
 };
 
 /*
@@ -55,9 +77,52 @@ new_frame_data_sequence(void)
   fds = (frame_data_sequence *)g_malloc(sizeof *fds);
   fds->count = 0;
   fds->ptree_root = NULL;
+  fds->leaf_bounds = g_array_new(FALSE, FALSE, sizeof(frame_time_bounds));
+  fds->group_bounds = g_array_new(FALSE, FALSE, sizeof(frame_time_bounds));
+  fds->time_index_valid = TRUE;
+  fds->ts_monotonic = TRUE;
+  nstime_set_zero(&fds->last_ts);
   return fds;
 }
 
+/*
+ * Account for the time stamp of the frame with the given index in the
+ * time index.  Frames must be indexed in order.
+ */
+static void
+frame_time_index_add(frame_data_sequence *fds, guint32 idx, const nstime_t *ts)
+{
+  frame_time_bounds *bounds;
+  frame_time_bounds new_bounds;
+
+  if (idx > 0 && nstime_cmp(ts, &fds->last_ts) < 0)
+    fds->ts_monotonic = FALSE;
+  fds->last_ts = *ts;
+
+  new_bounds.min_ts = *ts;
+  new_bounds.max_ts = *ts;
+
+  if (LEAF_INDEX(idx) == 0) {
+    g_array_append_val(fds->leaf_bounds, new_bounds);
+  } else {
+    bounds = &g_array_index(fds->leaf_bounds, frame_time_bounds, idx >> LOG2_NODES_PER_LEVEL);
+    if (nstime_cmp(ts, &bounds->min_ts) < 0)
+      bounds->min_ts = *ts;
+    if (nstime_cmp(ts, &bounds->max_ts) > 0)
+      bounds->max_ts = *ts;
+  }
+
+  if ((idx & ((1U << LOG2_FRAMES_PER_GROUP) - 1)) == 0) {
+    g_array_append_val(fds->group_bounds, new_bounds);
+  } else {
+    bounds = &g_array_index(fds->group_bounds, frame_time_bounds, idx >> LOG2_FRAMES_PER_GROUP);
+    if (nstime_cmp(ts, &bounds->min_ts) < 0)
+      bounds->min_ts = *ts;
+    if (nstime_cmp(ts, &bounds->max_ts) > 0)
+      bounds->max_ts = *ts;
+  }
+}
+
 /*
  * Add a new frame_data structure to a frame_data_sequence.
  */
@@ -168,6 +233,8 @@ frame_data_sequence_add(frame_data_sequence *fds, frame_data *fdata)
     node = &leaf[LEAF_INDEX(fds->count)];
   }
   *node = *fdata;
+  if (fds->time_index_valid)
+    frame_time_index_add(fds, fds->count, &node->abs_ts);
   fds->count++;
   return node;
 }
@@ -224,6 +291,116 @@ frame_data_sequence_find(frame_data_sequence *fds, guint32 num)
   return &leaf[LEAF_INDEX(num)];
 }
 
+/*
+ * Note that the time stamps of frames have been changed, e.g. by a
+ * time shift.
+ */
+void
+frame_data_sequence_invalidate_time_index(frame_data_sequence *fds)
+{
+  if (fds)
+    fds->time_index_valid = FALSE;
+}
+
+static void
+frame_time_index_rebuild(frame_data_sequence *fds)
+{
+  guint32 num;
+
+  g_array_set_size(fds->leaf_bounds, 0);
+  g_array_set_size(fds->group_bounds, 0);
+  fds->ts_monotonic = TRUE;
+  for (num = 1; num <= fds->count; num++)
+    frame_time_index_add(fds, num - 1, &frame_data_sequence_find(fds, num)->abs_ts);
+  fds->time_index_valid = TRUE;
+}
+
+static inline gboolean
+frame_time_bounds_overlap(const frame_time_bounds *bounds, const nstime_t *start, const nstime_t *end)
+{
+  if (start && nstime_cmp(&bounds->max_ts, start) < 0)
+    return FALSE;
+  if (end && nstime_cmp(&bounds->min_ts, end) >= 0)
+    return FALSE;
+  return TRUE;
+}
+
+/*
+ * Find the first frame after frame number "after" whose absolute time
+ * stamp lies within [start, end).
+ */
+guint32
+frame_data_sequence_find_next_in_time_range(frame_data_sequence *fds,
+    guint32 after, const nstime_t *start, const nstime_t *end)
+{
+  guint32 idx = after;        /* The index of frame number after + 1 */
+
+  if (fds == NULL)
+    return 0;
+
+  if (!fds->time_index_valid)
+    frame_time_index_rebuild(fds);
+
+  if (fds->ts_monotonic && start) {
+    /*
+     * The leaf bounds are sorted; binary search for the first leaf
+     * that ends at or after start.
+     */
+    guint32 lo = 0, hi = fds->leaf_bounds->len;
+
+    while (lo < hi) {
+      guint32 mid = lo + (hi - lo) / 2;
+
+      if (nstime_cmp(&g_array_index(fds->leaf_bounds, frame_time_bounds, mid).max_ts, start) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    if (idx < (lo << LOG2_NODES_PER_LEVEL))
+      idx = lo << LOG2_NODES_PER_LEVEL;
+  }
+
+  while (idx < fds->count) {
+    const frame_time_bounds *bounds;
+    frame_data *fdata;
+    guint32 last;
+
+    bounds = &g_array_index(fds->group_bounds, frame_time_bounds, idx >> LOG2_FRAMES_PER_GROUP);
+    if (!frame_time_bounds_overlap(bounds, start, end)) {
+      if (fds->ts_monotonic && end && nstime_cmp(&bounds->min_ts, end) >= 0)
+        return 0;
+      idx = ((idx >> LOG2_FRAMES_PER_GROUP) + 1) << LOG2_FRAMES_PER_GROUP;
+      continue;
+    }
+
+    bounds = &g_array_index(fds->leaf_bounds, frame_time_bounds, idx >> LOG2_NODES_PER_LEVEL);
+    last = ((idx >> LOG2_NODES_PER_LEVEL) + 1) << LOG2_NODES_PER_LEVEL;
+    if (!frame_time_bounds_overlap(bounds, start, end)) {
+      if (fds->ts_monotonic && end && nstime_cmp(&bounds->min_ts, end) >= 0)
+        return 0;
+      idx = last;
+      continue;
+    }
+
+    /* Scan this leaf. */
+    if (last > fds->count)
+      last = fds->count;
+    for (; idx < last; idx++) {
+      fdata = frame_data_sequence_find(fds, idx + 1);
+      if (start && nstime_cmp(&fdata->abs_ts, start) < 0)
+        continue;
+      if (end && nstime_cmp(&fdata->abs_ts, end) >= 0) {
+        if (fds->ts_monotonic)
+          return 0;
+        continue;
+      }
+      return idx + 1;
+    }
+  }
+
+  return 0;
+}
+
 /* recursively frees a frame_data radix level */
 static void
 free_frame_data_array(void *array, guint count, guint level, gboolean last)
@@ -307,6 +484,9 @@ free_frame_data_sequence(frame_data_sequence *fds)
     free_frame_data_array(fds->ptree_root, fds->count, levels, TRUE);
   }
 
+  g_array_free(fds->leaf_bounds, TRUE);
+  g_array_free(fds->group_bounds, TRUE);
+
   /* free the header struct */
   g_free(fds);
 }
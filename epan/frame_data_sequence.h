@@ -28,6 +28,28 @@ WS_DLL_PUBLIC frame_data *frame_data_sequence_add(frame_data_sequence *fds,
 WS_DLL_PUBLIC frame_data *frame_data_sequence_find(frame_data_sequence *fds,
     guint32 num);
 
+/*
+ * Find the first frame after frame number "after" whose absolute time
+ * stamp lies within [start, end); start and end may be NULL for an
+ * unbounded range.  Pass 0 for "after" to start with the first frame.
+ * Returns 0 if there are no more such frames.
+ *
+ * Frames are returned in frame number order, so repeatedly calling
+ * this with the previous result visits every frame in the range.
+ * Blocks of frames whose time stamps all lie outside the range are
+ * skipped without being looked at.
+ */
+WS_DLL_PUBLIC guint32 frame_data_sequence_find_next_in_time_range(
+    frame_data_sequence *fds, guint32 after, const nstime_t *start,
+    const nstime_t *end);
+
+/*
+ * Tell the frame_data_sequence that the time stamps of its frames have
+ * changed, so that its time index is rebuilt before it's used again.
+ */
+WS_DLL_PUBLIC void frame_data_sequence_invalidate_time_index(
+    frame_data_sequence *fds);
+
 /*
  * Free a frame_data_sequence and all the frame_data structures in it.
  */
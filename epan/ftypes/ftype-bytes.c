@@ -27,7 +27,18 @@ bytes_fvalue_new(fvalue_t *fv)
 static void
 bytes_fvalue_copy(fvalue_t *dst, const fvalue_t *src)
 {
-	dst->value.bytes = g_bytes_ref(src->value.bytes);
+	const uint8_t *data;
+	size_t size;
+
+	if (src->value.bytes == NULL) {
+		dst->value.bytes = NULL;
+		return;
+	}
+
+	/* The source may reference packet data (see
+	 * fvalue_set_bytes_data_static()), so take a private copy. */
+	data = g_bytes_get_data(src->value.bytes, &size);
+	dst->value.bytes = g_bytes_new(data, size);
 }
 
 static void
@@ -10,6 +10,7 @@
 
 #include "ftypes-int.h"
 
+#include <epan/exceptions.h>
 #include <wsutil/ws_assert.h>
 
 /* Keep track of ftype_t's via their ftenum number */
@@ -472,6 +473,16 @@ fvalue_new(ftenum_t ftype)
 	return fv;
 }
 
+fvalue_t*
+fvalue_new_scoped(wmem_allocator_t *scope, ftenum_t ftype)
+{
+	fvalue_t		*fv;
+
+	fv = wmem_new(scope, fvalue_t);
+	fvalue_init(fv, ftype);
+	return fv;
+}
+
 fvalue_t*
 fvalue_dup(const fvalue_t *fv_orig)
 {
@@ -927,6 +938,14 @@ fvalue_set_bytes_data(fvalue_t *fv, const void *data, size_t size)
 	g_bytes_unref(bytes);
 }
 
+void
+fvalue_set_bytes_data_static(fvalue_t *fv, const void *data, size_t size)
+{
+	GBytes *bytes = g_bytes_new_static(data, size);
+	fvalue_set_bytes(fv, bytes);
+	g_bytes_unref(bytes);
+}
+
 void
 fvalue_set_fcwwn(fvalue_t *fv, const uint8_t *value)
 {
@@ -1331,6 +1350,84 @@ fvalue_matches(const fvalue_t *a, const ws_regex_t *re)
 	return yes ? FT_TRUE : FT_FALSE;
 }
 
+/* Get the bytes that "contains" searches in (or for) a value. Returns
+ * false if the type doesn't support "contains" or there is no data. */
+static bool
+contains_data(const fvalue_t *fv, const uint8_t **data, size_t *length)
+{
+	const uint8_t * volatile ptr = NULL;
+	volatile size_t len = 0;
+	tvbuff_t *tvb;
+
+	switch (fv->ftype->ftype) {
+		case FT_STRING:
+		case FT_STRINGZ:
+		case FT_UINT_STRING:
+		case FT_STRINGZPAD:
+		case FT_STRINGZTRUNC:
+			*data = (const uint8_t *)fv->value.strbuf->str;
+			*length = fv->value.strbuf->len;
+			return true;
+		case FT_BYTES:
+		case FT_UINT_BYTES:
+		case FT_AX25:
+		case FT_VINES:
+		case FT_ETHER:
+		case FT_OID:
+		case FT_REL_OID:
+		case FT_SYSTEM_ID:
+		case FT_FCWWN:
+			*data = g_bytes_get_data(fv->value.bytes, length);
+			return true;
+		case FT_PROTOCOL:
+			/* Protocols without a tvb never contain a constant,
+			 * whose protocol string is empty; see cmp_contains()
+			 * in ftype-protocol.c. */
+			tvb = fv->value.protocol.tvb;
+			if (tvb == NULL)
+				return false;
+			TRY {
+				len = tvb_captured_length(tvb);
+				ptr = tvb_get_ptr(tvb, 0, (int)len);
+			}
+			CATCH_ALL {
+				ptr = NULL;
+			}
+			ENDTRY;
+			if (ptr == NULL)
+				return false;
+			*data = ptr;
+			*length = len;
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool
+fvalue_add_contains_pattern(ws_multisearch_t *ms, const fvalue_t *b)
+{
+	const uint8_t *data;
+	size_t length;
+
+	if (!contains_data(b, &data, &length))
+		return false;
+	ws_multisearch_add(ms, data, length);
+	return true;
+}
+
+ft_bool_t
+fvalue_contains_any(const fvalue_t *a, const ws_multisearch_t *ms)
+{
+	const uint8_t *data;
+	size_t length;
+
+	ws_assert(a->ftype->contains);
+	if (!contains_data(a, &data, &length))
+		return FT_FALSE;
+	return ws_multisearch_find(ms, data, length) ? FT_TRUE : FT_FALSE;
+}
+
 bool
 fvalue_is_zero(const fvalue_t *a)
 {
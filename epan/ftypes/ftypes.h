@@ -15,6 +15,7 @@
 #include <wireshark.h>
 
 #include <wsutil/regex.h>
+#include <wsutil/multisearch.h>
 #include <epan/wmem_scopes.h>
 
 #ifdef __cplusplus
@@ -307,6 +308,12 @@ WS_DLL_PUBLIC
 fvalue_t*
 fvalue_new(ftenum_t ftype);
 
+/* Allocate and initialize an fvalue_t from a wmem scope. Release
+ * it with fvalue_cleanup(); the memory itself belongs to the scope. */
+WS_DLL_PUBLIC
+fvalue_t*
+fvalue_new_scoped(wmem_allocator_t *scope, ftenum_t ftype);
+
 WS_DLL_PUBLIC
 fvalue_t*
 fvalue_dup(const fvalue_t *fv);
@@ -392,6 +399,12 @@ WS_DLL_PUBLIC
 void
 fvalue_set_bytes_data(fvalue_t *fv, const void *data, size_t size);
 
+/* Like fvalue_set_bytes_data(), but references the data instead of
+ * copying it. The data must outlive the fvalue; fvalue_dup() copies it. */
+WS_DLL_PUBLIC
+void
+fvalue_set_bytes_data_static(fvalue_t *fv, const void *data, size_t size);
+
 WS_DLL_PUBLIC
 void
 fvalue_set_fcwwn(fvalue_t *fv, const uint8_t *value);
@@ -550,6 +563,19 @@ WS_DLL_PUBLIC
 ft_bool_t
 fvalue_matches(const fvalue_t *a, const ws_regex_t *re);
 
+/* Adds the bytes that "contains" looks for in b to the pattern set.
+ * Returns false if the type of b can't be used. */
+WS_DLL_PUBLIC
+bool
+fvalue_add_contains_pattern(ws_multisearch_t *ms, const fvalue_t *b);
+
+/* True if a contains any of the patterns in the compiled set. This is
+ * the same as fvalue_contains() with each of them, except that empty
+ * patterns never match. */
+WS_DLL_PUBLIC
+ft_bool_t
+fvalue_contains_any(const fvalue_t *a, const ws_multisearch_t *ms);
+
 WS_DLL_PUBLIC
 bool
 fvalue_is_zero(const fvalue_t *a);
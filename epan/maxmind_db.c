@@ -41,6 +41,7 @@ static mmdb_lookup_t mmdb_not_found;
 #include <wsutil/ws_pipe.h>
 #include <wsutil/strtoi.h>
 #include <wsutil/glib-compat.h>
+#include <wsutil/pint.h>
 
 // To do:
 // - Add RBL lookups? Along with the "is this a spammer" information that most RBL databases
@@ -364,6 +365,503 @@ read_mmdbr_stdout_worker(gpointer data _U_) {
     return NULL;
 }
 
+/*
+ * Built-in MaxMind DB reader.
+ *
+ * libmaxminddb is Apache-2.0 licensed, which is why lookups normally go
+ * through the separate mmdbresolve process. The MaxMind DB format is
+ * simple enough to read directly, so unless the user opts out we map each
+ * database into memory and walk it here. Results are available
+ * immediately and land in the same per-address maps that mmdbresolve
+ * responses do. If a database can't be opened we fall back to
+ * mmdbresolve.
+ *
+ * https://maxmind.github.io/MaxMind-DB/
+ */
+
+#define MMDB_METADATA_MARKER        "\xAB\xCD\xEFMaxMind.com"
+#define MMDB_METADATA_MARKER_LEN    14
+#define MMDB_METADATA_MAX_SIZE      (128 * 1024)
+#define MMDB_DATA_SECTION_SEPARATOR 16
+#define MMDB_MAX_DEPTH              32
+
+#define MMDB_TYPE_EXTENDED  0
+#define MMDB_TYPE_POINTER   1
+#define MMDB_TYPE_UTF8      2
+#define MMDB_TYPE_DOUBLE    3
+#define MMDB_TYPE_BYTES     4
+#define MMDB_TYPE_UINT16    5
+#define MMDB_TYPE_UINT32    6
+#define MMDB_TYPE_MAP       7
+#define MMDB_TYPE_INT32     8
+#define MMDB_TYPE_UINT64    9
+#define MMDB_TYPE_UINT128   10
+#define MMDB_TYPE_ARRAY     11
+#define MMDB_TYPE_BOOLEAN   14
+#define MMDB_TYPE_FLOAT     15
+
+typedef struct _mmdb_section_t {
+    const guint8 *base;
+    size_t size;
+} mmdb_section_t;
+
+typedef struct _mmdb_value_t {
+    guint type;
+    guint32 size;   // Payload length, or the number of entries for maps and arrays
+    size_t offset;  // Payload offset
+} mmdb_value_t;
+
+typedef struct _mmdb_reader_t {
+    GMappedFile *mapped_file;
+    const guint8 *tree;
+    guint32 node_count;
+    guint record_size;
+    guint node_size;
+    guint32 ipv4_start_node;
+    gboolean ipv6_tree;
+    mmdb_section_t data;
+} mmdb_reader_t;
+
+static GPtrArray *mmdb_readers; // mmdb_reader_t *
+
+static gboolean use_builtin_reader = TRUE;
+static gboolean mmdb_readers_failed;
+
+/* Decode the control byte(s) of the field at *offset. For pointers,
+ * size is set to the pointer value. */
+static gboolean
+mmdb_read_control(const mmdb_section_t *sec, size_t *offset, guint *type, guint32 *size) {
+    const guint8 *p;
+
+    if (*offset >= sec->size) {
+        return FALSE;
+    }
+    guint8 ctrl = sec->base[(*offset)++];
+    *type = ctrl >> 5;
+
+    if (*type == MMDB_TYPE_POINTER) {
+        guint ss = (ctrl >> 3) & 0x3;
+        guint32 vvv = ctrl & 0x7;
+
+        if (sec->size - *offset < ss + 1) {
+            return FALSE;
+        }
+        p = sec->base + *offset;
+        switch (ss) {
+        case 0:
+            *size = (vvv << 8) | p[0];
+            break;
+        case 1:
+            *size = ((vvv << 16) | pntoh16(p)) + 2048;
+            break;
+        case 2:
+            *size = ((vvv << 24) | pntoh24(p)) + 526336;
+            break;
+        default:
+            *size = pntoh32(p);
+            break;
+        }
+        *offset += ss + 1;
+        return TRUE;
+    }
+
+    if (*type == MMDB_TYPE_EXTENDED) {
+        if (*offset >= sec->size) {
+            return FALSE;
+        }
+        *type = 7 + sec->base[(*offset)++];
+    }
+
+    *size = ctrl & 0x1f;
+    if (*size >= 29) {
+        guint extra = *size - 28;
+
+        if (sec->size - *offset < extra) {
+            return FALSE;
+        }
+        p = sec->base + *offset;
+        switch (extra) {
+        case 1:
+            *size = 29 + p[0];
+            break;
+        case 2:
+            *size = 285 + pntoh16(p);
+            break;
+        default:
+            *size = 65821 + pntoh24(p);
+            break;
+        }
+        *offset += extra;
+    }
+    return TRUE;
+}
+
+/* Decode the field at offset, following a pointer if there is one. */
+static gboolean
+mmdb_read_value(const mmdb_section_t *sec, size_t offset, mmdb_value_t *value) {
+    if (!mmdb_read_control(sec, &offset, &value->type, &value->size)) {
+        return FALSE;
+    }
+    if (value->type == MMDB_TYPE_POINTER) {
+        offset = value->size;
+        // Pointers to pointers are invalid.
+        if (!mmdb_read_control(sec, &offset, &value->type, &value->size) || value->type == MMDB_TYPE_POINTER) {
+            return FALSE;
+        }
+    }
+    value->offset = offset;
+
+    switch (value->type) {
+    case MMDB_TYPE_MAP:
+    case MMDB_TYPE_ARRAY:
+    case MMDB_TYPE_BOOLEAN:
+        return TRUE;
+    default:
+        return sec->size - offset >= value->size;
+    }
+}
+
+/* Advance *offset past the field there without following pointers. */
+static gboolean
+mmdb_skip_value(const mmdb_section_t *sec, size_t *offset, int depth) {
+    guint type;
+    guint32 size;
+
+    if (depth > MMDB_MAX_DEPTH || !mmdb_read_control(sec, offset, &type, &size)) {
+        return FALSE;
+    }
+
+    switch (type) {
+    case MMDB_TYPE_POINTER:
+    case MMDB_TYPE_BOOLEAN:
+        return TRUE;
+    case MMDB_TYPE_MAP:
+        size *= 2;
+        /* FALL THROUGH */
+    case MMDB_TYPE_ARRAY:
+        for (guint32 i = 0; i < size; i++) {
+            if (!mmdb_skip_value(sec, offset, depth + 1)) {
+                return FALSE;
+            }
+        }
+        return TRUE;
+    default:
+        if (sec->size - *offset < size) {
+            return FALSE;
+        }
+        *offset += size;
+        return TRUE;
+    }
+}
+
+/* Look up a value by its dotted map key path, e.g. "country.names.en". */
+static gboolean
+mmdb_get_path(const mmdb_section_t *sec, size_t offset, const char *path, mmdb_value_t *value) {
+    if (!mmdb_read_value(sec, offset, value)) {
+        return FALSE;
+    }
+
+    while (*path) {
+        const char *key_end = strchr(path, '.');
+        size_t key_len = key_end ? (size_t) (key_end - path) : strlen(path);
+        size_t cur = value->offset;
+        guint32 pairs = value->size;
+        gboolean found = FALSE;
+
+        if (value->type != MMDB_TYPE_MAP) {
+            return FALSE;
+        }
+
+        for (guint32 i = 0; i < pairs && !found; i++) {
+            mmdb_value_t key;
+
+            if (!mmdb_read_value(sec, cur, &key) || !mmdb_skip_value(sec, &cur, 0)) {
+                return FALSE;
+            }
+            if (key.type == MMDB_TYPE_UTF8 && key.size == key_len &&
+                    memcmp(sec->base + key.offset, path, key_len) == 0) {
+                if (!mmdb_read_value(sec, cur, value)) {
+                    return FALSE;
+                }
+                found = TRUE;
+            } else if (!mmdb_skip_value(sec, &cur, 0)) {
+                return FALSE;
+            }
+        }
+        if (!found) {
+            return FALSE;
+        }
+        path += key_end ? key_len + 1 : key_len;
+    }
+    return TRUE;
+}
+
+static gboolean
+mmdb_get_uint(const mmdb_section_t *sec, size_t offset, const char *path, guint64 *uint_val) {
+    mmdb_value_t value;
+
+    if (!mmdb_get_path(sec, offset, path, &value)) {
+        return FALSE;
+    }
+    switch (value.type) {
+    case MMDB_TYPE_UINT16:
+    case MMDB_TYPE_UINT32:
+    case MMDB_TYPE_INT32:
+    case MMDB_TYPE_UINT64:
+        if (value.size > 8) {
+            return FALSE;
+        }
+        *uint_val = 0;
+        for (guint32 i = 0; i < value.size; i++) {
+            *uint_val = (*uint_val << 8) | sec->base[value.offset + i];
+        }
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+static gboolean
+mmdb_get_double(const mmdb_section_t *sec, size_t offset, const char *path, double *double_val) {
+    mmdb_value_t value;
+
+    if (!mmdb_get_path(sec, offset, path, &value)) {
+        return FALSE;
+    }
+    if (value.type == MMDB_TYPE_DOUBLE && value.size == 8) {
+        guint64 bits = pntoh64(sec->base + value.offset);
+        memcpy(double_val, &bits, sizeof(bits));
+        return TRUE;
+    }
+    if (value.type == MMDB_TYPE_FLOAT && value.size == 4) {
+        guint32 bits = pntoh32(sec->base + value.offset);
+        float float_val;
+        memcpy(&float_val, &bits, sizeof(bits));
+        *double_val = float_val;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static const char *
+mmdb_get_string(const mmdb_section_t *sec, size_t offset, const char *path) {
+    mmdb_value_t value;
+
+    if (!mmdb_get_path(sec, offset, path, &value) || value.type != MMDB_TYPE_UTF8 || value.size == 0) {
+        return NULL;
+    }
+    char *str = g_strndup((const char *) sec->base + value.offset, value.size);
+    const char *chunk_str = chunkify_string(str);
+    g_free(str);
+    return chunk_str;
+}
+
+static guint32
+mmdb_read_record(const mmdb_reader_t *reader, guint32 node, int bit) {
+    const guint8 *p = reader->tree + (size_t) node * reader->node_size;
+
+    switch (reader->record_size) {
+    case 24:
+        return pntoh24(p + (bit ? 3 : 0));
+    case 28:
+        if (bit) {
+            return ((guint32) (p[3] & 0x0f) << 24) | pntoh24(p + 4);
+        }
+        return ((guint32) (p[3] & 0xf0) << 20) | pntoh24(p);
+    default:
+        return pntoh32(p + (bit ? 4 : 0));
+    }
+}
+
+static void
+mmdb_reader_free(mmdb_reader_t *reader) {
+    g_mapped_file_unref(reader->mapped_file);
+    g_free(reader);
+}
+
+static mmdb_reader_t *
+mmdb_reader_open(const char *path) {
+    GError *err = NULL;
+    GMappedFile *mapped_file = g_mapped_file_new(path, FALSE, &err);
+
+    if (!mapped_file) {
+        ws_debug("can't map %s: %s", path, err->message);
+        g_clear_error(&err);
+        return NULL;
+    }
+
+    const guint8 *data = (const guint8 *) g_mapped_file_get_contents(mapped_file);
+    size_t size = g_mapped_file_get_length(mapped_file);
+    size_t search_start = size > MMDB_METADATA_MAX_SIZE ? size - MMDB_METADATA_MAX_SIZE : 0;
+    const guint8 *marker = NULL;
+
+    // The metadata follows the last occurrence of the marker.
+    for (size_t i = size; data && i >= search_start + MMDB_METADATA_MARKER_LEN; i--) {
+        if (memcmp(data + i - MMDB_METADATA_MARKER_LEN, MMDB_METADATA_MARKER, MMDB_METADATA_MARKER_LEN) == 0) {
+            marker = data + i - MMDB_METADATA_MARKER_LEN;
+            break;
+        }
+    }
+    if (!marker) {
+        ws_debug("%s: no metadata", path);
+        g_mapped_file_unref(mapped_file);
+        return NULL;
+    }
+
+    mmdb_section_t metadata = { marker + MMDB_METADATA_MARKER_LEN, size - (marker - data) - MMDB_METADATA_MARKER_LEN };
+    guint64 major_version = 0, node_count = 0, record_size = 0, ip_version = 0;
+
+    if (!mmdb_get_uint(&metadata, 0, "binary_format_major_version", &major_version) || major_version != 2 ||
+            !mmdb_get_uint(&metadata, 0, "node_count", &node_count) || node_count == 0 || node_count > G_MAXUINT32 ||
+            !mmdb_get_uint(&metadata, 0, "record_size", &record_size) ||
+            (record_size != 24 && record_size != 28 && record_size != 32) ||
+            !mmdb_get_uint(&metadata, 0, "ip_version", &ip_version) ||
+            (ip_version != 4 && ip_version != 6)) {
+        ws_debug("%s: unsupported metadata", path);
+        g_mapped_file_unref(mapped_file);
+        return NULL;
+    }
+
+    size_t tree_size = (size_t) node_count * (record_size / 4);
+    if (tree_size + MMDB_DATA_SECTION_SEPARATOR > (size_t) (marker - data)) {
+        ws_debug("%s: truncated search tree", path);
+        g_mapped_file_unref(mapped_file);
+        return NULL;
+    }
+
+    mmdb_reader_t *reader = g_new0(mmdb_reader_t, 1);
+    reader->mapped_file = mapped_file;
+    reader->tree = data;
+    reader->node_count = (guint32) node_count;
+    reader->record_size = (guint) record_size;
+    reader->node_size = (guint) record_size / 4;
+    reader->ipv6_tree = ip_version == 6;
+    reader->data.base = data + tree_size + MMDB_DATA_SECTION_SEPARATOR;
+    reader->data.size = (marker - data) - tree_size - MMDB_DATA_SECTION_SEPARATOR;
+
+    // IPv4 addresses live in ::/96 of an IPv6 tree.
+    guint32 node = 0;
+    for (int i = 0; i < 96 && reader->ipv6_tree && node < reader->node_count; i++) {
+        node = mmdb_read_record(reader, node, 0);
+    }
+    reader->ipv4_start_node = node;
+
+    ws_debug("opened %s: %u nodes, %u bit records, IPv%u", path, reader->node_count, reader->record_size, (guint) ip_version);
+    return reader;
+}
+
+/* Find the data section offset of the record for an address. */
+static gboolean
+mmdb_reader_find(const mmdb_reader_t *reader, const guint8 *addr, int bits, size_t *data_offset) {
+    guint32 node = 0;
+
+    if (bits == 32) {
+        node = reader->ipv4_start_node;
+    } else if (!reader->ipv6_tree) {
+        return FALSE;
+    }
+
+    for (int i = 0; i < bits && node < reader->node_count; i++) {
+        node = mmdb_read_record(reader, node, (addr[i >> 3] >> (7 - (i & 7))) & 1);
+    }
+
+    if (node <= reader->node_count) {
+        return FALSE;
+    }
+    *data_offset = (size_t) (node - reader->node_count) - MMDB_DATA_SECTION_SEPARATOR;
+    return *data_offset < reader->data.size;
+}
+
+static void
+mmdb_readers_close(void) {
+    if (mmdb_readers) {
+        g_ptr_array_free(mmdb_readers, TRUE);
+        mmdb_readers = NULL;
+    }
+}
+
+/* Open every database in mmdb_file_arr. Returns FALSE if any of them
+ * can't be read, in which case mmdbresolve should be used instead. */
+static gboolean
+mmdb_readers_open(void) {
+    mmdb_readers_close();
+    mmdb_readers = g_ptr_array_new_with_free_func((GDestroyNotify) mmdb_reader_free);
+
+    for (guint i = 0; i < mmdb_file_arr->len; i++) {
+        const char *path = (const char *) g_ptr_array_index(mmdb_file_arr, i);
+        mmdb_reader_t *reader = mmdb_reader_open(path);
+
+        if (!reader) {
+            ws_debug("falling back to mmdbresolve");
+            mmdb_readers_close();
+            mmdb_readers_failed = TRUE;
+            return FALSE;
+        }
+        g_ptr_array_add(mmdb_readers, reader);
+    }
+    return TRUE;
+}
+
+/* Look an address up in each database. Later databases override
+ * earlier ones, as with mmdbresolve. Main thread only. */
+static mmdb_lookup_t *
+mmdb_readers_lookup(const guint8 *addr, int bits) {
+    mmdb_lookup_t lookup;
+
+    init_lookup(&lookup);
+
+    for (guint i = 0; i < mmdb_readers->len; i++) {
+        const mmdb_reader_t *reader = (const mmdb_reader_t *) g_ptr_array_index(mmdb_readers, i);
+        const mmdb_section_t *sec = &reader->data;
+        size_t offset;
+        const char *str_val;
+        guint64 uint_val;
+        double double_val;
+
+        if (!mmdb_reader_find(reader, addr, bits, &offset)) {
+            continue;
+        }
+
+        if ((str_val = mmdb_get_string(sec, offset, RES_COUNTRY_ISO_CODE)) != NULL) {
+            lookup.found = TRUE;
+            lookup.country_iso = str_val;
+        }
+        if ((str_val = mmdb_get_string(sec, offset, RES_COUNTRY_NAMES_EN)) != NULL) {
+            lookup.found = TRUE;
+            lookup.country = str_val;
+        }
+        if ((str_val = mmdb_get_string(sec, offset, RES_CITY_NAMES_EN)) != NULL) {
+            lookup.found = TRUE;
+            lookup.city = str_val;
+        }
+        if ((str_val = mmdb_get_string(sec, offset, RES_ASN_ORG)) != NULL) {
+            lookup.found = TRUE;
+            lookup.as_org = str_val;
+        }
+        if (mmdb_get_uint(sec, offset, RES_ASN_NUMBER, &uint_val) && uint_val <= G_MAXUINT32) {
+            lookup.found = TRUE;
+            lookup.as_number = (guint32) uint_val;
+        }
+        if (mmdb_get_double(sec, offset, RES_LOCATION_LATITUDE, &double_val)) {
+            lookup.found = TRUE;
+            lookup.latitude = double_val;
+        }
+        if (mmdb_get_double(sec, offset, RES_LOCATION_LONGITUDE, &double_val)) {
+            lookup.found = TRUE;
+            lookup.longitude = double_val;
+        }
+        if (mmdb_get_uint(sec, offset, RES_LOCATION_ACCURACY, &uint_val) && uint_val <= G_MAXUINT16) {
+            lookup.found = TRUE;
+            lookup.accuracy = (guint16) uint_val;
+        }
+    }
+
+    if (!lookup.found) {
+        return &mmdb_not_found;
+    }
+    return (mmdb_lookup_t *) wmem_memdup(wmem_epan_scope(), &lookup, sizeof(mmdb_lookup_t));
+}
+
 /**
  * Stop our mmdbresolve process.
  * Main thread only.
@@ -372,6 +870,8 @@ static void mmdb_resolve_stop(void) {
     char *request;
     mmdb_response_t *response;
 
+    mmdb_readers_close();
+
     while (mmdbr_request_q && (request = (char *) g_async_queue_try_pop(mmdbr_request_q)) != NULL) {
         g_free(request);
     }
@@ -445,7 +945,7 @@ static void mmdb_resolve_stop(void) {
 }
 
 /**
- * Start an mmdbresolve process.
+ * Open our databases in-process, or start an mmdbresolve process.
  */
 static void mmdb_resolve_start(void) {
     if (!mmdbr_request_q) {
@@ -478,12 +978,17 @@ static void mmdb_resolve_start(void) {
     }
 
     mmdb_resolve_stop();
+    mmdb_readers_failed = FALSE;
 
     if (mmdb_file_arr->len == 0) {
         ws_debug("no GeoIP databases found");
         return;
     }
 
+    if (use_builtin_reader && mmdb_readers_open()) {
+        return;
+    }
+
     GPtrArray *args = g_ptr_array_new();
     char *mmdbresolve = get_executable_path("mmdbresolve");
     g_ptr_array_add(args, mmdbresolve);
@@ -612,6 +1117,14 @@ maxmind_db_pref_init(module_t *nameres)
             "Lookup geolocation information for IPv4 and IPv6 addresses with configured MaxMind databases",
             &gbl_resolv_flags.maxmind_geoip);
 
+    prefs_register_bool_preference(nameres,
+            "maxmind_builtin_reader",
+            "Read MaxMind databases in-process",
+            "Read MaxMind databases directly instead of through mmdbresolve."
+            " Geolocation information is then available on the first pass."
+            " mmdbresolve is still used if a database can't be read.",
+            &use_builtin_reader);
+
     static uat_field_t maxmind_db_paths_fields[] = {
         UAT_FLD_DIRECTORYNAME(maxmind_mod, path, "MaxMind Database Directory", "The MaxMind database directory path"),
         UAT_END_FIELDS
@@ -649,11 +1162,13 @@ void maxmind_db_pref_cleanup(void)
 void maxmind_db_pref_apply(void)
 {
     if (gbl_resolv_flags.maxmind_geoip) {
-        if (!mmdbr_pipe_valid()) {
+        // Restart if we aren't running or if the reader preference changed.
+        gboolean tried_builtin_reader = mmdb_readers || mmdb_readers_failed;
+        if ((!mmdb_readers && !mmdbr_pipe_valid()) || tried_builtin_reader != use_builtin_reader) {
             mmdb_resolve_start();
         }
     } else {
-        if (mmdbr_pipe_valid()) {
+        if (mmdb_readers || mmdbr_pipe_valid()) {
             mmdb_resolve_stop();
         }
     }
@@ -736,6 +1251,12 @@ maxmind_db_lookup_ipv4(const ws_in4_addr *addr) {
     mmdb_lookup_t *result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv4_map, GUINT_TO_POINTER(*addr));
 
     if (!result) {
+        if (mmdb_readers) {
+            result = mmdb_readers_lookup((const guint8 *) addr, 32);
+            wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(*addr), result);
+            return result;
+        }
+
         result = &mmdb_not_found;
         wmem_map_insert(mmdb_ipv4_map, GUINT_TO_POINTER(*addr), result);
 
@@ -763,6 +1284,12 @@ maxmind_db_lookup_ipv6(const ws_in6_addr *addr) {
     mmdb_lookup_t * result = (mmdb_lookup_t *) wmem_map_lookup(mmdb_ipv6_map, addr->bytes);
 
     if (!result) {
+        if (mmdb_readers) {
+            result = mmdb_readers_lookup(addr->bytes, 128);
+            wmem_map_insert(mmdb_ipv6_map, chunkify_v6_addr(addr), result);
+            return result;
+        }
+
         result = &mmdb_not_found;
         wmem_map_insert(mmdb_ipv6_map, chunkify_v6_addr(addr), result);
 
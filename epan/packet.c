@@ -628,6 +628,8 @@ dissect_record(epan_dissect_t *edt, int file_type_subtype,
 	edt->pi.src_win_scale = -1; /* unknown Rcv.Wind.Shift */
 	edt->pi.dst_win_scale = -1; /* unknown Rcv.Wind.Shift */
 	edt->pi.layers = wmem_list_new(edt->pi.pool);
+	edt->pi.layer_set = NULL;
+	edt->pi.layer_set_len = 0;
 	edt->tvb = tvb;
 
 	frame_delta_abs_time(edt->session, fd, fd->frame_ref_num, &edt->pi.rel_ts);
@@ -705,6 +707,8 @@ dissect_file(epan_dissect_t *edt, wtap_rec *rec,
 	edt->pi.p2p_dir = P2P_DIR_UNKNOWN;
 	edt->pi.link_dir = LINK_DIR_UNKNOWN;
 	edt->pi.layers = wmem_list_new(edt->pi.pool);
+	edt->pi.layer_set = NULL;
+	edt->pi.layer_set_len = 0;
 	edt->tvb = tvb;
 
 
@@ -768,6 +772,39 @@ struct dissector_handle {
 	protocol_t	*protocol;
 };
 
+static void
+layer_set_update(packet_info *pinfo, int proto_id, gboolean present)
+{
+	guint idx = proto_get_layer_index(proto_id);
+
+	if (pinfo->layer_set == NULL) {
+		pinfo->layer_set_len = (proto_get_layer_count() + 31) / 32;
+		pinfo->layer_set = wmem_alloc0_array(pinfo->pool, guint32, pinfo->layer_set_len);
+	}
+	if (idx / 32 >= pinfo->layer_set_len)
+		return;
+
+	if (present)
+		pinfo->layer_set[idx / 32] |= 1U << (idx % 32);
+	else
+		pinfo->layer_set[idx / 32] &= ~(1U << (idx % 32));
+}
+
+gboolean
+packet_has_layer(const packet_info *pinfo, const int proto_id)
+{
+	guint idx;
+
+	if (pinfo->layer_set == NULL)
+		return FALSE;
+
+	idx = proto_get_layer_index(proto_id);
+	if (idx / 32 >= pinfo->layer_set_len)
+		return FALSE;
+
+	return (pinfo->layer_set[idx / 32] & (1U << (idx % 32))) != 0;
+}
+
 static void
 add_layer(packet_info *pinfo, int proto_id)
 {
@@ -775,6 +812,7 @@ add_layer(packet_info *pinfo, int proto_id)
 
 	pinfo->curr_layer_num++;
 	wmem_list_append(pinfo->layers, GINT_TO_POINTER(proto_id));
+	layer_set_update(pinfo, proto_id, TRUE);
 
 	/* Increment layer number for this proto id. */
 	if (pinfo->proto_layers == NULL) {
@@ -810,6 +848,14 @@ remove_last_layer(packet_info *pinfo, gboolean reduce_count)
 	proto_id = GPOINTER_TO_INT(wmem_list_frame_data(frame));
 	wmem_list_remove_frame(pinfo->layers, frame);
 
+	/* The protocol may still be present further down the stack. */
+	for (frame = wmem_list_head(pinfo->layers); frame; frame = wmem_list_frame_next(frame)) {
+		if (GPOINTER_TO_INT(wmem_list_frame_data(frame)) == proto_id)
+			break;
+	}
+	if (frame == NULL)
+		layer_set_update(pinfo, proto_id, FALSE);
+
 	if (reduce_count) {
 		/* Reduce count for removed protocol layer. */
 		proto_layer_num_ptr = wmem_map_lookup(pinfo->proto_layers, GINT_TO_POINTER(proto_id));
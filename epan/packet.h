@@ -769,6 +769,13 @@ WS_DLL_PUBLIC void add_new_data_source(packet_info *pinfo, tvbuff_t *tvb,
 /* Removes the last-added data source, if it turns out it wasn't needed */
 WS_DLL_PUBLIC void remove_last_data_source(packet_info *pinfo);
 
+/*
+ * Return TRUE if the protocol with the given ID is currently one of the
+ * layers of the frame (pinfo->layers). This is a constant-time bit set
+ * lookup, cheaper than proto_is_frame_protocol() for hot paths.
+ */
+WS_DLL_PUBLIC gboolean packet_has_layer(const packet_info *pinfo, const int proto_id);
+
 /*
  * Return the data source name, tvb.
  */
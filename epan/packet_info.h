@@ -137,6 +137,8 @@ typedef struct _packet_info {
 
   wmem_list_t *layers;          /**< layers of each protocol */
   wmem_map_t *proto_layers;     /** map of proto_id to curr_proto_layer_num. */
+  guint32 *layer_set;           /**< bit set of protocols in layers, indexed by proto_get_layer_index() */
+  guint layer_set_len;          /**< number of guint32 words in layer_set */
   guint8 curr_layer_num;        /**< The current "depth" or layer number in the current frame */
   guint8 curr_proto_layer_num;  /**< The current "depth" or layer number for this dissector in the current frame */
   guint16 link_number;
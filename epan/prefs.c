@@ -85,6 +85,7 @@ static gboolean prefs_initialized = FALSE;
 static gchar *gpf_path = NULL;
 static gchar *cols_hidden_list = NULL;
 static gboolean gui_theme_is_dark = FALSE;
+static unsigned prefs_generation = 0;
 
 /*
  * XXX - variables to allow us to attempt to interpret the first
@@ -912,6 +913,7 @@ call_apply_cb(const void *key _U_, void *value, void *data _U_)
     if (module->obsolete)
         return FALSE;
     if (module->prefs_changed_flags) {
+        prefs_generation++;
         if (module->apply_cb != NULL)
             (*module->apply_cb)();
         module->prefs_changed_flags = 0;
@@ -921,6 +923,12 @@ call_apply_cb(const void *key _U_, void *value, void *data _U_)
     return FALSE;
 }
 
+unsigned
+prefs_get_generation(void)
+{
+    return prefs_generation;
+}
+
 /*
  * Call the "apply" callback function for each module if any of its
  * preferences have changed, and then clear the flag saying its
@@ -3573,11 +3581,13 @@ prefs_register_modules(void)
                                    "To prevent sorting by mistake (which can take some time to calculate), it can be disabled",
                                    &prefs.gui_packet_list_sortable);
 
-    prefs_register_uint_preference(gui_module, "packet_list_cached_rows_max",
-                                   "Maximum cached rows",
-                                   "Maximum number of rows that can be sorted by columns that require dissection. Increasing this increases memory consumption by caching column text",
+    prefs_register_obsolete_preference(gui_module, "packet_list_cached_rows_max");
+
+    prefs_register_uint_preference(gui_module, "packet_list_cache_size",
+                                   "Packet list cache size (MB)",
+                                   "Memory used to cache the column text of packet list rows. Increasing this increases memory consumption but makes scrolling and sorting by columns that require dissection faster",
                                    10,
-                                   &prefs.gui_packet_list_cached_rows_max);
+                                   &prefs.gui_packet_list_cache_size);
 
     prefs_register_bool_preference(gui_module, "interfaces_show_hidden",
                                    "Show hidden interfaces",
@@ -4233,7 +4243,7 @@ pre_init_prefs(void)
     prefs.gui_packet_list_show_related = TRUE;
     prefs.gui_packet_list_show_minimap = TRUE;
     prefs.gui_packet_list_sortable     = TRUE;
-    prefs.gui_packet_list_cached_rows_max = 10000;
+    prefs.gui_packet_list_cache_size = 128;
     g_free (prefs.gui_interfaces_hide_types);
     prefs.gui_interfaces_hide_types = g_strdup("");
     prefs.gui_interfaces_show_hidden = FALSE;
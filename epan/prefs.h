@@ -224,7 +224,7 @@ typedef struct _e_prefs {
   gboolean     gui_packet_list_show_related;
   gboolean     gui_packet_list_show_minimap;
   gboolean     gui_packet_list_sortable;
-  guint        gui_packet_list_cached_rows_max;
+  guint        gui_packet_list_cache_size; /* MB */
   gint         gui_decimal_places1; /* Used for type 1 calculations */
   gint         gui_decimal_places2; /* Used for type 2 calculations */
   gint         gui_decimal_places3; /* Used for type 3 calculations */
@@ -403,6 +403,13 @@ WS_DLL_PUBLIC void prefs_apply_all(void);
  */
 WS_DLL_PUBLIC void prefs_apply(module_t *module);
 
+/**
+ * Get a counter that changes whenever changed preferences of a module
+ * have been applied. Callers caching data derived from preferences can
+ * compare it to know when to drop their cache.
+ */
+WS_DLL_PUBLIC unsigned prefs_get_generation(void);
+
 
 struct preference;
 
@@ -282,7 +282,7 @@ proto_tree_set_protocol_tvb(field_info *fi, tvbuff_t *tvb, const char* field_dat
 static void
 proto_tree_set_bytes(field_info *fi, const guint8* start_ptr, gint length);
 static void
-proto_tree_set_bytes_tvb(field_info *fi, tvbuff_t *tvb, gint offset, gint length);
+proto_tree_set_bytes_tvb(proto_tree *tree, field_info *fi, tvbuff_t *tvb, gint offset, gint length);
 static void
 proto_tree_set_bytes_gbytearray(field_info *fi, const GByteArray *value);
 static void
@@ -385,11 +385,18 @@ struct _protocol {
 	                                   can be added to a dissector table, but use the
 	                                   parent_proto_id for things like enable/disable */
 	GList      *heur_list;          /* Heuristic dissectors associated with this protocol */
+	guint       layer_index;        /* dense index used for per-packet layer sets */
 };
 
 /* List of all protocols */
 static GList *protocols = NULL;
 
+/* Number of layer indices handed out to protocols so far */
+static guint protocol_layer_count = 0;
+
+/* Bumped whenever a field or protocol is registered or deregistered */
+static guint registrar_generation = 0;
+
 /* Structure stored for deregistered g_slice */
 struct g_slice_data {
 	gsize    block_size;
@@ -487,6 +494,7 @@ static const char *reserved_filter_names[] = {
 	"bitand",
 	"bitwise_and",
 	"contains",
+	"contains_any",
 	"matches",
 	"not",
 	"and",
@@ -810,7 +818,7 @@ proto_tree_free_node(proto_node *node, gpointer data _U_)
 
 	proto_tree_children_foreach(node, proto_tree_free_node, NULL);
 
-	fvalue_free(finfo->value);
+	fvalue_cleanup(finfo->value);
 	finfo->value = NULL;
 }
 
@@ -2643,7 +2651,7 @@ static void
 free_fvalue_cb(void *data)
 {
 	fvalue_t *fv = (fvalue_t*)data;
-	fvalue_free(fv);
+	fvalue_cleanup(fv);
 }
 
 /* Add an item to a proto_tree, using the text label registered to that item;
@@ -2680,12 +2688,12 @@ proto_tree_new_item(field_info *new_fi, proto_tree *tree,
 			break;
 
 		case FT_BYTES:
-			proto_tree_set_bytes_tvb(new_fi, tvb, start, length);
+			proto_tree_set_bytes_tvb(tree, new_fi, tvb, start, length);
 			break;
 
 		case FT_UINT_BYTES:
 			n = get_uint_value(tree, tvb, start, length, encoding);
-			proto_tree_set_bytes_tvb(new_fi, tvb, start + length, n);
+			proto_tree_set_bytes_tvb(tree, new_fi, tvb, start + length, n);
 
 			/* Instead of calling proto_item_set_len(), since we don't yet
 			 * have a proto_item, we set the field_info's length ourselves. */
@@ -4459,7 +4467,7 @@ proto_tree_add_bytes_item(proto_tree *tree, int hfindex, tvbuff_t *tvb,
 	}
 	else {
 		/* n will be zero except when it's a FT_UINT_BYTES */
-		proto_tree_set_bytes_tvb(new_fi, tvb, start + n, length);
+		proto_tree_set_bytes_tvb(tree, new_fi, tvb, start + n, length);
 
 		/* XXX: If we have a non-NULL tree but NULL retval, we don't
 		 * use the byte array created above in this case.
@@ -4745,11 +4753,34 @@ proto_tree_set_bytes(field_info *fi, const guint8* start_ptr, gint length)
 }
 
 
+/* Returns TRUE if ds_tvb is one of the packet's data sources, whose
+ * data stays around until the packet (and its tree) is freed. */
+static gboolean
+is_packet_data_source(packet_info *pinfo, tvbuff_t *ds_tvb)
+{
+	GSList *src;
+
+	for (src = pinfo->data_src; src; src = src->next) {
+		if (get_data_source_tvb((struct data_source *)src->data) == ds_tvb)
+			return TRUE;
+	}
+	return FALSE;
+}
+
 static void
-proto_tree_set_bytes_tvb(field_info *fi, tvbuff_t *tvb, gint offset, gint length)
+proto_tree_set_bytes_tvb(proto_tree *tree, field_info *fi, tvbuff_t *tvb, gint offset, gint length)
 {
+	const guint8 *start_ptr;
+
 	tvb_ensure_bytes_exist(tvb, offset, length);
-	proto_tree_set_bytes(fi, tvb_get_ptr(tvb, offset, length), length);
+	start_ptr = tvb_get_ptr(tvb, offset, length);
+
+	/* Reference the packet data rather than copying it if it will
+	 * outlive the field. */
+	if (length > 0 && is_packet_data_source(PTREE_DATA(tree)->pinfo, tvb_get_ds_tvb(tvb)))
+		fvalue_set_bytes_data_static(fi->value, start_ptr, length);
+	else
+		proto_tree_set_bytes(fi, start_ptr, length);
 }
 
 static void
@@ -6296,7 +6327,7 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 		for (tnode = tree; tnode != NULL; tnode = tnode->parent) {
 			depth++;
 			if (G_UNLIKELY(depth > prefs.gui_max_tree_depth)) {
-				fvalue_free(fi->value);
+				fvalue_cleanup(fi->value);
 				fi->value = NULL;
 				THROW_MESSAGE(DissectorError, wmem_strdup_printf(PNODE_POOL(tree),
 						     "Maximum tree depth %d exceeded for \"%s\" - \"%s\" (%s:%u) (Maximum depth can be increased in advanced preferences)",
@@ -6321,7 +6352,7 @@ proto_tree_add_node(proto_tree *tree, field_info *fi)
 		/* Since we are not adding fi to a node, its fvalue won't get
 		 * freed by proto_tree_free_node(), so free it now.
 		 */
-		fvalue_free(fi->value);
+		fvalue_cleanup(fi->value);
 		fi->value = NULL;
 		REPORT_DISSECTOR_BUG("\"%s\" - \"%s\" tfi->tree_type: %d invalid (%s:%u)",
 				     fi->hfinfo->name, fi->hfinfo->abbrev, tfi->tree_type, __FILE__, __LINE__);
@@ -6674,7 +6705,7 @@ new_field_info(proto_tree *tree, header_field_info *hfinfo, tvbuff_t *tvb,
 	fi->flags      = 0;
 	if (!PTREE_DATA(tree)->visible)
 		FI_SET_FLAG(fi, FI_HIDDEN);
-	fi->value = fvalue_new(fi->hfinfo->type);
+	fi->value = fvalue_new_scoped(PNODE_POOL(tree), fi->hfinfo->type);
 	fi->rep        = NULL;
 
 	/* add the data source tvbuff */
@@ -7497,10 +7528,11 @@ finfo_set_len(field_info *fi, const gint length)
 	 */
 	if (fvalue_type_ftenum(fi->value) == FT_BYTES && fi->length > 0) {
 		GBytes *bytes = fvalue_get_bytes(fi->value);
-		gsize size;
-		const void *data = g_bytes_get_data(bytes, &size);
-		if ((gsize)fi->length <= size) {
-			fvalue_set_bytes_data(fi->value, data, fi->length);
+		if ((gsize)fi->length <= g_bytes_get_size(bytes)) {
+			/* Shares the data (copied or not) with the old value. */
+			GBytes *prefix = g_bytes_new_from_bytes(bytes, 0, fi->length);
+			fvalue_set_bytes(fi->value, prefix);
+			g_bytes_unref(prefix);
 		}
 		g_bytes_unref(bytes);
 	}
@@ -7903,6 +7935,7 @@ proto_register_protocol(const char *name, const char *short_name,
 	protocol->can_toggle = TRUE;
 	protocol->parent_proto_id = -1;
 	protocol->heur_list = NULL;
+	protocol->layer_index = protocol_layer_count++;
 
 	/* List will be sorted later by name, when all protocols completed registering */
 	protocols = g_list_prepend(protocols, protocol);
@@ -7962,6 +7995,7 @@ proto_register_protocol_in_name_only(const char *name, const char *short_name, c
 
 	protocol->parent_proto_id = parent_proto;
 	protocol->heur_list = NULL;
+	protocol->layer_index = protocol_layer_count++;
 
 	/* List will be sorted later by name, when all protocols completed registering */
 	protocols = g_list_prepend(protocols, protocol);
@@ -7998,6 +8032,8 @@ proto_deregister_protocol(const char *short_name)
 	if (protocol == NULL)
 		return FALSE;
 
+	registrar_generation++;
+
 	g_hash_table_remove(proto_names, protocol->name);
 	g_hash_table_remove(proto_short_names, (gpointer)short_name);
 	g_hash_table_remove(proto_filter_names, (gpointer)protocol->filter_name);
@@ -8128,6 +8164,28 @@ proto_get_id(const protocol_t *protocol)
 	return protocol->proto_id;
 }
 
+guint
+proto_get_layer_index(const int proto_id)
+{
+	protocol_t *protocol = find_protocol_by_id(proto_id);
+
+	if (protocol == NULL)
+		return G_MAXUINT;
+	return protocol->layer_index;
+}
+
+guint
+proto_get_layer_count(void)
+{
+	return protocol_layer_count;
+}
+
+guint
+proto_registrar_get_generation(void)
+{
+	return registrar_generation;
+}
+
 gboolean
 proto_name_already_registered(const gchar *name)
 {
@@ -8487,6 +8545,8 @@ proto_deregister_field (const int parent, gint hf_id)
 	if (hf_id == -1 || hf_id == 0)
 		return;
 
+	registrar_generation++;
+
 	proto = find_protocol_by_id (parent);
 	if (!proto || proto->fields == NULL) {
 		return;
@@ -9374,6 +9434,8 @@ proto_register_field_init(header_field_info *hfinfo, const int parent)
 
 	tmp_fld_check_assert(hfinfo);
 
+	registrar_generation++;
+
 	hfinfo->parent         = parent;
 	hfinfo->same_name_next = NULL;
 	hfinfo->same_name_prev_id = -1;
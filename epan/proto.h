@@ -2658,6 +2658,12 @@ WS_DLL_PUBLIC header_field_info* proto_registrar_get_nth(guint hfindex);
  @return the registered item */
 WS_DLL_PUBLIC header_field_info* proto_registrar_get_byname(const char *field_name);
 
+/** Get a counter that changes whenever a field or protocol is registered
+ or deregistered. Callers caching data derived from the registered fields
+ can compare it to know when to drop their cache.
+ @return the registration generation */
+WS_DLL_PUBLIC guint proto_registrar_get_generation(void);
+
 /** Get the header_field information based upon a field alias.
  @param alias_name the aliased field name to search for
  @return the registered item */
@@ -2731,6 +2737,16 @@ WS_DLL_PUBLIC const char *proto_get_protocol_name(const int proto_id);
  @return its proto_id */
 WS_DLL_PUBLIC int proto_get_id(const protocol_t *protocol);
 
+/** Get the dense index of a protocol, used to address per-packet layer sets.
+ Indices are assigned in registration order and are never reused.
+ @param proto_id protocol id (0-indexed)
+ @return its layer index, or G_MAXUINT if proto_id is not a protocol */
+WS_DLL_PUBLIC guint proto_get_layer_index(const int proto_id);
+
+/** Get the number of layer indices assigned so far.
+ @return one more than the highest layer index */
+WS_DLL_PUBLIC guint proto_get_layer_count(void);
+
 /** Get the protocol's short name, for the given protocol's "protocol_t".
  @return its short name. */
 WS_DLL_PUBLIC const char *proto_get_protocol_short_name(const protocol_t *protocol);
@@ -48,6 +48,13 @@ enum _stat_tree_columns {
 /* used to contain the registered stat trees */
 static GHashTable *registry = NULL;
 
+/* hash of a node name, used to find it among its parent's children */
+static guint
+stats_tree_name_hash(const gchar *name)
+{
+    return g_str_hash(name);
+}
+
 /* a text representation of a node
 if buffer is NULL returns a newly allocated string */
 extern gchar*
@@ -106,7 +113,7 @@ free_stat_node(stat_node *node)
     }
     }
 
-    if (node->hash) g_hash_table_destroy(node->hash);
+    g_free(node->child_index);
 
     while (node->bh) {
         bucket = node->bh;
@@ -130,6 +137,7 @@ stats_tree_free(stats_tree *st)
 
     g_free(st->filter);
     g_hash_table_destroy(st->names);
+    g_free(st->root.child_index);
     g_ptr_array_free(st->parents,TRUE);
     g_free(st->display_name);
 
@@ -216,6 +224,11 @@ stats_tree_reinit(void *p)
     }
 
     st->root.children = NULL;
+    st->root.last_child = NULL;
+    g_free(st->root.child_index);
+    st->root.child_index = NULL;
+    st->root.child_index_size = 0;
+    st->root.num_children = 0;
     st->root.counter = 0;
     switch (st->root.datatype)
     {
@@ -355,6 +368,7 @@ stats_tree_new(stats_tree_cfg *cfg, tree_pres *pr, const char *filter)
     st->root.burst_time = -1.0;
 
     st->root.name = stats_tree_get_displayname(cfg->name);
+    st->root.name_hash = stats_tree_name_hash(st->root.name);
     st->root.st = st;
 
     st->st_flags = st->cfg->st_flags;
@@ -452,6 +466,106 @@ stats_tree_presentation(void (*registry_iterator)(gpointer,gpointer,gpointer),
 }
 
 
+/*
+ * Children are kept in a linked list, in creation order, for presentation.
+ * Nodes with many children (hosts, URIs, query names...) also get an
+ * open-addressing hash index of them, so that looking up the child to
+ * tick doesn't require walking the list.
+ */
+#define STAT_NODE_INDEX_MIN_CHILDREN 8
+
+static stat_node*
+stat_node_find_child(const stat_node *parent, const gchar *name, guint name_hash)
+{
+    stat_node *child;
+    stat_node *found = NULL;
+    guint mask, i;
+
+    if (parent->child_index) {
+        mask = parent->child_index_size - 1;
+        for (i = name_hash & mask; (child = parent->child_index[i]) != NULL; i = (i + 1) & mask) {
+            if (child->name_hash == name_hash && strcmp(child->name, name) == 0)
+                return child;
+        }
+        return NULL;
+    }
+
+    /* The most recently created child with the name wins, as in the index. */
+    for (child = parent->children; child; child = child->next) {
+        if (child->name_hash == name_hash && strcmp(child->name, name) == 0)
+            found = child;
+    }
+    return found;
+}
+
+static void
+stat_node_index_insert(stat_node **index, guint size, stat_node *node)
+{
+    guint mask = size - 1;
+    guint i;
+
+    for (i = node->name_hash & mask; index[i] != NULL; i = (i + 1) & mask) {
+        if (index[i]->name_hash == node->name_hash && strcmp(index[i]->name, node->name) == 0)
+            break;
+    }
+    index[i] = node;
+}
+
+/* Rebuild the index with room for twice as many children as we have. */
+static void
+stat_node_index_rebuild(stat_node *parent)
+{
+    stat_node *child;
+    guint size = 16;
+
+    while (size < parent->num_children * 4)
+        size <<= 1;
+
+    g_free(parent->child_index);
+    parent->child_index = g_new0(stat_node*, size);
+    parent->child_index_size = size;
+
+    for (child = parent->children; child; child = child->next)
+        stat_node_index_insert(parent->child_index, size, child);
+}
+
+static void
+stat_node_add_child(stat_node *parent, stat_node *node)
+{
+    /* insert as last child */
+    if (parent->last_child) {
+        parent->last_child->next = node;
+    } else {
+        parent->children = node;
+    }
+    parent->last_child = node;
+    parent->num_children++;
+
+    if (parent->child_index && parent->num_children * 2 <= parent->child_index_size) {
+        stat_node_index_insert(parent->child_index, parent->child_index_size, node);
+    } else if (parent->num_children > STAT_NODE_INDEX_MIN_CHILDREN) {
+        stat_node_index_rebuild(parent);
+    }
+}
+
+/*
+ * Find the node to manipulate. Nodes whose parent was created with_hash
+ * are only looked up among that parent's children; for other parents we
+ * first look in the namespace of named (parent) nodes.
+ */
+static stat_node*
+stat_node_lookup(stats_tree *st, stat_node *parent, const gchar *name, guint name_hash)
+{
+    stat_node *node;
+
+    if (!parent->with_hash) {
+        node = (stat_node *)g_hash_table_lookup(st->names,name);
+        if (node)
+            return node;
+    }
+    return stat_node_find_child(parent, name, name_hash);
+}
+
 /* creates a stat_tree node
 *    name: the name of the stats_tree node
 *    parent_name: the name of the ALREADY REGISTERED parent
@@ -459,12 +573,11 @@ stats_tree_presentation(void (*registry_iterator)(gpointer,gpointer,gpointer),
 *    as_named_node: whether or not it has to be registered in the root namespace
 */
 static stat_node*
-new_stat_node(stats_tree *st, const gchar *name, int parent_id, stat_node_datatype datatype,
-          gboolean with_hash, gboolean as_parent_node)
+new_stat_node(stats_tree *st, const gchar *name, guint name_hash, int parent_id,
+          stat_node_datatype datatype, gboolean with_hash, gboolean as_parent_node)
 {
 
     stat_node *node = g_new0(stat_node, 1);
-    stat_node *last_chld = NULL;
 
     node->datatype = datatype;
     switch (datatype)
@@ -485,8 +598,9 @@ new_stat_node(stats_tree *st, const gchar *name, int parent_id, stat_node_dataty
     node->burst_time = -1.0;
 
     node->name = g_strdup(name);
+    node->name_hash = name_hash;
     node->st = st;
-    node->hash = with_hash ? g_hash_table_new(g_str_hash,g_str_equal) : NULL;
+    node->with_hash = with_hash;
 
     if (as_parent_node) {
         g_hash_table_insert(st->names,
@@ -507,23 +621,7 @@ new_stat_node(stats_tree *st, const gchar *name, int parent_id, stat_node_dataty
         ws_assert_not_reached();
     }
 
-    if (node->parent->children) {
-        /* insert as last child */
-
-        for (last_chld = node->parent->children;
-             last_chld->next;
-             last_chld = last_chld->next ) ;
-
-        last_chld->next = node;
-
-    } else {
-        /* insert as first child */
-        node->parent->children = node;
-    }
-
-    if(node->parent->hash) {
-        g_hash_table_replace(node->parent->hash,node->name,node);
-    }
+    stat_node_add_child(node->parent, node);
 
     if (st->cfg->setup_node_pr) {
         st->cfg->setup_node_pr(node);
@@ -538,7 +636,7 @@ new_stat_node(stats_tree *st, const gchar *name, int parent_id, stat_node_dataty
 extern int
 stats_tree_create_node(stats_tree *st, const gchar *name, int parent_id, stat_node_datatype datatype, gboolean with_hash)
 {
-    stat_node *node = new_stat_node(st,name,parent_id,datatype,with_hash,TRUE);
+    stat_node *node = new_stat_node(st,name,stats_tree_name_hash(name),parent_id,datatype,with_hash,TRUE);
 
     if (node)
         return node->id;
@@ -653,19 +751,16 @@ stats_tree_manip_node_int(manip_node_mode mode, stats_tree *st, const char *name
 {
     stat_node *node = NULL;
     stat_node *parent = NULL;
+    guint name_hash = stats_tree_name_hash(name);
 
     ws_assert( parent_id >= 0 && parent_id < (int) st->parents->len );
 
     parent = (stat_node *)g_ptr_array_index(st->parents,parent_id);
 
-    if( parent->hash ) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
-    } else {
-        node = (stat_node *)g_hash_table_lookup(st->names,name);
-    }
+    node = stat_node_lookup(st, parent, name, name_hash);
 
     if ( node == NULL )
-        node = new_stat_node(st,name,parent_id,STAT_DT_INT,with_hash,with_hash);
+        node = new_stat_node(st,name,name_hash,parent_id,STAT_DT_INT,with_hash,with_hash);
 
     switch (mode) {
         case MN_INCREASE:
@@ -715,20 +810,16 @@ stats_tree_manip_node_float(manip_node_mode mode, stats_tree *st, const char *na
 {
     stat_node *node = NULL;
     stat_node *parent = NULL;
+    guint name_hash = stats_tree_name_hash(name);
 
     ws_assert(parent_id >= 0 && parent_id < (int)st->parents->len);
 
     parent = (stat_node *)g_ptr_array_index(st->parents, parent_id);
 
-    if (parent->hash) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash, name);
-    }
-    else {
-        node = (stat_node *)g_hash_table_lookup(st->names, name);
-    }
+    node = stat_node_lookup(st, parent, name, name_hash);
 
     if (node == NULL)
-        node = new_stat_node(st, name, parent_id, STAT_DT_FLOAT, with_hash, with_hash);
+        node = new_stat_node(st, name, name_hash, parent_id, STAT_DT_FLOAT, with_hash, with_hash);
 
     switch (mode) {
     case MN_AVERAGE:
@@ -841,12 +932,12 @@ stats_tree_create_range_node(stats_tree *st, const gchar *name, int parent_id, .
 {
     va_list list;
     gchar *curr_range;
-    stat_node *rng_root = new_stat_node(st, name, parent_id, STAT_DT_INT, FALSE, TRUE);
+    stat_node *rng_root = new_stat_node(st, name, stats_tree_name_hash(name), parent_id, STAT_DT_INT, FALSE, TRUE);
     stat_node *range_node = NULL;
 
     va_start( list, parent_id );
     while (( curr_range = va_arg(list, gchar*) )) {
-        range_node = new_stat_node(st, curr_range, rng_root->id, STAT_DT_INT, FALSE, FALSE);
+        range_node = new_stat_node(st, curr_range, stats_tree_name_hash(curr_range), rng_root->id, STAT_DT_INT, FALSE, FALSE);
         range_node->rng = get_range(curr_range);
     }
     va_end( list );
@@ -860,14 +951,14 @@ stats_tree_create_range_node_string(stats_tree *st, const gchar *name,
                     gchar** str_ranges)
 {
     int i;
-    stat_node *rng_root = new_stat_node(st, name, parent_id, STAT_DT_INT, FALSE, TRUE);
+    stat_node *rng_root = new_stat_node(st, name, stats_tree_name_hash(name), parent_id, STAT_DT_INT, FALSE, TRUE);
     stat_node *range_node = NULL;
 
     for (i = 0; i < num_str_ranges - 1; i++) {
-        range_node = new_stat_node(st, str_ranges[i], rng_root->id, STAT_DT_INT, FALSE, FALSE);
+        range_node = new_stat_node(st, str_ranges[i], stats_tree_name_hash(str_ranges[i]), rng_root->id, STAT_DT_INT, FALSE, FALSE);
         range_node->rng = get_range(str_ranges[i]);
     }
-    range_node = new_stat_node(st, str_ranges[i], rng_root->id, STAT_DT_INT, FALSE, FALSE);
+    range_node = new_stat_node(st, str_ranges[i], stats_tree_name_hash(str_ranges[i]), rng_root->id, STAT_DT_INT, FALSE, FALSE);
     range_node->rng = get_range(str_ranges[i]);
     if (range_node->rng->floor == range_node->rng->ceil) {
         range_node->rng->ceil = G_MAXINT;
@@ -897,11 +988,11 @@ stats_tree_range_node_with_pname(stats_tree *st, const gchar *name,
     gchar *curr_range;
     stat_node *range_node = NULL;
     int parent_id = stats_tree_parent_id_by_name(st,parent_name);
-    stat_node *rng_root = new_stat_node(st, name, parent_id, STAT_DT_INT, FALSE, TRUE);
+    stat_node *rng_root = new_stat_node(st, name, stats_tree_name_hash(name), parent_id, STAT_DT_INT, FALSE, TRUE);
 
     va_start( list, parent_name );
     while (( curr_range = va_arg(list, gchar*) )) {
-        range_node = new_stat_node(st, curr_range, rng_root->id, STAT_DT_INT, FALSE, FALSE);
+        range_node = new_stat_node(st, curr_range, stats_tree_name_hash(curr_range), rng_root->id, STAT_DT_INT, FALSE, FALSE);
         range_node->rng = get_range(curr_range);
     }
     va_end( list );
@@ -926,11 +1017,7 @@ stats_tree_tick_range(stats_tree *st, const gchar *name, int parent_id,
         ws_assert_not_reached();
     }
 
-    if( parent->hash ) {
-        node = (stat_node *)g_hash_table_lookup(parent->hash,name);
-    } else {
-        node = (stat_node *)g_hash_table_lookup(st->names,name);
-    }
+    node = stat_node_lookup(st, parent, name, stats_tree_name_hash(name));
 
     if ( node == NULL )
         ws_assert_not_reached();
@@ -970,7 +1057,7 @@ stats_tree_tick_range(stats_tree *st, const gchar *name, int parent_id,
 extern int
 stats_tree_create_pivot(stats_tree *st, const gchar *name, int parent_id)
 {
-    stat_node *node = new_stat_node(st,name,parent_id,STAT_DT_INT,TRUE,TRUE);
+    stat_node *node = new_stat_node(st,name,stats_tree_name_hash(name),parent_id,STAT_DT_INT,TRUE,TRUE);
 
     if (node)
         return node->id;
@@ -985,7 +1072,7 @@ stats_tree_create_pivot_by_pname(stats_tree *st, const gchar *name,
     int parent_id = stats_tree_parent_id_by_name(st,parent_name);
     stat_node *node;
 
-    node = new_stat_node(st,name,parent_id,STAT_DT_INT,TRUE,TRUE);
+    node = new_stat_node(st,name,stats_tree_name_hash(name),parent_id,STAT_DT_INT,TRUE,TRUE);
 
     if (node)
         return node->id;
@@ -81,8 +81,18 @@ struct _stat_node {
 	gint			max_burst;
 	double			burst_time;
 
-	/** children nodes by name */
-	GHashTable		*hash;
+	/** hash of the name, for quicker lookups by name */
+	guint			name_hash;
+
+	/** TRUE if children are only looked up under this node, rather
+	 *  than first in the tree's namespace of parent nodes */
+	gboolean		with_hash;
+
+	/** open-addressing index of the children by name, built once
+	 *  there are more than STAT_NODE_INDEX_MIN_CHILDREN of them */
+	stat_node		**child_index;
+	guint			child_index_size;
+	guint			num_children;
 
 	/** the owner of this node */
 	stats_tree		*st;
@@ -90,6 +100,7 @@ struct _stat_node {
 	/** relatives */
 	stat_node		*parent;
 	stat_node		*children;
+	stat_node		*last_child;
 	stat_node		*next;
 
 	/** used to check if value is within range */
@@ -86,6 +86,10 @@ typedef struct _tap_listener_t {
 	guint flags;
 	gchar *fstring;
 	dfilter_t *code;
+	/* result of code for the packet being pushed, if code_pushed
+	   matches tap_push_count */
+	guint64 code_pushed;
+	gboolean code_passed;
 	void *tapdata;
 	tap_reset_cb reset;
 	tap_packet_cb packet;
@@ -95,6 +99,9 @@ typedef struct _tap_listener_t {
 
 static tap_listener_t *tap_listener_queue=NULL;
 
+/* number of times the tapped queue has been pushed */
+static guint64 tap_push_count=0;
+
 static GSList *tap_plugins = NULL;
 
 #ifdef HAVE_PLUGINS
@@ -319,6 +326,10 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 		return;
 	}
 
+	/* A listener may be queued several times for the same packet;
+	   the tree doesn't change, so evaluate its filter only once. */
+	tap_push_count++;
+
 	/* loop over all tap listeners and call the listener callback
 	   for all packets that match the filter. */
 	for(i=0;i<tap_packet_index;i++){
@@ -350,7 +361,11 @@ tap_push_tapped_queue(epan_dissect_t *edt)
 					 */
 					guint flags = tl->flags;
 					if(tl->code){
-						if (!dfilter_apply_edt(tl->code, edt)){
+						if(tl->code_pushed!=tap_push_count){
+							tl->code_passed=dfilter_apply_edt(tl->code, edt);
+							tl->code_pushed=tap_push_count;
+						}
+						if (!tl->code_passed){
 							/* The packet didn't
 							 * pass the filter. */
 							if (tl->flags & TL_IGNORE_DISPLAY_FILTER)
@@ -92,29 +92,7 @@ static void match_subtree_text(proto_node *node, gpointer data);
 static void match_subtree_text_reverse(proto_node *node, gpointer data);
 static match_result match_summary_line(capture_file *cf, frame_data *fdata,
         wtap_rec *, Buffer *, void *criterion);
-static match_result match_narrow_and_wide(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_narrow_and_wide_reverse(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_narrow_and_wide_case(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_narrow_and_wide_case_reverse(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_narrow_case(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_narrow_case_reverse(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_wide(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_wide_reverse(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_wide_case(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_wide_case_reverse(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_binary(capture_file *cf, frame_data *fdata,
-        wtap_rec *, Buffer *, void *criterion);
-static match_result match_binary_reverse(capture_file *cf, frame_data *fdata,
+static match_result match_data(capture_file *cf, frame_data *fdata,
         wtap_rec *, Buffer *, void *criterion);
 static match_result match_regex(capture_file *cf, frame_data *fdata,
         wtap_rec *, Buffer *, void *criterion);
@@ -370,6 +348,7 @@ cf_close(capture_file *cf)
     color_filters_cleanup();
 
     if (cf->provider.wth) {
+        cap_file_provider_clear_read_cache(&cf->provider);
         wtap_close(cf->provider.wth);
         cf->provider.wth = NULL;
     }
@@ -716,6 +695,10 @@ cf_read(capture_file *cf, gboolean reloading)
     /* compute the time it took to load the file */
     compute_elapsed(cf, start_time);
 
+    /* Look up the addresses in the file all at once, rather than as
+       they're displayed. */
+    host_name_lookup_prefetch();
+
     /* Set the file encapsulation type now; we don't know what it is until
        we've looked at all the packets, as we don't know until then whether
        there's more than one type (and thus whether it's
@@ -1647,7 +1630,8 @@ cf_read_record(capture_file *cf, const frame_data *fdata,
     int    err;
     gchar *err_info;
 
-    if (!wtap_seek_read(cf->provider.wth, fdata->file_off, rec, buf, &err, &err_info)) {
+    if (!cap_file_provider_read_record(&cf->provider, fdata->num, fdata->file_off,
+                rec, buf, &err, &err_info)) {
         cfile_read_failure_alert_box(cf->filename, err, err_info);
         return FALSE;
     }
@@ -1661,7 +1645,8 @@ cf_read_record_no_alert(capture_file *cf, const frame_data *fdata,
     int    err;
     gchar *err_info;
 
-    if (!wtap_seek_read(cf->provider.wth, fdata->file_off, rec, buf, &err, &err_info)) {
+    if (!cap_file_provider_read_record(&cf->provider, fdata->num, fdata->file_off,
+                rec, buf, &err, &err_info)) {
         g_free(err_info);
         return FALSE;
     }
@@ -3529,9 +3514,18 @@ match_summary_line(capture_file *cf, frame_data *fdata,
 typedef struct {
     const guint8 *data;
     size_t        data_len;
-    ws_mempbrk_pattern *pattern;
+    guint8       *wide;         /* data widened to UTF-16, or NULL */
+    size_t        wide_len;
+    gboolean      narrow;       /* look for data itself */
+    gboolean      nocase;       /* data is upper case; ignore ASCII case */
+    gboolean      reverse;      /* look for the last match in a frame */
+    ws_mempbrk_pattern *pattern; /* first byte of data in either case */
 } cbs_t;    /* "Counted byte string" */
 
+static guint8 *widen_string(const guint8 *string, size_t len, size_t *wide_len);
+static gboolean find_packet_data(capture_file *cf, cbs_t *info,
+        search_direction dir);
+
 
 /*
  * The current match_* routines only support ASCII case insensitivity and don't
@@ -3552,60 +3546,47 @@ gboolean
 cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
         search_direction dir, bool multiple)
 {
-    cbs_t  info;
+    cbs_t  info = {0};
     guint8 needles[3];
     ws_mempbrk_pattern pattern = {0};
     ws_match_function match_function;
+    gboolean succeeded;
 
     info.data = string;
     info.data_len = string_size;
+    info.narrow = TRUE;
+    info.reverse = (cf->dir != SD_FORWARD);
 
     /* Regex, String or hex search? */
     if (cf->regex) {
         /* Regular Expression search */
-        match_function = (cf->dir == SD_FORWARD) ? match_regex : match_regex_reverse;
-    } else if (cf->string) {
-        /* String search - what type of string? */
-        if (cf->case_type) {
-            needles[0] = string[0];
-            needles[1] = g_ascii_tolower(needles[0]);
-            needles[2] = '\0';
-            ws_mempbrk_compile(&pattern, needles);
-            info.pattern = &pattern;
-            switch (cf->scs_type) {
-
-                case SCS_NARROW_AND_WIDE:
-                    match_function = (cf->dir == SD_FORWARD) ? match_narrow_and_wide_case : match_narrow_and_wide_case_reverse;
-                    break;
-
-                case SCS_NARROW:
-                    match_function = (cf->dir == SD_FORWARD) ? match_narrow_case : match_narrow_case_reverse;
-                    break;
-
-                case SCS_WIDE:
-                    match_function = (cf->dir == SD_FORWARD) ? match_wide_case : match_wide_case_reverse;
-                    break;
-
-                default:
-                    ws_assert_not_reached();
-                    return FALSE;
+        match_function = info.reverse ? match_regex_reverse : match_regex;
+    } else {
+        /* Narrow, case-sensitive match is the same as looking
+         * for a converted hexstring. */
+        match_function = match_data;
+        if (cf->string) {
+            /* String search - what type of string? */
+            if (cf->case_type) {
+                needles[0] = string[0];
+                needles[1] = g_ascii_tolower(needles[0]);
+                needles[2] = '\0';
+                ws_mempbrk_compile(&pattern, needles);
+                info.pattern = &pattern;
+                info.nocase = TRUE;
             }
-
-        } else {
             switch (cf->scs_type) {
 
                 case SCS_NARROW_AND_WIDE:
-                    match_function = (cf->dir == SD_FORWARD) ? match_narrow_and_wide : match_narrow_and_wide_reverse;
+                    info.wide = widen_string(string, string_size, &info.wide_len);
                     break;
 
                 case SCS_NARROW:
-                    /* Narrow, case-sensitive match is the same as looking
-                     * for a converted hexstring. */
-                    match_function = (cf->dir == SD_FORWARD) ? match_binary : match_binary_reverse;
                     break;
 
                 case SCS_WIDE:
-                    match_function = (cf->dir == SD_FORWARD) ? match_wide : match_wide_reverse;
+                    info.wide = widen_string(string, string_size, &info.wide_len);
+                    info.narrow = FALSE;
                     break;
 
                 default:
@@ -3613,8 +3594,6 @@ cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
                     return FALSE;
             }
         }
-    } else {
-        match_function = (cf->dir == SD_FORWARD) ? match_binary : match_binary_reverse;
     }
 
     if (multiple && cf->current_frame && (cf->search_pos || cf->search_len)) {
@@ -3634,461 +3613,163 @@ cf_find_packet_data(capture_file *cf, const guint8 *string, size_t string_size,
                 packet_list_select_row_from_data(cf->current_frame);
             }
             cf->search_in_progress = FALSE;
+            g_free(info.wide);
             return TRUE;
         }
     }
     cf->search_pos = 0; /* Reset the position */
     cf->search_len = 0; /* Reset length */
-    return find_packet(cf, match_function, &info, dir);
+    if (cf->regex)
+        succeeded = find_packet(cf, match_function, &info, dir);
+    else
+        succeeded = find_packet_data(cf, &info, dir);
+    g_free(info.wide);
+    return succeeded;
 }
 
-static match_result
-match_narrow_and_wide(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+/* Widens an ASCII string to UTF-16LE the way the wide match always has:
+ * each byte is followed by '\0', except the last. */
+static guint8 *
+widen_string(const guint8 *string, size_t len, size_t *wide_len)
 {
-    cbs_t        *info       = (cbs_t *)criterion;
-    const guint8 *ascii_text = info->data;
-    size_t        textlen    = info->data_len;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
-    guint32       i;
-    guint8        c_char;
-    size_t        c_match    = 0;
+    guint8 *wide;
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
-    result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
-    buf_end = buf_start + buf_len;
-    pd = buf_start;
-    if (cf->search_len || cf->search_pos) {
-        /* we want to start searching one byte past the previous match start */
-        pd += cf->search_pos + 1;
-    }
-    for (; pd < buf_end; pd++) {
-        pd = (guint8 *)memchr(pd, ascii_text[0], buf_end - pd);
-        if (pd == NULL) break;
-        /* Try narrow match at this start location */
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = pd[i];
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-            } else {
-                break;
-            }
-        }
-
-        /* Now try wide match at the same start location. */
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = pd[i];
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-                i++;
-                if (pd + i >= buf_end || pd[i] != '\0') break;
-            } else {
-                break;
-            }
-        }
+    if (len == 0) {
+        *wide_len = 0;
+        return NULL;
     }
-
-done:
-    return result;
+    *wide_len = 2 * len - 1;
+    wide = (guint8 *)g_malloc0(*wide_len);
+    for (size_t i = 0; i < len; i++)
+        wide[2 * i] = string[i];
+    return wide;
 }
 
-static match_result
-match_narrow_and_wide_reverse(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+/* Compares len bytes at pd with needle, which is upper case, folding
+ * ASCII lower case letters in pd. Each block of 16 bytes is compared
+ * without branching on the data so that the compiler can vectorize it. */
+static gboolean
+equal_nocase(const guint8 *pd, const guint8 *needle, size_t len)
 {
-    cbs_t        *info       = (cbs_t *)criterion;
-    const guint8 *ascii_text = info->data;
-    size_t        textlen    = info->data_len;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
-    guint32       i;
-    guint8        c_char;
-    size_t        c_match    = 0;
+    size_t i = 0;
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
+    while (i < len) {
+        size_t n = MIN(len - i, 16);
+        guint8 diff = 0;
 
-    result = MR_NOTMATCHED;
-    /* Has to be room to hold the sought data. */
-    if (textlen > fdata->cap_len) {
-        return result;
-    }
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
-    buf_end = buf_start + buf_len;
-    pd = buf_end - textlen;
-    if (cf->search_len || cf->search_pos) {
-        /* we want to start searching one byte before the previous match start */
-        pd = buf_start + cf->search_pos - 1;
-    }
-    for (; pd < buf_end; pd++) {
-        pd = (uint8_t *)ws_memrchr(buf_start, ascii_text[0], pd - buf_start + 1);
-        if (pd == NULL) break;
-        /* Try narrow match at this start location */
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = pd[i];
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-            } else {
-                break;
-            }
-        }
+        for (size_t j = 0; j < n; j++) {
+            guint8 c = pd[i + j];
 
-        /* Now try wide match at the same start location. */
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = pd[i];
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-                i++;
-                if (pd + i >= buf_end || pd[i] != '\0') break;
-            } else {
-                break;
-            }
+            c -= ((guint8)(c - 'a') < 26) << 5;
+            diff |= c ^ needle[i + j];
         }
+        if (diff != 0)
+            return FALSE;
+        i += n;
     }
-
-done:
-    return result;
+    return TRUE;
 }
 
-/* Case insensitive match */
-static match_result
-match_narrow_and_wide_case(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+/* Finds the first occurrence of needle starting at or after offset from. */
+static const guint8 *
+find_needle(const cbs_t *info, const guint8 *needle, size_t needle_len,
+        const guint8 *buf, size_t len, size_t from)
 {
-    cbs_t        *info       = (cbs_t *)criterion;
-    const guint8 *ascii_text = info->data;
-    size_t        textlen    = info->data_len;
-    ws_mempbrk_pattern *pattern = info->pattern;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
-    guint32       i;
+    const guint8 *pd, *last;
     guint8        c_char;
-    size_t        c_match    = 0;
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
+    if (from >= len || needle_len > len - from)
+        return NULL;
+    if (!info->nocase)
+        return ws_memmem(buf + from, len - from, needle, needle_len);
 
-    ws_assert(pattern != NULL);
-
-    result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
-    buf_end = buf_start + buf_len;
-    pd = buf_start;
-    if (cf->search_len || cf->search_pos) {
-        /* we want to start searching one byte past the previous match start */
-        pd += cf->search_pos + 1;
-    }
-    for (; pd < buf_end; pd++) {
-        pd = (guint8 *)ws_mempbrk_exec(pd, buf_end - pd, pattern, &c_char);
-        if (pd == NULL) break;
-        /* Try narrow match at this start location */
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = g_ascii_toupper(pd[i]);
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-            } else {
-                break;
-            }
-        }
-
-        /* Now try wide match at the same start location. */
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = g_ascii_toupper(pd[i]);
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-                i++;
-                if (pd + i >= buf_end || pd[i] != '\0') break;
-            } else {
-                break;
-            }
-        }
+    /* ws_mempbrk finds the first byte in either case, 16 bytes at a time. */
+    last = buf + len - needle_len;
+    for (pd = buf + from; pd <= last; pd++) {
+        pd = ws_mempbrk_exec(pd, last - pd + 1, info->pattern, &c_char);
+        if (pd == NULL)
+            break;
+        if (equal_nocase(pd, needle, needle_len))
+            return pd;
     }
-
-done:
-    return result;
+    return NULL;
 }
 
-static match_result
-match_narrow_and_wide_case_reverse(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+/* Finds the last occurrence of needle starting at or before offset from. */
+static const guint8 *
+rfind_needle(const cbs_t *info, const guint8 *needle, size_t needle_len,
+        const guint8 *buf, size_t len, size_t from)
 {
-    cbs_t        *info       = (cbs_t *)criterion;
-    const guint8 *ascii_text = info->data;
-    size_t        textlen    = info->data_len;
-    ws_mempbrk_pattern *pattern = info->pattern;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
-    guint32       i;
+    const guint8 *pd;
     guint8        c_char;
-    size_t        c_match    = 0;
+    size_t        n;
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
-    ws_assert(pattern != NULL);
-
-    result = MR_NOTMATCHED;
     /* Has to be room to hold the sought data. */
-    if (textlen > fdata->cap_len) {
-        return result;
-    }
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
-    buf_end = buf_start + buf_len;
-    pd = buf_end - textlen;
-    if (cf->search_len || cf->search_pos) {
-        /* we want to start searching one byte before the previous match start */
-        pd = buf_start + cf->search_pos - 1;
-    }
-    for (; pd >= buf_start; pd--) {
-        pd = (guint8 *)ws_memrpbrk_exec(buf_start, pd - buf_start + 1, pattern, &c_char);
-        if (pd == NULL) break;
-        /* Try narrow match at this start location */
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = g_ascii_toupper(pd[i]);
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-            } else {
-                break;
-            }
-        }
-
-        /* Now try wide match at the same start location. */
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = g_ascii_toupper(pd[i]);
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-                i++;
-                if (pd + i >= buf_end || pd[i] != '\0') break;
-            } else {
-                break;
-            }
-        }
-    }
-
-done:
-    return result;
-}
-
-/* Case insensitive match */
-static match_result
-match_narrow_case(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
-{
-    cbs_t        *info       = (cbs_t *)criterion;
-    const guint8 *ascii_text = info->data;
-    size_t        textlen    = info->data_len;
-    ws_mempbrk_pattern *pattern = info->pattern;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
-    guint32       i;
-    guint8        c_char;
-    size_t        c_match    = 0;
-
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
-    ws_assert(pattern != NULL);
-
-    result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
-    buf_end = buf_start + buf_len;
-    pd = buf_start;
-    if (cf->search_len || cf->search_pos) {
-        /* we want to start searching one byte past the previous match start */
-        pd += cf->search_pos + 1;
-    }
-    for (; pd < buf_end; pd++) {
-        pd = (guint8 *)ws_mempbrk_exec(pd, buf_end - pd, pattern, &c_char);
-        if (pd == NULL) break;
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = g_ascii_toupper(pd[i]);
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    /* Save position and length for highlighting the field. */
-                    result = MR_MATCHED;
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-            } else {
-                break;
-            }
-        }
+    if (needle_len > len)
+        return NULL;
+    n = MIN(from, len - needle_len) + 1;
+    while (n > 0) {
+        if (info->nocase)
+            pd = ws_memrpbrk_exec(buf, n, info->pattern, &c_char);
+        else
+            pd = ws_memrchr(buf, needle[0], n);
+        if (pd == NULL)
+            break;
+        if (info->nocase ? equal_nocase(pd, needle, needle_len) :
+                memcmp(pd, needle, needle_len) == 0)
+            return pd;
+        n = pd - buf;
     }
-
-done:
-    return result;
+    return NULL;
 }
 
-static match_result
-match_narrow_case_reverse(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+/* Looks for the search string in a frame's data. A forward search looks
+ * for the first match starting at or after offset from, a reverse search
+ * for the last one starting at or before it. If a narrow and a wide match
+ * start at the same place the narrow one wins. */
+static gboolean
+cbs_search(const cbs_t *info, const guint8 *buf, size_t len, size_t from,
+        uint32_t *match_pos, uint32_t *match_len)
 {
-    cbs_t        *info       = (cbs_t *)criterion;
-    const guint8 *ascii_text = info->data;
-    size_t        textlen    = info->data_len;
-    ws_mempbrk_pattern *pattern = info->pattern;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
-    guint32       i;
-    guint8        c_char;
-    size_t        c_match    = 0;
+    const guint8 *narrow = NULL, *wide = NULL;
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
-    ws_assert(pattern != NULL);
+    if (info->data_len == 0)
+        return FALSE;
 
-    result = MR_NOTMATCHED;
-    /* Has to be room to hold the sought data. */
-    if (textlen > fdata->cap_len) {
-        return result;
-    }
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
-    buf_end = buf_start + buf_len;
-    pd = buf_end - textlen;
-    if (cf->search_len || cf->search_pos) {
-        /* we want to start searching one byte before the previous match start */
-        pd = buf_start + cf->search_pos - 1;
-    }
-    for (; pd >= buf_start; pd--) {
-        pd = (guint8 *)ws_memrpbrk_exec(buf_start, pd - buf_start + 1, pattern, &c_char);
-        if (pd == NULL) break;
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = g_ascii_toupper(pd[i]);
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    /* Save position and length for highlighting the field. */
-                    result = MR_MATCHED;
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-            } else {
-                break;
-            }
-        }
+    if (info->reverse) {
+        if (info->narrow)
+            narrow = rfind_needle(info, info->data, info->data_len, buf, len, from);
+        if (info->wide != NULL)
+            wide = rfind_needle(info, info->wide, info->wide_len, buf, len, from);
+    } else {
+        if (info->narrow)
+            narrow = find_needle(info, info->data, info->data_len, buf, len, from);
+        /* A wide match has to start before the narrow one to win. */
+        if (info->wide != NULL)
+            wide = find_needle(info, info->wide, info->wide_len, buf,
+                    narrow != NULL ? MIN(len, (size_t)(narrow - buf) + info->wide_len - 1) : len,
+                    from);
+    }
+
+    if (wide != NULL && (narrow == NULL || (info->reverse ? wide > narrow : wide < narrow))) {
+        *match_pos = (uint32_t)(wide - buf);
+        *match_len = (uint32_t)info->wide_len;
+    } else if (narrow != NULL) {
+        *match_pos = (uint32_t)(narrow - buf);
+        *match_len = (uint32_t)info->data_len;
+    } else {
+        return FALSE;
     }
-
-done:
-    return result;
+    return TRUE;
 }
 
 static match_result
-match_wide(capture_file *cf, frame_data *fdata,
+match_data(capture_file *cf, frame_data *fdata,
         wtap_rec *rec, Buffer *buf, void *criterion)
 {
-    cbs_t        *info       = (cbs_t *)criterion;
-    const guint8 *ascii_text = info->data;
-    size_t        textlen    = info->data_len;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
-    guint32       i;
-    guint8        c_char;
-    size_t        c_match    = 0;
+    cbs_t        *info = (cbs_t *)criterion;
+    size_t        from;
+    uint32_t      match_pos, match_len;
 
     /* Load the frame's data. */
     if (!cf_read_record(cf, fdata, rec, buf)) {
@@ -4096,300 +3777,117 @@ match_wide(capture_file *cf, frame_data *fdata,
         return MR_ERROR;
     }
 
-    result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
-    buf_end = buf_start + buf_len;
-    pd = buf_start;
     if (cf->search_len || cf->search_pos) {
-        /* we want to start searching one byte past the previous match start */
-        pd += cf->search_pos + 1;
-    }
-    for (; pd < buf_end; pd++) {
-        pd = (guint8 *)memchr(pd, ascii_text[0], buf_end - pd);
-        if (pd == NULL) break;
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = pd[i];
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-                i++;
-                if (pd + i >= buf_end || pd[i] != '\0') break;
-            } else {
-                break;
-            }
+        /* we want to start searching one byte past (or before) the
+           previous match start */
+        if (!info->reverse) {
+            from = cf->search_pos + 1;
+        } else if (cf->search_pos > 0) {
+            from = cf->search_pos - 1;
+        } else {
+            return MR_NOTMATCHED;
         }
+    } else {
+        from = info->reverse ? fdata->cap_len : 0;
     }
 
-done:
-    return result;
-}
-
-static match_result
-match_wide_reverse(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
-{
-    cbs_t        *info       = (cbs_t *)criterion;
-    const guint8 *ascii_text = info->data;
-    size_t        textlen    = info->data_len;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
-    guint32       i;
-    guint8        c_char;
-    size_t        c_match    = 0;
-
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
-    result = MR_NOTMATCHED;
-    /* Has to be room to hold the sought data. */
-    if (textlen > fdata->cap_len) {
-        return result;
-    }
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
-    buf_end = buf_start + buf_len;
-    pd = buf_end - textlen;
-    if (cf->search_len || cf->search_pos) {
-        /* we want to start searching one byte before the previous match start */
-        pd = buf_start + cf->search_pos - 1;
-    }
-    for (; pd < buf_end; pd++) {
-        pd = (uint8_t *)ws_memrchr(buf_start, ascii_text[0], pd - buf_start + 1);
-        if (pd == NULL) break;
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = pd[i];
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-                i++;
-                if (pd + i >= buf_end || pd[i] != '\0') break;
-            } else {
-                break;
-            }
-        }
+    if (!cbs_search(info, ws_buffer_start_ptr(buf), fdata->cap_len, from,
+                &match_pos, &match_len)) {
+        return MR_NOTMATCHED;
     }
-
-done:
-    return result;
+    /* Save position and length for highlighting the field. */
+    cf->search_pos = match_pos;
+    cf->search_len = match_len;
+    return MR_MATCHED;
 }
 
-/* Case insensitive match */
-static match_result
-match_wide_case(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
-{
-    cbs_t        *info       = (cbs_t *)criterion;
-    const guint8 *ascii_text = info->data;
-    size_t        textlen    = info->data_len;
-    ws_mempbrk_pattern *pattern = info->pattern;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
-    guint32       i;
-    guint8        c_char;
-    size_t        c_match    = 0;
-
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
-    ws_assert(pattern != NULL);
+/*
+ * A string or byte search doesn't need the dissectors, so rather than
+ * reading and searching one frame at a time, find_packet_data() reads a
+ * batch of displayed frames and searches them on several threads at once.
+ * The frames are still read on this thread, since random access to the
+ * capture file isn't thread safe.
+ */
+#define FIND_BATCH_FRAMES       1024
+#define FIND_BATCH_BYTES        (4 * 1024 * 1024)
+/* Don't hand fewer frames than this to a thread. */
+#define FIND_CHUNK_FRAMES       64
 
-    result = MR_NOTMATCHED;
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
-    buf_end = buf_start + buf_len;
-    pd = buf_start;
-    if (cf->search_len || cf->search_pos) {
-        /* we want to start searching one byte past the previous match start */
-        pd += cf->search_pos + 1;
-    }
-    for (; pd < buf_end; pd++) {
-        pd = (guint8 *)ws_mempbrk_exec(pd, buf_end - pd, pattern, &c_char);
-        if (pd == NULL) break;
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = g_ascii_toupper(pd[i]);
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-                i++;
-                if (pd + i >= buf_end || pd[i] != '\0') break;
-            } else {
-                break;
-            }
-        }
-    }
+typedef struct {
+    frame_data   *fdata;
+    Buffer        buf;
+    uint32_t      match_pos;
+    uint32_t      match_len;
+} find_slot_t;
 
-done:
-    return result;
-}
+typedef struct {
+    const cbs_t  *info;
+    find_slot_t  *slots;        /* in search order */
+    guint         num_slots;
+    guint         num_buffers;  /* slots with an initialized buffer */
+    guint         num_chunks;
+    gint          first_match;  /* first matching slot, or G_MAXINT */
+    guint         pending;      /* chunks still being searched */
+    GMutex        mutex;
+    GCond         cond;
+} find_batch_t;
 
-/* Case insensitive match */
-static match_result
-match_wide_case_reverse(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+static void
+search_batch_chunk(gpointer data, gpointer user_data)
 {
-    cbs_t        *info       = (cbs_t *)criterion;
-    const guint8 *ascii_text = info->data;
-    size_t        textlen    = info->data_len;
-    ws_mempbrk_pattern *pattern = info->pattern;
-    match_result  result;
-    guint32       buf_len;
-    guint8       *pd, *buf_start, *buf_end;
-    guint32       i;
-    guint8        c_char;
-    size_t        c_match    = 0;
+    find_batch_t *batch = (find_batch_t *)user_data;
+    guint         chunk = GPOINTER_TO_UINT(data) - 1;
+    guint         first = chunk * batch->num_slots / batch->num_chunks;
+    guint         last = (chunk + 1) * batch->num_slots / batch->num_chunks;
+    gint          cur;
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
-    ws_assert(pattern != NULL);
+    for (guint i = first; i < last; i++) {
+        find_slot_t *slot = &batch->slots[i];
 
-    result = MR_NOTMATCHED;
-    /* Has to be room to hold the sought data. */
-    if (textlen > fdata->cap_len) {
-        return result;
-    }
-    buf_len = fdata->cap_len;
-    buf_start = ws_buffer_start_ptr(buf);
-    buf_end = buf_start + buf_len;
-    pd = buf_end - textlen;
-    if (cf->search_len || cf->search_pos) {
-        /* we want to start searching one byte before the previous match start */
-        pd = buf_start + cf->search_pos - 1;
-    }
-    for (; pd >= buf_start; pd--) {
-        pd = (guint8 *)ws_memrpbrk_exec(buf_start, pd - buf_start + 1, pattern, &c_char);
-        if (pd == NULL) break;
-        c_match = 0;
-        for (i = 0; pd + i < buf_end; i++) {
-            c_char = g_ascii_toupper(pd[i]);
-            if (c_char == ascii_text[c_match]) {
-                c_match++;
-                if (c_match == textlen) {
-                    result = MR_MATCHED;
-                    /* Save position and length for highlighting the field. */
-                    cf->search_pos = (uint32_t)(pd - buf_start);
-                    cf->search_len = (uint32_t)(i + 1);
-                    goto done;
-                }
-                i++;
-                if (pd + i >= buf_end || pd[i] != '\0') break;
-            } else {
-                break;
-            }
+        /* Give up once a frame earlier in the search order has matched. */
+        if (g_atomic_int_get(&batch->first_match) < (gint)i)
+            break;
+        if (cbs_search(batch->info, ws_buffer_start_ptr(&slot->buf),
+                    slot->fdata->cap_len,
+                    batch->info->reverse ? slot->fdata->cap_len : 0,
+                    &slot->match_pos, &slot->match_len)) {
+            do {
+                cur = g_atomic_int_get(&batch->first_match);
+            } while ((gint)i < cur &&
+                    !g_atomic_int_compare_and_exchange(&batch->first_match, cur, (gint)i));
+            break;
         }
     }
 
-done:
-    return result;
+    g_mutex_lock(&batch->mutex);
+    if (--batch->pending == 0)
+        g_cond_signal(&batch->cond);
+    g_mutex_unlock(&batch->mutex);
 }
 
-static match_result
-match_binary(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
+/* Returns the index of the first matching slot in the batch, or -1. */
+static gint
+search_batch(find_batch_t *batch, GThreadPool **pool)
 {
-    cbs_t        *info        = (cbs_t *)criterion;
-    size_t        datalen     = info->data_len;
-    match_result  result;
-    const uint8_t *pd = NULL, *buf_start;
-
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
-
-    result = MR_NOTMATCHED;
-    buf_start = ws_buffer_start_ptr(buf);
-    size_t offset = 0;
-    if (cf->search_len || cf->search_pos) {
-        /* we want to start searching one byte past the previous match start */
-        offset = cf->search_pos + 1;
-    }
-    if (offset < fdata->cap_len) {
-        pd = ws_memmem(buf_start + offset, fdata->cap_len - offset, info->data, datalen);
-    }
-    if (pd != NULL) {
-        result = MR_MATCHED;
-        /* Save position and length for highlighting the field. */
-        cf->search_pos = (uint32_t)(pd - buf_start);
-        cf->search_len = (uint32_t)datalen;
-    }
+    guint num_threads = g_get_num_processors();
 
-    return result;
-}
+    batch->num_chunks = MIN(num_threads, MAX(batch->num_slots / FIND_CHUNK_FRAMES, 1));
+    batch->first_match = G_MAXINT;
+    batch->pending = batch->num_chunks;
 
-static match_result
-match_binary_reverse(capture_file *cf, frame_data *fdata,
-        wtap_rec *rec, Buffer *buf, void *criterion)
-{
-    cbs_t        *info        = (cbs_t *)criterion;
-    size_t        datalen     = info->data_len;
-    match_result  result;
-    const uint8_t *pd = NULL, *buf_start;
+    if (batch->num_chunks > 1 && *pool == NULL)
+        *pool = g_thread_pool_new(search_batch_chunk, batch, num_threads - 1, FALSE, NULL);
+    for (guint chunk = 1; chunk < batch->num_chunks; chunk++)
+        g_thread_pool_push(*pool, GUINT_TO_POINTER(chunk + 1), NULL);
+    /* Search the first chunk on this thread. */
+    search_batch_chunk(GUINT_TO_POINTER(1), batch);
 
-    /* Load the frame's data. */
-    if (!cf_read_record(cf, fdata, rec, buf)) {
-        /* Attempt to get the packet failed. */
-        return MR_ERROR;
-    }
+    g_mutex_lock(&batch->mutex);
+    while (batch->pending > 0)
+        g_cond_wait(&batch->cond, &batch->mutex);
+    g_mutex_unlock(&batch->mutex);
 
-    result = MR_NOTMATCHED;
-    buf_start = ws_buffer_start_ptr(buf);
-    /* Has to be room to hold the sought data. */
-    if (datalen > fdata->cap_len) {
-        return result;
-    }
-    pd = buf_start + fdata->cap_len - datalen;
-    if (cf->search_len || cf->search_pos) {
-        /* we want to start searching one byte before the previous match start */
-        pd = buf_start + cf->search_pos - 1;
-    }
-    for (; pd >= buf_start; pd--) {
-        pd = (uint8_t *)ws_memrchr(buf_start, info->data[0], pd - buf_start + 1);
-        if (pd == NULL) break;
-        if (memcmp(pd, info->data, datalen) == 0) {
-            result = MR_MATCHED;
-            /* Save position and length for highlighting the field. */
-            cf->search_pos = (uint32_t)(pd - buf_start);
-            cf->search_len = (uint32_t)datalen;
-            break;
-        }
-    }
-
-    return result;
+    return batch->first_match == G_MAXINT ? -1 : batch->first_match;
 }
 
 static match_result
@@ -4548,6 +4046,110 @@ match_time_reference(capture_file *cf _U_, frame_data *fdata, wtap_rec *rec _U_,
     return fdata->ref_time ? MR_MATCHED : MR_NOTMATCHED;
 }
 
+/* Moves past framenum in the search direction, wrapping around at either
+ * end of the capture if we're asked to. */
+static guint32
+next_find_framenum(capture_file *cf, guint32 framenum, guint32 prev_framenum,
+        search_direction dir)
+{
+    if (dir == SD_BACKWARD) {
+        /* Go on to the previous frame. */
+        if (framenum <= 1) {
+            /*
+             * XXX - other apps have a bit more of a detailed message
+             * for this, and instead of offering "OK" and "Cancel",
+             * they offer things such as "Continue" and "Cancel";
+             * we need an API for popping up alert boxes with
+             * {Verb} and "Cancel".
+             */
+
+            if (prefs.gui_find_wrap) {
+                statusbar_push_temporary_msg("Search reached the beginning. Continuing at end.");
+                return cf->count;           /* wrap around */
+            } else {
+                statusbar_push_temporary_msg("Search reached the beginning.");
+                return prev_framenum;       /* stay on previous packet */
+            }
+        }
+        return framenum - 1;
+    } else {
+        /* Go on to the next frame. */
+        if (framenum == cf->count) {
+            if (prefs.gui_find_wrap) {
+                statusbar_push_temporary_msg("Search reached the end. Continuing at beginning.");
+                return 1;                   /* wrap around */
+            } else {
+                statusbar_push_temporary_msg("Search reached the end.");
+                return prev_framenum;       /* stay on previous packet */
+            }
+        }
+        return framenum + 1;
+    }
+}
+
+/* Selects the packet list row of the frame a search stopped at, if any. */
+static gboolean
+select_found_frame(capture_file *cf, frame_data *new_fd)
+{
+    gboolean found_row;
+
+    if (new_fd == NULL)
+        return FALSE;   /* The search failed */
+
+    /* We found a frame that's displayed and that matches.
+       Try to find and select the packet summary list row for that frame. */
+    cf->search_in_progress = TRUE;
+    found_row = packet_list_select_row_from_data(new_fd);
+    cf->search_in_progress = FALSE;
+    if (!found_row) {
+        /* We didn't find a row corresponding to this frame.
+           This means that the frame isn't being displayed currently,
+           so we can't select it. */
+        cf->search_pos = 0; /* Reset the position */
+        cf->search_len = 0; /* Reset length */
+        simple_message_box(ESD_TYPE_INFO, NULL,
+                "The capture file is probably not fully dissected.",
+                "End of capture exceeded.");
+        return FALSE; /* The search succeeded but we didn't find the row */
+    }
+    return TRUE; /* The search succeeded and we found the row */
+}
+
+/* Creates the progress bar if necessary and updates it, but only after
+ * PROGBAR_UPDATE_INTERVAL has elapsed. Calling update_progress_dlg and
+ * packets_bar_update will likely trigger UI paint events, which might
+ * take a while depending on the platform and display. Reset our timer
+ * *after* painting. */
+static void
+update_find_progress(capture_file *cf, progdlg_t **progbar, GTimer *prog_timer,
+        float *progbar_val, int count)
+{
+    gchar status_str[100];
+
+    /* We check on every iteration of the loop, so that it takes no
+       longer than the standard time to create it (otherwise, for a
+       large file, we might take considerably longer than that standard
+       time in order to get to the next progress bar step). */
+    if (*progbar == NULL)
+        *progbar = delayed_create_progress_dlg(cf->window, NULL, NULL,
+                FALSE, &cf->stop_flag, *progbar_val);
+
+    if (g_timer_elapsed(prog_timer, NULL) > PROGBAR_UPDATE_INTERVAL) {
+        /* let's not divide by zero. I should never be started
+         * with count == 0, so let's assert that
+         */
+        ws_assert(cf->count > 0);
+
+        *progbar_val = (gfloat) count / cf->count;
+
+        snprintf(status_str, sizeof(status_str),
+                "%4u of %u packets", count, cf->count);
+        update_progress_dlg(*progbar, *progbar_val, status_str);
+
+        g_timer_start(prog_timer);
+    }
+}
+
 static gboolean
 find_packet(capture_file *cf, ws_match_function match_function,
         void *criterion, search_direction dir)
@@ -4562,9 +4164,7 @@ find_packet(capture_file *cf, ws_match_function match_function,
     progdlg_t   *progbar = NULL;
     GTimer      *prog_timer = g_timer_new();
     int          count;
-    gboolean     succeeded;
     float        progbar_val;
-    gchar        status_str[100];
     match_result result;
 
     wtap_rec_init(&rec);
@@ -4590,35 +4190,7 @@ find_packet(capture_file *cf, ws_match_function match_function,
     cf->stop_flag = FALSE;
 
     for (;;) {
-        /* Create the progress bar if necessary.
-           We check on every iteration of the loop, so that it takes no
-           longer than the standard time to create it (otherwise, for a
-           large file, we might take considerably longer than that standard
-           time in order to get to the next progress bar step). */
-        if (progbar == NULL)
-            progbar = delayed_create_progress_dlg(cf->window, NULL, NULL,
-                    FALSE, &cf->stop_flag, progbar_val);
-
-        /*
-         * Update the progress bar, but do it only after PROGBAR_UPDATE_INTERVAL
-         * has elapsed. Calling update_progress_dlg and packets_bar_update will
-         * likely trigger UI paint events, which might take a while depending on
-         * the platform and display. Reset our timer *after* painting.
-         */
-        if (g_timer_elapsed(prog_timer, NULL) > PROGBAR_UPDATE_INTERVAL) {
-            /* let's not divide by zero. I should never be started
-             * with count == 0, so let's assert that
-             */
-            ws_assert(cf->count > 0);
-
-            progbar_val = (gfloat) count / cf->count;
-
-            snprintf(status_str, sizeof(status_str),
-                    "%4u of %u packets", count, cf->count);
-            update_progress_dlg(progbar, progbar_val, status_str);
-
-            g_timer_start(prog_timer);
-        }
+        update_find_progress(cf, &progbar, prog_timer, &progbar_val, count);
 
         if (cf->stop_flag) {
             /* Well, the user decided to abort the search.  Go back to the
@@ -4628,39 +4200,7 @@ find_packet(capture_file *cf, ws_match_function match_function,
         }
 
         /* Go past the current frame. */
-        if (dir == SD_BACKWARD) {
-            /* Go on to the previous frame. */
-            if (framenum <= 1) {
-                /*
-                 * XXX - other apps have a bit more of a detailed message
-                 * for this, and instead of offering "OK" and "Cancel",
-                 * they offer things such as "Continue" and "Cancel";
-                 * we need an API for popping up alert boxes with
-                 * {Verb} and "Cancel".
-                 */
-
-                if (prefs.gui_find_wrap) {
-                    statusbar_push_temporary_msg("Search reached the beginning. Continuing at end.");
-                    framenum = cf->count;     /* wrap around */
-                } else {
-                    statusbar_push_temporary_msg("Search reached the beginning.");
-                    framenum = prev_framenum; /* stay on previous packet */
-                }
-            } else
-                framenum--;
-        } else {
-            /* Go on to the next frame. */
-            if (framenum == cf->count) {
-                if (prefs.gui_find_wrap) {
-                    statusbar_push_temporary_msg("Search reached the end. Continuing at beginning.");
-                    framenum = 1;             /* wrap around */
-                } else {
-                    statusbar_push_temporary_msg("Search reached the end.");
-                    framenum = prev_framenum; /* stay on previous packet */
-                }
-            } else
-                framenum++;
-        }
+        framenum = next_find_framenum(cf, framenum, prev_framenum, dir);
 
         fdata = frame_data_sequence_find(cf->provider.frames, framenum);
         count++;
@@ -4695,31 +4235,131 @@ find_packet(capture_file *cf, ws_match_function match_function,
         destroy_progress_dlg(progbar);
     g_timer_destroy(prog_timer);
 
-    if (new_fd != NULL) {
-        /* We found a frame that's displayed and that matches.
-           Try to find and select the packet summary list row for that frame. */
-        gboolean found_row;
-
-        cf->search_in_progress = TRUE;
-        found_row = packet_list_select_row_from_data(new_fd);
-        cf->search_in_progress = FALSE;
-        if (!found_row) {
-            /* We didn't find a row corresponding to this frame.
-               This means that the frame isn't being displayed currently,
-               so we can't select it. */
-            cf->search_pos = 0; /* Reset the position */
-            cf->search_len = 0; /* Reset length */
-            simple_message_box(ESD_TYPE_INFO, NULL,
-                    "The capture file is probably not fully dissected.",
-                    "End of capture exceeded.");
-            succeeded = FALSE; /* The search succeeded but we didn't find the row */
-        } else
-            succeeded = TRUE; /* The search succeeded and we found the row */
-    } else
-        succeeded = FALSE;   /* The search failed */
     wtap_rec_cleanup(&rec);
     ws_buffer_free(&buf);
-    return succeeded;
+    return select_found_frame(cf, new_fd);
+}
+
+/* find_packet() for string and byte searches, which reads the frames in
+ * batches and searches each batch in parallel. */
+static gboolean
+find_packet_data(capture_file *cf, cbs_t *info, search_direction dir)
+{
+    frame_data  *start_fd;
+    guint32      framenum;
+    guint32      prev_framenum;
+    frame_data  *fdata;
+    wtap_rec     rec;
+    frame_data  *new_fd = NULL;
+    progdlg_t   *progbar = NULL;
+    GTimer      *prog_timer = g_timer_new();
+    int          count;
+    float        progbar_val;
+    find_batch_t batch;
+    GThreadPool *pool = NULL;
+    size_t       batch_bytes;
+    gboolean     done = FALSE;
+    gboolean     read_failed = FALSE;
+    gint         match;
+
+    wtap_rec_init(&rec);
+    memset(&batch, 0, sizeof(batch));
+    batch.info = info;
+    batch.slots = g_new0(find_slot_t, FIND_BATCH_FRAMES);
+    g_mutex_init(&batch.mutex);
+    g_cond_init(&batch.cond);
+
+    start_fd = cf->current_frame;
+    if (start_fd != NULL)  {
+        prev_framenum = start_fd->num;
+    } else {
+        prev_framenum = 0;  /* No start packet selected. */
+    }
+
+    count = 0;
+    framenum = prev_framenum;
+
+    g_timer_start(prog_timer);
+    /* Progress so far. */
+    progbar_val = 0.0f;
+
+    cf->stop_flag = FALSE;
+
+    while (!done) {
+        update_find_progress(cf, &progbar, prog_timer, &progbar_val, count);
+
+        if (cf->stop_flag) {
+            /* Well, the user decided to abort the search.  Go back to the
+               frame where we started. */
+            new_fd = start_fd;
+            break;
+        }
+
+        /* Read the next batch of displayed frames, in search order. */
+        batch.num_slots = 0;
+        batch_bytes = 0;
+        while (batch.num_slots < FIND_BATCH_FRAMES && batch_bytes < FIND_BATCH_BYTES) {
+            framenum = next_find_framenum(cf, framenum, prev_framenum, dir);
+            fdata = frame_data_sequence_find(cf->provider.frames, framenum);
+            count++;
+
+            if (fdata && fdata->passed_dfilter) {
+                find_slot_t *slot = &batch.slots[batch.num_slots];
+
+                if (batch.num_slots == batch.num_buffers) {
+                    ws_buffer_init(&slot->buf, 1514);
+                    batch.num_buffers++;
+                }
+                if (!cf_read_record(cf, fdata, &rec, &slot->buf)) {
+                    /* Error; cf_read_record() has reported the error.
+                       Search what we have, then give up. */
+                    read_failed = TRUE;
+                    done = TRUE;
+                    break;
+                }
+                wtap_rec_reset(&rec);
+                slot->fdata = fdata;
+                batch.num_slots++;
+                batch_bytes += fdata->cap_len;
+            }
+
+            if (fdata == start_fd) {
+                /* We're back to the frame we were on originally. */
+                done = TRUE;
+                break;
+            }
+        }
+
+        match = search_batch(&batch, &pool);
+        if (match >= 0) {
+            /* Go to the new frame, and save position and length for
+               highlighting the field. */
+            new_fd = batch.slots[match].fdata;
+            cf->search_pos = batch.slots[match].match_pos;
+            cf->search_len = batch.slots[match].match_len;
+            break;
+        }
+        if (read_failed) {
+            /* Go back to the frame where we started. */
+            new_fd = start_fd;
+        }
+    }
+
+    /* We're done scanning the packets; destroy the progress bar if it
+       was created. */
+    if (progbar != NULL)
+        destroy_progress_dlg(progbar);
+    g_timer_destroy(prog_timer);
+
+    if (pool != NULL)
+        g_thread_pool_free(pool, FALSE, TRUE);
+    for (guint i = 0; i < batch.num_buffers; i++)
+        ws_buffer_free(&batch.slots[i].buf);
+    g_free(batch.slots);
+    g_mutex_clear(&batch.mutex);
+    g_cond_clear(&batch.cond);
+    wtap_rec_cleanup(&rec);
+    return select_found_frame(cf, new_fd);
 }
 
 gboolean
@@ -5302,6 +4942,7 @@ rescan_file(capture_file *cf, const char *fname, gboolean is_tempfile)
     frame_data          *fdata;
 
     /* Close the old handle. */
+    cap_file_provider_clear_read_cache(&cf->provider);
     wtap_close(cf->provider.wth);
 
     /* Open the new file. */
@@ -91,3 +91,203 @@ cap_file_provider_set_modified_block(struct packet_provider_data *prov, frame_da
 
   fd->has_modified_block = TRUE;
 }
+
+/*
+ * Records read ahead by cap_file_provider_read_record(), keyed by file
+ * offset.  Random access to a frame costs a seek and, for a compressed
+ * file, restoring the decompressor state; reading the frames that follow
+ * it at the same time costs little more than the read itself.
+ */
+#define READ_CACHE_MAX_BYTES    (32 * 1024 * 1024)
+/* Number of frames read at a time; doubles while the access pattern
+ * stays sequential. */
+#define READ_AHEAD_MIN          8
+#define READ_AHEAD_MAX          256
+
+typedef struct {
+  gint64 file_off;
+  wtap_rec rec;
+  Buffer buf;
+  gsize size;
+  GList link;           /* in the LRU list */
+} cached_record;
+
+struct frame_read_cache {
+  wtap *wth;            /* the file the records were read from */
+  GHashTable *records;  /* file offset -> cached_record */
+  GQueue lru;           /* most recently used first */
+  gsize size;
+  guint32 last_num;     /* frame read last, or 0 */
+  int direction;        /* 1 or -1 if reading in order, else 0 */
+  guint read_ahead;
+};
+
+static void
+cached_record_free(gpointer data)
+{
+  cached_record *entry = (cached_record *)data;
+
+  wtap_rec_cleanup(&entry->rec);
+  ws_buffer_free(&entry->buf);
+  g_free(entry);
+}
+
+static void
+read_cache_remove(struct frame_read_cache *cache, cached_record *entry)
+{
+  g_queue_unlink(&cache->lru, &entry->link);
+  cache->size -= entry->size;
+  g_hash_table_remove(cache->records, &entry->file_off);
+}
+
+/* Read a record into the cache, unless it's already there. */
+static cached_record *
+read_cache_fill(struct frame_read_cache *cache, gint64 file_off,
+    int *err, gchar **err_info)
+{
+  cached_record *entry;
+
+  entry = (cached_record *)g_hash_table_lookup(cache->records, &file_off);
+  if (entry != NULL)
+    return entry;
+
+  entry = g_new0(cached_record, 1);
+  entry->file_off = file_off;
+  wtap_rec_init(&entry->rec);
+  ws_buffer_init(&entry->buf, 1514);
+  if (!wtap_seek_read(cache->wth, file_off, &entry->rec, &entry->buf, err, err_info)) {
+    cached_record_free(entry);
+    return NULL;
+  }
+  entry->size = sizeof(*entry) + ws_buffer_length(&entry->buf);
+  entry->link.data = entry;
+  g_hash_table_insert(cache->records, &entry->file_off, entry);
+  g_queue_push_head_link(&cache->lru, &entry->link);
+  cache->size += entry->size;
+  return entry;
+}
+
+static void
+read_cache_trim(struct frame_read_cache *cache, const cached_record *keep)
+{
+  GList *link = cache->lru.tail;
+
+  while (cache->size > READ_CACHE_MAX_BYTES && link != NULL) {
+    GList *prev = link->prev;
+
+    if (link->data != keep)
+      read_cache_remove(cache, (cached_record *)link->data);
+    link = prev;
+  }
+}
+
+gboolean
+cap_file_provider_read_record(struct packet_provider_data *prov,
+    guint32 frame_num, gint64 file_off, wtap_rec *rec, Buffer *buf,
+    int *err, gchar **err_info)
+{
+  struct frame_read_cache *cache = prov->read_cache;
+  cached_record *entry;
+  Buffer options_buf;
+  wtap_block_t options_buf_block;
+
+  if (cache != NULL && cache->wth != prov->wth)
+    cap_file_provider_clear_read_cache(prov);
+
+  /*
+   * Reading a memory-mapped file is already just a copy out of the
+   * mapping; caching would only add a second copy.
+   */
+  if (wtap_is_mapped(prov->wth))
+    return wtap_seek_read(prov->wth, file_off, rec, buf, err, err_info);
+
+  if (prov->read_cache == NULL) {
+    cache = g_new0(struct frame_read_cache, 1);
+    cache->wth = prov->wth;
+    cache->records = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, cached_record_free);
+    g_queue_init(&cache->lru);
+    cache->read_ahead = READ_AHEAD_MIN;
+    prov->read_cache = cache;
+  }
+
+  /* Which way, if any, are the frames being read? */
+  if (cache->last_num != 0 && frame_num == cache->last_num + 1) {
+    cache->direction = 1;
+  } else if (cache->last_num != 0 && frame_num + 1 == cache->last_num) {
+    cache->direction = -1;
+  } else if (frame_num != cache->last_num) {
+    cache->direction = 0;
+    cache->read_ahead = READ_AHEAD_MIN;
+  }
+  cache->last_num = frame_num;
+
+  entry = (cached_record *)g_hash_table_lookup(cache->records, &file_off);
+  if (entry == NULL) {
+    entry = read_cache_fill(cache, file_off, err, err_info);
+    if (entry == NULL)
+      return FALSE;
+
+    if (cache->direction != 0 && prov->frames != NULL) {
+      /*
+       * Read the frames after this one (or before it, reading them
+       * in file order so that the reads are contiguous).  Stop at
+       * the first one we can't read; we'll report the error when
+       * it's asked for.
+       */
+      guint32 first, last;
+      int ra_err;
+      gchar *ra_err_info;
+
+      if (cache->direction > 0) {
+        first = frame_num + 1;
+        last = frame_num + cache->read_ahead;
+      } else {
+        first = frame_num > cache->read_ahead ? frame_num - cache->read_ahead : 1;
+        last = frame_num - 1;
+      }
+      for (guint32 num = first; num <= last && num >= first; num++) {
+        frame_data *fd = frame_data_sequence_find(prov->frames, num);
+
+        if (fd == NULL)
+          break;
+        if (read_cache_fill(cache, fd->file_off, &ra_err, &ra_err_info) == NULL) {
+          g_free(ra_err_info);
+          break;
+        }
+      }
+      if (cache->read_ahead < READ_AHEAD_MAX)
+        cache->read_ahead *= 2;
+    }
+  } else {
+    g_queue_unlink(&cache->lru, &entry->link);
+    g_queue_push_head_link(&cache->lru, &entry->link);
+  }
+
+  /* Hand the caller a copy, as wtap_seek_read() would have filled it in. */
+  options_buf = rec->options_buf;
+  options_buf_block = rec->options_buf_block;
+  *rec = entry->rec;
+  rec->options_buf = options_buf;
+  rec->options_buf_block = options_buf_block;
+  rec->block = wtap_block_ref(entry->rec.block);
+  ws_buffer_clean(buf);
+  ws_buffer_append(buf, ws_buffer_start_ptr(&entry->buf), ws_buffer_length(&entry->buf));
+
+  read_cache_trim(cache, entry);
+  return TRUE;
+}
+
+void
+cap_file_provider_clear_read_cache(struct packet_provider_data *prov)
+{
+  struct frame_read_cache *cache = prov->read_cache;
+
+  if (cache == NULL)
+    return;
+
+  /* The list links are part of the records. */
+  g_queue_init(&cache->lru);
+  g_hash_table_destroy(cache->records);
+  g_free(cache);
+  prov->read_cache = NULL;
+}
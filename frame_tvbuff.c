@@ -23,26 +23,44 @@
 struct tvb_frame {
     struct tvbuff tvb;
 
-    Buffer *buf;         /* Packet data */
+    Buffer *buf;         /* Packet data, if not used in place */
+    const guint8 *data;  /* Packet data, in buf or in a mapped file */
 
     const struct packet_provider_data *prov;	/* provider of packet information */
+    guint32 frame_num;   /**< Frame number */
     gint64 file_off;     /**< File offset */
 
     guint offset;
 };
 
 static gboolean
-frame_read(struct tvb_frame *frame_tvb, wtap_rec *rec, Buffer *buf)
+frame_read(struct tvb_frame *frame_tvb, wtap_rec *rec, Buffer *buf,
+        const guint8 **data)
 {
     int    err;
     gchar *err_info;
+    gboolean read_ok;
     gboolean ok = TRUE;
 
     /* XXX, what if phdr->caplen isn't equal to
      * frame_tvb->tvb.length + frame_tvb->offset?
+     *
+     * If the file is memory-mapped, wrap the data in the mapping rather
+     * than copying it.  Otherwise go through the provider's read cache,
+     * which is the only part of the provider that reading changes, so
+     * that reading the bytes of a frame that was just read, or that
+     * was read ahead, doesn't mean reading it again.
      */
-    if (!wtap_seek_read(frame_tvb->prov->wth, frame_tvb->file_off, rec, buf, &err, &err_info)) {
+    if (wtap_is_mapped(frame_tvb->prov->wth)) {
+        read_ok = wtap_seek_read_ptr(frame_tvb->prov->wth, frame_tvb->file_off, rec, buf, data, &err, &err_info);
+    } else {
+        read_ok = cap_file_provider_read_record((struct packet_provider_data *)frame_tvb->prov,
+                frame_tvb->frame_num, frame_tvb->file_off, rec, buf, &err, &err_info);
+        *data = ws_buffer_start_ptr(buf);
+    }
+    if (!read_ok) {
         /* XXX - report error! */
+        *data = ws_buffer_start_ptr(buf);
         switch (err) {
             case WTAP_ERR_BAD_FILE:
                 g_free(err_info);
@@ -55,6 +73,23 @@ frame_read(struct tvb_frame *frame_tvb, wtap_rec *rec, Buffer *buf)
 
 static GPtrArray *buffer_cache = NULL;
 
+/*
+ * Buffer for reads of a memory-mapped file, which only need it if the
+ * data can't be used in place; it's handed to the tvbuff if it's used.
+ */
+static Buffer mapped_read_buf;
+static gboolean mapped_read_buf_ready = FALSE;
+
+static Buffer *
+frame_buffer_new(void)
+{
+    if (G_UNLIKELY(!buffer_cache)) buffer_cache = g_ptr_array_sized_new(1024);
+
+    if (buffer_cache->len > 0)
+        return (struct Buffer *) g_ptr_array_remove_index(buffer_cache, buffer_cache->len - 1);
+    return g_new(struct Buffer, 1);
+}
+
 static void
 frame_cache(struct tvb_frame *frame_tvb)
 {
@@ -62,22 +97,33 @@ frame_cache(struct tvb_frame *frame_tvb)
 
     wtap_rec_init(&rec);
 
-    if (frame_tvb->buf == NULL) {
-        if (G_UNLIKELY(!buffer_cache)) buffer_cache = g_ptr_array_sized_new(1024);
-
-        if (buffer_cache->len > 0) {
-            frame_tvb->buf = (struct Buffer *) g_ptr_array_remove_index(buffer_cache, buffer_cache->len - 1);
+    if (frame_tvb->data == NULL) {
+        if (wtap_is_mapped(frame_tvb->prov->wth)) {
+            if (!mapped_read_buf_ready) {
+                ws_buffer_init(&mapped_read_buf, frame_tvb->tvb.length + frame_tvb->offset);
+                mapped_read_buf_ready = TRUE;
+            }
+            ws_buffer_clean(&mapped_read_buf);
+
+            if (!frame_read(frame_tvb, &rec, &mapped_read_buf, &frame_tvb->data))
+            { /* TODO: THROW(???); */ }
+
+            if (frame_tvb->data == ws_buffer_start_ptr(&mapped_read_buf)) {
+                /* The data was copied after all; keep it. */
+                frame_tvb->buf = frame_buffer_new();
+                *frame_tvb->buf = mapped_read_buf;
+                mapped_read_buf_ready = FALSE;
+            }
         } else {
-            frame_tvb->buf = g_new(struct Buffer, 1);
-        }
-
-        ws_buffer_init(frame_tvb->buf, frame_tvb->tvb.length + frame_tvb->offset);
+            frame_tvb->buf = frame_buffer_new();
+            ws_buffer_init(frame_tvb->buf, frame_tvb->tvb.length + frame_tvb->offset);
 
-        if (!frame_read(frame_tvb, &rec, frame_tvb->buf))
-        { /* TODO: THROW(???); */ }
+            if (!frame_read(frame_tvb, &rec, frame_tvb->buf, &frame_tvb->data))
+            { /* TODO: THROW(???); */ }
+        }
     }
 
-    frame_tvb->tvb.real_data = ws_buffer_start_ptr(frame_tvb->buf) + frame_tvb->offset;
+    frame_tvb->tvb.real_data = frame_tvb->data + frame_tvb->offset;
 
     wtap_rec_cleanup(&rec);
 }
@@ -208,12 +254,14 @@ frame_tvbuff_new(const struct packet_provider_data *prov, const frame_data *fd,
     /* XXX, wtap_can_seek() */
     if (prov->wth && prov->wth->random_fh) {
         frame_tvb->prov = prov;
+        frame_tvb->frame_num = fd->num;
         frame_tvb->file_off = fd->file_off;
         frame_tvb->offset = 0;
     } else
         frame_tvb->prov = NULL;
 
     frame_tvb->buf = NULL;
+    frame_tvb->data = NULL;
 
     return tvb;
 }
@@ -256,9 +304,11 @@ frame_clone(tvbuff_t *tvb, guint abs_offset, guint abs_length)
 
     cloned_frame_tvb = (struct tvb_frame *) cloned_tvb;
     cloned_frame_tvb->prov = frame_tvb->prov;
+    cloned_frame_tvb->frame_num = frame_tvb->frame_num;
     cloned_frame_tvb->file_off = frame_tvb->file_off;
     cloned_frame_tvb->offset = abs_offset;
     cloned_frame_tvb->buf = NULL;
+    cloned_frame_tvb->data = NULL;
 
     return cloned_tvb;
 }
@@ -313,12 +363,14 @@ file_tvbuff_new(const struct packet_provider_data *prov, const frame_data *fd,
     /* XXX, wtap_can_seek() */
     if (prov->wth && prov->wth->random_fh) {
         frame_tvb->prov = prov;
+        frame_tvb->frame_num = fd->num;
         frame_tvb->file_off = fd->file_off;
         frame_tvb->offset = 0;
     } else
         frame_tvb->prov = NULL;
 
     frame_tvb->buf = NULL;
+    frame_tvb->data = NULL;
 
     return tvb;
 }
@@ -30,6 +30,7 @@
 #include <wsutil/version_info.h>
 
 #include <wiretap/wtap.h>
+#include <wiretap/flow_key.h>
 
 #include <epan/color_filters.h>
 #include <epan/timestamp.h>
@@ -355,6 +356,32 @@ clean_exit:
 	return ret;
 }
 
+/*
+ * The flow key extractor reads raw packet data without the dissectors'
+ * bounds checking, so give it the input as each of the link-layer types
+ * it handles.
+ */
+static void
+fuzz_flow_key(wtap_rec *rec, const guint8 *buf)
+{
+	static const int encaps[] = {
+		WTAP_ENCAP_ETHERNET,
+		WTAP_ENCAP_SLL,
+		WTAP_ENCAP_SLL2,
+		WTAP_ENCAP_NULL,
+		WTAP_ENCAP_RAW_IP,
+	};
+	int saved_encap = rec->rec_header.packet_header.pkt_encap;
+	wtap_flow_key_t key;
+
+	for (size_t i = 0; i < G_N_ELEMENTS(encaps); i++) {
+		rec->rec_header.packet_header.pkt_encap = encaps[i];
+		if (wtap_flow_key_get(rec, buf, &key))
+			(void)wtap_flow_key_hash(&key);
+	}
+	rec->rec_header.packet_header.pkt_encap = saved_encap;
+}
+
 #ifdef FUZZ_EPAN
 int
 LLVMFuzzerTestOneInput(const guint8 *buf, size_t real_len)
@@ -377,6 +404,8 @@ LLVMFuzzerTestOneInput(const guint8 *buf, size_t real_len)
 	rec.rec_header.packet_header.pkt_encap = G_MAXINT16;
 	rec.presence_flags = WTAP_HAS_TS | WTAP_HAS_CAP_LEN; /* most common flags... */
 
+	fuzz_flow_key(&rec, buf);
+
 	frame_data_init(&fdlocal, ++framenum, &rec, /* offset */ 0, /* cum_bytes */ 0);
 	/* frame_data_set_before_dissect() not needed */
 	epan_dissect_run(edt, WTAP_FILE_TYPE_SUBTYPE_UNKNOWN, &rec, tvb_new_real_data(buf, len, len), &fdlocal, NULL /* &fuzz_cinfo */);
@@ -421,6 +421,7 @@ cf_open(capture_file *cf, const char *fname, unsigned int type, gboolean is_temp
 
     /* The open succeeded.  Fill in the information for this file. */
 
+    cap_file_provider_clear_read_cache(&cf->provider);
     cf->provider.wth = wth;
     cf->f_datalen = 0; /* not used, but set it anyway */
 
@@ -517,7 +518,8 @@ sharkd_dissect_request(guint32 framenum, guint32 frame_ref_num,
     if (fdata == NULL)
         return DISSECT_REQUEST_NO_SUCH_FRAME;
 
-    if (!wtap_seek_read(cfile.provider.wth, fdata->file_off, rec, buf, err, err_info)) {
+    if (!cap_file_provider_read_record(&cfile.provider, fdata->num, fdata->file_off,
+                rec, buf, err, err_info)) {
         if (cinfo != NULL)
             col_fill_in_error(cinfo, fdata, FALSE, FALSE /* fill_fd_columns */);
         return DISSECT_REQUEST_READ_ERROR; /* error reading the record */
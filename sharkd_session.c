@@ -86,6 +86,10 @@ struct sharkd_filter_item
 
 static GHashTable *filter_table = NULL;
 
+/* Extracted iograph columns, keyed by "<hf_index>:<filter>". */
+static GHashTable *iograph_columns_table = NULL;
+static guint32 iograph_columns_count;
+
 static int mode;
 static guint32 rpcid;
 
@@ -414,6 +418,8 @@ json_prep(char* buf, const jsmntok_t* tokens, int count)
         {"frames",     "refs",       2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"intervals",  "interval",   2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"intervals",  "filter",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
+        {"intervals",  "from",       2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
+        {"intervals",  "to",         2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"iograph",    "interval",   2, JSMN_PRIMITIVE,    SHARKD_JSON_UINTEGER, SHARKD_OPTIONAL},
         {"iograph",    "filter",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_OPTIONAL},
         {"iograph",    "graph0",     2, JSMN_STRING,       SHARKD_JSON_STRING,   SHARKD_MANDATORY},
@@ -752,6 +758,19 @@ sharkd_session_filter_data(const char *filter)
     return l;
 }
 
+static void
+sharkd_iograph_columns_free(gpointer data)
+{
+    io_graph_columns_free((io_graph_columns_t *) data);
+}
+
+static void
+sharkd_iograph_cache_clear(void)
+{
+    if (iograph_columns_table)
+        g_hash_table_remove_all(iograph_columns_table);
+}
+
 static gboolean
 sharkd_rtp_match_init(rtpstream_id_t *id, const char *init_str)
 {
@@ -1185,6 +1204,8 @@ sharkd_session_process_load(const char *buf, const jsmntok_t *tokens, int count)
         return;
     }
 
+    sharkd_iograph_cache_clear();
+
     TRY
     {
         err = sharkd_load_cap_file();
@@ -4306,47 +4327,19 @@ struct sharkd_iograph
     io_graph_item_unit_t calc_type;
     guint32 interval;
 
-    /* result */
-    int space_items;
-    int num_items;
-    io_graph_item_t *items;
-    GString *error;
+    /* data, shared by all graphs with the same filter and field */
+    io_graph_columns_t *columns;
 };
 
+#define SHARKD_IOGRAPH_MAX_CACHED 32
+
 static tap_packet_status
 sharkd_iograph_packet(void *g, packet_info *pinfo, epan_dissect_t *edt, const void *dummy _U_, tap_flags_t flags _U_)
 {
-    struct sharkd_iograph *graph = (struct sharkd_iograph *) g;
-    int idx;
-    gboolean update_succeeded;
-
-    idx = get_io_graph_index(pinfo, graph->interval);
-    if (idx < 0 || idx >= SHARKD_IOGRAPH_MAX_ITEMS)
-        return TAP_PACKET_DONT_REDRAW;
-
-    if (idx + 1 > graph->num_items)
-    {
-        if (idx + 1 > graph->space_items)
-        {
-            int new_size = idx + 1024;
+    io_graph_columns_t *columns = (io_graph_columns_t *) g;
 
-            graph->items = (io_graph_item_t *) g_realloc(graph->items, sizeof(io_graph_item_t) * new_size);
-            reset_io_graph_items(&graph->items[graph->space_items], new_size - graph->space_items);
-
-            graph->space_items = new_size;
-        }
-        else if (graph->items == NULL)
-        {
-            graph->items = g_new(io_graph_item_t, graph->space_items);
-            reset_io_graph_items(graph->items, graph->space_items);
-        }
-
-        graph->num_items = idx + 1;
-    }
-
-    update_succeeded = update_io_graph_item(graph->items, idx, pinfo, edt, graph->hf_index, graph->calc_type, graph->interval);
-    /* XXX - TAP_PACKET_FAILED if the item couldn't be updated, with an error message? */
-    return update_succeeded ? TAP_PACKET_REDRAW : TAP_PACKET_DONT_REDRAW;
+    /* XXX - TAP_PACKET_FAILED if the packet couldn't be added, with an error message? */
+    return io_graph_columns_append(columns, pinfo, edt) ? TAP_PACKET_REDRAW : TAP_PACKET_DONT_REDRAW;
 }
 
 /**
@@ -4374,7 +4367,9 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
 {
     const char *tok_interval = json_find_attr(buf, tokens, count, "interval");
     struct sharkd_iograph graphs[10];
-    gboolean is_any_ok = FALSE;
+    io_graph_columns_t *tapped[10];
+    char *tapped_keys[10];
+    int tapped_count = 0;
     int graph_count;
 
     guint32 interval_ms = 1000; /* default: one per second */
@@ -4383,6 +4378,14 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
     if (tok_interval)
         ws_strtou32(tok_interval, NULL, &interval_ms);
 
+    /* Columns extracted for an older capture can't be reused, and each request can add up to G_N_ELEMENTS(graphs) of them. */
+    if (iograph_columns_count != cfile.count ||
+        g_hash_table_size(iograph_columns_table) + G_N_ELEMENTS(graphs) > SHARKD_IOGRAPH_MAX_CACHED)
+    {
+        sharkd_iograph_cache_clear();
+        iograph_columns_count = cfile.count;
+    }
+
     for (i = graph_count = 0; i < (int) G_N_ELEMENTS(graphs); i++)
     {
         struct sharkd_iograph *graph = &graphs[graph_count];
@@ -4391,6 +4394,8 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
         const char *tok_filter;
         char tok_format_buf[32];
         const char *field_name;
+        GString *error;
+        char *key;
 
         snprintf(tok_format_buf, sizeof(tok_format_buf), "graph%d", i);
         tok_graph = json_find_attr(buf, tokens, count, tok_format_buf);
@@ -4430,79 +4435,108 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
         graph->interval = interval_ms;
 
         graph->hf_index = -1;
-        graph->error = check_field_unit(field_name, &graph->hf_index, graph->calc_type);
-
-        graph->space_items = 0; /* TODO, can avoid realloc()s in sharkd_iograph_packet() by calculating: capture_time / interval */
-        graph->num_items = 0;
-        graph->items = NULL;
-
-        if (!graph->error)
-            graph->error = register_tap_listener("frame", graph, tok_filter, TL_REQUIRES_PROTO_TREE, NULL, sharkd_iograph_packet, NULL, NULL);
+        error = check_field_unit(field_name, &graph->hf_index, graph->calc_type);
+
+        /*
+         * Graphs with the same filter and field share their columns, both
+         * within this request and with earlier ones, so only the first of
+         * them needs to be tapped.
+         */
+        key = g_strdup_printf("%d:%s", graph->hf_index, tok_filter ? tok_filter : "");
+        graph->columns = NULL;
+        if (!error)
+            graph->columns = (io_graph_columns_t *) g_hash_table_lookup(iograph_columns_table, key);
+
+        if (!error && !graph->columns)
+        {
+            graph->columns = io_graph_columns_new(graph->hf_index);
+            error = register_tap_listener("frame", graph->columns, tok_filter, graph->hf_index >= 0 ? TL_REQUIRES_PROTO_TREE : 0, NULL, sharkd_iograph_packet, NULL, NULL);
+            if (error)
+            {
+                io_graph_columns_free(graph->columns);
+            }
+            else
+            {
+                g_hash_table_insert(iograph_columns_table, g_strdup(key), graph->columns);
+                tapped[tapped_count] = graph->columns;
+                tapped_keys[tapped_count] = key;
+                tapped_count++;
+                key = NULL;
+            }
+        }
+        g_free(key);
 
         graph_count++;
 
-        if (graph->error)
+        if (error)
         {
             sharkd_json_error(
                     rpcid, -6001, NULL,
-                    "%s", graph->error->str
+                    "%s", error->str
                     );
-            g_string_free(graph->error, TRUE);
+            g_string_free(error, TRUE);
+
+            /* Don't keep columns which were never filled in. */
+            for (int j = 0; j < tapped_count; j++)
+            {
+                remove_tap_listener(tapped[j]);
+                g_hash_table_remove(iograph_columns_table, tapped_keys[j]);
+                g_free(tapped_keys[j]);
+            }
             return;
         }
-
-        if (graph->error == NULL)
-            is_any_ok = TRUE;
     }
 
-    /* retap only if we have at least one ok */
-    if (is_any_ok)
+    /* retap only if some columns haven't been extracted yet */
+    if (tapped_count > 0)
         sharkd_retap();
 
+    for (i = 0; i < tapped_count; i++)
+    {
+        remove_tap_listener(tapped[i]);
+        g_free(tapped_keys[i]);
+    }
+
     sharkd_json_result_prologue(rpcid);
 
     sharkd_json_array_open("iograph");
     for (i = 0; i < graph_count; i++)
     {
         struct sharkd_iograph *graph = &graphs[i];
+        io_graph_item_t *items;
+        int num_items;
+        int idx;
+        int next_idx = 0;
 
         json_dumper_begin_object(&dumper);
 
-        if (graph->error)
-        {
-            fprintf(stderr, "SNAP 6002 - we should never get to here.\n");
-            g_string_free(graph->error, TRUE);
-            exit(-1);
-        }
-        else
-        {
-            int idx;
-            int next_idx = 0;
+        num_items = io_graph_columns_num_items(graph->columns, graph->interval, SHARKD_IOGRAPH_MAX_ITEMS);
+        items = g_new(io_graph_item_t, num_items > 0 ? num_items : 1);
+        io_graph_columns_fill_items(graph->columns, graph->calc_type, graph->interval, items, num_items);
 
-            sharkd_json_array_open("items");
-            for (idx = 0; idx < graph->num_items; idx++)
-            {
-                double val;
+        sharkd_json_array_open("items");
+        for (idx = 0; idx < num_items; idx++)
+        {
+            double val;
 
-                val = get_io_graph_item(graph->items, graph->calc_type, idx, graph->hf_index, &cfile, graph->interval, graph->num_items);
+            val = get_io_graph_item(items, graph->calc_type, idx, graph->hf_index, &cfile, graph->interval, num_items);
 
-                /* if it's zero, don't display */
-                if (val == 0.0)
-                    continue;
+            /* if it's zero, don't display */
+            if (val == 0.0)
+                continue;
 
-                /* cause zeros are not printed, need to output index */
-                if (next_idx != idx)
-                    sharkd_json_value_stringf(NULL, "%x", idx);
+            /* cause zeros are not printed, need to output index */
+            if (next_idx != idx)
+                sharkd_json_value_stringf(NULL, "%x", idx);
 
-                sharkd_json_value_anyf(NULL, "%f", val);
-                next_idx = idx + 1;
-            }
-            sharkd_json_array_close();
+            sharkd_json_value_anyf(NULL, "%f", val);
+            next_idx = idx + 1;
         }
+        sharkd_json_array_close();
+
         json_dumper_end_object(&dumper);
 
-        remove_tap_listener(graph);
-        g_free(graph->items);
+        g_free(items);
     }
     sharkd_json_array_close();
 
@@ -4517,6 +4551,8 @@ sharkd_session_process_iograph(char *buf, const jsmntok_t *tokens, int count)
  * Input:
  *   (o) interval - interval time in ms, if not specified: 1000ms
  *   (o) filter   - filter for generating interval request
+ *   (o) from     - only count frames at least this many ms after the first frame
+ *   (o) to       - only count frames less than this many ms after the first frame
  *
  * Output object with attributes:
  *   (m) intervals - array of intervals, with indexes:
@@ -4535,6 +4571,8 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
 {
     const char *tok_interval = json_find_attr(buf, tokens, count, "interval");
     const char *tok_filter = json_find_attr(buf, tokens, count, "filter");
+    const char *tok_from = json_find_attr(buf, tokens, count, "from");
+    const char *tok_to = json_find_attr(buf, tokens, count, "to");
 
     const guint8 *filter_data = NULL;
 
@@ -4545,6 +4583,10 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
     } st, st_total;
 
     nstime_t *start_ts;
+    nstime_t from_ts, to_ts;
+    const nstime_t *from_p = NULL, *to_p = NULL;
+    guint32 from_ms = 0, to_ms = 0;
+    guint32 framenum;
 
     guint32 interval_ms = 1000; /* default: one per second */
 
@@ -4583,7 +4625,27 @@ sharkd_session_process_intervals(char *buf, const jsmntok_t *tokens, int count)
 
     start_ts = (cfile.count >= 1) ? &(sharkd_get_frame(1)->abs_ts) : NULL;
 
-    for (guint32 framenum = 1; framenum <= cfile.count; framenum++)
+    if (start_ts && tok_from)
+    {
+        ws_strtou32(tok_from, NULL, &from_ms);  // already validated
+        from_ts.secs = from_ms / 1000;
+        from_ts.nsecs = (from_ms % 1000) * 1000000;
+        nstime_add(&from_ts, start_ts);
+        from_p = &from_ts;
+    }
+    if (start_ts && tok_to)
+    {
+        ws_strtou32(tok_to, NULL, &to_ms);  // already validated
+        to_ts.secs = to_ms / 1000;
+        to_ts.nsecs = (to_ms % 1000) * 1000000;
+        nstime_add(&to_ts, start_ts);
+        to_p = &to_ts;
+    }
+
+    /* The time index lets us skip blocks of frames outside [from, to). */
+    for (framenum = frame_data_sequence_find_next_in_time_range(cfile.provider.frames, 0, from_p, to_p);
+         framenum != 0;
+         framenum = frame_data_sequence_find_next_in_time_range(cfile.provider.frames, framenum, from_p, to_p))
     {
         frame_data *fdata;
         gint64 msec_rel;
@@ -5065,6 +5127,8 @@ sharkd_session_process_setcomment(char *buf, const jsmntok_t *tokens, int count)
     else
     {
         sharkd_set_modified_block(fdata, pkt_block);
+        /* frame.comment may be graphed */
+        sharkd_iograph_cache_clear();
         sharkd_json_simple_ok(rpcid);
     }
 }
@@ -5116,6 +5180,8 @@ sharkd_session_process_setconf(char *buf, const jsmntok_t *tokens, int count)
     switch (ret)
     {
         case PREFS_SET_OK:
+            /* Preferences can change dissection, don't reuse extracted iograph values. */
+            sharkd_iograph_cache_clear();
             sharkd_json_simple_ok(rpcid);
             break;
 
@@ -5834,6 +5900,7 @@ sharkd_session_main(int mode_setting)
     dumper.output_file = stdout;
 
     filter_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_session_filter_free);
+    iograph_columns_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, sharkd_iograph_columns_free);
 
 #ifdef HAVE_MAXMINDDB
     /* mmdbresolve was stopped before fork(), force starting it */
@@ -5884,6 +5951,7 @@ sharkd_session_main(int mode_setting)
     }
 
     g_hash_table_destroy(filter_table);
+    g_hash_table_destroy(iograph_columns_table);
     g_free(tokens);
 
     return 0;
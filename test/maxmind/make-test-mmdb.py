@@ -0,0 +1,245 @@
+#!/usr/bin/env python3
+#
+# Wireshark tests
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+'''Write the MaxMind DB files used by suite_nameres.py.
+
+Usage: make-test-mmdb.py [output directory]
+
+The valid databases map 8.0.0.0/8 and 4.2.2.0/24. The others are broken
+in the ways the built-in reader in epan/maxmind_db.c has to cope with.
+'''
+
+import os
+import struct
+import sys
+
+METADATA_MARKER = b'\xab\xcd\xefMaxMind.com'
+
+T_POINTER, T_UTF8, T_DOUBLE, T_BYTES, T_UINT16, T_UINT32, T_MAP = range(1, 8)
+T_INT32, T_UINT64, T_UINT128, T_ARRAY = range(8, 12)
+
+
+def control(type_, size):
+    if size < 29:
+        size_bits, extra = size, b''
+    elif size < 285:
+        size_bits, extra = 29, bytes([size - 29])
+    elif size < 65821:
+        size_bits, extra = 30, struct.pack('>H', size - 285)
+    else:
+        size_bits, extra = 31, struct.pack('>I', size - 65821)[1:]
+    if type_ > 7:
+        return bytes([size_bits]) + bytes([type_ - 7]) + extra
+    return bytes([type_ << 5 | size_bits]) + extra
+
+
+def pointer(offset):
+    if offset < 2048:
+        return bytes([T_POINTER << 5 | 0 << 3 | offset >> 8, offset & 0xff])
+    if offset < 526336:
+        offset -= 2048
+        return bytes([T_POINTER << 5 | 1 << 3 | offset >> 16]) + struct.pack('>H', offset & 0xffff)
+    raise ValueError('pointer too big')
+
+
+class Raw(bytes):
+    '''Bytes to be written as they are.'''
+
+
+class Uint(int):
+    def __new__(cls, value, type_=T_UINT32):
+        obj = int.__new__(cls, value)
+        obj.type_ = type_
+        return obj
+
+
+class Encoder:
+    '''Encodes values for a data section. Strings that have been written
+    before are written as pointers to the first copy, as real databases
+    do with map keys.'''
+
+    def __init__(self, base=0):
+        self.buf = bytearray()
+        self.base = base
+        self.strings = {}
+
+    def encode(self, value):
+        buf = self.buf
+        offset = len(buf)
+        if isinstance(value, Raw):
+            buf += value
+        elif isinstance(value, str):
+            if value in self.strings:
+                buf += pointer(self.strings[value])
+            else:
+                self.strings[value] = offset + self.base
+                data = value.encode('utf-8')
+                buf += control(T_UTF8, len(data)) + data
+        elif isinstance(value, bytes):
+            buf += control(T_BYTES, len(value)) + value
+        elif isinstance(value, float):
+            buf += control(T_DOUBLE, 8) + struct.pack('>d', value)
+        elif isinstance(value, int):
+            type_ = getattr(value, 'type_', T_UINT32)
+            data = value.to_bytes(16, 'big').lstrip(b'\0')
+            buf += control(type_, len(data)) + data
+        elif isinstance(value, dict):
+            buf += control(T_MAP, len(value))
+            for key, item in value.items():
+                self.encode(key)
+                self.encode(item)
+        elif isinstance(value, list):
+            buf += control(T_ARRAY, len(value))
+            for item in value:
+                self.encode(item)
+        else:
+            raise TypeError(value)
+        return offset + self.base
+
+
+def prefix_bits(addr, length, ip_version):
+    if ip_version == 6 and len(addr) == 4:
+        addr = bytes(12) + addr
+        length += 96
+    return [(addr[i // 8] >> (7 - i % 8)) & 1 for i in range(length)]
+
+
+def write_mmdb(ip_version, record_size, networks, records, extra_metadata=None, node_count_adjust=0):
+    '''networks: list of (address bytes, prefix length, record key).
+    records: dict of record key to the value, or to an int giving a raw
+    tree record value.'''
+    # Build the search tree. Records are ('node', n), ('data', key)
+    # or None for no data.
+    nodes = [[None, None]]
+    for addr, length, key in networks:
+        bits = prefix_bits(addr, length, ip_version)
+        node = 0
+        for bit in bits[:-1]:
+            rec = nodes[node][bit]
+            if rec is None:
+                nodes.append([None, None])
+                rec = nodes[node][bit] = ('node', len(nodes) - 1)
+            node = rec[1]
+        nodes[node][bits[-1]] = ('data', key)
+    node_count = len(nodes)
+
+    # A block of filler first, so that the later pointers are long ones.
+    enc = Encoder()
+    enc.encode(bytes(3000))
+    data_offsets = {}
+    for key, value in records.items():
+        if not isinstance(value, Uint) and isinstance(value, int):
+            continue
+        data_offsets[key] = enc.encode(value)
+
+    def record_value(rec):
+        if rec is None:
+            return node_count
+        if rec[0] == 'node':
+            return rec[1]
+        value = records[rec[1]]
+        if not isinstance(value, Uint) and isinstance(value, int):
+            return value
+        return node_count + 16 + data_offsets[rec[1]]
+
+    tree = bytearray()
+    for left, right in nodes:
+        left, right = record_value(left), record_value(right)
+        if record_size == 24:
+            tree += left.to_bytes(3, 'big') + right.to_bytes(3, 'big')
+        elif record_size == 28:
+            tree += (left & 0xffffff).to_bytes(3, 'big')
+            tree.append((left >> 20) & 0xf0 | (right >> 24) & 0x0f)
+            tree += (right & 0xffffff).to_bytes(3, 'big')
+        else:
+            tree += left.to_bytes(4, 'big') + right.to_bytes(4, 'big')
+
+    metadata = {
+        'binary_format_major_version': Uint(2, T_UINT16),
+        'binary_format_minor_version': Uint(0, T_UINT16),
+        'build_epoch': Uint(1700000000, T_UINT64),
+        'database_type': 'Wireshark-Test',
+        'description': {'en': 'Wireshark test database'},
+        'ip_version': Uint(ip_version, T_UINT16),
+        'languages': ['en'],
+        'node_count': Uint(node_count + node_count_adjust),
+        'record_size': Uint(record_size, T_UINT16),
+    }
+    metadata.update(extra_metadata or {})
+    meta_enc = Encoder()
+    meta_enc.encode(metadata)
+
+    return bytes(tree) + bytes(16) + bytes(enc.buf) + METADATA_MARKER + bytes(meta_enc.buf)
+
+
+GOOD_RECORDS = {
+    'eight': {
+        'autonomous_system_number': 64496,
+        'autonomous_system_organization': 'Test AS',
+        'city': {'names': {'en': 'Testville', 'de': 'Teststadt'}},
+        'country': {'iso_code': 'ZZ', 'names': {'de': 'Testreich', 'en': 'Testland'}},
+        'location': {'accuracy_radius': Uint(100, T_UINT16), 'latitude': 1.5, 'longitude': -2.25},
+    },
+    # Shares its keys with the record above, so they are pointers.
+    'four': {
+        'country': {'names': {'en': 'Otherland'}, 'iso_code': 'ZY'},
+        'location': {'latitude': -10.0, 'longitude': 20.0},
+    },
+}
+
+GOOD_NETWORKS = [
+    (bytes([8, 0, 0, 0]), 8, 'eight'),
+    (bytes([4, 2, 2, 0]), 24, 'four'),
+]
+
+
+def make_all():
+    files = {}
+    for ip_version, record_size in ((6, 24), (4, 28), (6, 32)):
+        files['geoip-ipv%d-%d.mmdb' % (ip_version, record_size)] = \
+            write_mmdb(ip_version, record_size, GOOD_NETWORKS, GOOD_RECORDS)
+
+    good = files['geoip-ipv6-24.mmdb']
+    # Cut off in the data section, so there's no metadata.
+    files['truncated-metadata.mmdb'] = good[:len(good) // 2]
+    # The metadata claims more nodes than there is room for.
+    files['truncated-tree.mmdb'] = write_mmdb(6, 24, GOOD_NETWORKS, GOOD_RECORDS, node_count_adjust=1000)
+    # A record size that doesn't exist.
+    files['bad-record-size.mmdb'] = write_mmdb(6, 24, GOOD_NETWORKS, GOOD_RECORDS,
+                                               extra_metadata={'record_size': Uint(30, T_UINT16)})
+    # Bad data: nesting past the maximum depth, a pointer past the end
+    # of the data section, a string longer than the data section, a map
+    # that claims more pairs than there are, and a search tree record
+    # pointing past the data section. None of them may be looked up.
+    files['bad-data.mmdb'] = write_mmdb(6, 24, [
+        (bytes([8, 8, 8, 0]), 24, 'deep'),
+        (bytes([8, 8, 4, 0]), 24, 'past-end'),
+        (bytes([4, 2, 2, 0]), 24, 'long-string'),
+        (bytes([192, 168, 43, 0]), 24, 'short-map'),
+        (bytes([174, 137, 0, 0]), 16, 'tree-past-end'),
+    ], {
+        'deep': {
+            'deep': Raw(control(T_ARRAY, 1) * 100 + control(T_UINT16, 0)),
+            'country': {'names': {'en': 'Deepland'}},
+        },
+        'past-end': {'country': Raw(pointer(0x7ffff))},
+        'long-string': {'autonomous_system_organization': Raw(control(T_UTF8, 60000))},
+        # Last, so that reading past its end runs off the data section.
+        'short-map': Raw(control(T_MAP, 200) + control(T_UTF8, 4) + b'city' + control(T_UTF8, 1) + b'x'),
+        'tree-past-end': 0xffffff,
+    })
+    return files
+
+
+def main():
+    out_dir = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    for name, data in make_all().items():
+        with open(os.path.join(out_dir, name), 'wb') as f:
+            f.write(data)
+
+
+if __name__ == '__main__':
+    main()
@@ -332,3 +332,36 @@ class TestTsharkExtcap:
         # Ensure tshark lists 2 interfaces in the preferences
         proc = subprocesstest.run((cmd_tshark, '-G', 'currentprefs'), capture_output=True, env=test_env)
         assert count_output(proc.stdout, 'extcap.sampleif.test') == 2
+
+
+class TestCapinfosClopts:
+    def test_capinfos_threads_keep_order(self, cmd_capinfos, capture_file, test_env):
+        '''--threads reports files in command line order'''
+        files = [capture_file(f) for f in ('dhcp.pcap', 'dhcp.pcapng', 'http.pcap', 'dns-mdns.pcap', 'dhcp-nanosecond.pcapng')]
+        serial = subprocesstest.run([cmd_capinfos, '-T'] + files, capture_output=True, env=test_env)
+        assert serial.returncode == ExitCodes.OK
+        parallel = subprocesstest.run([cmd_capinfos, '-T', '--threads', '4'] + files, capture_output=True, env=test_env)
+        assert parallel.returncode == ExitCodes.OK
+        assert parallel.stdout == serial.stdout
+
+    def test_capinfos_fast_isb(self, cmd_capinfos, capture_file, test_env):
+        '''--fast takes the packet count and times from the trailing interface statistics'''
+        infos = ['-c', '-E', '-u', '-a', '-e', '-x', '-S', '-M']
+        isb_file = capture_file('dhcp-isb.pcapng')
+        full = subprocesstest.run([cmd_capinfos] + infos + [isb_file], capture_output=True, env=test_env)
+        assert full.returncode == ExitCodes.OK
+        fast = subprocesstest.run([cmd_capinfos, '--fast'] + infos + [isb_file], capture_output=True, env=test_env)
+        assert fast.returncode == ExitCodes.OK
+        assert fast.stdout == full.stdout
+        assert grep_output(fast.stdout, r'Number of packets:\s+4')
+        # The data size is only known if the packets were read.
+        fast = subprocesstest.run((cmd_capinfos, '--fast', '-d', isb_file), capture_output=True, env=test_env)
+        assert grep_output(fast.stdout, r'Data size:\s+\(unknown\)')
+        full = subprocesstest.run((cmd_capinfos, '-d', isb_file), capture_output=True, env=test_env)
+        assert not grep_output(full.stdout, r'Data size:\s+\(unknown\)')
+
+    def test_capinfos_fast_fallback(self, cmd_capinfos, capture_file, test_env):
+        '''--fast reads the whole file when there are no interface statistics'''
+        process = subprocesstest.run((cmd_capinfos, '--fast', '-c', capture_file('dhcp.pcapng')), capture_output=True, env=test_env)
+        assert process.returncode == ExitCodes.OK
+        assert grep_output(process.stdout, r'Number of packets:\s+4')
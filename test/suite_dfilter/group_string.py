@@ -134,6 +134,28 @@ class TestDfilterString:
         dfilter = 'http.request.method contains 48:45:41:44' # "48:45:41:44"
         checkDFilterCount(dfilter, 0)
 
+    def test_contains_any_1(self, checkDFilterCount):
+        dfilter = 'http.request.method contains_any {"POST", "EA"}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_contains_any_2(self, checkDFilterCount):
+        dfilter = 'http.request.method contains_any {"POST", "GET", "PUT"}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_contains_any_3(self, checkDFilterCount):
+        dfilter = 'http.request.method contains_any {"\x48\x45\x41\x44"}' # "HEAD"
+        checkDFilterCount(dfilter, 1)
+
+    def test_contains_any_4(self, checkDFilterFail):
+        error = 'A range may not appear in a contains_any set'
+        dfilter = 'http.request.method contains_any {"A".."B"}'
+        checkDFilterFail(dfilter, error)
+
+    def test_contains_any_5(self, checkDFilterFail):
+        error = 'Only constant values may appear in a contains_any set'
+        dfilter = 'http.request.method contains_any {http.request.uri}'
+        checkDFilterFail(dfilter, error)
+
     def test_contains_fail_0(self, checkDFilterCount):
         dfilter = 'http.user_agent contains "update"'
         checkDFilterCount(dfilter, 0)
@@ -463,6 +463,59 @@ class TestDfilterXor:
         dfilter = 'ip.src == 9.9.9.9 ^^ ip.dst == 9.9.9.9'
         checkDFilterCount(dfilter, 0)
 
+class TestDfilterSuperinstructions:
+    trace_file = "http.pcap"
+
+    def test_fused_eq_1(self, checkDFilterSucceed):
+        dfilter = 'tcp.port == 80'
+        checkDFilterSucceed(dfilter, 'FIELD_ANY_EQ')
+
+    def test_fused_eq_2(self, checkDFilterCount):
+        dfilter = 'tcp.port == 443 or tcp.port == 3267'
+        checkDFilterCount(dfilter, 1)
+
+    def test_fused_ne_1(self, checkDFilterCount):
+        dfilter = 'tcp.port != 80'
+        checkDFilterCount(dfilter, 0)
+
+    def test_fused_gt_1(self, checkDFilterCount):
+        dfilter = 'tcp.port > 3000'
+        checkDFilterCount(dfilter, 1)
+
+    def test_fused_in_1(self, checkDFilterSucceed):
+        dfilter = 'tcp.port in {443, 8000..8080}'
+        checkDFilterSucceed(dfilter, 'FIELD_ANY_IN')
+
+    def test_fused_in_2(self, checkDFilterCount):
+        dfilter = 'tcp.port in {10..20, 3000..4000, 15..25}'
+        checkDFilterCount(dfilter, 1)
+
+    def test_fused_contains_1(self, checkDFilterSucceed):
+        dfilter = 'http.request.method contains "POST" or http.request.method contains "EA"'
+        checkDFilterSucceed(dfilter, 'ANY_CONTAINS_ANY')
+
+    def test_fused_contains_2(self, checkDFilterCount):
+        dfilter = 'http.request.method contains "POST" or tcp.port == 1 or http.request.method contains "EA"'
+        checkDFilterCount(dfilter, 1)
+
+    def test_fused_contains_3(self, checkDFilterCount):
+        dfilter = 'http.request.method contains "POST" or http.request.method contains_any {"GET", "PUT"}'
+        checkDFilterCount(dfilter, 0)
+
+    def test_fused_contains_4(self, cmd_dftest, base_env):
+        # Protocols are compared pair by pair, so they aren't fused.
+        dfilter = 'http contains "POST" or http contains "GET"'
+        proc = subprocesstest.run([cmd_dftest, '--', dfilter],
+                                capture_output=True,
+                                universal_newlines=True,
+                                env=base_env)
+        assert proc.returncode == 0
+        assert 'CONTAINS_ANY' not in proc.stdout
+
+    def test_fused_contains_5(self, checkDFilterCount):
+        dfilter = 'http contains "POST" or http contains "GET"'
+        checkDFilterCount(dfilter, 1)
+
 class TestDfilterTFSValueString:
     trace_file = "http.pcap"
 
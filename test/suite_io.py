@@ -10,6 +10,7 @@
 
 import io
 import os.path
+import struct
 import subprocess
 from subprocesstest import cat_dhcp_command, check_packet_count
 import sys
@@ -54,6 +55,38 @@ def check_io_4_packets(capture_file, result_file, cmd_tshark, cmd_capinfos, from
     check_packet_count(cmd_capinfos, 4, testout_file)
 
 
+def pcapng_blocks(data):
+    '''Yields the (type, body) of each block of a little-endian pcapng file.'''
+    offset = 0
+    while offset < len(data):
+        block_type, length = struct.unpack_from('<II', data, offset)
+        yield block_type, data[offset + 8:offset + length - 4]
+        offset += length
+
+
+def pcapng_block(block_type, body):
+    body += bytes(-len(body) % 4)
+    length = len(body) + 12
+    return struct.pack('<II', block_type, length) + body + struct.pack('<I', length)
+
+
+def nrb_names(data):
+    '''Returns the names in the IPv4 records of the NRBs of a pcapng file.'''
+    names = []
+    for block_type, body in pcapng_blocks(data):
+        if block_type != 4:
+            continue
+        offset = 0
+        while offset + 4 <= len(body):
+            record_type, length = struct.unpack_from('<HH', body, offset)
+            if record_type == 0:
+                break
+            if record_type == 1:
+                names.append(body[offset + 8:offset + 4 + length].rstrip(b'\0').decode())
+            offset += 4 + length + (-length % 4)
+    return names
+
+
 class TestTsharkIO:
     def test_tshark_io_stdin_direct(self, cmd_tshark, cmd_capinfos, capture_file, result_file, test_env):
         '''Read from stdin and write direct using TShark'''
@@ -81,3 +114,76 @@ class TestRawsharkIO:
         rawshark_cmd = '{0} | "{1}" -r - -n -dencap:1 -R "udp.port==68"'.format(raw_dhcp_cmd, cmd_rawshark)
         rawshark_stdout = subprocess.check_output(rawshark_cmd, shell=True, encoding='utf-8', env=test_env)
         assert rawshark_stdout == io_baseline_str
+
+
+class TestTsharkPipeline:
+    @pytest.mark.parametrize('capture', ('dhcp.pcap', 'dns+icmp.pcapng.gz', 'dtls12-aes128ccm8-dsb.pcapng'))
+    def test_tshark_pipeline_same_output(self, cmd_tshark, capture_file, capture, test_env):
+        '''Printed output with --pipeline matches output without it'''
+        args = (cmd_tshark, '-r', capture_file(capture), '-V')
+        expected = subprocess.check_output(args, env=test_env)
+        actual = subprocess.check_output(args + ('--pipeline',), env=test_env)
+        assert actual == expected
+
+    def test_tshark_pipeline_count(self, cmd_tshark, cmd_capinfos, capture_file, result_file, test_env):
+        '''Write a capture file with --pipeline and -c'''
+        testout_file = result_file(testout_pcap)
+        subprocess.check_call((cmd_tshark,
+            '-r', capture_file('dns+icmp.pcapng.gz'),
+            '-c', '3',
+            '-w', testout_file,
+            '--pipeline',
+        ), env=test_env)
+        check_packet_count(cmd_capinfos, 3, testout_file)
+
+    def test_tshark_pipeline_mid_file_nrbs(self, cmd_tshark, capture_file, result_file, test_env):
+        '''Write a pcapng file with --pipeline from one with NRBs between its packets'''
+        with open(capture_file('dhcp.pcapng'), 'rb') as f:
+            blocks = list(pcapng_blocks(f.read()))
+        header = b''.join(pcapng_block(t, b) for t, b in blocks if t in (0x0a0d0d0a, 1))
+        packets = [pcapng_block(t, b) for t, b in blocks if t == 6]
+        # Enough packets that the reader thread reads NRBs while the
+        # dump thread writes, with a new name every 40 packets.
+        contents = [header]
+        names = []
+        for i in range(2000):
+            if i % 40 == 0:
+                name = 'host{}.example'.format(i // 40)
+                record = bytes([10, 0, 0, i // 40 + 1]) + name.encode() + b'\0'
+                contents.append(pcapng_block(4, struct.pack('<HH', 1, len(record)) +
+                    record + bytes(-len(record) % 4) + bytes(4)))
+                names.append(name)
+            contents.append(packets[i % len(packets)])
+        in_file = result_file('nrbs.pcapng')
+        with open(in_file, 'wb') as f:
+            f.write(b''.join(contents))
+
+        testout_file = result_file('testout.pcapng')
+        subprocess.check_call((cmd_tshark,
+            '-r', in_file,
+            '-w', testout_file,
+            '--pipeline',
+        ), env=test_env)
+        with open(testout_file, 'rb') as f:
+            written = f.read()
+        assert nrb_names(written) == names
+        assert sum(1 for t, b in pcapng_blocks(written) if t == 6) == 2000
+
+
+class TestTsharkFlowShards:
+    def test_tshark_flow_shards_same_output(self, cmd_tshark, capture_file, test_env):
+        '''Fields printed with --flow-shards match the fields printed without it'''
+        args = (cmd_tshark, '-r', capture_file('dns+icmp.pcapng.gz'),
+            '-T', 'fields', '-e', 'frame.number', '-e', 'frame.time_relative',
+            '-e', 'ip.src', '-e', 'ip.dst', '-e', '_ws.col.info')
+        expected = subprocess.check_output(args, env=test_env)
+        actual = subprocess.check_output(args + ('--flow-shards', '3'), env=test_env)
+        assert actual == expected
+
+    def test_tshark_flow_shards_count(self, cmd_tshark, capture_file, test_env):
+        '''--flow-shards stops after the -c packet count'''
+        args = (cmd_tshark, '-r', capture_file('dns+icmp.pcapng.gz'),
+            '-c', '3', '-T', 'fields', '-e', 'frame.number')
+        expected = subprocess.check_output(args, env=test_env)
+        actual = subprocess.check_output(args + ('--flow-shards', '2'), env=test_env)
+        assert actual == expected
@@ -104,3 +104,75 @@ class TestNameResolution:
                 ), encoding='utf-8')
         assert '174.137.42.65\twww.wireshark.org' not in stdout
         assert 'fe80::6233:4bff:fe13:c558\tCrunch.local' in stdout
+
+
+@pytest.fixture
+def geoip_fields(cmd_tshark, capture_file, dirs, tmp_path, test_env):
+    '''Run tshark with a single MaxMind database read by the built-in
+    reader, and return the GeoIP fields by destination address.'''
+    def geoip_fields_real(mmdb_name):
+        mmdb_dir = tmp_path / 'maxmind'
+        mmdb_dir.mkdir()
+        shutil.copyfile(os.path.join(dirs.maxmind_dir, mmdb_name), mmdb_dir / mmdb_name)
+        proc = subprocess.run((cmd_tshark,
+                '-r', capture_file('dns+icmp.pcapng.gz'),
+                '-o', 'nameres.maxmind_geoip: TRUE',
+                '-o', 'nameres.maxmind_builtin_reader: TRUE',
+                '-o', 'uat:maxmind_db_paths:"{}"'.format(str(mmdb_dir).replace('\\', '\\x5c')),
+                '-T', 'fields',
+                '-E', 'separator=|',
+                '-E', 'occurrence=f',
+                '-e', 'ip.dst',
+                '-e', 'ip.geoip.dst_country_iso',
+                '-e', 'ip.geoip.dst_country',
+                '-e', 'ip.geoip.dst_city',
+                '-e', 'ip.geoip.dst_asnum',
+                '-e', 'ip.geoip.dst_org',
+                '-e', 'ip.geoip.dst_lat',
+                '-e', 'ip.geoip.dst_lon',
+                ), check=True, capture_output=True, encoding='utf-8', env=test_env)
+        fields = {}
+        for line in proc.stdout.splitlines():
+            values = line.split('|')
+            if values[0]:
+                fields[values[0]] = values[1:]
+        return fields
+    return geoip_fields_real
+
+
+class TestMaxMindDB:
+    '''The built-in MaxMind DB reader. The databases in test/maxmind are
+    written by test/maxmind/make-test-mmdb.py.'''
+
+    @pytest.mark.parametrize('mmdb_name', (
+        'geoip-ipv6-24.mmdb',
+        'geoip-ipv4-28.mmdb',
+        'geoip-ipv6-32.mmdb',
+    ))
+    def test_maxmind_builtin_reader(self, geoip_fields, mmdb_name):
+        '''Lookups in databases with each record size.'''
+        fields = geoip_fields(mmdb_name)
+        iso, country, city, asnum, org, lat, lon = fields['8.8.8.8']
+        assert (iso, country, city, asnum, org) == ('ZZ', 'Testland', 'Testville', '64496', 'Test AS')
+        assert (float(lat), float(lon)) == (1.5, -2.25)
+        assert fields['8.8.4.4'][:2] == ['ZZ', 'Testland']
+        # This record's map keys are pointers to the ones above.
+        iso, country, city, asnum, org, lat, lon = fields['4.2.2.2']
+        assert (iso, country) == ('ZY', 'Otherland')
+        assert (float(lat), float(lon)) == (-10.0, 20.0)
+        assert 'Testland' not in fields['174.137.42.65']
+
+    @pytest.mark.parametrize('mmdb_name', (
+        'truncated-metadata.mmdb',
+        'truncated-tree.mmdb',
+        'bad-record-size.mmdb',
+        'bad-data.mmdb',
+    ))
+    def test_maxmind_builtin_reader_malformed(self, geoip_fields, mmdb_name):
+        '''Broken databases are rejected or give no results, without
+        crashing.'''
+        fields = geoip_fields(mmdb_name)
+        assert '8.8.8.8' in fields
+        for values in fields.values():
+            for name in ('Testland', 'Otherland', 'Deepland', 'Test AS'):
+                assert name not in values
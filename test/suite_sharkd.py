@@ -1139,6 +1139,26 @@ class TestSharkd:
             {"jsonrpc":"2.0","id":3,"error":{"code":-6001,"message":"Filter \"garbage filter\" is invalid - \"filter\" was unexpected in this context."}},
         ))
 
+    def test_sharkd_req_iograph_shared(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap')}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"iograph",
+            "params":{"graph0": "max:udp.length", "filter0": "udp",
+                      "graph1": "min:udp.length", "filter1": "udp",
+                      "graph2": "avg:udp.length", "filter2": "udp"}
+            },
+            {"jsonrpc":"2.0", "id":3, "method":"iograph",
+            "params":{"interval": 10, "graph0": "max:udp.length", "filter0": "udp",
+                      "graph1": "packets"}
+            },
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":{"iograph": [{"items": [308.000000]}, {"items": [280.000000]}, {"items": [294.000000]}]}},
+            {"jsonrpc":"2.0","id":3,"result":{"iograph": [{"items": [308.000000, "7", 308.000000]}, {"items": [2.000000, "7", 2.000000]}]}},
+        ))
+
     def test_sharkd_req_intervals_bad(self, check_sharkd_session, capture_file):
         check_sharkd_session((
             {"jsonrpc":"2.0", "id":1, "method":"load",
@@ -1171,6 +1191,27 @@ class TestSharkd:
             {"jsonrpc":"2.0","id":4,"result":{"intervals":[[0,2,656]],"last":0,"frames":2,"bytes":656}},
         ))
 
+    def test_sharkd_req_intervals_range(self, check_sharkd_session, capture_file):
+        check_sharkd_session((
+            {"jsonrpc":"2.0", "id":1, "method":"load",
+            "params":{"file": capture_file('dhcp.pcap')}
+            },
+            {"jsonrpc":"2.0", "id":2, "method":"intervals",
+            "params":{"interval": 1, "from": 1}
+            },
+            {"jsonrpc":"2.0", "id":3, "method":"intervals",
+            "params":{"interval": 1, "to": 1}
+            },
+            {"jsonrpc":"2.0", "id":4, "method":"intervals",
+            "params":{"interval": 1, "from": 1, "to": 70}
+            },
+        ), (
+            {"jsonrpc":"2.0","id":1,"result":{"status":"OK"}},
+            {"jsonrpc":"2.0","id":2,"result":{"intervals":[[70,2,656]],"last":70,"frames":2,"bytes":656}},
+            {"jsonrpc":"2.0","id":3,"result":{"intervals":[[0,2,656]],"last":0,"frames":2,"bytes":656}},
+            {"jsonrpc":"2.0","id":4,"result":{"intervals":[],"last":0,"frames":0,"bytes":0}},
+        ))
+
     def test_sharkd_req_frame_basic(self, check_sharkd_session, capture_file):
         # XXX add more tests for other options (ref_frame, prev_frame, columns, color, bytes, hidden)
         check_sharkd_session((
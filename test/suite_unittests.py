@@ -47,6 +47,12 @@ class TestUnitTests:
             '--verbose'
         ), env=base_env)
 
+    def test_unit_wiretap(self, program, base_env):
+        '''wiretap unit tests'''
+        subprocess.check_call((program('test_wiretap'),
+            '--verbose'
+        ), env=base_env)
+
     def test_unit_wsutil(self, program, base_env):
         '''wsutil unit tests'''
         subprocess.check_call((program('test_wsutil'),
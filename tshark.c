@@ -30,6 +30,9 @@
 
 #ifndef _WIN32
 #include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #endif
 
 #include <glib.h>
@@ -51,9 +54,11 @@
 #include <wsutil/wslog.h>
 #include <wsutil/ws_assert.h>
 #include <wsutil/strtoi.h>
+#include <wsutil/tempfile.h>
 #include <cli_main.h>
 #include <wsutil/version_info.h>
 #include <wiretap/wtap_opttypes.h>
+#include <wiretap/flow_key.h>
 
 #include "globals.h"
 #include <epan/timestamp.h>
@@ -143,6 +148,8 @@
 #define LONGOPT_HEXDUMP                 LONGOPT_BASE_APPLICATION+7
 #define LONGOPT_SELECTED_FRAME          LONGOPT_BASE_APPLICATION+8
 #define LONGOPT_PRINT_TIMERS            LONGOPT_BASE_APPLICATION+9
+#define LONGOPT_PIPELINE                LONGOPT_BASE_APPLICATION+10
+#define LONGOPT_FLOW_SHARDS             LONGOPT_BASE_APPLICATION+11
 
 capture_file cfile;
 
@@ -255,8 +262,12 @@ typedef enum {
 static process_file_status_t process_cap_file(capture_file *, char *, int, gboolean, int, gint64, int);
 
 static gboolean process_packet_single_pass(capture_file *cf,
-        epan_dissect_t *edt, gint64 offset, wtap_rec *rec, Buffer *buf,
+        epan_dissect_t *edt, gint64 offset, wtap_rec *rec, const guint8 *pd,
         guint tap_flags);
+static const char *tshark_get_interface_name(struct packet_provider_data *prov,
+        guint32 interface_id);
+static const char *tshark_get_interface_description(struct packet_provider_data *prov,
+        guint32 interface_id);
 static void show_print_file_io_error(void);
 static gboolean write_preamble(capture_file *cf);
 static gboolean print_packet(capture_file *cf, epan_dissect_t *edt);
@@ -268,6 +279,11 @@ static void tshark_cmdarg_err_cont(const char *msg_format, va_list ap);
 static GHashTable *output_only_tables = NULL;
 
 static gboolean opt_print_timers = FALSE;
+static gboolean opt_pipeline = FALSE;
+
+/* Number of flow shard worker processes; 0 or 1 means we aren't sharding. */
+#define FLOW_SHARDS_MAX 64
+static guint flow_shard_count = 0;
 struct elapsed_pass_s {
     gint64 dissect;
     gint64 dfilter_read;
@@ -572,6 +588,10 @@ print_usage(FILE *output)
     fprintf(output, "                           values\n");
     fprintf(output, "  --elastic-mapping-filter <protocols> If -G elastic-mapping is specified, put only the\n");
     fprintf(output, "                           specified protocols within the mapping file\n");
+    fprintf(output, "  --pipeline               read, dissect and write in separate threads\n");
+    fprintf(output, "                           (single-pass file processing only)\n");
+    fprintf(output, "  --flow-shards <count>    dissect the flows in a capture file in <count>\n");
+    fprintf(output, "                           worker processes, see the man page for details\n");
     fprintf(output, "  --temp-dir <directory>   write temporary files to this directory\n");
     fprintf(output, "                           (default: %s)\n", g_get_tmp_dir());
     fprintf(output, "\n");
@@ -948,6 +968,8 @@ main(int argc, char *argv[])
         {"hexdump", ws_required_argument, NULL, LONGOPT_HEXDUMP},
         {"selected-frame", ws_required_argument, NULL, LONGOPT_SELECTED_FRAME},
         {"print-timers", ws_no_argument, NULL, LONGOPT_PRINT_TIMERS},
+        {"pipeline", ws_no_argument, NULL, LONGOPT_PIPELINE},
+        {"flow-shards", ws_required_argument, NULL, LONGOPT_FLOW_SHARDS},
         {0, 0, 0, 0}
     };
     gboolean             arg_error = FALSE;
@@ -981,6 +1003,7 @@ main(int argc, char *argv[])
     gchar               *volatile pdu_export_arg = NULL;
     char                *volatile exp_pdu_filename = NULL;
     const gchar         *volatile tls_session_keys_file = NULL;
+    gboolean             taps_requested = FALSE;
     exp_pdu_t            exp_pdu_tap_data;
     const gchar*         elastic_mapping_filter = NULL;
 
@@ -1756,6 +1779,7 @@ main(int argc, char *argv[])
                     exit_status = WS_EXIT_INVALID_OPTION;
                     goto clean_exit;
                 }
+                taps_requested = TRUE;
                 break;
             case 'd':        /* Decode as rule */
             case 'K':        /* Kerberos keytab file */
@@ -1785,6 +1809,7 @@ main(int argc, char *argv[])
                     exit_status = WS_EXIT_INVALID_OPTION;
                     goto clean_exit;
                 }
+                taps_requested = TRUE;
                 break;
             case LONGOPT_EXPORT_TLS_SESSION_KEYS:   /* --export-tls-session-keys */
                 tls_session_keys_file = ws_optarg;
@@ -1838,6 +1863,17 @@ main(int argc, char *argv[])
             case LONGOPT_PRINT_TIMERS:
                 opt_print_timers = TRUE;
                 break;
+            case LONGOPT_PIPELINE:
+                opt_pipeline = TRUE;
+                break;
+            case LONGOPT_FLOW_SHARDS:
+                flow_shard_count = get_positive_int(ws_optarg, "number of flow shards");
+                if (flow_shard_count > FLOW_SHARDS_MAX) {
+                    cmdarg_err("The number of flow shards must be at most %d.", FLOW_SHARDS_MAX);
+                    exit_status = WS_EXIT_INVALID_OPTION;
+                    goto clean_exit;
+                }
+                break;
             default:
             case '?':        /* Bad flag - print usage message */
                 switch(ws_optopt) {
@@ -1959,6 +1995,40 @@ main(int argc, char *argv[])
         }
     }
 
+    if (flow_shard_count > 1) {
+        /*
+         * The workers' results are merged by interleaving their printed
+         * output, so only output that's printed packet by packet can be
+         * sharded.
+         */
+#ifdef _WIN32
+        cmdarg_err("--flow-shards isn't supported on Windows.");
+        exit_status = WS_EXIT_INVALID_OPTION;
+        goto clean_exit;
+#else
+        if (cf_name == NULL || strcmp(cf_name, "-") == 0) {
+            cmdarg_err("--flow-shards can only be used when reading a capture file.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (perform_two_pass_analysis || opt_pipeline) {
+            cmdarg_err("--flow-shards can't be used with -2 or --pipeline.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (output_file_name || pdu_export_arg || taps_requested || tls_session_keys_file) {
+            cmdarg_err("--flow-shards can't be used with -w, -U, -z, --export-objects or --export-tls-session-keys.");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+        if (output_action == WRITE_JSON || output_action == WRITE_JSON_RAW || print_format == PR_FMT_PS) {
+            cmdarg_err("--flow-shards can't be used with \"-T json\", \"-T jsonraw\" or \"-T ps\".");
+            exit_status = WS_EXIT_INVALID_OPTION;
+            goto clean_exit;
+        }
+#endif
+    }
+
 #ifndef HAVE_LIBPCAP
     if (capture_option_specified)
         cmdarg_err("This version of TShark was not built with support for capturing packets.");
@@ -2753,8 +2823,8 @@ tshark_epan_new(capture_file *cf)
 {
     static const struct packet_provider_funcs funcs = {
         tshark_get_frame_ts,
-        cap_file_provider_get_interface_name,
-        cap_file_provider_get_interface_description,
+        tshark_get_interface_name,
+        tshark_get_interface_description,
         NULL,
     };
 
@@ -3057,8 +3127,8 @@ capture_input_new_packets(capture_session *cap_session, int to_read)
                 wtap_close(cf->provider.wth);
                 cf->provider.wth = NULL;
             } else {
-                ret = process_packet_single_pass(cf, edt, data_offset, &rec, &buf,
-                        tap_flags);
+                ret = process_packet_single_pass(cf, edt, data_offset, &rec,
+                        ws_buffer_start_ptr(&buf), tap_flags);
             }
             if (ret != FALSE) {
                 /* packet successfully read and gone through the "Read Filter" */
@@ -3703,6 +3773,702 @@ process_cap_file_second_pass(capture_file *cf, wtap_dumper *pdh,
     return status;
 }
 
+/*
+ * Pipelined single-pass processing (--pipeline).
+ *
+ * A reader thread reads records from the input file in batches, so that
+ * reading and decompressing the file overlaps dissection.  Records that
+ * are to be written to an output capture file are written by a dump
+ * thread and, on UN*X, the standard output is redirected to a pipe that
+ * a writer thread copies to the real standard output, so that writing
+ * overlaps dissection as well.  Dissection, filtering and formatting
+ * stay on the main thread, in file order, so the output is the same as
+ * it is without --pipeline.
+ *
+ * The batches go round through bounded queues: the reader thread takes
+ * them from free_batches and puts them on full_batches; the main thread
+ * processes them and puts them on dump_batches if there's an output
+ * capture file, otherwise back on free_batches; the dump thread puts
+ * them back on free_batches.
+ */
+#define PIPELINE_BATCH_SIZE     64
+#define PIPELINE_NUM_BATCHES    8
+#define PIPELINE_WRITE_SIZE     65536
+
+typedef enum {
+    DEFERRED_IPV4,
+    DEFERRED_IPV6,
+    DEFERRED_SECRETS
+} deferred_type_e;
+
+/*
+ * Name resolution or decryption secrets information the reader thread
+ * read; libwireshark isn't thread-safe, so it's handed to libwireshark
+ * by the main thread, before it processes the batch in which it was
+ * read.
+ */
+typedef struct {
+    deferred_type_e type;
+    guint           ipv4;
+    ws_in6_addr     ipv6;
+    gchar          *name;
+    gboolean        static_entry;
+    guint32         secrets_type;
+    void           *secrets;
+    guint           secrets_size;
+} pipeline_deferred_t;
+
+typedef struct {
+    wtap_batch_t    batch;
+    gboolean       *write;          /* TRUE for records to write to the output file */
+    int             first_framenum; /* frame number before the first record */
+    GSList         *deferred;       /* pipeline_deferred_t, most recent first */
+    gboolean        end;            /* no records; end of the input */
+    int             err;            /* for the end of the input, the read error */
+    gchar          *err_info;
+} pipeline_batch_t;
+
+typedef struct {
+    const char     *name;
+    const char     *description;
+} pipeline_iface_t;
+
+typedef struct {
+    wtap             *wth;
+    wtap_dumper      *pdh;
+    GMutex            wth_lock;     /* held while reading, looking at IDBs and dumping */
+    pipeline_batch_t  batches[PIPELINE_NUM_BATCHES];
+    pipeline_batch_t  dump_end;     /* tells the dump thread to quit */
+    GAsyncQueue      *free_batches;
+    GAsyncQueue      *full_batches;
+    GAsyncQueue      *dump_batches;
+    pipeline_batch_t *reading;      /* batch the reader thread is filling in */
+    pipeline_batch_t *current;      /* batch the main thread is processing */
+    guint             current_index;
+    gboolean          read_done;    /* the main thread got to the end of the input */
+    gint              stop_reading;
+    GHashTable       *ifaces;       /* pipeline_iface_t, by interface ID */
+    GThread          *reader;
+    GThread          *dumper;
+    gint              dump_failed;
+    int               dump_err;
+    gchar            *dump_err_info;
+    guint32           dump_err_framenum;
+#ifndef _WIN32
+    int               stdout_fd;    /* the real standard output */
+    int               pipe_fd;      /* read side of the standard output pipe */
+    gint              write_errno;
+    GThread          *writer;
+#endif
+} pipeline_t;
+
+/* The pipeline for the pass in progress, if it's pipelined. */
+static pipeline_t *pipeline;
+
+static void
+pipeline_defer(pipeline_deferred_t *deferred)
+{
+    pipeline->reading->deferred = g_slist_prepend(pipeline->reading->deferred,
+            deferred);
+}
+
+static void
+pipeline_new_ipv4(const guint addr, const gchar *name, const gboolean static_entry)
+{
+    pipeline_deferred_t *deferred;
+
+    if (pipeline == NULL || pipeline->reading == NULL) {
+        /* Not called from the reader thread. */
+        add_ipv4_name(addr, name, static_entry);
+        return;
+    }
+    deferred = g_new0(pipeline_deferred_t, 1);
+    deferred->type = DEFERRED_IPV4;
+    deferred->ipv4 = addr;
+    deferred->name = g_strdup(name);
+    deferred->static_entry = static_entry;
+    pipeline_defer(deferred);
+}
+
+static void
+pipeline_new_ipv6(const void *addrp, const gchar *name, const gboolean static_entry)
+{
+    pipeline_deferred_t *deferred;
+
+    if (pipeline == NULL || pipeline->reading == NULL) {
+        /* Not called from the reader thread. */
+        add_ipv6_name((const ws_in6_addr *)addrp, name, static_entry);
+        return;
+    }
+    deferred = g_new0(pipeline_deferred_t, 1);
+    deferred->type = DEFERRED_IPV6;
+    memcpy(&deferred->ipv6, addrp, sizeof deferred->ipv6);
+    deferred->name = g_strdup(name);
+    deferred->static_entry = static_entry;
+    pipeline_defer(deferred);
+}
+
+static void
+pipeline_new_secrets(guint32 secrets_type, const void *secrets, guint size)
+{
+    pipeline_deferred_t *deferred;
+
+    if (pipeline == NULL || pipeline->reading == NULL) {
+        /* Not called from the reader thread. */
+        secrets_wtap_callback(secrets_type, secrets, size);
+        return;
+    }
+    deferred = g_new0(pipeline_deferred_t, 1);
+    deferred->type = DEFERRED_SECRETS;
+    deferred->secrets_type = secrets_type;
+    deferred->secrets = g_memdup2(secrets, size);
+    deferred->secrets_size = size;
+    pipeline_defer(deferred);
+}
+
+/*
+ * Hand the information deferred while reading a batch to libwireshark,
+ * in the order in which it was read, or, if discard is TRUE, just
+ * free it.
+ */
+static void
+pipeline_run_deferred(pipeline_batch_t *pb, gboolean discard)
+{
+    GSList *item;
+    pipeline_deferred_t *deferred;
+
+    pb->deferred = g_slist_reverse(pb->deferred);
+    for (item = pb->deferred; item != NULL; item = g_slist_next(item)) {
+        deferred = (pipeline_deferred_t *)item->data;
+        if (!discard) {
+            switch (deferred->type) {
+
+            case DEFERRED_IPV4:
+                add_ipv4_name(deferred->ipv4, deferred->name,
+                        deferred->static_entry);
+                break;
+
+            case DEFERRED_IPV6:
+                add_ipv6_name(&deferred->ipv6, deferred->name,
+                        deferred->static_entry);
+                break;
+
+            case DEFERRED_SECRETS:
+                secrets_wtap_callback(deferred->secrets_type,
+                        deferred->secrets, deferred->secrets_size);
+                break;
+            }
+        }
+        g_free(deferred->name);
+        g_free(deferred->secrets);
+        g_free(deferred);
+    }
+    g_slist_free(pb->deferred);
+    pb->deferred = NULL;
+}
+
+static gpointer
+pipeline_reader(gpointer data)
+{
+    pipeline_t *pl = (pipeline_t *)data;
+    pipeline_batch_t *pb;
+
+    do {
+        pb = (pipeline_batch_t *)g_async_queue_pop(pl->free_batches);
+        pb->err = 0;
+        pb->err_info = NULL;
+        g_mutex_lock(&pl->wth_lock);
+        pl->reading = pb;
+        pb->end = g_atomic_int_get(&pl->stop_reading) ||
+            !wtap_read_batch(pl->wth, &pb->batch, &pb->err, &pb->err_info);
+        pl->reading = NULL;
+        g_mutex_unlock(&pl->wth_lock);
+        g_async_queue_push(pl->full_batches, pb);
+    } while (!pb->end);
+
+    return NULL;
+}
+
+static gpointer
+pipeline_dumper(gpointer data)
+{
+    pipeline_t *pl = (pipeline_t *)data;
+    pipeline_batch_t *pb;
+    guint i;
+    gboolean ok;
+    guint32 framenum;
+    int err;
+    gchar *err_info;
+
+    while ((pb = (pipeline_batch_t *)g_async_queue_pop(pl->dump_batches)) != &pl->dump_end) {
+        if (!g_atomic_int_get(&pl->dump_failed)) {
+            /*
+             * Process whatever IDBs we haven't seen yet; the reader
+             * thread has read at least the ones for this batch.
+             *
+             * Keep the reader thread locked out while writing, too:
+             * the dumper writes the NRBs, DSBs and MEVs it hasn't
+             * written yet from the wtap's arrays of them, which the
+             * reader thread appends to (and may reallocate).
+             */
+            framenum = pb->first_framenum + 1;
+            err_info = NULL;
+            g_mutex_lock(&pl->wth_lock);
+            ok = process_new_idbs(pl->wth, pl->pdh, &err, &err_info);
+            for (i = 0; ok && i < pb->batch.count; i++) {
+                if (!pb->write[i])
+                    continue;
+                framenum = pb->first_framenum + i + 1;
+                ok = wtap_dump(pl->pdh, &pb->batch.recs[i],
+                        wtap_batch_rec_data(&pb->batch, i), &err, &err_info);
+            }
+            g_mutex_unlock(&pl->wth_lock);
+            if (!ok) {
+                ws_debug("tshark: error writing to a capture file (%d)", err);
+                pl->dump_err = err;
+                pl->dump_err_info = err_info;
+                pl->dump_err_framenum = framenum;
+                g_atomic_int_set(&pl->dump_failed, TRUE);
+            }
+        }
+        g_async_queue_push(pl->free_batches, pb);
+    }
+
+    return NULL;
+}
+
+#ifndef _WIN32
+static gpointer
+pipeline_writer(gpointer data)
+{
+    pipeline_t *pl = (pipeline_t *)data;
+    char *buf;
+    ssize_t nread, nwritten, off;
+
+    buf = (char *)g_malloc(PIPELINE_WRITE_SIZE);
+    for (;;) {
+        nread = ws_read(pl->pipe_fd, buf, PIPELINE_WRITE_SIZE);
+        if (nread == 0)
+            break;      /* the main thread closed the pipe */
+        if (nread < 0) {
+            if (errno == EINTR)
+                continue;
+            g_atomic_int_set(&pl->write_errno, errno);
+            break;
+        }
+        /*
+         * After an error, just drain the pipe; the main thread
+         * reports the error.
+         */
+        for (off = 0; off < nread && g_atomic_int_get(&pl->write_errno) == 0; off += nwritten) {
+            nwritten = ws_write(pl->stdout_fd, buf + off, nread - off);
+            if (nwritten < 0) {
+                if (errno != EINTR)
+                    g_atomic_int_set(&pl->write_errno, errno);
+                nwritten = 0;
+            }
+        }
+    }
+    /* If we quit early, the main thread's writes fail rather than block. */
+    ws_close(pl->pipe_fd);
+    g_free(buf);
+
+    return NULL;
+}
+
+static void
+pipeline_check_write_error(pipeline_t *pl)
+{
+    int write_errno = g_atomic_int_get(&pl->write_errno);
+
+    if (write_errno != 0) {
+        errno = write_errno;
+        show_print_file_io_error();
+        exit(2);
+    }
+}
+
+/*
+ * Point the standard output at a pipe, and start a thread to copy what's
+ * written to it to the real standard output.
+ */
+static void
+pipeline_start_writer(pipeline_t *pl)
+{
+    int fds[2];
+
+    fflush(stdout);
+    if (pipe(fds) == -1)
+        return;
+    pl->stdout_fd = ws_dup(1);
+    if (pl->stdout_fd == -1 || dup2(fds[1], 1) == -1) {
+        ws_debug("tshark: can't redirect the standard output: %s", g_strerror(errno));
+        if (pl->stdout_fd != -1)
+            ws_close(pl->stdout_fd);
+        ws_close(fds[0]);
+        ws_close(fds[1]);
+        return;
+    }
+    ws_close(fds[1]);
+    pl->pipe_fd = fds[0];
+    pl->writer = g_thread_new("tshark writer", pipeline_writer, pl);
+}
+
+static void
+pipeline_stop_writer(pipeline_t *pl)
+{
+    fflush(stdout);
+    /* This closes the write side of the pipe, so the writer thread
+       quits once it's written everything. */
+    dup2(pl->stdout_fd, 1);
+    ws_close(pl->stdout_fd);
+    g_thread_join(pl->writer);
+    pl->writer = NULL;
+    pipeline_check_write_error(pl);
+}
+#endif
+
+static pipeline_t *
+pipeline_start(capture_file *cf, wtap_dumper *pdh)
+{
+    pipeline_t *pl;
+    guint i;
+
+    pl = g_new0(pipeline_t, 1);
+    pl->wth = cf->provider.wth;
+    pl->pdh = pdh;
+    g_mutex_init(&pl->wth_lock);
+    pl->free_batches = g_async_queue_new();
+    pl->full_batches = g_async_queue_new();
+    pl->dump_batches = g_async_queue_new();
+    for (i = 0; i < PIPELINE_NUM_BATCHES; i++) {
+        wtap_batch_init(&pl->batches[i].batch, PIPELINE_BATCH_SIZE);
+        pl->batches[i].write = g_new0(gboolean, PIPELINE_BATCH_SIZE);
+    }
+    pl->ifaces = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    pipeline = pl;
+
+    /*
+     * Setting the callbacks hands them the blocks read so far, which
+     * libwireshark already has; discard those.
+     */
+    pl->reading = &pl->batches[0];
+    wtap_set_cb_new_ipv4(pl->wth, pipeline_new_ipv4);
+    wtap_set_cb_new_ipv6(pl->wth, pipeline_new_ipv6);
+    wtap_set_cb_new_secrets(pl->wth, pipeline_new_secrets);
+    pl->reading = NULL;
+    pipeline_run_deferred(&pl->batches[0], TRUE);
+
+    for (i = 0; i < PIPELINE_NUM_BATCHES; i++)
+        g_async_queue_push(pl->free_batches, &pl->batches[i]);
+
+#ifndef _WIN32
+    if (print_packet_info)
+        pipeline_start_writer(pl);
+#endif
+    if (pdh != NULL)
+        pl->dumper = g_thread_new("tshark dumper", pipeline_dumper, pl);
+    pl->reader = g_thread_new("tshark reader", pipeline_reader, pl);
+
+    return pl;
+}
+
+/* Done with the batch the main thread was processing. */
+static void
+pipeline_release_current(pipeline_t *pl)
+{
+    if (pl->current == NULL)
+        return;
+    if (pl->dumper != NULL)
+        g_async_queue_push(pl->dump_batches, pl->current);
+    else
+        g_async_queue_push(pl->free_batches, pl->current);
+    pl->current = NULL;
+}
+
+/*
+ * Get the next record from the reader thread; this is the pipelined
+ * equivalent of wtap_read().  The record and its data remain valid
+ * until the next call.
+ */
+static gboolean
+pipeline_read(pipeline_t *pl, int framenum, wtap_rec **rec, const guint8 **pd,
+        gint64 *data_offset, int *err, gchar **err_info)
+{
+    pipeline_batch_t *pb;
+    guint i;
+
+    while (pl->current == NULL || pl->current_index >= pl->current->batch.count) {
+        pipeline_release_current(pl);
+        if (pl->read_done)
+            return FALSE;
+#ifndef _WIN32
+        if (pl->writer != NULL)
+            pipeline_check_write_error(pl);
+#endif
+        pb = (pipeline_batch_t *)g_async_queue_pop(pl->full_batches);
+        pipeline_run_deferred(pb, FALSE);
+        if (pb->end) {
+            pl->read_done = TRUE;
+            *err = pb->err;
+            *err_info = pb->err_info;
+            pb->err_info = NULL;
+            g_async_queue_push(pl->free_batches, pb);
+            return FALSE;
+        }
+        memset(pb->write, 0, pb->batch.count * sizeof *pb->write);
+        pb->first_framenum = framenum;
+        pl->current = pb;
+        pl->current_index = 0;
+    }
+
+    i = pl->current_index++;
+    *rec = &pl->current->batch.recs[i];
+    *pd = wtap_batch_rec_data(&pl->current->batch, i);
+    *data_offset = pl->current->batch.offsets[i];
+    return TRUE;
+}
+
+/* Have the dump thread write the record pipeline_read() last returned. */
+static void
+pipeline_write_record(pipeline_t *pl)
+{
+    pl->current->write[pl->current_index - 1] = TRUE;
+}
+
+static gboolean
+pipeline_dump_failed(pipeline_t *pl)
+{
+    return g_atomic_int_get(&pl->dump_failed);
+}
+
+/*
+ * Stop the threads and free the pipeline.  Returns FALSE, with the error
+ * filled in, if writing to the output capture file failed.
+ */
+static gboolean
+pipeline_finish(pipeline_t *pl, int *err, gchar **err_info,
+        volatile guint32 *err_framenum)
+{
+    pipeline_batch_t *pb;
+    gboolean end;
+    gboolean ok;
+    guint i;
+
+    pipeline_release_current(pl);
+    if (!pl->read_done) {
+        /* We stopped early; have the reader thread stop as well. */
+        g_atomic_int_set(&pl->stop_reading, TRUE);
+        do {
+            pb = (pipeline_batch_t *)g_async_queue_pop(pl->full_batches);
+            pipeline_run_deferred(pb, TRUE);
+            end = pb->end;
+            g_free(pb->err_info);
+            pb->err_info = NULL;
+            g_async_queue_push(pl->free_batches, pb);
+        } while (!end);
+    }
+    g_thread_join(pl->reader);
+    if (pl->dumper != NULL) {
+        g_async_queue_push(pl->dump_batches, &pl->dump_end);
+        g_thread_join(pl->dumper);
+    }
+#ifndef _WIN32
+    if (pl->writer != NULL)
+        pipeline_stop_writer(pl);
+#endif
+    pipeline = NULL;
+
+    ok = !pl->dump_failed;
+    if (!ok) {
+        g_free(*err_info);
+        *err = pl->dump_err;
+        *err_info = pl->dump_err_info;
+        *err_framenum = pl->dump_err_framenum;
+    }
+
+    for (i = 0; i < PIPELINE_NUM_BATCHES; i++) {
+        wtap_batch_cleanup(&pl->batches[i].batch);
+        g_free(pl->batches[i].write);
+    }
+    g_async_queue_unref(pl->free_batches);
+    g_async_queue_unref(pl->full_batches);
+    g_async_queue_unref(pl->dump_batches);
+    g_hash_table_destroy(pl->ifaces);
+    g_mutex_clear(&pl->wth_lock);
+    g_free(pl);
+
+    return ok;
+}
+
+/*
+ * While a pipelined pass is running, the reader thread may be adding
+ * interfaces, so look each one up only once, with the reader thread
+ * locked out; IDBs don't change once they've been read.
+ */
+static const pipeline_iface_t *
+pipeline_get_iface(pipeline_t *pl, struct packet_provider_data *prov,
+        guint32 interface_id)
+{
+    pipeline_iface_t *iface;
+
+    iface = (pipeline_iface_t *)g_hash_table_lookup(pl->ifaces,
+            GUINT_TO_POINTER(interface_id));
+    if (iface == NULL) {
+        iface = g_new(pipeline_iface_t, 1);
+        g_mutex_lock(&pl->wth_lock);
+        iface->name = cap_file_provider_get_interface_name(prov, interface_id);
+        iface->description = cap_file_provider_get_interface_description(prov, interface_id);
+        g_mutex_unlock(&pl->wth_lock);
+        g_hash_table_insert(pl->ifaces, GUINT_TO_POINTER(interface_id), iface);
+    }
+    return iface;
+}
+
+static const char *
+tshark_get_interface_name(struct packet_provider_data *prov,
+        guint32 interface_id)
+{
+    if (pipeline != NULL)
+        return pipeline_get_iface(pipeline, prov, interface_id)->name;
+    return cap_file_provider_get_interface_name(prov, interface_id);
+}
+
+static const char *
+tshark_get_interface_description(struct packet_provider_data *prov,
+        guint32 interface_id)
+{
+    if (pipeline != NULL)
+        return pipeline_get_iface(pipeline, prov, interface_id)->description;
+    return cap_file_provider_get_interface_description(prov, interface_id);
+}
+
+/*
+ * Flow-sharded processing (--flow-shards).
+ *
+ * Most of the state dissectors keep (conversations, reassembly, TCP
+ * analysis) is per flow, so, to use more than one core for large files,
+ * we can fork worker processes, each of which opens the file itself with
+ * its own epan session and dissects only the packets of the flows that
+ * hash to it; the other packets are just counted, so that frame numbers
+ * and time stamps relative to the first or the previous captured packet
+ * come out as usual.
+ *
+ * Each worker prints to a temporary file of its own and sends us, over a
+ * pipe, the frame number of each packet that passed the filters and the
+ * offset in the file just past its output.  We merge those in frame
+ * number order and copy the workers' output to the standard output, so
+ * the result is in the same order as without --flow-shards.  At the end,
+ * a worker sends an entry with a frame number of 0 giving the read error,
+ * if any, followed by the error information string.
+ */
+#define FLOW_SHARD_INDEX_BATCH  256
+
+typedef struct {
+    guint32 framenum;       /* 0 for the entry at the end */
+    guint32 err_info_len;   /* at the end, length of the error information */
+    gint64  end;            /* offset past the output; at the end, the error */
+} flow_shard_entry_t;
+
+/* In a worker, its index and where it sends entries. */
+static gboolean flow_shard_worker;
+static guint flow_shard_index;
+static int flow_shard_index_fd = -1;
+static flow_shard_entry_t flow_shard_entries[FLOW_SHARD_INDEX_BATCH];
+static guint flow_shard_num_entries;
+
+/*
+ * Hash the flow a packet belongs to, the same way in both directions,
+ * from a quick look at its headers; tunneled packets hash by the inner
+ * flow.  Packets without an IP header hash to 0.
+ */
+static guint32
+flow_shard_hash(const wtap_rec *rec, const guint8 *pd)
+{
+    wtap_flow_key_t key;
+
+    if (!wtap_flow_key_get(rec, pd, &key))
+        return 0;
+    return wtap_flow_key_hash(&key);
+}
+
+/* Is this packet one for another worker? */
+static gboolean
+flow_shard_skip(const wtap_rec *rec, const guint8 *pd)
+{
+    return flow_shard_worker &&
+        flow_shard_hash(rec, pd) % flow_shard_count != flow_shard_index;
+}
+
+/*
+ * Count a packet another worker dissects, as process_packet_single_pass()
+ * would count it.
+ */
+static void
+skip_packet_single_pass(capture_file *cf, gint64 offset, wtap_rec *rec)
+{
+    frame_data fdata;
+
+    cf->count++;
+    frame_data_init(&fdata, cf->count, rec, offset, cum_bytes);
+    frame_data_set_before_dissect(&fdata, &cf->elapsed_time,
+            &cf->provider.ref, cf->provider.prev_dis);
+    if (cf->provider.ref == &fdata) {
+        ref_frame = fdata;
+        cf->provider.ref = &ref_frame;
+    }
+    prev_cap_frame = fdata;
+    cf->provider.prev_cap = &prev_cap_frame;
+    frame_data_destroy(&fdata);
+}
+
+#ifndef _WIN32
+static void
+flow_shard_send(const void *data, size_t len)
+{
+    const char *p = (const char *)data;
+    ssize_t nwritten;
+
+    while (len != 0) {
+        nwritten = ws_write(flow_shard_index_fd, p, len);
+        if (nwritten < 0) {
+            if (errno == EINTR)
+                continue;
+            /* The parent has stopped listening to us, so we're done. */
+            _exit(0);
+        }
+        p += nwritten;
+        len -= nwritten;
+    }
+}
+
+static void
+flow_shard_flush_entries(void)
+{
+    fflush(stdout);
+    flow_shard_send(flow_shard_entries,
+            flow_shard_num_entries * sizeof flow_shard_entries[0]);
+    flow_shard_num_entries = 0;
+}
+#endif
+
+/* Tell the parent where the output for a packet that passed ends. */
+static void
+flow_shard_note_packet(int framenum)
+{
+#ifndef _WIN32
+    if (!flow_shard_worker)
+        return;
+    flow_shard_entries[flow_shard_num_entries].framenum = framenum;
+    flow_shard_entries[flow_shard_num_entries].err_info_len = 0;
+    flow_shard_entries[flow_shard_num_entries].end = ftello(stdout);
+    if (++flow_shard_num_entries == FLOW_SHARD_INDEX_BATCH)
+        flow_shard_flush_entries();
+#else
+    (void)framenum;
+#endif
+}
+
 static pass_status_t
 process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
         int max_packet_count, gint64 max_byte_count,
@@ -3712,6 +4478,9 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
 {
     wtap_rec        rec;
     Buffer          buf;
+    wtap_rec       *recp = &rec;
+    const guint8   *pd;
+    pipeline_t     *pl = NULL;
     gboolean create_proto_tree = FALSE;
     gboolean        filtering_tap_listeners;
     guint           tap_flags;
@@ -3772,8 +4541,19 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
      */
     set_resolution_synchrony(TRUE);
 
+    if (opt_pipeline)
+        pl = pipeline_start(cf, pdh);
+
     *err = 0;
-    while (wtap_read(cf->provider.wth, &rec, &buf, err, err_info, &data_offset)) {
+    for (;;) {
+        if (pl != NULL) {
+            if (!pipeline_read(pl, framenum, &recp, &pd, &data_offset, err, err_info))
+                break;
+        } else {
+            if (!wtap_read(cf->provider.wth, &rec, &buf, err, err_info, &data_offset))
+                break;
+            pd = ws_buffer_start_ptr(&buf);
+        }
         if (read_interrupted) {
             status = PASS_INTERRUPTED;
             break;
@@ -3781,9 +4561,10 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
         framenum++;
 
         /*
-         * Process whatever IDBs we haven't seen yet.
+         * Process whatever IDBs we haven't seen yet.  (If we're
+         * pipelining, the dump thread does that.)
          */
-        if (!process_new_idbs(cf->provider.wth, pdh, err, err_info)) {
+        if (pl == NULL && !process_new_idbs(cf->provider.wth, pdh, err, err_info)) {
             *err_framenum = framenum;
             status = PASS_WRITE_ERROR;
             break;
@@ -3793,15 +4574,21 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
 
         reset_epan_mem(cf, edt, create_proto_tree, print_packet_info && print_details);
 
-        if (process_packet_single_pass(cf, edt, data_offset, &rec, &buf, tap_flags)) {
+        if (flow_shard_skip(recp, pd)) {
+            /* Another flow shard worker dissects this one. */
+            skip_packet_single_pass(cf, data_offset, recp);
+        } else if (process_packet_single_pass(cf, edt, data_offset, recp, pd, tap_flags)) {
             /* Either there's no read filtering or this packet passed the
                filter, so, if we're writing to a capture file, write
                this packet out. */
             write_framenum++;
+            flow_shard_note_packet(framenum);
             if (pdh != NULL) {
                 ws_debug("tshark: writing packet #%d to outfile as #%d",
                         framenum, write_framenum);
-                if (!wtap_dump(pdh, &rec, ws_buffer_start_ptr(&buf), err, err_info)) {
+                if (pl != NULL) {
+                    pipeline_write_record(pl);
+                } else if (!wtap_dump(pdh, recp, pd, err, err_info)) {
                     /* Error writing to the output file. */
                     ws_debug("tshark: error writing to a capture file (%d)", *err);
                     *err_framenum = framenum;
@@ -3827,8 +4614,20 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
             *err = 0; /* This is not an error */
             break;
         }
-        wtap_rec_reset(&rec);
+        if (pl != NULL) {
+            if (pipeline_dump_failed(pl)) {
+                /* pipeline_finish() fills in the error. */
+                status = PASS_WRITE_ERROR;
+                break;
+            }
+            /* The record is reset when its batch is next filled in;
+               the dump thread may still need its block. */
+        } else {
+            wtap_rec_reset(&rec);
+        }
     }
+    if (pl != NULL && !pipeline_finish(pl, err, err_info, err_framenum))
+        status = PASS_WRITE_ERROR;
     if (status == PASS_SUCCEEDED) {
         if (*err != 0) {
             /* Error reading from the input file. */
@@ -3853,6 +4652,282 @@ process_cap_file_single_pass(capture_file *cf, wtap_dumper *pdh,
     return status;
 }
 
+#ifndef _WIN32
+typedef struct {
+    pid_t               pid;
+    int                 out_fd;     /* the file the worker prints to */
+    int                 index_fd;   /* read side of the pipe it sends entries on */
+    gint64              out_pos;    /* offset of the output we haven't copied */
+    guint8              buf[sizeof (flow_shard_entry_t) * FLOW_SHARD_INDEX_BATCH];
+    gsize               buf_pos;
+    gsize               buf_len;
+    flow_shard_entry_t  head;       /* the next entry, if have_head */
+    gboolean            have_head;
+    gboolean            done;       /* got the entry at the end */
+    gboolean            failed;     /* the pipe closed before the entry at the end */
+    int                 err;
+    gchar              *err_info;
+} flow_shard_t;
+
+/*
+ * Runs in a worker process after the fork; it opens the file again,
+ * so that it doesn't share the file offset with the other processes,
+ * and dissects its share of the packets in a new epan session.
+ */
+WS_NORETURN static void
+flow_shard_run_worker(capture_file *cf, guint index, int out_fd, int index_fd,
+        int max_packet_count, gint64 max_byte_count)
+{
+    char *fname;
+    int err = 0;
+    gchar *err_info = NULL;
+    guint32 err_framenum;
+    pass_status_t status;
+    flow_shard_entry_t end;
+
+    if (dup2(out_fd, 1) == -1)
+        _exit(2);
+    ws_close(out_fd);
+    flow_shard_worker = TRUE;
+    flow_shard_index = index;
+    flow_shard_index_fd = index_fd;
+
+    wtap_close(cf->provider.wth);
+    cf->provider.wth = NULL;
+    fname = cf->filename;
+    cf->filename = NULL;
+    if (cf_open(cf, fname, cf->open_type, FALSE, &err) != CF_OK)
+        _exit(2);
+    g_free(fname);
+
+    /* The parent enforces the limit on the number of packets written. */
+    status = process_cap_file_single_pass(cf, NULL, max_packet_count,
+            max_byte_count, 0, &err, &err_info, &err_framenum);
+    flow_shard_flush_entries();
+
+    end.framenum = 0;
+    end.err_info_len = 0;
+    end.end = 0;
+    if (status == PASS_READ_ERROR) {
+        end.end = err;
+        if (err_info != NULL)
+            end.err_info_len = (guint32)strlen(err_info);
+    }
+    flow_shard_send(&end, sizeof end);
+    if (end.err_info_len != 0)
+        flow_shard_send(err_info, end.err_info_len);
+    _exit(0);
+}
+
+/* Read from a worker's pipe; returns FALSE if it closes first. */
+static gboolean
+flow_shard_read(flow_shard_t *shard, void *data, gsize len)
+{
+    guint8 *p = (guint8 *)data;
+    ssize_t nread;
+    gsize n;
+
+    while (len != 0) {
+        if (shard->buf_pos == shard->buf_len) {
+            nread = ws_read(shard->index_fd, shard->buf, sizeof shard->buf);
+            if (nread < 0 && errno == EINTR)
+                continue;
+            if (nread <= 0)
+                return FALSE;
+            shard->buf_pos = 0;
+            shard->buf_len = nread;
+        }
+        n = MIN(len, shard->buf_len - shard->buf_pos);
+        memcpy(p, shard->buf + shard->buf_pos, n);
+        shard->buf_pos += n;
+        p += n;
+        len -= n;
+    }
+    return TRUE;
+}
+
+/* Get the next entry from a worker, waiting for it if need be. */
+static void
+flow_shard_next(flow_shard_t *shard)
+{
+    if (!flow_shard_read(shard, &shard->head, sizeof shard->head)) {
+        shard->failed = TRUE;
+        shard->done = TRUE;
+        return;
+    }
+    if (shard->head.framenum != 0) {
+        shard->have_head = TRUE;
+        return;
+    }
+
+    shard->done = TRUE;
+    shard->err = (int)shard->head.end;
+    if (shard->head.err_info_len != 0) {
+        shard->err_info = (gchar *)g_malloc(shard->head.err_info_len + 1);
+        if (!flow_shard_read(shard, shard->err_info, shard->head.err_info_len))
+            shard->failed = TRUE;
+        shard->err_info[shard->head.err_info_len] = '\0';
+    }
+}
+
+/* Copy the output for a worker's next entry to the standard output. */
+static void
+flow_shard_copy_output(flow_shard_t *shard)
+{
+    static char buf[65536];
+    ssize_t nread;
+
+    while (shard->out_pos < shard->head.end) {
+        nread = pread(shard->out_fd, buf,
+                (size_t)MIN((gint64)sizeof buf, shard->head.end - shard->out_pos),
+                shard->out_pos);
+        if (nread < 0 && errno == EINTR)
+            continue;
+        if (nread <= 0)
+            break;
+        fwrite(buf, 1, nread, stdout);
+        shard->out_pos += nread;
+    }
+    shard->out_pos = shard->head.end;
+}
+
+static pass_status_t
+process_cap_file_sharded(capture_file *cf, int max_packet_count,
+        gint64 max_byte_count, int max_write_packet_count,
+        int *err, gchar **err_info)
+{
+    flow_shard_t   *shards;
+    flow_shard_t   *best;
+    const char     *tmpdir = NULL;
+    char           *tmpname;
+    GError         *gerr = NULL;
+    int             fds[2];
+    guint           i, j;
+    guint           num_started = 0;
+    int             write_count = 0;
+    gboolean        stopped = FALSE;
+    pass_status_t   status = PASS_SUCCEEDED;
+
+#ifdef HAVE_LIBPCAP
+    tmpdir = global_capture_opts.temp_dir;
+#endif
+    shards = g_new0(flow_shard_t, flow_shard_count);
+
+    /* Don't have the workers write out what we've buffered. */
+    fflush(stdout);
+
+    *err = 0;
+    for (i = 0; i < flow_shard_count; i++) {
+        shards[i].out_fd = create_tempfile(tmpdir, &tmpname, "tshark_shard", NULL, &gerr);
+        if (shards[i].out_fd == -1) {
+            *err = WTAP_ERR_INTERNAL;
+            *err_info = ws_strdup_printf("can't create a temporary file for a flow shard: %s",
+                    gerr->message);
+            g_error_free(gerr);
+            break;
+        }
+        /* The worker and we hold it open; nobody else needs it. */
+        ws_unlink(tmpname);
+        g_free(tmpname);
+        if (pipe(fds) == -1) {
+            *err = errno;
+            ws_close(shards[i].out_fd);
+            break;
+        }
+        shards[i].pid = fork();
+        if (shards[i].pid == -1) {
+            *err = errno;
+            ws_close(shards[i].out_fd);
+            ws_close(fds[0]);
+            ws_close(fds[1]);
+            break;
+        }
+        if (shards[i].pid == 0) {
+            for (j = 0; j < i; j++) {
+                ws_close(shards[j].out_fd);
+                ws_close(shards[j].index_fd);
+            }
+            ws_close(fds[0]);
+            flow_shard_run_worker(cf, i, shards[i].out_fd, fds[1],
+                    max_packet_count, max_byte_count);
+        }
+        ws_close(fds[1]);
+        shards[i].index_fd = fds[0];
+        num_started++;
+    }
+    if (num_started < flow_shard_count) {
+        stopped = TRUE;
+        status = PASS_READ_ERROR;
+    }
+
+    /* Merge the workers' output in frame number order. */
+    while (!stopped) {
+        best = NULL;
+        for (i = 0; i < num_started; i++) {
+            if (!shards[i].have_head && !shards[i].done)
+                flow_shard_next(&shards[i]);
+            if (shards[i].have_head &&
+                    (best == NULL || shards[i].head.framenum < best->head.framenum))
+                best = &shards[i];
+        }
+        if (best == NULL)
+            break;
+        if (read_interrupted) {
+            status = PASS_INTERRUPTED;
+            stopped = TRUE;
+            break;
+        }
+
+        flow_shard_copy_output(best);
+        best->have_head = FALSE;
+        if (line_buffered)
+            fflush(stdout);
+        if (ferror(stdout)) {
+            show_print_file_io_error();
+            exit(2);
+        }
+
+        write_count++;
+        if (max_write_packet_count > 0 && write_count >= max_write_packet_count) {
+            ws_debug("tshark: max_write_packet_count (%d) reached", max_write_packet_count);
+            stopped = TRUE;
+        }
+    }
+
+    /* If we stopped early, stop the workers as well. */
+    for (i = 0; i < num_started; i++) {
+        if (stopped && !shards[i].done)
+            kill(shards[i].pid, SIGTERM);
+        ws_close(shards[i].index_fd);
+    }
+    for (i = 0; i < num_started; i++) {
+        while (waitpid(shards[i].pid, NULL, 0) == -1 && errno == EINTR)
+            ;
+        ws_close(shards[i].out_fd);
+    }
+
+    /* They all read the same file, so report the first read error. */
+    for (i = 0; i < num_started; i++) {
+        if (!stopped && status == PASS_SUCCEEDED) {
+            if (shards[i].failed) {
+                *err = WTAP_ERR_INTERNAL;
+                *err_info = ws_strdup_printf("flow shard worker %u exited unexpectedly", i);
+                status = PASS_READ_ERROR;
+            } else if (shards[i].err != 0) {
+                *err = shards[i].err;
+                *err_info = shards[i].err_info;
+                shards[i].err_info = NULL;
+                status = PASS_READ_ERROR;
+            }
+        }
+        g_free(shards[i].err_info);
+    }
+    g_free(shards);
+
+    return status;
+}
+#endif
+
 static process_file_status_t
 process_cap_file(capture_file *cf, char *save_file, int out_file_type,
         gboolean out_file_name_res, int max_packet_count, gint64 max_byte_count,
@@ -3956,6 +5031,12 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
 
         ws_debug("tshark: done with first pass");
 
+        /* Resolve the addresses seen in the first pass in bulk, so that
+           the second pass doesn't wait on them one at a time. */
+        if (host_name_lookup_prefetch() > 0) {
+            host_name_lookup_wait();
+        }
+
         if (first_pass_status == PASS_INTERRUPTED) {
             /* The first pass was interrupted; skip the second pass.
                It won't be run, so it won't get an error. */
@@ -3984,6 +5065,15 @@ process_cap_file(capture_file *cf, char *save_file, int out_file_type,
         first_pass_status = PASS_SUCCEEDED; /* There is no first pass */
 
         elapsed_start = g_get_monotonic_time();
+#ifndef _WIN32
+        if (flow_shard_count > 1)
+            second_pass_status = process_cap_file_sharded(cf,
+                    max_packet_count,
+                    max_byte_count,
+                    max_write_packet_count,
+                    &err, &err_info);
+        else
+#endif
         second_pass_status = process_cap_file_single_pass(cf, pdh,
                 max_packet_count,
                 max_byte_count,
@@ -4140,7 +5230,7 @@ out:
 
 static gboolean
 process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
-        wtap_rec *rec, Buffer *buf, guint tap_flags _U_)
+        wtap_rec *rec, const guint8 *pd, guint tap_flags _U_)
 {
     frame_data      fdata;
     column_info    *cinfo;
@@ -4204,7 +5294,7 @@ process_packet_single_pass(capture_file *cf, epan_dissect_t *edt, gint64 offset,
         block = wtap_block_ref(rec->block);
         elapsed_start = g_get_monotonic_time();
         epan_dissect_run_with_taps(edt, cf->cd_t, rec,
-                frame_tvbuff_new_buffer(&cf->provider, &fdata, buf),
+                frame_tvbuff_new(&cf->provider, &fdata, pd),
                 &fdata, cinfo);
         tshark_elapsed.first_pass.dissect += g_get_monotonic_time() - elapsed_start;
 
@@ -263,3 +263,585 @@ double get_io_graph_item(const io_graph_item_t *items_, io_graph_item_unit_t val
     }
     return value;
 }
+
+/*
+ * Columnar I/O graph data
+ */
+
+typedef enum {
+    IOG_COL_VALUES_NONE,    /* Field occurrences are only counted */
+    IOG_COL_VALUES_UINT,    /* guint64 */
+    IOG_COL_VALUES_INT,     /* gint64 */
+    IOG_COL_VALUES_FLOAT,   /* gdouble, aggregated as gfloat */
+    IOG_COL_VALUES_DOUBLE,  /* gdouble */
+    IOG_COL_VALUES_TIME     /* nstime_t */
+} io_graph_col_values_t;
+
+struct _io_graph_columns_t {
+    int hf_index;
+    io_graph_col_values_t value_type;
+
+    /* One element per packet */
+    GArray *rel_ts;         /* gint64, nanoseconds relative to the first packet */
+    GArray *frame_num;      /* guint32 */
+    GArray *pkt_len;        /* guint32 */
+    GArray *counted;        /* guint8, FALSE if the packet lacks the field */
+    GArray *val_end;        /* guint32, number of field values up to and including this packet */
+
+    /* One element per field value, see value_type */
+    GArray *values;
+    guint32 num_values;
+};
+
+static io_graph_col_values_t
+io_graph_columns_value_type(int hf_index)
+{
+    if (hf_index < 0) {
+        return IOG_COL_VALUES_NONE;
+    }
+
+    switch (proto_registrar_get_ftype(hf_index)) {
+    case FT_UINT8:
+    case FT_UINT16:
+    case FT_UINT24:
+    case FT_UINT32:
+    case FT_UINT40:
+    case FT_UINT48:
+    case FT_UINT56:
+    case FT_UINT64:
+        return IOG_COL_VALUES_UINT;
+    case FT_INT8:
+    case FT_INT16:
+    case FT_INT24:
+    case FT_INT32:
+    case FT_INT40:
+    case FT_INT48:
+    case FT_INT56:
+    case FT_INT64:
+        return IOG_COL_VALUES_INT;
+    case FT_FLOAT:
+        return IOG_COL_VALUES_FLOAT;
+    case FT_DOUBLE:
+        return IOG_COL_VALUES_DOUBLE;
+    case FT_RELATIVE_TIME:
+        return IOG_COL_VALUES_TIME;
+    default:
+        return IOG_COL_VALUES_NONE;
+    }
+}
+
+static void
+io_graph_columns_init_values(io_graph_columns_t *cols, int hf_index)
+{
+    guint elt_size;
+
+    cols->hf_index = hf_index;
+    cols->value_type = io_graph_columns_value_type(hf_index);
+    elt_size = cols->value_type == IOG_COL_VALUES_TIME ? sizeof(nstime_t) : sizeof(guint64);
+    cols->values = g_array_new(FALSE, FALSE, elt_size);
+    cols->num_values = 0;
+}
+
+io_graph_columns_t *
+io_graph_columns_new(int hf_index)
+{
+    io_graph_columns_t *cols = g_new0(io_graph_columns_t, 1);
+
+    cols->rel_ts = g_array_new(FALSE, FALSE, sizeof(gint64));
+    cols->frame_num = g_array_new(FALSE, FALSE, sizeof(guint32));
+    cols->pkt_len = g_array_new(FALSE, FALSE, sizeof(guint32));
+    cols->counted = g_array_new(FALSE, FALSE, sizeof(guint8));
+    cols->val_end = g_array_new(FALSE, FALSE, sizeof(guint32));
+    io_graph_columns_init_values(cols, hf_index);
+
+    return cols;
+}
+
+void
+io_graph_columns_reset(io_graph_columns_t *cols, int hf_index)
+{
+    g_array_set_size(cols->rel_ts, 0);
+    g_array_set_size(cols->frame_num, 0);
+    g_array_set_size(cols->pkt_len, 0);
+    g_array_set_size(cols->counted, 0);
+    g_array_set_size(cols->val_end, 0);
+    g_array_free(cols->values, TRUE);
+    io_graph_columns_init_values(cols, hf_index);
+}
+
+void
+io_graph_columns_free(io_graph_columns_t *cols)
+{
+    if (!cols) {
+        return;
+    }
+    g_array_free(cols->rel_ts, TRUE);
+    g_array_free(cols->frame_num, TRUE);
+    g_array_free(cols->pkt_len, TRUE);
+    g_array_free(cols->counted, TRUE);
+    g_array_free(cols->val_end, TRUE);
+    g_array_free(cols->values, TRUE);
+    g_free(cols);
+}
+
+int
+io_graph_columns_get_hf_index(const io_graph_columns_t *cols)
+{
+    return cols->hf_index;
+}
+
+guint
+io_graph_columns_get_count(const io_graph_columns_t *cols)
+{
+    return cols->rel_ts->len;
+}
+
+gboolean
+io_graph_columns_append(io_graph_columns_t *cols, packet_info *pinfo, epan_dissect_t *edt)
+{
+    gint64 rel_ts = (gint64) pinfo->rel_ts.secs * 1000000000 + pinfo->rel_ts.nsecs;
+    guint32 frame_num = pinfo->num;
+    guint32 pkt_len = pinfo->fd->pkt_len;
+    guint8 counted = TRUE;
+
+    if (edt && cols->hf_index >= 0) {
+        GPtrArray *gp;
+        guint i;
+
+        gp = proto_get_finfo_ptr_array(edt->tree, cols->hf_index);
+        if (!gp) {
+            counted = FALSE;
+        } else {
+            for (i = 0; i < gp->len; i++) {
+                fvalue_t *fv = ((field_info *)gp->pdata[i])->value;
+                guint64 new_uint64;
+                gint64 new_int64;
+                gdouble new_double;
+
+                switch (proto_registrar_get_ftype(cols->hf_index)) {
+                case FT_UINT8:
+                case FT_UINT16:
+                case FT_UINT24:
+                case FT_UINT32:
+                    new_uint64 = fvalue_get_uinteger(fv);
+                    g_array_append_val(cols->values, new_uint64);
+                    break;
+                case FT_UINT40:
+                case FT_UINT48:
+                case FT_UINT56:
+                case FT_UINT64:
+                    new_uint64 = fvalue_get_uinteger64(fv);
+                    g_array_append_val(cols->values, new_uint64);
+                    break;
+                case FT_INT8:
+                case FT_INT16:
+                case FT_INT24:
+                case FT_INT32:
+                    new_int64 = fvalue_get_sinteger(fv);
+                    g_array_append_val(cols->values, new_int64);
+                    break;
+                case FT_INT40:
+                case FT_INT48:
+                case FT_INT56:
+                case FT_INT64:
+                    new_int64 = fvalue_get_sinteger64(fv);
+                    g_array_append_val(cols->values, new_int64);
+                    break;
+                case FT_FLOAT:
+                case FT_DOUBLE:
+                    new_double = fvalue_get_floating(fv);
+                    g_array_append_val(cols->values, new_double);
+                    break;
+                case FT_RELATIVE_TIME:
+                    g_array_append_vals(cols->values, fvalue_get_time(fv), 1);
+                    break;
+                default:
+                    /* Only counted, see check_field_unit(). */
+                    break;
+                }
+            }
+            cols->num_values += gp->len;
+        }
+    }
+
+    g_array_append_val(cols->rel_ts, rel_ts);
+    g_array_append_val(cols->frame_num, frame_num);
+    g_array_append_val(cols->pkt_len, pkt_len);
+    g_array_append_val(cols->counted, counted);
+    g_array_append_val(cols->val_end, cols->num_values);
+
+    return counted;
+}
+
+/* Same as get_io_graph_index() on a nanosecond timestamp. */
+static inline gint64
+io_graph_columns_index(gint64 rel_ts, guint32 interval)
+{
+    if (rel_ts < 0) {
+        return -1;
+    }
+    return (rel_ts / 1000000) / interval;
+}
+
+int
+io_graph_columns_num_items(const io_graph_columns_t *cols, guint32 interval, int max_items)
+{
+    const gint64 *rel_ts = (const gint64 *) cols->rel_ts->data;
+    guint n = cols->rel_ts->len;
+    gint64 num_items = 0;
+    guint i;
+
+    if (interval == 0) {
+        return 0;
+    }
+
+    for (i = 0; i < n; i++) {
+        gint64 idx = io_graph_columns_index(rel_ts[i], interval);
+
+        if (idx >= num_items && idx < max_items) {
+            num_items = idx + 1;
+        }
+    }
+
+    return (int) num_items;
+}
+
+/*
+ * The loops below mirror update_io_graph_item() for each value type so that
+ * the type is dispatched once per graph instead of once per value.
+ */
+static void
+io_graph_columns_fill_uint(const io_graph_columns_t *cols, const int *pkt_idx, int item_unit, io_graph_item_t *items)
+{
+    const guint64 *vals = (const guint64 *) cols->values->data;
+    const guint32 *frame_num = (const guint32 *) cols->frame_num->data;
+    const guint32 *val_end = (const guint32 *) cols->val_end->data;
+    guint i;
+
+    for (i = 0; i < cols->val_end->len; i++) {
+        io_graph_item_t *item;
+        guint32 v;
+
+        if (pkt_idx[i] < 0) {
+            continue;
+        }
+        item = &items[pkt_idx[i]];
+        for (v = i ? val_end[i - 1] : 0; v < val_end[i]; v++) {
+            guint64 new_uint64 = vals[v];
+
+            if ((new_uint64 > (guint64)item->int_max) || (item->fields == 0)) {
+                item->int_max = new_uint64;
+                item->double_max = (gdouble)new_uint64;
+                if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                    item->extreme_frame_in_invl = frame_num[i];
+                }
+            }
+            if ((new_uint64 < (guint64)item->int_min) || (item->fields == 0)) {
+                item->int_min = new_uint64;
+                item->double_min = (gdouble)new_uint64;
+                if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                    item->extreme_frame_in_invl = frame_num[i];
+                }
+            }
+            item->int_tot += new_uint64;
+            item->double_tot += (gdouble)new_uint64;
+            item->fields++;
+        }
+    }
+}
+
+static void
+io_graph_columns_fill_int(const io_graph_columns_t *cols, const int *pkt_idx, int item_unit, io_graph_item_t *items)
+{
+    const gint64 *vals = (const gint64 *) cols->values->data;
+    const guint32 *frame_num = (const guint32 *) cols->frame_num->data;
+    const guint32 *val_end = (const guint32 *) cols->val_end->data;
+    guint i;
+
+    for (i = 0; i < cols->val_end->len; i++) {
+        io_graph_item_t *item;
+        guint32 v;
+
+        if (pkt_idx[i] < 0) {
+            continue;
+        }
+        item = &items[pkt_idx[i]];
+        for (v = i ? val_end[i - 1] : 0; v < val_end[i]; v++) {
+            gint64 new_int64 = vals[v];
+
+            if ((new_int64 > item->int_max) || (item->fields == 0)) {
+                item->int_max = new_int64;
+                item->double_max = (gdouble)new_int64;
+                if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                    item->extreme_frame_in_invl = frame_num[i];
+                }
+            }
+            if ((new_int64 < item->int_min) || (item->fields == 0)) {
+                item->int_min = new_int64;
+                item->double_min = (gdouble)new_int64;
+                if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                    item->extreme_frame_in_invl = frame_num[i];
+                }
+            }
+            item->int_tot += new_int64;
+            item->double_tot += (gdouble)new_int64;
+            item->fields++;
+        }
+    }
+}
+
+static void
+io_graph_columns_fill_float(const io_graph_columns_t *cols, const int *pkt_idx, int item_unit, io_graph_item_t *items)
+{
+    const gdouble *vals = (const gdouble *) cols->values->data;
+    const guint32 *frame_num = (const guint32 *) cols->frame_num->data;
+    const guint32 *val_end = (const guint32 *) cols->val_end->data;
+    guint i;
+
+    for (i = 0; i < cols->val_end->len; i++) {
+        io_graph_item_t *item;
+        guint32 v;
+
+        if (pkt_idx[i] < 0) {
+            continue;
+        }
+        item = &items[pkt_idx[i]];
+        for (v = i ? val_end[i - 1] : 0; v < val_end[i]; v++) {
+            gfloat new_float = (gfloat)vals[v];
+
+            if ((new_float > item->float_max) || (item->fields == 0)) {
+                item->float_max = new_float;
+                if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                    item->extreme_frame_in_invl = frame_num[i];
+                }
+            }
+            if ((new_float < item->float_min) || (item->fields == 0)) {
+                item->float_min = new_float;
+                if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                    item->extreme_frame_in_invl = frame_num[i];
+                }
+            }
+            item->float_tot += new_float;
+            item->fields++;
+        }
+    }
+}
+
+static void
+io_graph_columns_fill_double(const io_graph_columns_t *cols, const int *pkt_idx, int item_unit, io_graph_item_t *items)
+{
+    const gdouble *vals = (const gdouble *) cols->values->data;
+    const guint32 *frame_num = (const guint32 *) cols->frame_num->data;
+    const guint32 *val_end = (const guint32 *) cols->val_end->data;
+    guint i;
+
+    for (i = 0; i < cols->val_end->len; i++) {
+        io_graph_item_t *item;
+        guint32 v;
+
+        if (pkt_idx[i] < 0) {
+            continue;
+        }
+        item = &items[pkt_idx[i]];
+        for (v = i ? val_end[i - 1] : 0; v < val_end[i]; v++) {
+            gdouble new_double = vals[v];
+
+            if ((new_double > item->double_max) || (item->fields == 0)) {
+                item->double_max = new_double;
+                if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                    item->extreme_frame_in_invl = frame_num[i];
+                }
+            }
+            if ((new_double < item->double_min) || (item->fields == 0)) {
+                item->double_min = new_double;
+                if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                    item->extreme_frame_in_invl = frame_num[i];
+                }
+            }
+            item->double_tot += new_double;
+            item->fields++;
+        }
+    }
+}
+
+static void
+io_graph_columns_fill_time(const io_graph_columns_t *cols, const int *pkt_idx, int item_unit, io_graph_item_t *items)
+{
+    const nstime_t *vals = (const nstime_t *) cols->values->data;
+    const guint32 *frame_num = (const guint32 *) cols->frame_num->data;
+    const guint32 *val_end = (const guint32 *) cols->val_end->data;
+    guint i;
+
+    for (i = 0; i < cols->val_end->len; i++) {
+        io_graph_item_t *item;
+        guint32 v;
+
+        if (pkt_idx[i] < 0) {
+            continue;
+        }
+        item = &items[pkt_idx[i]];
+        for (v = i ? val_end[i - 1] : 0; v < val_end[i]; v++) {
+            const nstime_t *new_time = &vals[v];
+
+            if ( (new_time->secs > item->time_max.secs)
+                 || ( (new_time->secs == item->time_max.secs)
+                      && (new_time->nsecs > item->time_max.nsecs))
+                 || (item->fields == 0)) {
+                item->time_max = *new_time;
+                if (item_unit == IOG_ITEM_UNIT_CALC_MAX) {
+                    item->extreme_frame_in_invl = frame_num[i];
+                }
+            }
+            if ( (new_time->secs < item->time_min.secs)
+                 || ( (new_time->secs == item->time_min.secs)
+                      && (new_time->nsecs < item->time_min.nsecs))
+                 || (item->fields == 0)) {
+                item->time_min = *new_time;
+                if (item_unit == IOG_ITEM_UNIT_CALC_MIN) {
+                    item->extreme_frame_in_invl = frame_num[i];
+                }
+            }
+            nstime_add(&item->time_tot, new_time);
+            item->fields++;
+        }
+    }
+}
+
+static void
+io_graph_columns_fill_load(const io_graph_columns_t *cols, const int *pkt_idx, guint32 interval, io_graph_item_t *items)
+{
+    const nstime_t *vals = (const nstime_t *) cols->values->data;
+    const gint64 *rel_ts = (const gint64 *) cols->rel_ts->data;
+    const guint32 *val_end = (const guint32 *) cols->val_end->data;
+    guint64 interval_us = (guint64) interval * 1000;
+    guint i;
+
+    for (i = 0; i < cols->val_end->len; i++) {
+        guint32 v;
+
+        if (pkt_idx[i] < 0) {
+            continue;
+        }
+        for (v = i ? val_end[i - 1] : 0; v < val_end[i]; v++) {
+            guint64 t, pt; /* time in us */
+            int j;
+
+            /*
+             * Add the time this call spanned each interval according to its contribution
+             * to that interval.
+             */
+            t = vals[v].secs;
+            t = t * 1000000 + vals[v].nsecs / 1000;
+            j = pkt_idx[i];
+            /*
+             * Handle current interval
+             */
+            pt = (guint64) (rel_ts[i] / 1000) % interval_us;
+            if (pt > t) {
+                pt = t;
+            }
+            while (t) {
+                io_graph_item_t *load_item;
+
+                load_item = &items[j];
+                load_item->time_tot.nsecs += (int) (pt * 1000);
+                if (load_item->time_tot.nsecs > 1000000000) {
+                    load_item->time_tot.secs++;
+                    load_item->time_tot.nsecs -= 1000000000;
+                }
+
+                if (j == 0) {
+                    break;
+                }
+                j--;
+                t -= pt;
+                if (t > interval_us) {
+                    pt = interval_us;
+                } else {
+                    pt = t;
+                }
+            }
+        }
+    }
+}
+
+void
+io_graph_columns_fill_items(const io_graph_columns_t *cols, io_graph_item_unit_t item_unit, guint32 interval, io_graph_item_t *items, int num_items)
+{
+    const gint64 *rel_ts = (const gint64 *) cols->rel_ts->data;
+    const guint32 *frame_num = (const guint32 *) cols->frame_num->data;
+    const guint32 *pkt_len = (const guint32 *) cols->pkt_len->data;
+    const guint8 *counted = (const guint8 *) cols->counted->data;
+    const guint32 *val_end = (const guint32 *) cols->val_end->data;
+    guint n = cols->rel_ts->len;
+    int *pkt_idx;
+    guint i;
+
+    if (num_items <= 0 || interval == 0) {
+        return;
+    }
+    reset_io_graph_items(items, num_items);
+
+    /* Interval index of every packet, -1 if it falls outside the items. */
+    pkt_idx = g_new(int, n ? n : 1);
+    for (i = 0; i < n; i++) {
+        gint64 idx = io_graph_columns_index(rel_ts[i], interval);
+
+        pkt_idx[i] = (idx < num_items) ? (int) idx : -1;
+    }
+
+    /* Frame and byte counts */
+    for (i = 0; i < n; i++) {
+        io_graph_item_t *item;
+
+        if (pkt_idx[i] < 0) {
+            continue;
+        }
+        item = &items[pkt_idx[i]];
+        if (item->first_frame_in_invl == 0) {
+            item->first_frame_in_invl = frame_num[i];
+        }
+        item->last_frame_in_invl = frame_num[i];
+        if (counted[i]) {
+            item->frames++;
+            item->bytes += pkt_len[i];
+        }
+    }
+
+    /* Field values */
+    if (cols->hf_index >= 0) {
+        switch (cols->value_type) {
+        case IOG_COL_VALUES_UINT:
+            io_graph_columns_fill_uint(cols, pkt_idx, item_unit, items);
+            break;
+        case IOG_COL_VALUES_INT:
+            io_graph_columns_fill_int(cols, pkt_idx, item_unit, items);
+            break;
+        case IOG_COL_VALUES_FLOAT:
+            io_graph_columns_fill_float(cols, pkt_idx, item_unit, items);
+            break;
+        case IOG_COL_VALUES_DOUBLE:
+            io_graph_columns_fill_double(cols, pkt_idx, item_unit, items);
+            break;
+        case IOG_COL_VALUES_TIME:
+            if (item_unit == IOG_ITEM_UNIT_CALC_LOAD) {
+                io_graph_columns_fill_load(cols, pkt_idx, interval, items);
+            } else {
+                io_graph_columns_fill_time(cols, pkt_idx, item_unit, items);
+            }
+            break;
+        case IOG_COL_VALUES_NONE:
+            /* See the default case in update_io_graph_item(). */
+            ws_assert((item_unit == IOG_ITEM_UNIT_CALC_FRAMES) ||
+                      (item_unit == IOG_ITEM_UNIT_CALC_FIELDS));
+            for (i = 0; i < n; i++) {
+                if (pkt_idx[i] >= 0) {
+                    items[pkt_idx[i]].fields += val_end[i] - (i ? val_end[i - 1] : 0);
+                }
+            }
+            break;
+        }
+    }
+
+    g_free(pkt_idx);
+}
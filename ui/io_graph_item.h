@@ -397,6 +397,81 @@ update_io_graph_item(io_graph_item_t *items, int idx, packet_info *pinfo, epan_d
 }
 
 
+/*
+ * Columnar I/O graph data.
+ *
+ * Instead of updating an io_graph_item_t array from a tap for every graph,
+ * the values a set of graphs sharing the same filter and field needs can be
+ * extracted once into flat per-packet and per-value arrays. The interval
+ * items for any unit and interval are then computed from those arrays with
+ * simple loops, so changing the interval or adding another graph over an
+ * already extracted field doesn't require a retap.
+ */
+typedef struct _io_graph_columns_t io_graph_columns_t;
+
+/** Create an empty set of columns.
+ *
+ * @param hf_index [in] Header field index whose values should be extracted,
+ *                      or -1 if only frame and byte counts are needed.
+ * @return A new set of columns. Free with io_graph_columns_free().
+ */
+io_graph_columns_t *io_graph_columns_new(int hf_index);
+
+/** Discard all extracted packets and change the extracted field.
+ *
+ * @param cols [in,out] Columns to reset.
+ * @param hf_index [in] Header field index, or -1.
+ */
+void io_graph_columns_reset(io_graph_columns_t *cols, int hf_index);
+
+/** Free a set of columns. */
+void io_graph_columns_free(io_graph_columns_t *cols);
+
+/** Get the header field index the columns were created for. */
+int io_graph_columns_get_hf_index(const io_graph_columns_t *cols);
+
+/** Get the number of packets stored in the columns. */
+guint io_graph_columns_get_count(const io_graph_columns_t *cols);
+
+/** Append a packet to the columns.
+ *
+ * This is the columnar counterpart of update_io_graph_item() and is
+ * meant to be called from a tap "packet" callback.
+ *
+ * @param cols [in,out] Columns to append to.
+ * @param pinfo [in] Packet to append.
+ * @param edt [in] Dissection information. Required if the columns
+ *                 extract a field, may be NULL otherwise.
+ * @return TRUE if the packet was counted, FALSE if it lacks the field.
+ */
+gboolean io_graph_columns_append(io_graph_columns_t *cols, packet_info *pinfo, epan_dissect_t *edt);
+
+/** Get the number of items needed to hold the given interval.
+ *
+ * @param cols [in] Columns to examine.
+ * @param interval [in] Timing interval in ms.
+ * @param max_items [in] Upper limit on the number of items.
+ * @return The number of items, 0 if there are no packets.
+ */
+int io_graph_columns_num_items(const io_graph_columns_t *cols, guint32 interval, int max_items);
+
+/** Compute interval items from the columns.
+ *
+ * The result is identical to calling update_io_graph_item() for every
+ * packet appended to the columns. Packets falling outside
+ * [0, num_items) are skipped.
+ *
+ * @param cols [in] Columns to compute from.
+ * @param item_unit [in] The type of unit to calculate. From IOG_ITEM_UNITS.
+ * @param interval [in] Timing interval in ms.
+ * @param items [out] Array of at least num_items items. They are reset
+ *                    before being filled in.
+ * @param num_items [in] Number of items, usually from
+ *                       io_graph_columns_num_items().
+ */
+void io_graph_columns_fill_items(const io_graph_columns_t *cols, io_graph_item_unit_t item_unit, guint32 interval, io_graph_item_t *items, int num_items);
+
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -1282,14 +1282,21 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 {
     int interval = ui->intervalComboBox->itemData(ui->intervalComboBox->currentIndex()).toInt();
     bool need_retap = false;
+    bool need_recalc = false;
 
+    // Graphs normally rebuild their items from the values extracted during
+    // the last tap, so only a recalc is needed.
     if (uat_model_ != NULL) {
         for (int row = 0; row < uat_model_->rowCount(); row++) {
             IOGraph *iog = ioGraphs_.value(row, NULL);
             if (iog) {
-                iog->setInterval(interval);
+                bool rebuilt = iog->setInterval(interval);
                 if (iog->visible()) {
-                    need_retap = true;
+                    if (rebuilt) {
+                        need_recalc = true;
+                    } else {
+                        need_retap = true;
+                    }
                 }
             }
         }
@@ -1297,6 +1304,8 @@ void IOGraphDialog::on_intervalComboBox_currentIndexChanged(int)
 
     if (need_retap) {
         scheduleRetap(true);
+    } else if (need_recalc) {
+        scheduleRecalc(true);
     }
 
     updateLegend();
@@ -1704,7 +1713,9 @@ IOGraph::IOGraph(QCustomPlot *parent) :
     bars_(NULL),
     val_units_(IOG_ITEM_UNIT_FIRST),
     hf_index_(-1),
-    cur_idx_(-1)
+    interval_(0),
+    cur_idx_(-1),
+    columns_(io_graph_columns_new(-1))
 {
     Q_ASSERT(parent_ != NULL);
     graph_ = parent_->addGraph(parent_->xAxis, parent_->yAxis);
@@ -1729,6 +1740,7 @@ IOGraph::IOGraph(QCustomPlot *parent) :
 
 IOGraph::~IOGraph() {
     remove_tap_listener(this);
+    io_graph_columns_free(columns_);
     if (graph_) {
         parent_->removeGraph(graph_);
     }
@@ -2024,6 +2036,7 @@ void IOGraph::clearAllData()
 {
     cur_idx_ = -1;
     reset_io_graph_items(items_, max_io_items_);
+    io_graph_columns_reset(columns_, val_units_ >= IOG_ITEM_UNIT_CALC_SUM ? hf_index_ : -1);
     if (graph_) {
         graph_->data()->clear();
     }
@@ -2264,9 +2277,25 @@ bool IOGraph::hasItemToShow(int idx, double value) const
     return result;
 }
 
-void IOGraph::setInterval(int interval)
+// Rebuild the items from the packets extracted during the last tap. Returns
+// false if the graph has to be retapped instead.
+bool IOGraph::setInterval(int interval)
 {
+    if (interval == interval_) {
+        return true;
+    }
     interval_ = interval;
+
+    int hf_index = val_units_ >= IOG_ITEM_UNIT_CALC_SUM ? hf_index_ : -1;
+    if (interval_ <= 0 || io_graph_columns_get_hf_index(columns_) != hf_index) {
+        return false;
+    }
+
+    reset_io_graph_items(items_, max_io_items_);
+    int num_items = io_graph_columns_num_items(columns_, interval_, max_io_items_);
+    io_graph_columns_fill_items(columns_, val_units_, interval_, items_, num_items);
+    cur_idx_ = num_items - 1;
+    return true;
 }
 
 // Get the value at the given interval (idx) for the current value unit.
@@ -2295,6 +2324,15 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
         return TAP_PACKET_DONT_REDRAW;
     }
 
+    epan_dissect_t *adv_edt = NULL;
+    /* For ADVANCED mode we need to keep track of some more stuff than just frame and byte counts */
+    if (iog->val_units_ >= IOG_ITEM_UNIT_CALC_SUM) {
+        adv_edt = edt;
+    }
+
+    /* Keep every packet so that the interval can be changed without a retap */
+    io_graph_columns_append(iog->columns_, pinfo, adv_edt);
+
     int idx = get_io_graph_index(pinfo, iog->interval_);
     bool recalc = false;
 
@@ -2318,12 +2356,6 @@ tap_packet_status IOGraph::tapPacket(void *iog_ptr, packet_info *pinfo, epan_dis
         iog->start_time_ = nstime_to_sec(&start_nstime);
     }
 
-    epan_dissect_t *adv_edt = NULL;
-    /* For ADVANCED mode we need to keep track of some more stuff than just frame and byte counts */
-    if (iog->val_units_ >= IOG_ITEM_UNIT_CALC_SUM) {
-        adv_edt = edt;
-    }
-
     if (!update_io_graph_item(iog->items_, idx, pinfo, adv_edt, iog->hf_index_, iog->val_units_, iog->interval_)) {
         return TAP_PACKET_DONT_REDRAW;
     }
@@ -67,7 +67,7 @@ public:
     const QString valueUnitField() { return vu_field_; }
     void setValueUnitField(const QString &vu_field);
     unsigned int movingAveragePeriod() { return moving_avg_period_; }
-    void setInterval(int interval);
+    bool setInterval(int interval);
     bool addToLegend();
     bool removeFromLegend();
     QCPGraph *graph() { return graph_; }
@@ -123,6 +123,9 @@ private:
     // much as is feasible.
     io_graph_item_t items_[max_io_items_];
     int cur_idx_;
+    // Per-packet values from the last tap, used to rebuild items_ when only
+    // the interval changes.
+    io_graph_columns_t *columns_;
 };
 
 namespace Ui {
@@ -16,6 +16,7 @@
 
 #include "file.h"
 
+#include <wsutil/inet_addr.h>
 #include <wsutil/nstime.h>
 #include <epan/column.h>
 #include <epan/expert.h>
@@ -37,6 +38,7 @@
 #include <QColor>
 #include <QElapsedTimer>
 #include <QFontMetrics>
+#include <QHash>
 #include <QModelIndex>
 #include <QElapsedTimer>
 
@@ -79,7 +81,11 @@ PacketListModel::PacketListModel(QObject *parent, capture_file *cf) :
     number_to_row_(QVector<int>()),
     max_row_height_(0),
     max_line_count_(1),
-    idle_dissection_row_(0)
+    sort_keys_column_(-1),
+    idle_dissection_row_(0),
+    prefetch_row_(0),
+    prefetch_last_(-1),
+    prefetch_scheduled_(false)
 {
     Q_ASSERT(glbl_plist_model == Q_NULLPTR);
     glbl_plist_model = this;
@@ -148,6 +154,7 @@ guint PacketListModel::recreateVisibleRows()
     beginResetModel();
     visible_rows_.resize(0);
     number_to_row_.fill(0);
+    invalidateSortKeys();
     endResetModel();
 
     foreach (PacketListRecord *record, physical_rows_) {
@@ -173,6 +180,7 @@ void PacketListModel::clear() {
     beginResetModel();
     qDeleteAll(physical_rows_);
     PacketListRecord::invalidateAllRecords();
+    invalidateSortKeys();
     physical_rows_.resize(0);
     visible_rows_.resize(0);
     new_visible_rows_.resize(0);
@@ -186,6 +194,7 @@ void PacketListModel::clear() {
 void PacketListModel::invalidateAllColumnStrings()
 {
     PacketListRecord::invalidateAllRecords();
+    invalidateSortKeys();
     emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1),
             QVector<int>() << Qt::DisplayRole);
 }
@@ -195,6 +204,7 @@ void PacketListModel::resetColumns()
     if (cap_file_) {
         PacketListRecord::resetColumns(&cap_file_->cinfo);
     }
+    invalidateSortKeys();
 
     emit dataChanged(index(0, 0), index(rowCount() - 1, columnCount() - 1));
     emit headerDataChanged(Qt::Horizontal, 0, columnCount() - 1);
@@ -372,6 +382,7 @@ void PacketListModel::addFrameComment(const QModelIndexList &indices, const QByt
         // of just the frames changed.
         record->invalidateColorized();
         record->invalidateRecord();
+        invalidateSortKeys();
         emit dataChanged(index.sibling(index.row(), 0), index.sibling(index.row(), sectionMax),
                 QVector<int>() << Qt::BackgroundRole << Qt::ForegroundRole << Qt::DisplayRole);
     }
@@ -404,6 +415,7 @@ void PacketListModel::setFrameComment(const QModelIndex &index, const QByteArray
 
     record->invalidateColorized();
     record->invalidateRecord();
+    invalidateSortKeys();
     emit dataChanged(index.sibling(index.row(), 0), index.sibling(index.row(), sectionMax),
             QVector<int>() << Qt::BackgroundRole << Qt::ForegroundRole << Qt::DisplayRole);
 }
@@ -435,6 +447,7 @@ void PacketListModel::deleteFrameComments(const QModelIndexList &indices)
 
             record->invalidateColorized();
             record->invalidateRecord();
+            invalidateSortKeys();
             emit dataChanged(index.sibling(index.row(), 0), index.sibling(index.row(), sectionMax),
                     QVector<int>() << Qt::BackgroundRole << Qt::ForegroundRole << Qt::DisplayRole);
         }
@@ -462,6 +475,7 @@ void PacketListModel::deleteAllFrameComments()
 
             record->invalidateColorized();
             record->invalidateRecord();
+            invalidateSortKeys();
             row = packetNumberToRow(fdata->num);
             if (row > -1) {
                 emit dataChanged(index(row, 0), index(row, sectionMax),
@@ -509,27 +523,6 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     QString col_title = get_column_title(column);
 
-    if (text_sort_column_ >= 0 && (guint)visible_rows_.count() > prefs.gui_packet_list_cached_rows_max) {
-        /* Column not based on frame data but by column text that requires
-         * dissection, so to sort in a reasonable amount of time the column
-         * text needs to be cached.
-         */
-        /* If the sort is being triggered because the columns were already
-         * sorted and the filter is being cleared (or changed to something
-         * else with more rows than fit in the cache), then the temporary
-         * message will be immediately overwritten with the standard capture
-         * statistics by the packets_bar_update() call after thawing the rows.
-         * It will still blink yellow, and the user will get the message if
-         * they then click on the header file (wondering why it didn't sort.)
-         */
-        if (col_title.isEmpty()) {
-            col_title = tr("Column");
-        }
-        QString temp_msg = tr("%1 can only be sorted with %2 or fewer visible rows; increase cache size in Layout preferences").arg(col_title).arg(prefs.gui_packet_list_cached_rows_max);
-        mainApp->pushStatus(MainApplication::TemporaryStatus, temp_msg);
-        return;
-    }
-
     /* If we are currently in the middle of reading the capture file, don't
      * sort. PacketList::captureFileReadFinished invalidates all the cached
      * column strings and then tries to sort again.
@@ -574,9 +567,23 @@ void PacketListModel::sort(int column, Qt::SortOrder order)
 
     busy_timer_.start();
     sort_column_is_numeric_ = isNumericColumn(sort_column_);
-    QVector<PacketListRecord *> sorted_visible_rows_ = visible_rows_;
+    QVector<PacketListRecord *> sorted_visible_rows_;
     try {
-        std::sort(sorted_visible_rows_.begin(), sorted_visible_rows_.end(), recordLessThan);
+        if (text_sort_column_ >= 0) {
+            /* Column text requires dissection. Fetch it once per row and
+             * sort on the extracted keys, which are kept for the next sort
+             * by the same column.
+             */
+            ensureSortKeys();
+            std::sort(sort_keys_.begin(), sort_keys_.end(), sortKeyLessThan);
+            sorted_visible_rows_.reserve(sort_keys_.count());
+            foreach (const SortKey &key, sort_keys_) {
+                sorted_visible_rows_ << key.record;
+            }
+        } else {
+            sorted_visible_rows_ = visible_rows_;
+            std::sort(sorted_visible_rows_.begin(), sorted_visible_rows_.end(), recordLessThan);
+        }
 
         beginResetModel();
         visible_rows_.resize(0);
@@ -614,6 +621,247 @@ void PacketListModel::stopSorting()
     stop_flag_ = TRUE;
 }
 
+void PacketListModel::invalidateSortKeys()
+{
+    // Assign rather than clear() so that the memory is released.
+    sort_keys_ = QVector<SortKey>();
+    sort_keys_column_ = -1;
+}
+
+// The keys are kept in the order of visible_rows_, so they can be reused
+// as long as that still holds and the column and its text haven't changed.
+bool PacketListModel::sortKeysValid() const
+{
+    if (sort_keys_column_ != sort_column_ || sort_keys_.count() != visible_rows_.count()) {
+        return false;
+    }
+    for (int i = 0; i < sort_keys_.count(); i++) {
+        if (sort_keys_[i].record != visible_rows_[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+PacketListModel::SortKeyType PacketListModel::sortKeyType(int column)
+{
+    int col_fmt = sort_cap_file_->cinfo.columns[column].col_fmt;
+
+    if (!sort_column_is_numeric_) {
+        switch (col_fmt) {
+        case COL_UNRES_DST:      /**< 8) Unresolved dest */
+        case COL_UNRES_NET_DST:  /**< 27) Unresolved net dest */
+        case COL_UNRES_NET_SRC:  /**< 29) Unresolved net source */
+        case COL_UNRES_SRC:      /**< 39) Unresolved source */
+            return AddressSortKey;
+        default:
+            return TextSortKey;
+        }
+    }
+
+    switch (col_fmt) {
+    case COL_CUMULATIVE_BYTES:
+    case COL_NUMBER:
+    case COL_PACKET_LENGTH:
+    case COL_UNRES_DST_PORT:
+    case COL_UNRES_SRC_PORT:
+    case COL_RES_DST_PORT:
+    case COL_DEF_DST_PORT:
+    case COL_DEF_SRC_PORT:
+    case COL_RES_SRC_PORT:
+        return UnsignedSortKey;
+    default:
+        return DoubleSortKey;
+    }
+}
+
+namespace {
+// Value of one distinct column string, for the column's key type.
+struct SortValue {
+    guint32 text_id;
+    guint32 text_order;  // Order of the string by code points
+    int kind;            // 0: not a value of the key type; for addresses 4 or 6
+    guint64 u;
+    double d;
+    guint8 addr[16];
+};
+}
+
+static int compareSortValues(int key_type, const SortValue &v1, const SortValue &v2)
+{
+    int cmp_val = 0;
+
+    switch (key_type) {
+    case PacketListModel::UnsignedSortKey:
+    case PacketListModel::DoubleSortKey:
+        // Strings without a number sort first, and are all equal.
+        if (v1.kind != v2.kind) {
+            return v1.kind < v2.kind ? -1 : 1;
+        }
+        if (!v1.kind) {
+            return 0;
+        }
+        if (key_type == PacketListModel::UnsignedSortKey && v1.u != v2.u) {
+            return v1.u < v2.u ? -1 : 1;
+        }
+        if (key_type == PacketListModel::DoubleSortKey && v1.d != v2.d) {
+            return v1.d < v2.d ? -1 : 1;
+        }
+        break;
+    case PacketListModel::AddressSortKey:
+        // IPv4, then IPv6, then anything else (such as MAC addresses).
+        if (v1.kind != v2.kind) {
+            return v1.kind && (!v2.kind || v1.kind < v2.kind) ? -1 : 1;
+        }
+        if (v1.kind) {
+            cmp_val = memcmp(v1.addr, v2.addr, v1.kind == 4 ? 4 : 16);
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (cmp_val == 0 && v1.text_order != v2.text_order) {
+        cmp_val = v1.text_order < v2.text_order ? -1 : 1;
+    }
+    return cmp_val;
+}
+
+// Extracts the sort keys of sort_column_ for the visible rows, in their
+// current order, unless they are still valid from the previous sort.
+// Each distinct string is converted to the column's key type once, and
+// ranked once; the keys then only hold that rank.
+void PacketListModel::ensureSortKeys()
+{
+    if (sortKeysValid()) {
+        return;
+    }
+
+    invalidateSortKeys();
+    QVector<SortKey> keys(visible_rows_.count());
+    QHash<QString, guint32> text_ids;
+    QVector<QString> texts;
+    for (int i = 0; i < visible_rows_.count(); i++) {
+        if (busy_timer_.elapsed() > busy_timeout_) {
+            if (progress_frame_) {
+                progress_frame_->setValue(static_cast<int>(i * 100.0 / visible_rows_.count()));
+            }
+            mainApp->processEvents(QEventLoop::ExcludeSocketNotifiers, 1);
+            if (stop_flag_) {
+                throw SortAbort("Sorting aborted");
+            }
+            busy_timer_.restart();
+        }
+
+        PacketListRecord *record = visible_rows_[i];
+        const QString text = record->columnString(sort_cap_file_, sort_column_);
+        guint32 text_id;
+        QHash<QString, guint32>::const_iterator it = text_ids.constFind(text);
+        if (it == text_ids.constEnd()) {
+            text_id = static_cast<guint32>(texts.count());
+            text_ids.insert(text, text_id);
+            texts << text;
+        } else {
+            text_id = it.value();
+        }
+
+        SortKey &key = keys[i];
+        key.record = record;
+        key.frame_num = record->frameData()->num;
+        key.rank = text_id;
+    }
+    text_ids.clear();
+
+    // XXX: The naive string comparison compares Unicode code points.
+    // Proper collation is more expensive
+    QVector<guint32> order(texts.count());
+    for (int i = 0; i < order.count(); i++) {
+        order[i] = static_cast<guint32>(i);
+    }
+    std::sort(order.begin(), order.end(), [&texts](guint32 a, guint32 b) {
+        return texts[a].compare(texts[b]) < 0;
+    });
+
+    SortKeyType key_type = sortKeyType(sort_column_);
+    QVector<SortValue> values(texts.count());
+    for (int i = 0; i < order.count(); i++) {
+        SortValue &value = values[i];
+        value.text_id = order[i];
+        value.text_order = static_cast<guint32>(i);
+
+        bool ok = false;
+        switch (key_type) {
+        case UnsignedSortKey:
+            value.u = parseUnsignedColumn(texts[order[i]], &ok);
+            value.kind = ok;
+            break;
+        case DoubleSortKey:
+            value.d = parseNumericColumn(texts[order[i]], &ok);
+            value.kind = ok;
+            break;
+        case AddressSortKey:
+        {
+            QByteArray ba = texts[order[i]].toUtf8();
+            ws_in4_addr ip4;
+            if (ws_inet_pton4(ba.constData(), &ip4)) {
+                memcpy(value.addr, &ip4, sizeof ip4);
+                value.kind = 4;
+            } else if (ws_inet_pton6(ba.constData(), (ws_in6_addr *)value.addr)) {
+                value.kind = 6;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    texts.clear();
+
+    if (key_type != TextSortKey) {
+        std::sort(values.begin(), values.end(), [key_type](const SortValue &a, const SortValue &b) {
+            return compareSortValues(key_type, a, b) < 0;
+        });
+    }
+
+    // Values that compare equal share a rank, and are ordered by frame
+    // number.
+    QVector<guint32> rank(values.count());
+    guint32 cur_rank = 0;
+    for (int i = 0; i < values.count(); i++) {
+        if (i > 0 && compareSortValues(key_type, values[i - 1], values[i]) != 0) {
+            cur_rank++;
+        }
+        rank[values[i].text_id] = cur_rank;
+    }
+    values.clear();
+
+    for (int i = 0; i < keys.count(); i++) {
+        keys[i].rank = rank[keys[i].rank];
+    }
+    sort_keys_ = keys;
+    sort_keys_column_ = sort_column_;
+}
+
+// Same ordering as recordLessThan for text columns, except for address
+// columns, which are ordered by address.
+bool PacketListModel::sortKeyLessThan(const SortKey &k1, const SortKey &k2)
+{
+    int cmp_val = 0;
+
+    if (k1.rank != k2.rank) {
+        cmp_val = k1.rank < k2.rank ? -1 : 1;
+    } else if (k1.frame_num != k2.frame_num) {
+        // All else being equal, compare column numbers.
+        cmp_val = k1.frame_num < k2.frame_num ? -1 : 1;
+    }
+
+    if (sort_order_ == Qt::AscendingOrder) {
+        return cmp_val < 0;
+    } else {
+        return cmp_val > 0;
+    }
+}
+
 bool PacketListModel::isNumericColumn(int column)
 {
     if (column < 0) {
@@ -747,6 +995,17 @@ bool PacketListModel::recordLessThan(PacketListRecord *r1, PacketListRecord *r2)
     }
 }
 
+// Parses a field as an unsigned integer, the same way as parseNumericColumn.
+guint64 PacketListModel::parseUnsignedColumn(const QString &val, bool *ok)
+{
+    QByteArray ba = val.toUtf8();
+    const char *strval = ba.constData();
+    gchar *end = NULL;
+    guint64 num = g_ascii_strtoull(strval, &end, 10);
+    *ok = strval != end && strval[0] != '-';
+    return num;
+}
+
 // Parses a field as a double. Handle values with suffixes ("12ms"), negative
 // values ("-1.23") and fields with multiple occurrences ("1,2"). Marks values
 // that do not contain any numeric value ("Unknown") as invalid.
@@ -943,6 +1202,40 @@ void PacketListModel::dissectIdle(bool reset)
     emit bgColorizationProgress(first+1, idle_dissection_row_+1);
 }
 
+void PacketListModel::prefetchRows(int first, int last)
+{
+    prefetch_row_ = first < 0 ? 0 : first;
+    prefetch_last_ = last;
+    if (!prefetch_scheduled_ && prefetch_row_ <= prefetch_last_) {
+        prefetch_scheduled_ = true;
+        QTimer::singleShot(0, this, &PacketListModel::prefetchIdle);
+    }
+}
+
+void PacketListModel::prefetchIdle()
+{
+    prefetch_scheduled_ = false;
+
+    /* Don't dissect while the file is being read or the list sorted. */
+    if (!cap_file_ || cap_file_->read_lock) {
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < idle_dissection_interval_
+           && prefetch_row_ <= prefetch_last_
+           && prefetch_row_ < visible_rows_.count()) {
+        visible_rows_[prefetch_row_]->prefetchColumnStrings(cap_file_);
+        prefetch_row_++;
+    }
+
+    if (prefetch_row_ <= prefetch_last_ && prefetch_row_ < visible_rows_.count()) {
+        prefetch_scheduled_ = true;
+        QTimer::singleShot(0, this, &PacketListModel::prefetchIdle);
+    }
+}
+
 // XXX Pass in cinfo from packet_list_append so that we can fill in
 // line counts?
 gint PacketListModel::appendPacket(frame_data *fdata)
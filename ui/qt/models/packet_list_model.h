@@ -39,6 +39,14 @@ public:
         HEADER_CAN_RESOLVE = Qt::UserRole,
     };
 
+    // How the text of a sort column is compared.
+    enum SortKeyType {
+        TextSortKey,        // By code points
+        UnsignedSortKey,    // As an unsigned integer, then by text
+        DoubleSortKey,      // As a double, then by text
+        AddressSortKey      // As an IPv4 or IPv6 address, then by text
+    };
+
     explicit PacketListModel(QObject *parent = 0, capture_file *cf = NULL);
     ~PacketListModel();
     void setCaptureFile(capture_file *cf);
@@ -58,6 +66,13 @@ public:
     frame_data *getRowFdata(QModelIndex idx);
     frame_data *getRowFdata(int row);
     void ensureRowColorized(int row);
+    /**
+     * @brief Dissect and cache the column strings of rows, in short time
+     * slices run from the event loop on the GUI thread.
+     * @param first The first row.
+     * @param last The last row.
+     */
+    void prefetchRows(int first, int last);
     int visibleIndexOf(frame_data *fdata) const;
     /**
      * @brief Invalidate any cached column strings.
@@ -105,6 +120,19 @@ private:
     int max_row_height_; // px
     int max_line_count_;
 
+    // Sort key of a row for a text column, extracted once so that sorting
+    // doesn't need to fetch (and possibly dissect) the column text per
+    // comparison.
+    struct SortKey {
+        PacketListRecord *record = nullptr;
+        guint32 frame_num = 0;
+        guint32 rank = 0; // Order of the column value among all keyed rows
+    };
+    // Keys of the visible rows, in visible_rows_ order, for column
+    // sort_keys_column_.
+    QVector<SortKey> sort_keys_;
+    int sort_keys_column_;
+
     static int sort_column_;
     static int sort_column_is_numeric_;
     static int text_sort_column_;
@@ -112,6 +140,12 @@ private:
     static capture_file *sort_cap_file_;
     static bool recordLessThan(PacketListRecord *r1, PacketListRecord *r2);
     static double parseNumericColumn(const QString &val, bool *ok);
+    static guint64 parseUnsignedColumn(const QString &val, bool *ok);
+    static bool sortKeyLessThan(const SortKey &k1, const SortKey &k2);
+    static SortKeyType sortKeyType(int column);
+    bool sortKeysValid() const;
+    void ensureSortKeys();
+    void invalidateSortKeys();
 
     static gboolean stop_flag_;
     static ProgressFrame *progress_frame_;
@@ -121,6 +155,11 @@ private:
     QElapsedTimer *idle_dissection_timer_;
     int idle_dissection_row_;
 
+    int prefetch_row_;
+    int prefetch_last_;
+    bool prefetch_scheduled_;
+    void prefetchIdle();
+
     bool isNumericColumn(int column);
 
 private slots:
@@ -22,9 +22,185 @@
 
 #include <ui/qt/utils/qt_ui_utils.h>
 
-#include <QStringList>
+#include <QVarLengthArray>
 
-QCache<guint32, QStringList> PacketListRecord::col_text_cache_(500);
+#include <string.h>
+
+ColumnTextStore::ColumnTextStore() :
+    lru_head_(nullptr),
+    lru_tail_(nullptr),
+    num_cols_(0),
+    used_bytes_(0),
+    max_bytes_(128 * 1024 * 1024)
+{
+}
+
+ColumnTextStore::~ColumnTextStore()
+{
+    clear();
+}
+
+void ColumnTextStore::setMaxBytes(size_t max_bytes)
+{
+    max_bytes_ = max_bytes;
+    evict(nullptr);
+}
+
+void ColumnTextStore::clear()
+{
+    qDeleteAll(blocks_);
+    blocks_.clear();
+    lru_head_ = lru_tail_ = nullptr;
+    num_cols_ = 0;
+    used_bytes_ = 0;
+}
+
+bool ColumnTextStore::contains(guint32 frame_num) const
+{
+    const Block *block = blocks_.value(frame_num / block_frames_);
+    if (!block || num_cols_ < 1) {
+        return false;
+    }
+    return block->cells.at((frame_num % block_frames_) * num_cols_) != 0;
+}
+
+QString ColumnTextStore::text(guint32 frame_num, int column)
+{
+    if (column < 0 || column >= num_cols_) {
+        return QString();
+    }
+    Block *block = blocks_.value(frame_num / block_frames_);
+    if (!block) {
+        return QString();
+    }
+    guint32 offset = block->cells.at((frame_num % block_frames_) * num_cols_ + column);
+    if (offset == 0) {
+        return QString();
+    }
+    lruTouch(block);
+    return QString::fromUtf8(block->arena.constData() + offset - 1);
+}
+
+void ColumnTextStore::insert(guint32 frame_num, const char * const *texts, int num_cols)
+{
+    if (num_cols != num_cols_) {
+        clear();
+        num_cols_ = num_cols;
+    }
+    if (num_cols_ < 1) {
+        return;
+    }
+
+    guint32 block_num = frame_num / block_frames_;
+    Block *block = blocks_.value(block_num);
+    if (!block) {
+        block = new Block();
+        block->cells.fill(0, block_frames_ * num_cols_);
+        block->block_num = block_num;
+        block->bytes = 0;
+        block->lru_prev = block->lru_next = nullptr;
+        blocks_.insert(block_num, block);
+    }
+
+    guint32 *cells = block->cells.data() + (frame_num % block_frames_) * num_cols_;
+    for (int column = 0; column < num_cols_; column++) {
+        cells[column] = intern(block, texts[column] ? texts[column] : "") + 1;
+    }
+    lruTouch(block);
+
+    updateBytes(block);
+    evict(block);
+}
+
+void ColumnTextStore::remove(guint32 frame_num)
+{
+    Block *block = blocks_.value(frame_num / block_frames_);
+    if (!block || num_cols_ < 1) {
+        return;
+    }
+    // The strings stay in the arena until the block is dropped.
+    guint32 *cells = block->cells.data() + (frame_num % block_frames_) * num_cols_;
+    memset(cells, 0, num_cols_ * sizeof(guint32));
+}
+
+guint32 ColumnTextStore::intern(Block *block, const char *str)
+{
+    size_t len = strlen(str);
+    uint hash = qHash(QByteArray::fromRawData(str, static_cast<int>(len)));
+
+    QMultiHash<uint, guint32>::const_iterator it = block->strings.constFind(hash);
+    while (it != block->strings.constEnd() && it.key() == hash) {
+        if (strcmp(block->arena.constData() + it.value(), str) == 0) {
+            return it.value();
+        }
+        ++it;
+    }
+
+    guint32 offset = static_cast<guint32>(block->arena.size());
+    block->arena.append(str, static_cast<int>(len) + 1);
+    block->strings.insert(hash, offset);
+    return offset;
+}
+
+void ColumnTextStore::updateBytes(Block *block)
+{
+    // Approximate: QHash nodes hold the key, the value and a next pointer
+    // plus the bucket pointer.
+    size_t bytes = sizeof(Block) +
+            static_cast<size_t>(block->arena.capacity()) +
+            static_cast<size_t>(block->cells.capacity()) * sizeof(guint32) +
+            static_cast<size_t>(block->strings.size()) * (sizeof(uint) + sizeof(guint32) + 2 * sizeof(void *));
+    used_bytes_ = used_bytes_ - block->bytes + bytes;
+    block->bytes = bytes;
+}
+
+void ColumnTextStore::lruUnlink(Block *block)
+{
+    if (block->lru_prev) {
+        block->lru_prev->lru_next = block->lru_next;
+    } else if (lru_head_ == block) {
+        lru_head_ = block->lru_next;
+    }
+    if (block->lru_next) {
+        block->lru_next->lru_prev = block->lru_prev;
+    } else if (lru_tail_ == block) {
+        lru_tail_ = block->lru_prev;
+    }
+    block->lru_prev = block->lru_next = nullptr;
+}
+
+// Move a block to the front of the list, as the most recently used.
+void ColumnTextStore::lruTouch(Block *block)
+{
+    if (lru_head_ == block) {
+        return;
+    }
+    lruUnlink(block);
+    block->lru_next = lru_head_;
+    if (lru_head_) {
+        lru_head_->lru_prev = block;
+    }
+    lru_head_ = block;
+    if (!lru_tail_) {
+        lru_tail_ = block;
+    }
+}
+
+// Drop the least recently used blocks, except for keep, until we're back
+// under budget. keep has just been used, so it's at the front; when it's
+// also at the back, it's the only block left.
+void ColumnTextStore::evict(const Block *keep)
+{
+    while (used_bytes_ > max_bytes_ && lru_tail_ && lru_tail_ != keep) {
+        Block *lru = lru_tail_;
+        lruUnlink(lru);
+        used_bytes_ -= lru->bytes;
+        blocks_.remove(lru->block_num);
+        delete lru;
+    }
+}
+
+ColumnTextStore PacketListRecord::col_text_store_;
 QMap<int, int> PacketListRecord::cinfo_column_;
 unsigned PacketListRecord::rows_color_ver_ = 1;
 
@@ -54,8 +230,8 @@ void PacketListRecord::ensureColorized(capture_file *cap_file)
 
     bool dissect_color = !colorized_ || ( color_ver_ != rows_color_ver_ );
     if (dissect_color) {
-        /* Dissect columns only if it won't evict anything from cache */
-        bool dissect_columns = col_text_cache_.totalCost() < col_text_cache_.maxCost();
+        /* Dissect columns only if it won't evict anything from the store */
+        bool dissect_columns = !col_text_store_.isFull();
         dissect(cap_file, dissect_columns, dissect_color);
     }
 }
@@ -77,16 +253,22 @@ const QString PacketListRecord::columnString(capture_file *cap_file, int column,
     // properly colorized?
     //
     bool dissect_color = ( colorized && !colorized_ ) || ( color_ver_ != rows_color_ver_ );
-    QStringList *col_text = nullptr;
-    if (!dissect_color) {
-        col_text = col_text_cache_.object(fdata_->num);
-    }
-    if (col_text == nullptr || column >= col_text->count() || col_text->at(column).isNull()) {
+    if (dissect_color || !col_text_store_.contains(fdata_->num)) {
         dissect(cap_file, true, dissect_color);
-        col_text = col_text_cache_.object(fdata_->num);
     }
 
-    return col_text ? col_text->at(column) : QString();
+    return col_text_store_.text(fdata_->num, column);
+}
+
+void PacketListRecord::prefetchColumnStrings(capture_file *cap_file)
+{
+    Q_ASSERT(fdata_);
+
+    if (!cap_file || col_text_store_.contains(fdata_->num)) {
+        return;
+    }
+
+    dissect(cap_file, true, !colorized());
 }
 
 void PacketListRecord::resetColumns(column_info *cinfo)
@@ -219,28 +401,29 @@ void PacketListRecord::cacheColumnStrings(column_info *cinfo)
         return;
     }
 
-    QStringList *col_text = new QStringList();
+    QVarLengthArray<const char *, 32> col_text(cinfo->num_cols);
 
     lines_ = 1;
     line_count_changed_ = false;
 
     for (int column = 0; column < cinfo->num_cols; ++column) {
-        int col_lines = 1;
+        int col_lines = 0;
 
-        QString col_str;
         int text_col = cinfo_column_.value(column, -1);
         if (text_col < 0) {
             col_fill_in_frame_data(fdata_, cinfo, column, FALSE);
         }
 
-        col_str = QString(get_column_text(cinfo, column));
-        *col_text << col_str;
-        col_lines = static_cast<int>(col_str.count('\n'));
+        const char *col_str = get_column_text(cinfo, column);
+        col_text[column] = col_str;
+        for (const char *nl = col_str ? strchr(col_str, '\n') : NULL; nl; nl = strchr(nl + 1, '\n')) {
+            col_lines++;
+        }
         if (col_lines > lines_) {
             lines_ = col_lines;
             line_count_changed_ = true;
         }
     }
 
-    col_text_cache_.insert(fdata_->num, col_text);
+    col_text_store_.insert(fdata_->num, col_text.constData(), cinfo->num_cols);
 }
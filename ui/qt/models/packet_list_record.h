@@ -20,13 +20,67 @@
 #include <epan/packet.h>
 
 #include <QByteArray>
-#include <QCache>
+#include <QHash>
 #include <QList>
+#include <QMultiHash>
 #include <QVariant>
+#include <QVector>
 
 struct conversation;
 struct _GStringChunk;
 
+/*
+ * Column text of packet list rows. Rows are grouped in blocks of
+ * consecutive frames; each block keeps its distinct strings once, as
+ * NUL-terminated UTF-8, in a single arena. When the memory budget is
+ * exceeded, the least recently used blocks are dropped.
+ */
+class ColumnTextStore
+{
+public:
+    ColumnTextStore();
+    ~ColumnTextStore();
+
+    void setMaxBytes(size_t max_bytes);
+    bool isFull() const { return used_bytes_ >= max_bytes_; }
+    void clear();
+
+    bool contains(guint32 frame_num) const;
+    // Returns a null QString if the row isn't stored.
+    QString text(guint32 frame_num, int column);
+    void insert(guint32 frame_num, const char * const *texts, int num_cols);
+    void remove(guint32 frame_num);
+
+private:
+    static const guint32 block_frames_ = 1024;
+
+    struct Block {
+        QByteArray arena;
+        // Hash of a string -> its offset in the arena.
+        QMultiHash<uint, guint32> strings;
+        // Arena offset + 1 of each column of each row, 0 if not stored.
+        QVector<guint32> cells;
+        guint32 block_num;
+        size_t bytes;
+        // Neighbours in the list of blocks, from most to least recently used.
+        Block *lru_prev;
+        Block *lru_next;
+    };
+
+    QHash<guint32, Block *> blocks_;
+    Block *lru_head_;
+    Block *lru_tail_;
+    int num_cols_;
+    size_t used_bytes_;
+    size_t max_bytes_;
+
+    guint32 intern(Block *block, const char *str);
+    void updateBytes(Block *block);
+    void lruUnlink(Block *block);
+    void lruTouch(Block *block);
+    void evict(const Block *keep);
+};
+
 class PacketListRecord
 {
 public:
@@ -37,6 +91,8 @@ public:
     void ensureColorized(capture_file *cap_file);
     // Return the string value for a column. Data is cached if possible.
     const QString columnString(capture_file *cap_file, int column, bool colorized = false);
+    // Dissect and store the column strings if they aren't stored yet.
+    void prefetchColumnStrings(capture_file *cap_file);
     frame_data *frameData() const { return fdata_; }
     // packet_list->col_to_text in gtk/packet_list_store.c
     static int textColumn(int column) { return cinfo_column_.value(column, -1); }
@@ -46,12 +102,9 @@ public:
     int columnTextSize(const char *str);
 
     void invalidateColorized() { colorized_ = false; }
-    void invalidateRecord() { col_text_cache_.remove(fdata_->num); }
-    static void invalidateAllRecords() { col_text_cache_.clear(); }
-    /* In Qt 6, QCache maxCost is a qsizetype, but the QAbstractItemModel
-     * number of rows is still an int, so we're limited to INT_MAX anyway.
-     */
-    static void setMaxCache(int cost) { col_text_cache_.setMaxCost(cost); }
+    void invalidateRecord() { col_text_store_.remove(fdata_->num); }
+    static void invalidateAllRecords() { col_text_store_.clear(); }
+    static void setMaxCache(size_t bytes) { col_text_store_.setMaxBytes(bytes); }
     static void resetColumns(column_info *cinfo);
     static void resetColorization() { rows_color_ver_++; }
 
@@ -60,7 +113,7 @@ public:
 
 private:
     /** The column text for some columns */
-    static QCache<guint32, QStringList> col_text_cache_;
+    static ColumnTextStore col_text_store_;
 
     frame_data *fdata_;
     int lines_;
@@ -272,12 +272,7 @@ PacketList::PacketList(QWidget *parent) :
     connect(mainApp, SIGNAL(addressResolutionChanged()), this, SLOT(redrawVisiblePacketsDontSelectCurrent()));
     connect(mainApp, SIGNAL(columnDataChanged()), this, SLOT(redrawVisiblePacketsDontSelectCurrent()));
     connect(mainApp, &MainApplication::preferencesChanged, this, [=]() {
-        /* The pref is a uint but QCache maxCost is a signed int (/
-         * qsizetype in Qt 6). Note that QAbstractItemModel row numbers
-         * are ints, not unsigned ints, so we're limited to INT_MAX
-         * rows anyway.
-         */
-        PacketListRecord::setMaxCache(prefs.gui_packet_list_cached_rows_max > INT_MAX ? INT_MAX : prefs.gui_packet_list_cached_rows_max);
+        PacketListRecord::setMaxCache(static_cast<size_t>(prefs.gui_packet_list_cache_size) * 1024 * 1024);
         if ((bool) (prefs.gui_packet_list_sortable) != isSortingEnabled()) {
             setSortingEnabled(prefs.gui_packet_list_sortable);
         }
@@ -289,6 +284,7 @@ PacketList::PacketList(QWidget *parent) :
             this, SLOT(sectionMoved(int,int,int)));
 
     connect(verticalScrollBar(), SIGNAL(actionTriggered(int)), this, SLOT(vScrollBarActionTriggered(int)));
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &PacketList::prefetchColumnStrings);
 }
 
 PacketList::~PacketList()
@@ -1968,6 +1964,22 @@ void PacketList::vScrollBarActionTriggered(int)
     scrollViewChanged(tail_at_end_);
 }
 
+// Fill the column strings of the next couple of pages so that scrolling down
+// doesn't have to dissect them. The model does this a few rows at a time,
+// from zero-length timers on the GUI thread, the same way it colorizes in
+// idle time; each slice holds up the event loop briefly.
+void PacketList::prefetchColumnStrings()
+{
+    QModelIndex top = indexAt(viewport()->rect().topLeft());
+    if (!top.isValid()) {
+        return;
+    }
+    QModelIndex bottom = indexAt(viewport()->rect().bottomLeft());
+    int last = bottom.isValid() ? bottom.row() : packet_list_model_->rowCount() - 1;
+    int page = last - top.row() + 1;
+    packet_list_model_->prefetchRows(last + 1, last + 2 * page);
+}
+
 void PacketList::scrollViewChanged(bool at_end)
 {
     if (capture_in_progress_) {
@@ -200,6 +200,7 @@ private slots:
     void updateRowHeights(const QModelIndex &ih_index);
     void copySummary();
     void vScrollBarActionTriggered(int);
+    void prefetchColumnStrings();
     void drawFarOverlay();
     void drawNearOverlay();
     void updatePackets(bool redraw);
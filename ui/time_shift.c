@@ -290,6 +290,7 @@ time_shift_all(capture_file *cf, const gchar *offset_text)
         modify_time_perform(fd, neg ? SHIFT_NEG : SHIFT_POS, &offset, SHIFT_KEEPOFFSET);
     }
     cf->unsaved_changes = TRUE;
+    frame_data_sequence_invalidate_time_index(cf->provider.frames);
     packet_list_queue_draw();
 
     return NULL;
@@ -336,6 +337,7 @@ time_shift_settime(capture_file *cf, guint packet_num, const gchar *time_text)
     }
 
     cf->unsaved_changes = TRUE;
+    frame_data_sequence_invalidate_time_index(cf->provider.frames);
     packet_list_queue_draw();
     return NULL;
 }
@@ -420,6 +422,7 @@ time_shift_adjtime(capture_file *cf, guint packet1_num, const gchar *time1_text,
     }
 
     cf->unsaved_changes = TRUE;
+    frame_data_sequence_invalidate_time_index(cf->provider.frames);
     packet_list_queue_draw();
     return NULL;
 }
@@ -444,6 +447,7 @@ time_shift_undo(capture_file *cf)
             continue;   /* Shouldn't happen */
         modify_time_perform(fd, SHIFT_NEG, &nulltime, SHIFT_SETTOZERO);
     }
+    frame_data_sequence_invalidate_time_index(cf->provider.frames);
     packet_list_queue_draw();
     return NULL;
 }
@@ -890,6 +890,7 @@ wtap_open_offline(const char *filename, unsigned int type, int *err, char **err_
 	wth->file_encap = WTAP_ENCAP_UNKNOWN;
 	wth->subtype_sequential_close = NULL;
 	wth->subtype_close = NULL;
+	wth->subtype_get_trailing_if_stats = NULL;
 	wth->file_tsprec = WTAP_TSPREC_USEC;
 	wth->pathname = g_strdup(filename);
 	wth->priv = NULL;
@@ -203,6 +203,13 @@ struct wtap_reader {
 #ifdef USE_LZ4
     LZ4F_dctx *lz4_dctx;
 #endif
+    /* memory mapping, for uncompressed random-access files */
+    GMappedFile *map;           /* mapping of the file, or NULL */
+    const guint8 *map_data;     /* uncompressed data in the mapping */
+    gint64 map_size;            /* number of bytes of data in the mapping */
+    gint64 map_file_size;       /* bytes of data in the file when last looked at, or -1 */
+    gboolean map_fd_valid;      /* TRUE if the buffers and fd match pos */
+    GSList *map_retired;        /* earlier mappings, kept until closing */
 };
 
 /* Current read offset within a buffer. */
@@ -1060,6 +1067,98 @@ gz_reset(FILE_T state)
     buf_reset(&state->in);        /* no input data yet */
 }
 
+/*
+ * Move to a new position in a memory-mapped file without going through
+ * the file descriptor; the buffers, and the file descriptor's position,
+ * no longer match the position.
+ */
+static void
+map_set_pos(FILE_T state, gint64 pos)
+{
+    if (state->map_fd_valid) {
+        buf_reset(&state->out);
+        buf_reset(&state->in);
+        state->map_fd_valid = FALSE;
+    }
+    state->pos = pos;
+}
+
+/*
+ * Before reading a memory-mapped file through the file descriptor,
+ * e.g. for data past the end of the mapping, make the file descriptor's
+ * position match the position.
+ */
+static int
+map_sync_fd(FILE_T state)
+{
+    if (state->map_fd_valid)
+        return 0;
+
+    if (ws_lseek64(state->fd, state->start + state->pos, SEEK_SET) == -1) {
+        state->err = errno;
+        state->err_info = NULL;
+        return -1;
+    }
+    state->raw_pos = state->start + state->pos;
+    state->eof = FALSE;
+    state->map_fd_valid = TRUE;
+    return 0;
+}
+
+/*
+ * Stop using the mapping, and read through the file descriptor from
+ * the current position on.  Data handed out by file_read_mapped() must
+ * stay valid, so the mapping is kept around until we're closed.
+ */
+static int
+map_retire(FILE_T state)
+{
+    if (map_sync_fd(state) == -1)
+        return -1;
+    state->map_retired = g_slist_prepend(state->map_retired, state->map);
+    state->map = NULL;
+    state->map_data = NULL;
+    state->map_size = 0;
+    return 0;
+}
+
+/*
+ * Another process can truncate the file while we have it mapped, and
+ * touching a page of the mapping that is wholly past the new end of
+ * the file raises SIGBUS.  Before using the mapping for the data from
+ * the current position up to end, check that the file still has it;
+ * if it doesn't, stop using the mapping, so that the read goes through
+ * the file descriptor and comes up short instead.
+ *
+ * So as not to make a system call for every read, the file's size is
+ * looked at again only after a seek, i.e. once per random-access read
+ * of a record, or if end is past where the file ended last time.
+ *
+ * This only protects reads.  Data already handed out by
+ * file_read_mapped() still points into the mapping, and touching it
+ * after the file has been truncated under it raises SIGBUS.
+ */
+static gboolean
+map_has_data(FILE_T state, gint64 end)
+{
+    ws_statb64 st;
+
+    if (end > state->map_size)
+        return FALSE;
+    if (end > state->map_file_size) {
+        if (ws_fstat64(state->fd, &st) == -1) {
+            map_retire(state);
+            return FALSE;
+        }
+        state->map_file_size = st.st_size - state->start;
+        if (state->map_file_size < end) {
+            map_retire(state);
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
 FILE_T
 file_fdopen(int fd)
 {
@@ -1288,10 +1387,65 @@ file_open(const char *path)
     return ft;
 }
 
+#ifndef _WIN32
+/*
+ * Map an uncompressed regular file into memory, so that random-access
+ * reads don't need a system call and a copy through our buffers, and
+ * so that file_read_mapped() can hand out packet data in place.
+ *
+ * Data past the end of the mapping, e.g. data appended to the file
+ * after we mapped it, is still read through the file descriptor.
+ * Once we're told that the file is still being written, by
+ * file_unmap(), we stop using the mapping altogether, as the writer
+ * might also truncate it.
+ *
+ * Not done on Windows, where a file can't be renamed or deleted while
+ * it's mapped, which would get in the way of saving over it.
+ */
+static void
+file_map(FILE_T state)
+{
+    ws_statb64 st;
+    GMappedFile *map;
+    gsize length;
+
+    if (ws_fstat64(state->fd, &st) == -1 || !S_ISREG(st.st_mode))
+        return;
+
+    /* Look at the beginning of the file to see whether it's compressed. */
+    if (file_peekc(state) == -1)
+        return;
+    if (state->is_compressed || state->compression != UNCOMPRESSED)
+        return;
+
+    map = g_mapped_file_new_from_fd(state->fd, FALSE, NULL);
+    if (map == NULL)
+        return;
+    length = g_mapped_file_get_length(map);
+    if (length <= (gsize)state->start) {
+        g_mapped_file_unref(map);
+        return;
+    }
+    state->map = map;
+    state->map_data = (const guint8 *)g_mapped_file_get_contents(map) + state->start;
+    state->map_size = (gint64)(length - state->start);
+    state->map_file_size = (gint64)st.st_size - state->start;
+
+    /* We haven't moved since peeking, so the buffers are still good. */
+    state->map_fd_valid = TRUE;
+}
+#endif
+
 void
-file_set_random_access(FILE_T stream, gboolean random_flag _U_, GPtrArray *seek)
+file_set_random_access(FILE_T stream, gboolean random_flag, GPtrArray *seek)
 {
     stream->fast_seek = seek;
+#ifndef _WIN32
+    if (random_flag)
+        file_map(stream);
+#else
+    (void)random_flag;
+#endif
 }
 
 gint64
@@ -1308,6 +1462,30 @@ file_seek(FILE_T file, gint64 offset, int whence, int *err)
 */
     }
 
+    if (file->map != NULL) {
+        /* Seeking in a memory-mapped file just changes the position. */
+        if (whence == SEEK_CUR)
+            offset += file->pos;
+        else if (whence == SEEK_END) {
+            ws_statb64 st;
+
+            if (ws_fstat64(file->fd, &st) == -1) {
+                *err = errno;
+                return -1;
+            }
+            offset += st.st_size - file->start;
+        }
+        if (offset < 0) {
+            *err = EINVAL;
+            return -1;
+        }
+        if (offset != file->pos)
+            map_set_pos(file, offset);
+        /* Check that the file is still all there before the next read. */
+        file->map_file_size = -1;
+        return offset;
+    }
+
     /* Normalize offset to a SEEK_CUR specification */
     if (whence == SEEK_END) {
         /* Seek relative to the end of the file; given that we might be
@@ -1590,6 +1768,8 @@ file_tell(FILE_T stream)
 gint64
 file_tell_raw(FILE_T stream)
 {
+    if (stream->map != NULL)
+        return stream->start + stream->pos;
     return stream->raw_pos;
 }
 
@@ -1651,6 +1831,18 @@ file_read(void *buf, unsigned int len, FILE_T file)
     if (len == 0)
         return 0;
 
+    if (file->map != NULL) {
+        /* copy straight from the mapping if it has all the data */
+        if (map_has_data(file, file->pos + len)) {
+            if (buf != NULL)
+                memcpy(buf, file->map_data + file->pos, len);
+            map_set_pos(file, file->pos + len);
+            return (int)len;
+        }
+        if (map_sync_fd(file) == -1)
+            return -1;
+    }
+
     /* process a skip request */
     if (file->seek_pending) {
         file->seek_pending = FALSE;
@@ -1703,6 +1895,26 @@ file_read(void *buf, unsigned int len, FILE_T file)
     return (int)got;
 }
 
+gboolean
+file_is_mapped(FILE_T stream)
+{
+    return stream->map != NULL;
+}
+
+const guint8 *
+file_read_mapped(FILE_T file, unsigned int len)
+{
+    const guint8 *data;
+
+    if (file->map == NULL || file->err != 0 ||
+        !map_has_data(file, file->pos + len))
+        return NULL;
+
+    data = file->map_data + file->pos;
+    map_set_pos(file, file->pos + len);
+    return data;
+}
+
 /*
  * XXX - this *peeks* at next byte, not a character.
  */
@@ -1715,6 +1927,11 @@ file_peekc(FILE_T file)
     if (file->err != 0)
         return -1;
 
+    /* bytes are read through the buffers, even in a mapped file;
+       checking the mapping for each of them would cost more */
+    if (file->map != NULL && map_sync_fd(file) == -1)
+        return -1;
+
     /* try output buffer (no need to check for skip request) */
     if (file->out.avail != 0) {
         return *(file->out.next);
@@ -1763,6 +1980,10 @@ file_getc(FILE_T file)
     if (file->err != 0)
         return -1;
 
+    /* as in file_peekc() */
+    if (file->map != NULL && map_sync_fd(file) == -1)
+        return -1;
+
     /* try output buffer (no need to check for skip request) */
     if (file->out.avail != 0) {
         file->out.avail--;
@@ -1790,6 +2011,10 @@ file_getsp(char *buf, int len, FILE_T file)
     if (file->err != 0)
         return NULL;
 
+    /* lines are read through the buffers, even in a mapped file */
+    if (file->map != NULL && map_sync_fd(file) == -1)
+        return NULL;
+
     /* process a skip request */
     if (file->seek_pending) {
         file->seek_pending = FALSE;
@@ -1854,6 +2079,11 @@ file_gets(char *buf, int len, FILE_T file)
 int
 file_eof(FILE_T file)
 {
+    /* in a mapped file, we've only seen the end if we've read past
+       the mapping through the file descriptor */
+    if (file->map != NULL && !file->map_fd_valid)
+        return 0;
+
     /* return end-of-file state */
     return (file->eof && file->in.avail == 0 && file->out.avail == 0);
 }
@@ -1898,9 +2128,28 @@ file_fdreopen(FILE_T file, const char *path)
     if ((fd = ws_open(path, O_RDONLY|O_BINARY, 0000)) == -1)
         return FALSE;
     file->fd = fd;
+
+    if (file->map != NULL) {
+        /*
+         * The mapping is of the file we had open before; read the
+         * new one through the file descriptor, from the same place.
+         */
+        buf_reset(&file->out);
+        buf_reset(&file->in);
+        file->map_fd_valid = FALSE;
+        if (map_retire(file) == -1)
+            return FALSE;
+    }
     return TRUE;
 }
 
+void
+file_unmap(FILE_T file)
+{
+    if (file->map != NULL)
+        map_retire(file);
+}
+
 void
 file_close(FILE_T file)
 {
@@ -1921,6 +2170,9 @@ file_close(FILE_T file)
         g_free(file->in.buf);
     }
     g_free(file->fast_seek_cur);
+    if (file->map != NULL)
+        g_mapped_file_unref(file->map);
+    g_slist_free_full(file->map_retired, (GDestroyNotify)g_mapped_file_unref);
     file->err = 0;
     file->err_info = NULL;
     g_free(file);
@@ -22,6 +22,18 @@ extern gint64 file_tell_raw(FILE_T stream);
 extern int file_fstat(FILE_T stream, ws_statb64 *statb, int *err);
 WS_DLL_PUBLIC gboolean file_iscompressed(FILE_T stream);
 WS_DLL_PUBLIC int file_read(void *buf, unsigned int count, FILE_T file);
+/*
+ * If the stream is memory-mapped, and the count bytes at the current
+ * position are all in the mapping and still in the file, return a
+ * pointer to them, valid until the stream is closed, and move past
+ * them; otherwise return NULL without moving.
+ *
+ * If another process truncates the file, touching data handed out
+ * before that, past the new end of the file, raises SIGBUS; we only
+ * notice the truncation when reading.
+ */
+extern const guint8 *file_read_mapped(FILE_T file, unsigned int count);
+extern gboolean file_is_mapped(FILE_T stream);
 WS_DLL_PUBLIC int file_peekc(FILE_T stream);
 WS_DLL_PUBLIC int file_getc(FILE_T stream);
 WS_DLL_PUBLIC char *file_gets(char *buf, int len, FILE_T stream);
@@ -31,6 +43,12 @@ WS_DLL_PUBLIC int file_error(FILE_T fh, gchar **err_info);
 extern void file_clearerr(FILE_T stream);
 extern void file_fdclose(FILE_T file);
 extern int file_fdreopen(FILE_T file, const char *path);
+/*
+ * Stop reading the stream through a memory mapping, if it has one,
+ * e.g. because the file is still being written.  Data already handed
+ * out by file_read_mapped() stays valid.
+ */
+extern void file_unmap(FILE_T file);
 extern void file_close(FILE_T file);
 
 #ifdef HAVE_ZLIB
@@ -0,0 +1,550 @@
+/* flow_key.c
+ * Routines that find the flow a packet belongs to without dissecting it.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#include "flow_key.h"
+
+#include <string.h>
+
+#include <wsutil/pint.h>
+
+/*
+ * This is a quick look at the headers, for when running the dissectors
+ * would cost too much: it follows only the common encapsulations, and
+ * it believes what the headers say without checking much more than
+ * that they were captured.  Every read is checked against the captured
+ * length, and every loop moves forward through the packet, so it is
+ * safe on any data.
+ *
+ * libwiretap can't use the epan definitions, so we have our own.
+ */
+#define ETHERTYPE_IP            0x0800
+#define ETHERTYPE_ETHBRIDGE     0x6558  /* in GRE, Ethernet follows */
+#define ETHERTYPE_VLAN          0x8100
+#define ETHERTYPE_IPv6          0x86dd
+#define ETHERTYPE_MPLS          0x8847
+#define ETHERTYPE_MPLS_MULTI    0x8848
+#define ETHERTYPE_PPPOES        0x8864
+#define ETHERTYPE_IEEE_802_1AD  0x88a8
+#define ETHERTYPE_QINQ_OLD      0x9100
+
+#define PPP_IP                  0x0021
+#define PPP_IPV6                0x0057
+
+#define IP_PROTO_HOPOPTS        0
+#define IP_PROTO_IPIP           4
+#define IP_PROTO_TCP            6
+#define IP_PROTO_UDP            17
+#define IP_PROTO_DCCP           33
+#define IP_PROTO_IPV6           41
+#define IP_PROTO_ROUTING        43
+#define IP_PROTO_FRAGMENT       44
+#define IP_PROTO_GRE            47
+#define IP_PROTO_AH             51
+#define IP_PROTO_DSTOPTS        60
+#define IP_PROTO_SCTP           132
+#define IP_PROTO_UDPLITE        136
+
+#define UDP_PORT_GTPU           2152
+#define UDP_PORT_VXLAN          4789
+
+/* Address families in BSD loopback headers. AF_INET6 differs by OS. */
+#define BSD_AF_INET             2
+#define LINUX_AF_INET6          10
+#define BSD_AF_INET6_BSD        24      /* NetBSD, OpenBSD */
+#define BSD_AF_INET6_FREEBSD    28
+#define BSD_AF_INET6_DARWIN     30
+
+/* Tunnels nested deeper than this aren't looked into. */
+#define MAX_TUNNEL_DEPTH        4
+/* Nor are IPv6 extension headers past this many. */
+#define MAX_IPV6_EXT_HEADERS    8
+
+typedef struct {
+    const uint8_t *pd;
+    uint32_t caplen;
+} flow_packet_t;
+
+static bool get_ethertype(const flow_packet_t *p, uint16_t ethertype,
+        uint32_t offset, wtap_flow_key_t *key);
+
+/* Were len bytes at offset captured? */
+static inline bool
+have_bytes(const flow_packet_t *p, uint32_t offset, uint32_t len)
+{
+    return offset <= p->caplen && len <= p->caplen - offset;
+}
+
+static bool
+get_ethernet(const flow_packet_t *p, uint32_t offset, wtap_flow_key_t *key)
+{
+    if (!have_bytes(p, offset, 14))
+        return false;
+    return get_ethertype(p, pntoh16(p->pd + offset + 12), offset + 14, key);
+}
+
+/*
+ * Get the key of the packet inside a tunnel, whose type is given by an
+ * Ethernet type.  If there's no key to be had from it, the key stays
+ * that of the outer packet.
+ */
+static bool
+get_tunneled(const flow_packet_t *p, uint16_t ethertype, uint32_t offset,
+        wtap_flow_key_t *key)
+{
+    wtap_flow_key_t inner;
+    bool found;
+
+    if (key->tunnel_depth >= MAX_TUNNEL_DEPTH)
+        return false;
+    inner = *key;
+    inner.tunnel_depth++;
+    inner.flags |= WTAP_FLOW_KEY_TUNNELED;
+    if (ethertype == ETHERTYPE_ETHBRIDGE)
+        found = get_ethernet(p, offset, &inner);
+    else
+        found = get_ethertype(p, ethertype, offset, &inner);
+    if (found)
+        *key = inner;
+    return found;
+}
+
+static void
+get_gre(const flow_packet_t *p, uint32_t offset, wtap_flow_key_t *key)
+{
+    uint16_t flags, ethertype;
+
+    if (!have_bytes(p, offset, 4))
+        return;
+    flags = pntoh16(p->pd + offset);
+    ethertype = pntoh16(p->pd + offset + 2);
+    /* Version 0 only, without the obsolete source routing. */
+    if (flags & 0x4007)
+        return;
+    if (flags & 0x8000)         /* checksum */
+        offset += 4;
+    if (flags & 0x2000)         /* key */
+        offset += 4;
+    if (flags & 0x1000)         /* sequence number */
+        offset += 4;
+    get_tunneled(p, ethertype, offset + 4, key);
+}
+
+static void
+get_vxlan(const flow_packet_t *p, uint32_t offset, wtap_flow_key_t *key)
+{
+    /* The I flag says the VNI is valid. */
+    if (!have_bytes(p, offset, 8) || !(p->pd[offset] & 0x08))
+        return;
+    get_tunneled(p, ETHERTYPE_ETHBRIDGE, offset + 8, key);
+}
+
+static void
+get_gtpu(const flow_packet_t *p, uint32_t offset, wtap_flow_key_t *key)
+{
+    uint8_t flags, next_ext;
+    uint32_t ext_len;
+
+    /* Only GTPv1 G-PDUs carry user packets. */
+    if (!have_bytes(p, offset, 8))
+        return;
+    flags = p->pd[offset];
+    if ((flags & 0xf0) != 0x30 || p->pd[offset + 1] != 0xff)
+        return;
+    offset += 8;
+    if (flags & 0x07) {
+        /* The sequence number, N-PDU number and next extension
+         * header type are all there if any of them is. */
+        if (!have_bytes(p, offset, 4))
+            return;
+        next_ext = p->pd[offset + 3];
+        offset += 4;
+        while (next_ext != 0) {
+            if (!have_bytes(p, offset, 1))
+                return;
+            ext_len = p->pd[offset] * 4;
+            if (ext_len == 0 || !have_bytes(p, offset, ext_len))
+                return;
+            next_ext = p->pd[offset + ext_len - 1];
+            offset += ext_len;
+        }
+    }
+    if (!have_bytes(p, offset, 1))
+        return;
+    switch (p->pd[offset] >> 4) {
+
+    case 4:
+        get_tunneled(p, ETHERTYPE_IP, offset, key);
+        break;
+
+    case 6:
+        get_tunneled(p, ETHERTYPE_IPv6, offset, key);
+        break;
+    }
+}
+
+/* Get the ports, given the IP protocol and the transport header offset. */
+static void
+get_transport(const flow_packet_t *p, wtap_flow_key_t *key)
+{
+    uint32_t offset = key->l4_offset;
+    uint32_t hlen = 0;
+
+    switch (key->ip_proto) {
+
+    case IP_PROTO_IPIP:
+        get_tunneled(p, ETHERTYPE_IP, offset, key);
+        return;
+
+    case IP_PROTO_IPV6:
+        get_tunneled(p, ETHERTYPE_IPv6, offset, key);
+        return;
+
+    case IP_PROTO_GRE:
+        get_gre(p, offset, key);
+        return;
+
+    case IP_PROTO_TCP:
+    case IP_PROTO_UDP:
+    case IP_PROTO_UDPLITE:
+    case IP_PROTO_SCTP:
+    case IP_PROTO_DCCP:
+        break;
+
+    default:
+        return;
+    }
+
+    /* All of these start with the two ports. */
+    if (!have_bytes(p, offset, 4))
+        return;
+    key->src_port = pntoh16(p->pd + offset);
+    key->dst_port = pntoh16(p->pd + offset + 2);
+    key->flags |= WTAP_FLOW_KEY_PORTS;
+
+    switch (key->ip_proto) {
+
+    case IP_PROTO_TCP:
+        if (have_bytes(p, offset, 13))
+            hlen = (p->pd[offset + 12] >> 4) * 4;
+        if (hlen < 20)
+            return;
+        break;
+
+    case IP_PROTO_DCCP:
+        if (have_bytes(p, offset, 5))
+            hlen = p->pd[offset + 4] * 4;
+        if (hlen < 12)
+            return;
+        break;
+
+    case IP_PROTO_SCTP:
+        hlen = 12;
+        break;
+
+    default:
+        hlen = 8;
+        break;
+    }
+    if (!have_bytes(p, offset, hlen))
+        return;
+    key->payload_offset = offset + hlen;
+
+    if (key->ip_proto == IP_PROTO_UDP) {
+        if (key->dst_port == UDP_PORT_VXLAN)
+            get_vxlan(p, key->payload_offset, key);
+        else if (key->dst_port == UDP_PORT_GTPU || key->src_port == UDP_PORT_GTPU)
+            get_gtpu(p, key->payload_offset, key);
+    }
+}
+
+static void
+clear_ip(wtap_flow_key_t *key, uint32_t offset)
+{
+    memset(key->src, 0, sizeof key->src);
+    memset(key->dst, 0, sizeof key->dst);
+    key->src_port = 0;
+    key->dst_port = 0;
+    key->flags &= ~(WTAP_FLOW_KEY_PORTS|WTAP_FLOW_KEY_FRAGMENT);
+    key->l3_offset = offset;
+    key->payload_offset = 0;
+}
+
+static bool
+get_ipv4(const flow_packet_t *p, uint32_t offset, wtap_flow_key_t *key)
+{
+    const uint8_t *ip;
+    uint32_t hlen;
+
+    if (!have_bytes(p, offset, 20))
+        return false;
+    ip = p->pd + offset;
+    hlen = (ip[0] & 0x0f) * 4;
+    if ((ip[0] >> 4) != 4 || hlen < 20)
+        return false;
+
+    clear_ip(key, offset);
+    memcpy(key->src, ip + 12, 4);
+    memcpy(key->dst, ip + 16, 4);
+    key->addr_len = 4;
+    key->ip_proto = ip[9];
+    key->l4_offset = offset + hlen;
+
+    /* Only the first fragment has the transport header, and we want
+     * all of them to have the same key. */
+    if (pntoh16(ip + 6) & 0x3fff) {
+        key->flags |= WTAP_FLOW_KEY_FRAGMENT;
+        return true;
+    }
+    get_transport(p, key);
+    return true;
+}
+
+static bool
+get_ipv6(const flow_packet_t *p, uint32_t offset, wtap_flow_key_t *key)
+{
+    const uint8_t *ip;
+    uint8_t nxt;
+    uint32_t ext_len;
+    unsigned i;
+
+    if (!have_bytes(p, offset, 40))
+        return false;
+    ip = p->pd + offset;
+    if ((ip[0] >> 4) != 6)
+        return false;
+
+    clear_ip(key, offset);
+    memcpy(key->src, ip + 8, 16);
+    memcpy(key->dst, ip + 24, 16);
+    key->addr_len = 16;
+    nxt = ip[6];
+    offset += 40;
+
+    /* Skip the extension headers. */
+    for (i = 0; ; i++) {
+        key->ip_proto = nxt;
+        key->l4_offset = offset;
+        switch (nxt) {
+
+        case IP_PROTO_HOPOPTS:
+        case IP_PROTO_ROUTING:
+        case IP_PROTO_DSTOPTS:
+        case IP_PROTO_AH:
+        case IP_PROTO_FRAGMENT:
+            break;
+
+        default:
+            get_transport(p, key);
+            return true;
+        }
+
+        /* If we can't get past it, the key stops here. */
+        if (i == MAX_IPV6_EXT_HEADERS || !have_bytes(p, offset, 8))
+            return true;
+        if (nxt == IP_PROTO_FRAGMENT) {
+            /* A fragment offset or the M flag; as for IPv4. */
+            if (pntoh16(p->pd + offset + 2) & 0xfff9) {
+                key->ip_proto = p->pd[offset];
+                key->l4_offset = offset + 8;
+                key->flags |= WTAP_FLOW_KEY_FRAGMENT;
+                return true;
+            }
+            ext_len = 8;
+        } else if (nxt == IP_PROTO_AH) {
+            ext_len = (p->pd[offset + 1] + 2) * 4;
+        } else {
+            ext_len = (p->pd[offset + 1] + 1) * 8;
+        }
+        nxt = p->pd[offset];
+        offset += ext_len;
+    }
+}
+
+static bool
+get_ethertype(const flow_packet_t *p, uint16_t ethertype, uint32_t offset,
+        wtap_flow_key_t *key)
+{
+    uint32_t label;
+
+    while (ethertype == ETHERTYPE_VLAN || ethertype == ETHERTYPE_IEEE_802_1AD ||
+            ethertype == ETHERTYPE_QINQ_OLD) {
+        if (!have_bytes(p, offset, 4))
+            return false;
+        if (!(key->flags & WTAP_FLOW_KEY_VLAN)) {
+            key->vlan_id = pntoh16(p->pd + offset) & 0x0fff;
+            key->flags |= WTAP_FLOW_KEY_VLAN;
+        }
+        ethertype = pntoh16(p->pd + offset + 2);
+        offset += 4;
+    }
+
+    switch (ethertype) {
+
+    case ETHERTYPE_IP:
+        return get_ipv4(p, offset, key);
+
+    case ETHERTYPE_IPv6:
+        return get_ipv6(p, offset, key);
+
+    case ETHERTYPE_MPLS:
+    case ETHERTYPE_MPLS_MULTI:
+        /* Pop labels down to the bottom of the stack, and then guess
+         * what follows from its first nibble. */
+        do {
+            if (!have_bytes(p, offset, 4))
+                return false;
+            label = pntoh32(p->pd + offset);
+            offset += 4;
+        } while (!(label & 0x100));
+        if (!have_bytes(p, offset, 1))
+            return false;
+        switch (p->pd[offset] >> 4) {
+
+        case 4:
+            return get_ipv4(p, offset, key);
+
+        case 6:
+            return get_ipv6(p, offset, key);
+
+        case 0:
+            /* A pseudowire control word, and then Ethernet. */
+            return get_tunneled(p, ETHERTYPE_ETHBRIDGE, offset + 4, key);
+        }
+        return false;
+
+    case ETHERTYPE_PPPOES:
+        if (!have_bytes(p, offset, 8))
+            return false;
+        switch (pntoh16(p->pd + offset + 6)) {
+
+        case PPP_IP:
+            return get_ipv4(p, offset + 8, key);
+
+        case PPP_IPV6:
+            return get_ipv6(p, offset + 8, key);
+        }
+        return false;
+    }
+    return false;
+}
+
+bool
+wtap_flow_key_get(const wtap_rec *rec, const uint8_t *pd, wtap_flow_key_t *key)
+{
+    flow_packet_t p;
+    uint32_t family;
+
+    memset(key, 0, sizeof *key);
+    if (rec->rec_type != REC_TYPE_PACKET)
+        return false;
+    p.pd = pd;
+    p.caplen = rec->rec_header.packet_header.caplen;
+
+    switch (rec->rec_header.packet_header.pkt_encap) {
+
+    case WTAP_ENCAP_ETHERNET:
+        return get_ethernet(&p, 0, key);
+
+    case WTAP_ENCAP_SLL:
+        if (!have_bytes(&p, 0, 16))
+            return false;
+        return get_ethertype(&p, pntoh16(pd + 14), 16, key);
+
+    case WTAP_ENCAP_SLL2:
+        if (!have_bytes(&p, 0, 20))
+            return false;
+        return get_ethertype(&p, pntoh16(pd), 20, key);
+
+    case WTAP_ENCAP_NULL:
+    case WTAP_ENCAP_LOOP:
+        /* The address family, in whichever byte order it's in. */
+        if (!have_bytes(&p, 0, 4))
+            return false;
+        family = pntoh32(pd);
+        if (family > 0xffff)
+            family = pletoh32(pd);
+        switch (family) {
+
+        case BSD_AF_INET:
+            return get_ipv4(&p, 4, key);
+
+        case LINUX_AF_INET6:
+        case BSD_AF_INET6_BSD:
+        case BSD_AF_INET6_FREEBSD:
+        case BSD_AF_INET6_DARWIN:
+            return get_ipv6(&p, 4, key);
+        }
+        return false;
+
+    case WTAP_ENCAP_RAW_IP:
+        if (!have_bytes(&p, 0, 1))
+            return false;
+        if ((pd[0] >> 4) == 6)
+            return get_ipv6(&p, 0, key);
+        return get_ipv4(&p, 0, key);
+
+    case WTAP_ENCAP_RAW_IP4:
+        return get_ipv4(&p, 0, key);
+
+    case WTAP_ENCAP_RAW_IP6:
+        return get_ipv6(&p, 0, key);
+    }
+    return false;
+}
+
+uint32_t
+wtap_flow_key_hash(const wtap_flow_key_t *key)
+{
+    const uint8_t *addr_a = key->src, *addr_b = key->dst, *addr_tmp;
+    uint16_t port_a = key->src_port, port_b = key->dst_port, port_tmp;
+    uint32_t hash = 2166136261U;
+    unsigned i;
+    int cmp;
+
+    if (key->addr_len == 0)
+        return 0;
+
+    /* Put the endpoints in the same order for both directions. */
+    cmp = memcmp(addr_a, addr_b, key->addr_len);
+    if (cmp > 0 || (cmp == 0 && port_a > port_b)) {
+        addr_tmp = addr_a;
+        addr_a = addr_b;
+        addr_b = addr_tmp;
+        port_tmp = port_a;
+        port_a = port_b;
+        port_b = port_tmp;
+    }
+
+    /* FNV-1a */
+    for (i = 0; i < key->addr_len; i++)
+        hash = (hash ^ addr_a[i]) * 16777619U;
+    for (i = 0; i < key->addr_len; i++)
+        hash = (hash ^ addr_b[i]) * 16777619U;
+    hash = (hash ^ (port_a >> 8)) * 16777619U;
+    hash = (hash ^ (port_a & 0xff)) * 16777619U;
+    hash = (hash ^ (port_b >> 8)) * 16777619U;
+    hash = (hash ^ (port_b & 0xff)) * 16777619U;
+    hash = (hash ^ key->ip_proto) * 16777619U;
+    return hash;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
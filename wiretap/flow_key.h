@@ -0,0 +1,84 @@
+/** @file
+ * Definitions for routines that find the flow a packet belongs to
+ * without dissecting it.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __FLOW_KEY_H__
+#define __FLOW_KEY_H__
+
+#include "wiretap/wtap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define WTAP_FLOW_KEY_PORTS     0x01    /* src_port and dst_port are set */
+#define WTAP_FLOW_KEY_FRAGMENT  0x02    /* an IP fragment; there are no ports */
+#define WTAP_FLOW_KEY_TUNNELED  0x04    /* the key is from a tunneled packet */
+#define WTAP_FLOW_KEY_VLAN      0x08    /* vlan_id is set */
+
+/**
+ * The network and transport endpoints of a packet, and where its
+ * headers start. For a tunneled packet (GRE, VXLAN, GTP-U, IP in IP)
+ * the key is that of the innermost packet whose IP header is present.
+ */
+typedef struct wtap_flow_key_s {
+    uint8_t  src[16];           /* source address; the first addr_len bytes are used */
+    uint8_t  dst[16];           /* destination address */
+    uint8_t  addr_len;          /* 4 for IPv4, 16 for IPv6 */
+    uint8_t  ip_proto;          /* transport protocol, after any IPv6 extension headers */
+    uint8_t  flags;             /* WTAP_FLOW_KEY_ flags */
+    uint8_t  tunnel_depth;      /* number of tunnels the packet is in */
+    uint16_t src_port;
+    uint16_t dst_port;
+    uint16_t vlan_id;           /* first VLAN ID in the packet */
+    uint32_t l3_offset;         /* offset of the IP header */
+    uint32_t l4_offset;         /* offset of the transport header */
+    uint32_t payload_offset;    /* offset of the transport payload, or 0 if not captured */
+} wtap_flow_key_t;
+
+/**
+ * Find the flow key of a packet from a quick look at its headers.
+ * Handles Ethernet (with VLAN tags, MPLS and PPPoE), Linux cooked
+ * captures, BSD loopback and raw IP, IPv4 and IPv6 with extension
+ * headers, TCP, UDP, UDP-Lite, SCTP and DCCP, and GRE, VXLAN, GTP-U
+ * and IP in IP tunnels. Nothing is allocated.
+ *
+ * @param rec The record.
+ * @param pd The record's data.
+ * @param[out] key Set to the key.
+ * @return true if an IP header was found, false if the key is empty.
+ */
+WS_DLL_PUBLIC
+bool wtap_flow_key_get(const wtap_rec *rec, const uint8_t *pd, wtap_flow_key_t *key);
+
+/**
+ * Hash a flow key, the same way for both directions of the flow.
+ */
+WS_DLL_PUBLIC
+uint32_t wtap_flow_key_hash(const wtap_flow_key_t *key);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __FLOW_KEY_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
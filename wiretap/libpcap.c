@@ -68,8 +68,12 @@ static gboolean libpcap_read(wtap *wth, wtap_rec *rec, Buffer *buf,
     int *err, gchar **err_info, gint64 *data_offset);
 static gboolean libpcap_seek_read(wtap *wth, gint64 seek_off,
     wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
+static gboolean libpcap_seek_read_ptr(wtap *wth, gint64 seek_off,
+    wtap_rec *rec, Buffer *buf, const guint8 **data, int *err,
+    gchar **err_info);
 static gboolean libpcap_read_packet(wtap *wth, FILE_T fh,
-    wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
+    wtap_rec *rec, Buffer *buf, const guint8 **data, int *err,
+    gchar **err_info);
 static int libpcap_read_header(wtap *wth, FILE_T fh, int *err, gchar **err_info,
     struct pcaprec_ss990915_hdr *hdr);
 static void libpcap_close(wtap *wth);
@@ -295,6 +299,8 @@ wtap_open_return_val libpcap_open(wtap *wth, int *err, gchar **err_info)
 	/* This is a libpcap file */
 	wth->subtype_read = libpcap_read;
 	wth->subtype_seek_read = libpcap_seek_read;
+	wth->subtype_seek_read_ptr = libpcap_seek_read_ptr;
+	wth->subtype_read_appends = TRUE;
 	wth->subtype_close = libpcap_close;
 	wth->snapshot_length = hdr.snaplen;
 	libpcap = g_new0(libpcap_t, 1);
@@ -899,17 +905,25 @@ static gboolean libpcap_read(wtap *wth, wtap_rec *rec, Buffer *buf,
 {
 	*data_offset = file_tell(wth->fh);
 
-	return libpcap_read_packet(wth, wth->fh, rec, buf, err, err_info);
+	return libpcap_read_packet(wth, wth->fh, rec, buf, NULL, err, err_info);
 }
 
 static gboolean
 libpcap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
     Buffer *buf, int *err, gchar **err_info)
+{
+	return libpcap_seek_read_ptr(wth, seek_off, rec, buf, NULL, err,
+	    err_info);
+}
+
+static gboolean
+libpcap_seek_read_ptr(wtap *wth, gint64 seek_off, wtap_rec *rec,
+    Buffer *buf, const guint8 **data, int *err, gchar **err_info)
 {
 	if (file_seek(wth->random_fh, seek_off, SEEK_SET, err) == -1)
 		return FALSE;
 
-	if (!libpcap_read_packet(wth, wth->random_fh, rec, buf, err,
+	if (!libpcap_read_packet(wth, wth->random_fh, rec, buf, data, err,
 	    err_info)) {
 		if (*err == 0)
 			*err = WTAP_ERR_SHORT_READ;
@@ -920,9 +934,11 @@ libpcap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
 
 static gboolean
 libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
-    Buffer *buf, int *err, gchar **err_info)
+    Buffer *buf, const guint8 **data, int *err, gchar **err_info)
 {
 	struct pcaprec_ss990915_hdr hdr;
+	gsize data_start;
+	guint8 *pd;
 	guint packet_size;
 	guint orig_size;
 	int phdr_len;
@@ -1008,13 +1024,34 @@ libpcap_read_packet(wtap *wth, FILE_T fh, wtap_rec *rec,
 	rec->rec_header.packet_header.len = orig_size;
 
 	/*
-	 * Read the packet data.
+	 * Read the packet data.  If our caller can use it where it is
+	 * and we won't be modifying it, don't copy it if it's in a
+	 * memory-mapped region of the file.
 	 */
-	if (!wtap_read_packet_bytes(fh, buf, packet_size, err, err_info))
-		return FALSE;	/* failed */
+	if (data != NULL &&
+	    !pcap_read_post_process_modifies_data(wth->file_encap,
+	        libpcap->byte_swapped)) {
+		if (!wtap_read_packet_bytes_ptr(fh, buf, packet_size, data,
+		    err, err_info))
+			return FALSE;	/* failed */
+		pd = (guint8 *)*data;	/* only looked at, not modified */
+	} else {
+		/*
+		 * The data is appended to whatever's already in the
+		 * buffer, so that wtap_read_batch() can read a batch
+		 * of packets into the same buffer.
+		 */
+		data_start = ws_buffer_length(buf);
+		if (!wtap_read_packet_bytes(fh, buf, packet_size, err,
+		    err_info))
+			return FALSE;	/* failed */
+		pd = ws_buffer_start_ptr(buf) + data_start;
+		if (data != NULL)
+			*data = pd;
+	}
 
 	pcap_read_post_process(is_nokia, wth->file_encap, rec,
-	    ws_buffer_start_ptr(buf), libpcap->byte_swapped, libpcap->fcs_len);
+	    pd, libpcap->byte_swapped, libpcap->fcs_len);
 	return TRUE;
 }
 
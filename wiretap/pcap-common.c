@@ -2647,6 +2647,28 @@ pcap_read_post_process(gboolean is_nokia, int wtap_encap,
 	}
 }
 
+/*
+ * Returns TRUE if pcap_read_post_process() might modify the packet
+ * data, rather than just look at it, so that the data can't be used
+ * in place, e.g. in a memory-mapped file.
+ */
+gboolean
+pcap_read_post_process_modifies_data(int wtap_encap, gboolean bytes_swapped)
+{
+	switch (wtap_encap) {
+
+	case WTAP_ENCAP_SLL:
+	case WTAP_ENCAP_SLL2:
+	case WTAP_ENCAP_USB_LINUX:
+	case WTAP_ENCAP_USB_LINUX_MMAPPED:
+	case WTAP_ENCAP_NFLOG:
+	case WTAP_ENCAP_PFLOG:
+		/* These have their pseudo-headers byte-swapped in place. */
+		return bytes_swapped;
+	}
+	return FALSE;
+}
+
 gboolean
 wtap_encap_requires_phdr(int wtap_encap)
 {
@@ -48,8 +48,14 @@ pcapng_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 static gboolean
 pcapng_seek_read(wtap *wth, gint64 seek_off,
                  wtap_rec *rec, Buffer *buf, int *err, gchar **err_info);
+static gboolean
+pcapng_seek_read_ptr(wtap *wth, gint64 seek_off,
+                     wtap_rec *rec, Buffer *buf, const guint8 **data,
+                     int *err, gchar **err_info);
 static void
 pcapng_close(wtap *wth);
+static GArray *
+pcapng_get_trailing_if_stats(wtap *wth, int *err, gchar **err_info);
 
 static gboolean
 pcapng_encap_is_ft_specific(int encap);
@@ -857,7 +863,8 @@ pcapng_process_nflx_custom_option(wtapng_block_t *wblock,
         if (wblock->type == BLOCK_TYPE_CB_COPY) {
             ws_buffer_assure_space(wblock->frame_buffer, length);
             wblock->rec->rec_header.custom_block_header.length = length + 4;
-            memcpy(ws_buffer_start_ptr(wblock->frame_buffer), value, length);
+            memcpy(ws_buffer_end_ptr(wblock->frame_buffer), value, length);
+            ws_buffer_increase_length(wblock->frame_buffer, length);
             memcpy(&temp, value, sizeof(guint64));
             temp = GUINT64_FROM_LE(temp);
             wblock->rec->ts.secs = section_info->bblog_offset_tv_sec + temp;
@@ -1002,50 +1009,33 @@ pcapng_process_unhandled_option(wtapng_block_t *wblock _U_,
 }
 #endif
 
-gboolean
-pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
-                       section_info_t *section_info,
-                       guint opt_cont_buf_len,
-                       gboolean (*process_option)(wtapng_block_t *,
-                                                  const section_info_t *,
-                                                  guint16, guint16,
-                                                  const guint8 *,
-                                                  int *, gchar **),
-                       pcapng_opt_byte_order_e byte_order,
-                       int *err, gchar **err_info)
+/*
+ * Process options that have already been read into memory.
+ * option_content must be aligned on at least a 4-byte boundary.
+ */
+static gboolean
+pcapng_process_options_buffer(wtapng_block_t *wblock,
+                              section_info_t *section_info,
+                              const guint8 *option_content,
+                              guint opt_cont_buf_len,
+                              gboolean (*process_option)(wtapng_block_t *,
+                                                         const section_info_t *,
+                                                         guint16, guint16,
+                                                         const guint8 *,
+                                                         int *, gchar **),
+                              pcapng_opt_byte_order_e byte_order,
+                              int *err, gchar **err_info)
 {
-    guint8 *option_content; /* Allocate as large as the options block */
     guint opt_bytes_remaining;
     const guint8 *option_ptr;
     const pcapng_option_header_t *oh;
     guint16 option_code, option_length;
     guint rounded_option_length;
 
-    ws_debug("Options %u bytes", opt_cont_buf_len);
-    if (opt_cont_buf_len == 0) {
-        /* No options, so nothing to do */
-        return TRUE;
-    }
-
-    /* Allocate enough memory to hold all options */
-    option_content = (guint8 *)g_try_malloc(opt_cont_buf_len);
-    if (option_content == NULL) {
-        *err = ENOMEM;  /* we assume we're out of memory */
-        return FALSE;
-    }
-
-    /* Read all the options into the buffer */
-    if (!wtap_read_bytes(fh, option_content, opt_cont_buf_len, err, err_info)) {
-        ws_debug("failed to read options");
-        g_free(option_content);
-        return FALSE;
-    }
-
     /*
-     * Now process them.
-     * option_ptr starts out aligned on at least a 4-byte boundary, as
-     * that's what g_try_malloc() gives us, and each option is padded
-     * to a length that's a multiple of 4 bytes, so it remains aligned.
+     * option_ptr starts out aligned on at least a 4-byte boundary, and
+     * each option is padded to a length that's a multiple of 4 bytes,
+     * so it remains aligned.
      */
     option_ptr = &option_content[0];
     opt_bytes_remaining = opt_cont_buf_len;
@@ -1056,7 +1046,6 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
         if (sizeof (*oh) > opt_bytes_remaining) {
             *err = WTAP_ERR_BAD_FILE;
             *err_info = ws_strdup_printf("pcapng: Not enough data for option header");
-            g_free(option_content);
             return FALSE;
         }
         option_code = oh->option_code;
@@ -1098,7 +1087,6 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
             *err = WTAP_ERR_BAD_FILE;
             *err_info = ws_strdup_printf("pcapng: Not enough data to handle option of length %u",
                                         option_length);
-            g_free(option_content);
             return FALSE;
         }
 
@@ -1123,7 +1111,6 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
                                                   option_ptr,
                                                   byte_order,
                                                   err, err_info)) {
-                    g_free(option_content);
                     return FALSE;
                 }
                 break;
@@ -1133,17 +1120,62 @@ pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
                     !(*process_option)(wblock, (const section_info_t *)section_info, option_code,
                                        option_length, option_ptr,
                                        err, err_info)) {
-                    g_free(option_content);
                     return FALSE;
                 }
         }
         option_ptr += rounded_option_length; /* multiple of 4 bytes, so it remains aligned */
         opt_bytes_remaining -= rounded_option_length;
     }
-    g_free(option_content);
     return TRUE;
 }
 
+gboolean
+pcapng_process_options(FILE_T fh, wtapng_block_t *wblock,
+                       section_info_t *section_info,
+                       guint opt_cont_buf_len,
+                       gboolean (*process_option)(wtapng_block_t *,
+                                                  const section_info_t *,
+                                                  guint16, guint16,
+                                                  const guint8 *,
+                                                  int *, gchar **),
+                       pcapng_opt_byte_order_e byte_order,
+                       int *err, gchar **err_info)
+{
+    guint8 *option_content; /* Allocate as large as the options block */
+    gboolean ret;
+
+    ws_debug("Options %u bytes", opt_cont_buf_len);
+    if (opt_cont_buf_len == 0) {
+        /* No options, so nothing to do */
+        return TRUE;
+    }
+
+    /* Allocate enough memory to hold all options */
+    option_content = (guint8 *)g_try_malloc(opt_cont_buf_len);
+    if (option_content == NULL) {
+        *err = ENOMEM;  /* we assume we're out of memory */
+        return FALSE;
+    }
+
+    /* Read all the options into the buffer */
+    if (!wtap_read_bytes(fh, option_content, opt_cont_buf_len, err, err_info)) {
+        ws_debug("failed to read options");
+        g_free(option_content);
+        return FALSE;
+    }
+
+    /*
+     * Now process them.
+     * g_try_malloc() gives us memory aligned on at least a 4-byte
+     * boundary.
+     */
+    ret = pcapng_process_options_buffer(wblock, section_info, option_content,
+                                        opt_cont_buf_len, process_option,
+                                        byte_order, err, err_info);
+    g_free(option_content);
+    return ret;
+}
+
 typedef enum {
     PCAPNG_BLOCK_OK,
     PCAPNG_BLOCK_NOT_SHB,
@@ -1886,6 +1918,96 @@ pcapng_read_meta_event_block(FILE_T fh, pcapng_block_header_t *bh,
     return true;
 }
 
+/*
+ * Check that a packet block option is long enough to be processed
+ * by pcapng_process_packet_block_option().  This is done separately
+ * so that pcapng_read_packet_block() can check the options of a block
+ * without processing them.
+ */
+static gboolean
+pcapng_check_packet_block_option(guint16 option_code,
+                                 guint16 option_length,
+                                 const guint8 *option_content,
+                                 int *err, gchar **err_info)
+{
+    switch (option_code) {
+        case(OPT_EPB_FLAGS):
+            if (option_length != 4) {
+                *err = WTAP_ERR_BAD_FILE;
+                *err_info = ws_strdup_printf("pcapng: packet block flags option length %u is not 4",
+                                            option_length);
+                return FALSE;
+            }
+            break;
+        case(OPT_EPB_HASH):
+            if (option_length < 1) {
+                *err = WTAP_ERR_BAD_FILE;
+                *err_info = ws_strdup_printf("pcapng: packet block hash option length %u is < 1",
+                                            option_length);
+                return FALSE;
+            }
+            break;
+        case(OPT_EPB_DROPCOUNT):
+            if (option_length != 8) {
+                *err = WTAP_ERR_BAD_FILE;
+                *err_info = ws_strdup_printf("pcapng: packet block drop count option length %u is not 8",
+                                            option_length);
+                return FALSE;
+            }
+            break;
+        case(OPT_EPB_PACKETID):
+            if (option_length != 8) {
+                *err = WTAP_ERR_BAD_FILE;
+                *err_info = ws_strdup_printf("pcapng: packet block packet id option length %u is not 8",
+                                            option_length);
+                return FALSE;
+            }
+            break;
+        case(OPT_EPB_QUEUE):
+            if (option_length != 4) {
+                *err = WTAP_ERR_BAD_FILE;
+                *err_info = ws_strdup_printf("pcapng: packet block queue option length %u is not 4",
+                                            option_length);
+                return FALSE;
+            }
+            break;
+        case(OPT_EPB_VERDICT):
+            if (option_length < 1) {
+                *err = WTAP_ERR_BAD_FILE;
+                *err_info = ws_strdup_printf("pcapng: packet block verdict option length %u is < 1",
+                                            option_length);
+                return FALSE;
+            }
+            switch (option_content[0]) {
+
+                case(OPT_VERDICT_TYPE_TC):
+                    if (option_length != 9) {
+                        *err = WTAP_ERR_BAD_FILE;
+                        *err_info = ws_strdup_printf("pcapng: packet block TC verdict option length %u is != 9",
+                                                    option_length);
+                        return FALSE;
+                    }
+                    break;
+
+                case(OPT_VERDICT_TYPE_XDP):
+                    if (option_length != 9) {
+                        *err = WTAP_ERR_BAD_FILE;
+                        *err_info = ws_strdup_printf("pcapng: packet block XDP verdict option length %u is != 9",
+                                                    option_length);
+                        return FALSE;
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+            break;
+        default:
+            break;
+    }
+    return TRUE;
+}
+
 static gboolean
 pcapng_process_packet_block_option(wtapng_block_t *wblock,
                                    const section_info_t *section_info,
@@ -1898,6 +2020,10 @@ pcapng_process_packet_block_option(wtapng_block_t *wblock,
     packet_verdict_opt_t packet_verdict;
     packet_hash_opt_t packet_hash;
 
+    if (!pcapng_check_packet_block_option(option_code, option_length,
+                                          option_content, err, err_info))
+        return FALSE;
+
     /*
      * Handle option content.
      *
@@ -1917,26 +2043,12 @@ pcapng_process_packet_block_option(wtapng_block_t *wblock,
      */
     switch (option_code) {
         case(OPT_EPB_FLAGS):
-            if (option_length != 4) {
-                *err = WTAP_ERR_BAD_FILE;
-                *err_info = ws_strdup_printf("pcapng: packet block flags option length %u is not 4",
-                                            option_length);
-                /* XXX - free anything? */
-                return FALSE;
-            }
             pcapng_process_uint32_option(wblock, section_info,
                                          OPT_SECTION_BYTE_ORDER,
                                          option_code, option_length,
                                          option_content);
             break;
         case(OPT_EPB_HASH):
-            if (option_length < 1) {
-                *err = WTAP_ERR_BAD_FILE;
-                *err_info = ws_strdup_printf("pcapng: packet block hash option length %u is < 1",
-                                            option_length);
-                /* XXX - free anything? */
-                return FALSE;
-            }
             packet_hash.type = option_content[0];
             packet_hash.hash_bytes =
                 g_byte_array_new_take((guint8 *)g_memdup2(&option_content[1],
@@ -1948,52 +2060,24 @@ pcapng_process_packet_block_option(wtapng_block_t *wblock,
                      option_content[0], option_length - 1);
             break;
         case(OPT_EPB_DROPCOUNT):
-            if (option_length != 8) {
-                *err = WTAP_ERR_BAD_FILE;
-                *err_info = ws_strdup_printf("pcapng: packet block drop count option length %u is not 8",
-                                            option_length);
-                /* XXX - free anything? */
-                return FALSE;
-            }
             pcapng_process_uint64_option(wblock, section_info,
                                          OPT_SECTION_BYTE_ORDER,
                                          option_code, option_length,
                                          option_content);
             break;
         case(OPT_EPB_PACKETID):
-            if (option_length != 8) {
-                *err = WTAP_ERR_BAD_FILE;
-                *err_info = ws_strdup_printf("pcapng: packet block packet id option length %u is not 8",
-                                            option_length);
-                /* XXX - free anything? */
-                return FALSE;
-            }
             pcapng_process_uint64_option(wblock, section_info,
                                          OPT_SECTION_BYTE_ORDER,
                                          option_code, option_length,
                                          option_content);
             break;
         case(OPT_EPB_QUEUE):
-            if (option_length != 4) {
-                *err = WTAP_ERR_BAD_FILE;
-                *err_info = ws_strdup_printf("pcapng: packet block queue option length %u is not 4",
-                                            option_length);
-                /* XXX - free anything? */
-                return FALSE;
-            }
             pcapng_process_uint32_option(wblock, section_info,
                                          OPT_SECTION_BYTE_ORDER,
                                          option_code, option_length,
                                          option_content);
             break;
         case(OPT_EPB_VERDICT):
-            if (option_length < 1) {
-                *err = WTAP_ERR_BAD_FILE;
-                *err_info = ws_strdup_printf("pcapng: packet block verdict option length %u is < 1",
-                                            option_length);
-                /* XXX - free anything? */
-                return FALSE;
-            }
             switch (option_content[0]) {
 
                 case(OPT_VERDICT_TYPE_HW):
@@ -2005,13 +2089,6 @@ pcapng_process_packet_block_option(wtapng_block_t *wblock,
                     break;
 
                 case(OPT_VERDICT_TYPE_TC):
-                    if (option_length != 9) {
-                        *err = WTAP_ERR_BAD_FILE;
-                        *err_info = ws_strdup_printf("pcapng: packet block TC verdict option length %u is != 9",
-                                                    option_length);
-                        /* XXX - free anything? */
-                        return FALSE;
-                    }
                     /*  Don't cast a guint8 * into a guint64 *--the
                      *  guint8 * may not point to something that's
                      *  aligned correctly.
@@ -2024,13 +2101,6 @@ pcapng_process_packet_block_option(wtapng_block_t *wblock,
                     break;
 
                 case(OPT_VERDICT_TYPE_XDP):
-                    if (option_length != 9) {
-                        *err = WTAP_ERR_BAD_FILE;
-                        *err_info = ws_strdup_printf("pcapng: packet block XDP verdict option length %u is != 9",
-                                                    option_length);
-                        /* XXX - free anything? */
-                        return FALSE;
-                    }
                     /*  Don't cast a guint8 * into a guint64 *--the
                      *  guint8 * may not point to something that's
                      *  aligned correctly.
@@ -2062,6 +2132,144 @@ pcapng_process_packet_block_option(wtapng_block_t *wblock,
     return TRUE;
 }
 
+/*
+ * Options of a packet block whose decoding has been deferred with
+ * wtap_rec_lend_options_buf().  The options, as they are in the
+ * file, follow this structure; its size is a multiple of 4, so they
+ * are aligned on a 4-byte boundary.
+ */
+typedef struct {
+    gboolean byte_swapped;      /* section_info->byte_swapped */
+    guint    options_len;
+} pcapng_deferred_options_t;
+
+static void
+pcapng_decode_packet_block_options(wtap_block_t block, void *raw_options)
+{
+    pcapng_deferred_options_t *deferred = (pcapng_deferred_options_t *)raw_options;
+    wtapng_block_t wblock;
+    section_info_t section_info;
+    int err;
+    gchar *err_info = NULL;
+
+    memset(&wblock, 0, sizeof(wblock));
+    wblock.type = BLOCK_TYPE_EPB;
+    wblock.block = block;
+    memset(&section_info, 0, sizeof(section_info));
+    section_info.byte_swapped = deferred->byte_swapped;
+
+    /*
+     * pcapng_read_packet_block() checked the options, and doesn't
+     * defer any whose processing could fail.
+     */
+    if (!pcapng_process_options_buffer(&wblock, &section_info,
+                                       (const guint8 *)(deferred + 1),
+                                       deferred->options_len,
+                                       pcapng_process_packet_block_option,
+                                       OPT_SECTION_BYTE_ORDER,
+                                       &err, &err_info)) {
+        ws_warning("pcapng: deferred packet block options: %s",
+                   err_info != NULL ? err_info : "unknown error");
+        g_free(err_info);
+    }
+}
+
+/*
+ * Check the options of a packet block, which have been read into memory,
+ * without processing them, and get the packet flags, which we need to
+ * process the packet data.  Sets *must_process if processing them later
+ * would not do the same thing as processing them now.
+ */
+static gboolean
+pcapng_scan_packet_block_options(const section_info_t *section_info,
+                                 const guint8 *option_content,
+                                 guint opt_cont_buf_len,
+                                 gboolean *have_flags, guint32 *flags,
+                                 gboolean *must_process,
+                                 int *err, gchar **err_info)
+{
+    guint opt_bytes_remaining;
+    const guint8 *option_ptr;
+    const pcapng_option_header_t *oh;
+    guint16 option_code, option_length;
+    guint rounded_option_length;
+    guint32 pen;
+
+    *have_flags = FALSE;
+    *must_process = FALSE;
+    option_ptr = &option_content[0];
+    opt_bytes_remaining = opt_cont_buf_len;
+    while (opt_bytes_remaining != 0) {
+        /* Get option header. */
+        oh = (const pcapng_option_header_t *)(const void *)option_ptr;
+        /* Sanity check: don't run past the end of the options. */
+        if (sizeof (*oh) > opt_bytes_remaining) {
+            *err = WTAP_ERR_BAD_FILE;
+            *err_info = ws_strdup_printf("pcapng: Not enough data for option header");
+            return FALSE;
+        }
+        option_code = oh->option_code;
+        option_length = oh->option_length;
+        if (section_info->byte_swapped) {
+            option_code = GUINT16_SWAP_LE_BE(option_code);
+            option_length = GUINT16_SWAP_LE_BE(option_length);
+        }
+        option_ptr += sizeof (*oh);
+        opt_bytes_remaining -= sizeof (*oh);
+
+        rounded_option_length = ROUND_TO_4BYTE(option_length);
+        if (rounded_option_length > opt_bytes_remaining) {
+            *err = WTAP_ERR_BAD_FILE;
+            *err_info = ws_strdup_printf("pcapng: Not enough data to handle option of length %u",
+                                        option_length);
+            return FALSE;
+        }
+
+        switch (option_code) {
+            case(OPT_EOFOPT):
+                return TRUE;
+            case(OPT_COMMENT):
+                break;
+            case(OPT_CUSTOM_STR_COPY):
+            case(OPT_CUSTOM_BIN_COPY):
+            case(OPT_CUSTOM_STR_NO_COPY):
+            case(OPT_CUSTOM_BIN_NO_COPY):
+                if (option_length < 4) {
+                    *err = WTAP_ERR_BAD_FILE;
+                    *err_info = ws_strdup_printf("pcapng: option length (%d) too small for custom option",
+                                                option_length);
+                    return FALSE;
+                }
+                memcpy(&pen, option_ptr, sizeof(guint32));
+                if (section_info->byte_swapped)
+                    pen = GUINT32_SWAP_LE_BE(pen);
+                /* Netflix options can change the section state. */
+                if (pen == PEN_NFLX)
+                    *must_process = TRUE;
+                break;
+            default:
+                if (!pcapng_check_packet_block_option(option_code, option_length,
+                                                      option_ptr, err, err_info))
+                    return FALSE;
+                if (option_code == OPT_EPB_FLAGS) {
+                    memcpy(flags, option_ptr, sizeof(guint32));
+                    if (section_info->byte_swapped)
+                        *flags = GUINT32_SWAP_LE_BE(*flags);
+                    *have_flags = TRUE;
+                }
+                /* A plugin's option parser can fail. */
+                if (option_handlers[BT_INDEX_PBS] != NULL &&
+                    g_hash_table_lookup(option_handlers[BT_INDEX_PBS],
+                                        GUINT_TO_POINTER((guint)option_code)) != NULL)
+                    *must_process = TRUE;
+                break;
+        }
+        option_ptr += rounded_option_length;
+        opt_bytes_remaining -= rounded_option_length;
+    }
+    return TRUE;
+}
+
 static gboolean
 pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
                          section_info_t *section_info,
@@ -2080,6 +2288,12 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     guint64 ts;
     int pseudo_header_len;
     int fcslen;
+    gsize data_start;
+    guint8 *pd;
+    Buffer *options_buf;
+    pcapng_deferred_options_t *deferred;
+    gboolean have_flags;
+    gboolean must_process;
 
     wblock->block = wtap_block_create(WTAP_BLOCK_PACKET);
 
@@ -2247,10 +2461,28 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     wblock->rec->ts.secs = (time_t)(ts / iface_info.time_units_per_second);
     wblock->rec->ts.nsecs = (int)(((ts % iface_info.time_units_per_second) * 1000000000) / iface_info.time_units_per_second);
 
-    /* "(Enhanced) Packet Block" read capture data */
-    if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
-                                packet.cap_len - pseudo_header_len, err, err_info))
-        return FALSE;
+    /*
+     * "(Enhanced) Packet Block" read capture data; if our caller can use
+     * it where it is, and we won't be modifying it, don't copy it if it's
+     * in a memory-mapped region of the file.
+     */
+    if (wblock->frame_data != NULL &&
+        !pcap_read_post_process_modifies_data(iface_info.wtap_encap,
+                                              section_info->byte_swapped)) {
+        if (!wtap_read_packet_bytes_ptr(fh, wblock->frame_buffer,
+                                        packet.cap_len - pseudo_header_len,
+                                        wblock->frame_data, err, err_info))
+            return FALSE;
+        pd = (guint8 *)*wblock->frame_data;    /* only looked at, not modified */
+    } else {
+        data_start = ws_buffer_length(wblock->frame_buffer);
+        if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
+                                    packet.cap_len - pseudo_header_len, err, err_info))
+            return FALSE;
+        pd = ws_buffer_start_ptr(wblock->frame_buffer) + data_start;
+        if (wblock->frame_data != NULL)
+            *wblock->frame_data = pd;
+    }
     block_read += packet.cap_len - pseudo_header_len;
 
     /* jump over potential padding bytes at end of the packet data */
@@ -2268,16 +2500,50 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
         (int)sizeof(pcapng_block_header_t) -
         block_read -    /* fixed and variable part, including padding */
         (int)sizeof(bh->block_total_length);
-    if (!pcapng_process_options(fh, wblock, section_info, opt_cont_buf_len,
-                                pcapng_process_packet_block_option,
-                                OPT_SECTION_BYTE_ORDER, err, err_info))
-        return FALSE;
+    if (opt_cont_buf_len != 0) {
+        /*
+         * Read the options, and check them and get the packet flags
+         * without processing them; most readers never look at them.
+         */
+        options_buf = wtap_rec_get_options_buf(wblock->rec);
+        ws_buffer_assure_space(options_buf, sizeof(*deferred) + opt_cont_buf_len);
+        deferred = (pcapng_deferred_options_t *)ws_buffer_start_ptr(options_buf);
+        deferred->byte_swapped = section_info->byte_swapped;
+        deferred->options_len = opt_cont_buf_len;
+        if (!wtap_read_bytes(fh, deferred + 1, opt_cont_buf_len, err, err_info)) {
+            ws_debug("failed to read options");
+            return FALSE;
+        }
+        ws_buffer_increase_length(options_buf, sizeof(*deferred) + opt_cont_buf_len);
+        if (!pcapng_scan_packet_block_options(section_info,
+                                              (const guint8 *)(deferred + 1),
+                                              opt_cont_buf_len,
+                                              &have_flags, &flags,
+                                              &must_process, err, err_info)) {
+            return FALSE;
+        }
+        if (must_process) {
+            if (!pcapng_process_options_buffer(wblock, section_info,
+                                               (const guint8 *)(deferred + 1),
+                                               opt_cont_buf_len,
+                                               pcapng_process_packet_block_option,
+                                               OPT_SECTION_BYTE_ORDER,
+                                               err, err_info)) {
+                return FALSE;
+            }
+        } else {
+            /*
+             * The block borrows the options from the record, rather
+             * than getting a copy of its own for each packet.
+             */
+            wtap_rec_lend_options_buf(wblock->rec, wblock->block,
+                                      pcapng_decode_packet_block_options);
+        }
 
-    /*
-     * Did we get a packet flags option?
-     */
-    if (WTAP_OPTTYPE_SUCCESS == wtap_block_get_uint32_option_value(wblock->block, OPT_PKT_FLAGS, &flags)) {
-        if (PACK_FLAGS_FCS_LENGTH(flags) != 0) {
+        /*
+         * Did we get a packet flags option?
+         */
+        if (have_flags && PACK_FLAGS_FCS_LENGTH(flags) != 0) {
             /*
              * The FCS length is present, but in units of octets, not
              * bits; convert it to bits.
@@ -2286,14 +2552,16 @@ pcapng_read_packet_block(FILE_T fh, pcapng_block_header_t *bh,
         }
     }
     /*
-     * How about a drop_count option? If not, set it from other sources
+     * How about a drop_count option? If not, set it from other sources.
+     * Only a PB has a drop count, so check that first, to leave the
+     * options of an EPB alone.
      */
-    if (WTAP_OPTTYPE_SUCCESS != wtap_block_get_uint64_option_value(wblock->block, OPT_PKT_DROPCOUNT, &tmp64) && packet.drops_count != 0xFFFF) {
+    if (packet.drops_count != 0xFFFF && WTAP_OPTTYPE_SUCCESS != wtap_block_get_uint64_option_value(wblock->block, OPT_PKT_DROPCOUNT, &tmp64)) {
         wtap_block_add_uint64_option(wblock->block, OPT_PKT_DROPCOUNT, (guint64)packet.drops_count);
     }
 
     pcap_read_post_process(FALSE, iface_info.wtap_encap,
-                           wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer),
+                           wblock->rec, pd,
                            section_info->byte_swapped, fcslen);
 
     /*
@@ -2325,6 +2593,7 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     wtapng_simple_packet_t simple_packet;
     guint32 padding;
     int pseudo_header_len;
+    gsize data_start;
 
     /*
      * Is this block long enough to be an SPB?
@@ -2432,6 +2701,7 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     memset((void *)&wblock->rec->rec_header.packet_header.pseudo_header, 0, sizeof(union wtap_pseudo_header));
 
     /* "Simple Packet Block" read capture data */
+    data_start = ws_buffer_length(wblock->frame_buffer);
     if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
                                 simple_packet.cap_len, err, err_info))
         return FALSE;
@@ -2443,7 +2713,7 @@ pcapng_read_simple_packet_block(FILE_T fh, pcapng_block_header_t *bh,
     }
 
     pcap_read_post_process(FALSE, iface_info.wtap_encap,
-                           wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer),
+                           wblock->rec, ws_buffer_start_ptr(wblock->frame_buffer) + data_start,
                            section_info->byte_swapped, iface_info.fcslen);
 
     /*
@@ -3211,6 +3481,7 @@ pcapng_read_systemd_journal_export_block(wtap *wth, FILE_T fh, pcapng_block_head
     guint32 entry_length;
     guint64 rt_ts;
     gboolean have_ts = FALSE;
+    gsize data_start;
 
     if (bh->block_total_length < MIN_SYSTEMD_JOURNAL_EXPORT_BLOCK_SIZE) {
         *err = WTAP_ERR_BAD_FILE;
@@ -3222,6 +3493,7 @@ pcapng_read_systemd_journal_export_block(wtap *wth, FILE_T fh, pcapng_block_head
     entry_length = bh->block_total_length - MIN_BLOCK_SIZE;
 
     /* Includes padding bytes. */
+    data_start = ws_buffer_length(wblock->frame_buffer);
     if (!wtap_read_packet_bytes(fh, wblock->frame_buffer,
                                 entry_length, err, err_info)) {
         return FALSE;
@@ -3233,7 +3505,7 @@ pcapng_read_systemd_journal_export_block(wtap *wth, FILE_T fh, pcapng_block_head
      */
     ws_buffer_assure_space(wblock->frame_buffer, entry_length+1);
 
-    gchar *buf_ptr = (gchar *) ws_buffer_start_ptr(wblock->frame_buffer);
+    gchar *buf_ptr = (gchar *) ws_buffer_start_ptr(wblock->frame_buffer) + data_start;
     while (entry_length > 0 && buf_ptr[entry_length-1] == '\0') {
         entry_length--;
     }
@@ -3845,6 +4117,7 @@ pcapng_open(wtap *wth, int *err, gchar **err_info)
     wblock.block = NULL;
     /* we don't expect any packet blocks yet */
     wblock.frame_buffer = NULL;
+    wblock.frame_data = NULL;
     wblock.rec = NULL;
 
     switch (pcapng_read_section_header_block(wth->fh, &bh, &first_section,
@@ -3930,7 +4203,15 @@ pcapng_open(wtap *wth, int *err, gchar **err_info)
 
     wth->subtype_read = pcapng_read;
     wth->subtype_seek_read = pcapng_seek_read;
+    wth->subtype_seek_read_ptr = pcapng_seek_read_ptr;
+    /*
+     * Our own block readers append packet data to the buffer, so a
+     * batch can be read into one buffer; block types handled by
+     * plugins might not.
+     */
+    wth->subtype_read_appends = (block_handlers == NULL);
     wth->subtype_close = pcapng_close;
+    wth->subtype_get_trailing_if_stats = pcapng_get_trailing_if_stats;
     wth->file_type_subtype = pcapng_file_type_subtype;
 
     /* Always initialize the lists of Decryption Secret Blocks, Name
@@ -4030,6 +4311,7 @@ pcapng_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
     wtapng_block_t wblock;
 
     wblock.frame_buffer  = buf;
+    wblock.frame_data = NULL;
     wblock.rec = rec;
 
     /* read next block */
@@ -4084,6 +4366,15 @@ static gboolean
 pcapng_seek_read(wtap *wth, gint64 seek_off,
                  wtap_rec *rec, Buffer *buf,
                  int *err, gchar **err_info)
+{
+    return pcapng_seek_read_ptr(wth, seek_off, rec, buf, NULL, err, err_info);
+}
+
+/* Like pcapng_seek_read(), but packet data may be left in a mapped file. */
+static gboolean
+pcapng_seek_read_ptr(wtap *wth, gint64 seek_off,
+                     wtap_rec *rec, Buffer *buf, const guint8 **data,
+                     int *err, gchar **err_info)
 {
     pcapng_t *pcapng = (pcapng_t *)wth->priv;
     section_info_t *section_info, new_section;
@@ -4128,6 +4419,7 @@ pcapng_seek_read(wtap *wth, gint64 seek_off,
     }
 
     wblock.frame_buffer = buf;
+    wblock.frame_data = data;
     wblock.rec = rec;
 
     /* read the block */
@@ -4155,6 +4447,133 @@ pcapng_seek_read(wtap *wth, gint64 seek_off,
     return TRUE;
 }
 
+/*
+ * Maximum number of blocks we'll walk back over, from the end of the
+ * file, looking for Interface Statistics Blocks.
+ */
+#define MAX_TRAILING_ISBS   1024
+
+/*
+ * Find the ISBs at the end of the file without reading it sequentially.
+ *
+ * Every pcapng block ends with a copy of its total length, so we can
+ * walk backwards from the end of a section.  We only do this if the
+ * file has a single section whose Section Length is specified and
+ * matches the file size; otherwise we can't be sure that the ISBs we
+ * find describe all of the packets in the file.
+ *
+ * We stop at the first block that isn't an ISB, and leave the
+ * sequential read position where we found it.
+ */
+static GArray *
+pcapng_get_trailing_if_stats(wtap *wth, int *err, gchar **err_info)
+{
+    pcapng_t *pcapng = (pcapng_t *)wth->priv;
+    section_info_t *section_info;
+    section_info_t new_section;
+    wtapng_section_mandatory_t *section_mand;
+    pcapng_block_header_t bh;
+    guint32 trailer_len;
+    gint64 saved_offset, section_start, section_end, file_size, pos;
+    GArray *isb_offsets;
+    GArray *if_stats = NULL;
+    wtapng_block_t wblock;
+    int seek_err;
+    guint i;
+
+    /* Seeking backwards in a compressed file is too expensive. */
+    if (file_iscompressed(wth->fh))
+        return NULL;
+
+    if (pcapng->sections->len != 1 || wth->shb_hdrs->len != 1)
+        return NULL;
+
+    section_mand = (wtapng_section_mandatory_t *)wtap_block_get_mandatory_data(
+        g_array_index(wth->shb_hdrs, wtap_block_t, 0));
+    if (section_mand->section_length == G_GUINT64_CONSTANT(0xFFFFFFFFFFFFFFFF))
+        return NULL;
+
+    file_size = wtap_file_size(wth, err);
+    if (file_size == -1)
+        return NULL;
+
+    section_info = &g_array_index(pcapng->sections, section_info_t, 0);
+    saved_offset = file_tell(wth->fh);
+    isb_offsets = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+    /* Find the end of the section from the SHB's total length. */
+    if (file_seek(wth->fh, section_info->shb_off, SEEK_SET, err) == -1)
+        goto done;
+    if (!wtap_read_bytes(wth->fh, &bh, sizeof bh, err, err_info))
+        goto done;
+    if (section_info->byte_swapped)
+        bh.block_total_length = GUINT32_SWAP_LE_BE(bh.block_total_length);
+    section_start = section_info->shb_off + bh.block_total_length;
+    if (section_mand->section_length > (guint64)(file_size - section_start))
+        goto done;
+    section_end = section_start + (gint64)section_mand->section_length;
+    if (section_end != file_size)
+        goto done;
+
+    pos = section_end;
+    for (i = 0; i < MAX_TRAILING_ISBS && pos - section_start >= MIN_BLOCK_SIZE; i++) {
+        if (file_seek(wth->fh, pos - (gint64)sizeof trailer_len, SEEK_SET, err) == -1)
+            goto done;
+        if (!wtap_read_bytes(wth->fh, &trailer_len, sizeof trailer_len, err, err_info))
+            goto done;
+        if (section_info->byte_swapped)
+            trailer_len = GUINT32_SWAP_LE_BE(trailer_len);
+        if (trailer_len < MIN_ISB_SIZE || trailer_len % 4 != 0 ||
+            trailer_len > pos - section_start)
+            break;
+
+        if (file_seek(wth->fh, pos - trailer_len, SEEK_SET, err) == -1)
+            goto done;
+        if (!wtap_read_bytes(wth->fh, &bh, sizeof bh, err, err_info))
+            goto done;
+        if (section_info->byte_swapped) {
+            bh.block_type         = GUINT32_SWAP_LE_BE(bh.block_type);
+            bh.block_total_length = GUINT32_SWAP_LE_BE(bh.block_total_length);
+        }
+        if (bh.block_type != BLOCK_TYPE_ISB || bh.block_total_length != trailer_len)
+            break;
+
+        pos -= trailer_len;
+        g_array_prepend_val(isb_offsets, pos);
+    }
+
+    if (isb_offsets->len == 0)
+        goto done;
+
+    /* Now read the ISBs we found, in file order. */
+    if_stats = g_array_sized_new(FALSE, FALSE, sizeof(wtap_block_t), isb_offsets->len);
+    wblock.rec = NULL;
+    wblock.frame_buffer = NULL;
+    wblock.frame_data = NULL;
+    for (i = 0; i < isb_offsets->len; i++) {
+        wblock.block = NULL;
+        if (file_seek(wth->fh, g_array_index(isb_offsets, gint64, i), SEEK_SET, err) == -1 ||
+            !pcapng_read_block(wth, wth->fh, pcapng, section_info,
+                               &new_section, &wblock, err, err_info)) {
+            /* Whatever block the failed read made isn't in if_stats. */
+            wtap_block_unref(wblock.block);
+            wtap_block_array_free(if_stats);
+            if_stats = NULL;
+            goto done;
+        }
+        g_array_append_val(if_stats, wblock.block);
+    }
+
+done:
+    g_array_free(isb_offsets, TRUE);
+    if (file_seek(wth->fh, saved_offset, SEEK_SET, &seek_err) == -1) {
+        wtap_block_array_free(if_stats);
+        if_stats = NULL;
+        *err = seek_err;
+    }
+    return if_stats;
+}
+
 /* classic wtap: close capture file */
 static void
 pcapng_close(wtap *wth)
@@ -68,6 +68,7 @@ typedef struct wtapng_block_s {
     wtap_block_t block;
     wtap_rec     *rec;
     Buffer       *frame_buffer;
+    const guint8 **frame_data;   /* if not NULL, packet data may be left in a mapped file and pointed to by *frame_data */
 } wtapng_block_t;
 
 /* Section data in private struct */
@@ -0,0 +1,922 @@
+/*
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "wtap.h"
+#include "flow_key.h"
+
+/*
+ * Packets for the flow key tests are built up a header at a time.
+ */
+typedef struct {
+    guint8 data[512];
+    guint32 len;
+} test_packet_t;
+
+static void
+put_bytes(test_packet_t *p, const void *data, size_t len)
+{
+    g_assert_cmpuint(p->len + len, <=, sizeof p->data);
+    memcpy(p->data + p->len, data, len);
+    p->len += (guint32)len;
+}
+
+static void
+put_uint8(test_packet_t *p, guint8 val)
+{
+    put_bytes(p, &val, 1);
+}
+
+static void
+put_uint16(test_packet_t *p, guint16 val)
+{
+    put_uint8(p, val >> 8);
+    put_uint8(p, val & 0xff);
+}
+
+static void
+put_uint32(test_packet_t *p, guint32 val)
+{
+    put_uint16(p, val >> 16);
+    put_uint16(p, val & 0xffff);
+}
+
+static void
+put_zeros(test_packet_t *p, size_t len)
+{
+    static const guint8 zeros[64];
+
+    put_bytes(p, zeros, len);
+}
+
+static void
+put_ether(test_packet_t *p, guint16 ethertype)
+{
+    put_zeros(p, 12);
+    put_uint16(p, ethertype);
+}
+
+/* An 802.1Q or 802.1ad tag, and the type of what follows it. */
+static void
+put_vlan(test_packet_t *p, guint16 vlan_id, guint16 ethertype)
+{
+    put_uint16(p, vlan_id);
+    put_uint16(p, ethertype);
+}
+
+/* Addresses are 10.0.0.<src> and 10.0.0.<dst>. */
+static void
+put_ipv4(test_packet_t *p, guint8 proto, guint8 src, guint8 dst, guint16 frag)
+{
+    put_uint8(p, 0x45);
+    put_zeros(p, 5);
+    put_uint16(p, frag);
+    put_uint8(p, 64);
+    put_uint8(p, proto);
+    put_zeros(p, 2);
+    put_uint32(p, 0x0a000000 | src);
+    put_uint32(p, 0x0a000000 | dst);
+}
+
+/* Addresses are 2001:db8::<src> and 2001:db8::<dst>. */
+static void
+put_ipv6(test_packet_t *p, guint8 next_header, guint8 src, guint8 dst)
+{
+    put_uint32(p, 0x60000000);
+    put_zeros(p, 2);
+    put_uint8(p, next_header);
+    put_uint8(p, 64);
+    put_uint32(p, 0x20010db8);
+    put_zeros(p, 11);
+    put_uint8(p, src);
+    put_uint32(p, 0x20010db8);
+    put_zeros(p, 11);
+    put_uint8(p, dst);
+}
+
+static void
+put_udp(test_packet_t *p, guint16 src_port, guint16 dst_port)
+{
+    put_uint16(p, src_port);
+    put_uint16(p, dst_port);
+    put_zeros(p, 4);
+}
+
+static void
+put_tcp(test_packet_t *p, guint16 src_port, guint16 dst_port)
+{
+    put_uint16(p, src_port);
+    put_uint16(p, dst_port);
+    put_zeros(p, 8);
+    put_uint8(p, 5 << 4);
+    put_zeros(p, 7);
+}
+
+static void
+init_rec(wtap_rec *rec, int encap, guint32 caplen)
+{
+    memset(rec, 0, sizeof *rec);
+    rec->rec_type = REC_TYPE_PACKET;
+    rec->rec_header.packet_header.pkt_encap = encap;
+    rec->rec_header.packet_header.caplen = caplen;
+    rec->rec_header.packet_header.len = caplen;
+}
+
+/*
+ * Get the key of a packet, checking on the way that every shorter
+ * capture of it gives a key whose headers were captured.
+ */
+static void
+get_key(int encap, const test_packet_t *p, wtap_flow_key_t *key)
+{
+    wtap_rec rec;
+    wtap_flow_key_t short_key;
+    guint8 *data;
+
+    for (guint32 caplen = 0; caplen < p->len; caplen++) {
+        /* A copy of just what was captured, so that the sanitizers
+         * catch reads past it. */
+        data = (guint8 *)g_memdup2(p->data, caplen);
+        init_rec(&rec, encap, caplen);
+        if (wtap_flow_key_get(&rec, data, &short_key)) {
+            g_assert_cmpuint(short_key.l3_offset, <, caplen);
+            g_assert_cmpuint(short_key.payload_offset, <=, caplen);
+            if (short_key.flags & WTAP_FLOW_KEY_PORTS)
+                g_assert_cmpuint(short_key.l4_offset + 4, <=, caplen);
+        }
+        g_free(data);
+    }
+    init_rec(&rec, encap, p->len);
+    g_assert_true(wtap_flow_key_get(&rec, p->data, key));
+}
+
+static void
+check_ipv4(const wtap_flow_key_t *key, guint8 src, guint8 dst)
+{
+    const guint8 src_addr[4] = { 10, 0, 0, src };
+    const guint8 dst_addr[4] = { 10, 0, 0, dst };
+
+    g_assert_cmpuint(key->addr_len, ==, 4);
+    g_assert_cmpmem(key->src, 4, src_addr, 4);
+    g_assert_cmpmem(key->dst, 4, dst_addr, 4);
+}
+
+static void
+check_ipv6(const wtap_flow_key_t *key, guint8 src, guint8 dst)
+{
+    guint8 src_addr[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+    guint8 dst_addr[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+
+    src_addr[15] = src;
+    dst_addr[15] = dst;
+    g_assert_cmpuint(key->addr_len, ==, 16);
+    g_assert_cmpmem(key->src, 16, src_addr, 16);
+    g_assert_cmpmem(key->dst, 16, dst_addr, 16);
+}
+
+static void
+check_ports(const wtap_flow_key_t *key, guint8 ip_proto, guint16 src_port, guint16 dst_port)
+{
+    g_assert_cmpuint(key->ip_proto, ==, ip_proto);
+    g_assert_true(key->flags & WTAP_FLOW_KEY_PORTS);
+    g_assert_cmpuint(key->src_port, ==, src_port);
+    g_assert_cmpuint(key->dst_port, ==, dst_port);
+}
+
+static void
+test_flow_key_ethernet(void)
+{
+    test_packet_t p = { 0 };
+    wtap_flow_key_t key;
+
+    put_ether(&p, 0x0800);
+    put_ipv4(&p, 17, 1, 2, 0);
+    put_udp(&p, 1024, 53);
+    put_zeros(&p, 4);
+    get_key(WTAP_ENCAP_ETHERNET, &p, &key);
+    check_ipv4(&key, 1, 2);
+    check_ports(&key, 17, 1024, 53);
+    g_assert_cmpuint(key.flags, ==, WTAP_FLOW_KEY_PORTS);
+    g_assert_cmpuint(key.l3_offset, ==, 14);
+    g_assert_cmpuint(key.l4_offset, ==, 34);
+    g_assert_cmpuint(key.payload_offset, ==, 42);
+}
+
+static void
+test_flow_key_vlan(void)
+{
+    test_packet_t p = { 0 };
+    wtap_flow_key_t key;
+
+    /* QinQ: the outer tag's VLAN ID is the one we keep. */
+    put_ether(&p, 0x88a8);
+    put_vlan(&p, 100, 0x8100);
+    put_vlan(&p, 0x2000 | 200, 0x86dd);
+    put_ipv6(&p, 6, 3, 4);
+    put_tcp(&p, 80, 40000);
+    get_key(WTAP_ENCAP_ETHERNET, &p, &key);
+    check_ipv6(&key, 3, 4);
+    check_ports(&key, 6, 80, 40000);
+    g_assert_true(key.flags & WTAP_FLOW_KEY_VLAN);
+    g_assert_cmpuint(key.vlan_id, ==, 100);
+    g_assert_cmpuint(key.l3_offset, ==, 22);
+    g_assert_cmpuint(key.payload_offset, ==, 22 + 40 + 20);
+}
+
+static void
+test_flow_key_mpls(void)
+{
+    test_packet_t p = { 0 };
+    wtap_flow_key_t key;
+
+    /* Two labels, the second at the bottom of the stack. */
+    put_ether(&p, 0x8847);
+    put_uint32(&p, 1000 << 12);
+    put_uint32(&p, 2000 << 12 | 0x100);
+    put_ipv4(&p, 6, 5, 6, 0);
+    put_tcp(&p, 1234, 443);
+    get_key(WTAP_ENCAP_ETHERNET, &p, &key);
+    check_ipv4(&key, 5, 6);
+    check_ports(&key, 6, 1234, 443);
+    g_assert_false(key.flags & WTAP_FLOW_KEY_TUNNELED);
+
+    /* An Ethernet pseudowire with a control word. */
+    p.len = 0;
+    put_ether(&p, 0x8847);
+    put_uint32(&p, 3000 << 12 | 0x100);
+    put_uint32(&p, 0);
+    put_ether(&p, 0x0800);
+    put_ipv4(&p, 17, 7, 8, 0);
+    put_udp(&p, 5000, 5001);
+    get_key(WTAP_ENCAP_ETHERNET, &p, &key);
+    check_ipv4(&key, 7, 8);
+    check_ports(&key, 17, 5000, 5001);
+    g_assert_true(key.flags & WTAP_FLOW_KEY_TUNNELED);
+    g_assert_cmpuint(key.tunnel_depth, ==, 1);
+}
+
+static void
+test_flow_key_pppoe(void)
+{
+    test_packet_t p = { 0 };
+    wtap_flow_key_t key;
+
+    put_ether(&p, 0x8864);
+    put_uint8(&p, 0x11);
+    put_uint8(&p, 0);
+    put_uint16(&p, 0x1234);
+    put_uint16(&p, 40 + 8 + 2);
+    put_uint16(&p, 0x0057);
+    put_ipv6(&p, 17, 9, 10);
+    put_udp(&p, 546, 547);
+    get_key(WTAP_ENCAP_ETHERNET, &p, &key);
+    check_ipv6(&key, 9, 10);
+    check_ports(&key, 17, 546, 547);
+    g_assert_cmpuint(key.l3_offset, ==, 22);
+}
+
+static void
+test_flow_key_sll(void)
+{
+    test_packet_t p = { 0 };
+    wtap_flow_key_t key;
+
+    /* Linux cooked capture: the protocol is at the end. */
+    put_zeros(&p, 14);
+    put_uint16(&p, 0x0800);
+    put_ipv4(&p, 132, 1, 2, 0);
+    put_udp(&p, 2905, 2905);
+    put_zeros(&p, 4);
+    get_key(WTAP_ENCAP_SLL, &p, &key);
+    check_ipv4(&key, 1, 2);
+    check_ports(&key, 132, 2905, 2905);
+    g_assert_cmpuint(key.payload_offset, ==, 16 + 20 + 12);
+
+    /* Version 2: the protocol is at the start. */
+    p.len = 0;
+    put_uint16(&p, 0x86dd);
+    put_zeros(&p, 18);
+    put_ipv6(&p, 17, 1, 2);
+    put_udp(&p, 1, 2);
+    get_key(WTAP_ENCAP_SLL2, &p, &key);
+    check_ipv6(&key, 1, 2);
+    check_ports(&key, 17, 1, 2);
+    g_assert_cmpuint(key.l3_offset, ==, 20);
+}
+
+static void
+test_flow_key_loopback(void)
+{
+    static const guint8 af_inet_le[4] = { 2, 0, 0, 0 };
+    static const guint32 af_inet6[] = { 10, 24, 28, 30 };
+    test_packet_t p = { 0 };
+    wtap_flow_key_t key;
+
+    /* DLT_NULL is in the byte order of the host that captured it. */
+    put_bytes(&p, af_inet_le, sizeof af_inet_le);
+    put_ipv4(&p, 6, 1, 2, 0);
+    put_tcp(&p, 22, 50000);
+    get_key(WTAP_ENCAP_NULL, &p, &key);
+    check_ipv4(&key, 1, 2);
+    check_ports(&key, 6, 22, 50000);
+
+    /* AF_INET6 differs between OSes. */
+    for (size_t i = 0; i < G_N_ELEMENTS(af_inet6); i++) {
+        p.len = 0;
+        put_uint32(&p, af_inet6[i]);
+        put_ipv6(&p, 17, 3, 4);
+        put_udp(&p, 53, 53);
+        get_key(WTAP_ENCAP_LOOP, &p, &key);
+        check_ipv6(&key, 3, 4);
+        check_ports(&key, 17, 53, 53);
+    }
+}
+
+static void
+test_flow_key_raw_ip(void)
+{
+    test_packet_t p = { 0 };
+    wtap_flow_key_t key;
+
+    put_ipv6(&p, 6, 1, 2);
+    put_tcp(&p, 1, 2);
+    get_key(WTAP_ENCAP_RAW_IP, &p, &key);
+    check_ipv6(&key, 1, 2);
+    get_key(WTAP_ENCAP_RAW_IP6, &p, &key);
+    check_ipv6(&key, 1, 2);
+
+    p.len = 0;
+    put_ipv4(&p, 6, 1, 2, 0);
+    put_tcp(&p, 1, 2);
+    get_key(WTAP_ENCAP_RAW_IP, &p, &key);
+    check_ipv4(&key, 1, 2);
+    get_key(WTAP_ENCAP_RAW_IP4, &p, &key);
+    check_ipv4(&key, 1, 2);
+}
+
+static void
+test_flow_key_ipv6_ext(void)
+{
+    test_packet_t p = { 0 };
+    wtap_flow_key_t key;
+
+    /* Hop-by-hop options, routing (24 bytes) and destination options. */
+    put_ipv6(&p, 0, 1, 2);
+    put_uint8(&p, 43);
+    put_zeros(&p, 7);
+    put_uint8(&p, 60);
+    put_uint8(&p, 2);
+    put_zeros(&p, 22);
+    put_uint8(&p, 6);
+    put_zeros(&p, 7);
+    put_tcp(&p, 1111, 2222);
+    get_key(WTAP_ENCAP_RAW_IP6, &p, &key);
+    check_ipv6(&key, 1, 2);
+    check_ports(&key, 6, 1111, 2222);
+    g_assert_cmpuint(key.l4_offset, ==, 40 + 8 + 24 + 8);
+
+    /* An atomic fragment still has the ports. */
+    p.len = 0;
+    put_ipv6(&p, 44, 1, 2);
+    put_uint8(&p, 17);
+    put_zeros(&p, 7);
+    put_udp(&p, 3333, 4444);
+    get_key(WTAP_ENCAP_RAW_IP6, &p, &key);
+    check_ports(&key, 17, 3333, 4444);
+    g_assert_false(key.flags & WTAP_FLOW_KEY_FRAGMENT);
+
+    /* A first fragment (M set) doesn't, so that it gets the same key
+     * as the rest. */
+    p.len = 0;
+    put_ipv6(&p, 44, 1, 2);
+    put_uint8(&p, 17);
+    put_zeros(&p, 2);
+    put_uint8(&p, 1);
+    put_zeros(&p, 4);
+    put_udp(&p, 3333, 4444);
+    get_key(WTAP_ENCAP_RAW_IP6, &p, &key);
+    g_assert_true(key.flags & WTAP_FLOW_KEY_FRAGMENT);
+    g_assert_false(key.flags & WTAP_FLOW_KEY_PORTS);
+    g_assert_cmpuint(key.ip_proto, ==, 17);
+    g_assert_cmpuint(key.src_port, ==, 0);
+}
+
+static void
+test_flow_key_ipv4_fragment(void)
+{
+    test_packet_t p = { 0 };
+    wtap_flow_key_t key;
+
+    /* A later fragment: offset 185 (1480 bytes). */
+    put_ipv4(&p, 17, 1, 2, 185);
+    put_zeros(&p, 16);
+    get_key(WTAP_ENCAP_RAW_IP4, &p, &key);
+    check_ipv4(&key, 1, 2);
+    g_assert_cmpuint(key.ip_proto, ==, 17);
+    g_assert_true(key.flags & WTAP_FLOW_KEY_FRAGMENT);
+    g_assert_false(key.flags & WTAP_FLOW_KEY_PORTS);
+}
+
+static void
+test_flow_key_gre(void)
+{
+    test_packet_t p = { 0 };
+    wtap_flow_key_t key;
+
+    /* GRE with a key, carrying IPv4. */
+    put_ipv4(&p, 47, 100, 101, 0);
+    put_uint16(&p, 0x2000);
+    put_uint16(&p, 0x0800);
+    put_uint32(&p, 42);
+    put_ipv4(&p, 6, 1, 2, 0);
+    put_tcp(&p, 10, 20);
+    get_key(WTAP_ENCAP_RAW_IP4, &p, &key);
+    check_ipv4(&key, 1, 2);
+    check_ports(&key, 6, 10, 20);
+    g_assert_true(key.flags & WTAP_FLOW_KEY_TUNNELED);
+    g_assert_cmpuint(key.l3_offset, ==, 20 + 8);
+
+    /* Transparent Ethernet bridging, with a VLAN tag inside. */
+    p.len = 0;
+    put_ipv4(&p, 47, 100, 101, 0);
+    put_uint16(&p, 0);
+    put_uint16(&p, 0x6558);
+    put_ether(&p, 0x8100);
+    put_vlan(&p, 7, 0x0800);
+    put_ipv4(&p, 17, 3, 4, 0);
+    put_udp(&p, 30, 40);
+    get_key(WTAP_ENCAP_RAW_IP4, &p, &key);
+    check_ipv4(&key, 3, 4);
+    check_ports(&key, 17, 30, 40);
+    g_assert_cmpuint(key.vlan_id, ==, 7);
+
+    /* Enhanced GRE (version 1) isn't looked into. */
+    p.len = 0;
+    put_ipv4(&p, 47, 100, 101, 0);
+    put_uint16(&p, 0x0001);
+    put_uint16(&p, 0x0800);
+    put_ipv4(&p, 6, 1, 2, 0);
+    put_tcp(&p, 10, 20);
+    get_key(WTAP_ENCAP_RAW_IP4, &p, &key);
+    check_ipv4(&key, 100, 101);
+    g_assert_cmpuint(key.ip_proto, ==, 47);
+    g_assert_false(key.flags & WTAP_FLOW_KEY_TUNNELED);
+}
+
+static void
+test_flow_key_vxlan(void)
+{
+    test_packet_t p = { 0 };
+    wtap_flow_key_t key;
+
+    put_ether(&p, 0x0800);
+    put_ipv4(&p, 17, 100, 101, 0);
+    put_udp(&p, 49152, 4789);
+    put_uint32(&p, 0x08000000);
+    put_uint32(&p, 1234 << 8);
+    put_ether(&p, 0x86dd);
+    put_ipv6(&p, 6, 5, 6);
+    put_tcp(&p, 8080, 50000);
+    get_key(WTAP_ENCAP_ETHERNET, &p, &key);
+    check_ipv6(&key, 5, 6);
+    check_ports(&key, 6, 8080, 50000);
+    g_assert_true(key.flags & WTAP_FLOW_KEY_TUNNELED);
+    g_assert_cmpuint(key.tunnel_depth, ==, 1);
+    g_assert_cmpuint(key.l3_offset, ==, 14 + 20 + 8 + 8 + 14);
+}
+
+static void
+test_flow_key_gtpu(void)
+{
+    test_packet_t p = { 0 };
+    wtap_flow_key_t key;
+
+    /* A G-PDU with the E flag and one extension header (PDU session
+     * container, 4 bytes). */
+    put_ipv4(&p, 17, 100, 101, 0);
+    put_udp(&p, 2152, 2152);
+    put_uint8(&p, 0x34);
+    put_uint8(&p, 0xff);
+    put_uint16(&p, 0);
+    put_uint32(&p, 0x12345678);
+    put_zeros(&p, 3);
+    put_uint8(&p, 0x85);
+    put_uint8(&p, 1);
+    put_zeros(&p, 2);
+    put_uint8(&p, 0);
+    put_ipv4(&p, 17, 9, 10, 0);
+    put_udp(&p, 5353, 5353);
+    get_key(WTAP_ENCAP_RAW_IP4, &p, &key);
+    check_ipv4(&key, 9, 10);
+    check_ports(&key, 17, 5353, 5353);
+    g_assert_true(key.flags & WTAP_FLOW_KEY_TUNNELED);
+    g_assert_cmpuint(key.l3_offset, ==, 20 + 8 + 12 + 4);
+}
+
+static void
+test_flow_key_ip_in_ip(void)
+{
+    test_packet_t p = { 0 };
+    wtap_flow_key_t key;
+
+    put_ipv4(&p, 41, 100, 101, 0);
+    put_ipv6(&p, 4, 1, 2);
+    put_ipv4(&p, 6, 3, 4, 0);
+    put_tcp(&p, 1, 2);
+    get_key(WTAP_ENCAP_RAW_IP4, &p, &key);
+    check_ipv4(&key, 3, 4);
+    check_ports(&key, 6, 1, 2);
+    g_assert_cmpuint(key.tunnel_depth, ==, 2);
+}
+
+static void
+test_flow_key_truncated(void)
+{
+    test_packet_t p = { 0 };
+    wtap_rec rec;
+    wtap_flow_key_t key;
+
+    /* A VXLAN packet cut off inside the inner IP header keeps the key
+     * of the outer packet. */
+    put_ether(&p, 0x0800);
+    put_ipv4(&p, 17, 100, 101, 0);
+    put_udp(&p, 49152, 4789);
+    put_uint32(&p, 0x08000000);
+    put_uint32(&p, 0);
+    put_ether(&p, 0x0800);
+    put_ipv4(&p, 6, 1, 2, 0);
+    init_rec(&rec, WTAP_ENCAP_ETHERNET, p.len - 1);
+    g_assert_true(wtap_flow_key_get(&rec, p.data, &key));
+    check_ipv4(&key, 100, 101);
+    check_ports(&key, 17, 49152, 4789);
+    g_assert_false(key.flags & WTAP_FLOW_KEY_TUNNELED);
+
+    /* Cut off in the transport header: no ports. */
+    p.len = 0;
+    put_ether(&p, 0x0800);
+    put_ipv4(&p, 6, 1, 2, 0);
+    put_uint16(&p, 80);
+    init_rec(&rec, WTAP_ENCAP_ETHERNET, p.len);
+    g_assert_true(wtap_flow_key_get(&rec, p.data, &key));
+    check_ipv4(&key, 1, 2);
+    g_assert_false(key.flags & WTAP_FLOW_KEY_PORTS);
+
+    /* Cut off in the IP header: no key. */
+    init_rec(&rec, WTAP_ENCAP_ETHERNET, 14 + 19);
+    g_assert_false(wtap_flow_key_get(&rec, p.data, &key));
+    g_assert_cmpuint(key.addr_len, ==, 0);
+    g_assert_cmpuint(wtap_flow_key_hash(&key), ==, 0);
+
+    /* Not a packet. */
+    init_rec(&rec, WTAP_ENCAP_ETHERNET, p.len);
+    rec.rec_type = REC_TYPE_FT_SPECIFIC_EVENT;
+    g_assert_false(wtap_flow_key_get(&rec, p.data, &key));
+}
+
+static void
+test_flow_key_hash(void)
+{
+    test_packet_t p = { 0 }, q = { 0 };
+    wtap_flow_key_t key_p, key_q;
+
+    /* Both directions hash the same. */
+    put_ipv4(&p, 6, 1, 2, 0);
+    put_tcp(&p, 40000, 80);
+    put_ipv4(&q, 6, 2, 1, 0);
+    put_tcp(&q, 80, 40000);
+    get_key(WTAP_ENCAP_RAW_IP4, &p, &key_p);
+    get_key(WTAP_ENCAP_RAW_IP4, &q, &key_q);
+    g_assert_cmpuint(wtap_flow_key_hash(&key_p), ==, wtap_flow_key_hash(&key_q));
+
+    /* And so do both directions between two ports of one host. */
+    p.len = q.len = 0;
+    put_ipv6(&p, 17, 1, 1);
+    put_udp(&p, 1000, 2000);
+    put_ipv6(&q, 17, 1, 1);
+    put_udp(&q, 2000, 1000);
+    get_key(WTAP_ENCAP_RAW_IP6, &p, &key_p);
+    get_key(WTAP_ENCAP_RAW_IP6, &q, &key_q);
+    g_assert_cmpuint(wtap_flow_key_hash(&key_p), ==, wtap_flow_key_hash(&key_q));
+
+    /* Other flows don't, at least for these. */
+    p.len = q.len = 0;
+    put_ipv4(&p, 6, 1, 2, 0);
+    put_tcp(&p, 40000, 80);
+    put_ipv4(&q, 6, 1, 2, 0);
+    put_tcp(&q, 40001, 80);
+    get_key(WTAP_ENCAP_RAW_IP4, &p, &key_p);
+    get_key(WTAP_ENCAP_RAW_IP4, &q, &key_q);
+    g_assert_cmpuint(wtap_flow_key_hash(&key_p), !=, wtap_flow_key_hash(&key_q));
+}
+
+/*
+ * The options of pcapng packet blocks are left in the record until
+ * somebody looks at them; a block kept after the record is reused must
+ * still have its own.
+ */
+#define COMMENTED_PACKETS   3
+
+static void
+pcapng_append_u32(GByteArray *contents, guint32 value)
+{
+    value = GUINT32_TO_LE(value);
+    g_byte_array_append(contents, (const guint8 *)&value, sizeof value);
+}
+
+/* Write a pcapng file whose packets each have the comment "packet <n>". */
+static char *
+commented_file_write(const char *dir)
+{
+    static const guint8 shb[28] = {
+        0x0a, 0x0d, 0x0d, 0x0a, 28, 0, 0, 0,
+        0x4d, 0x3c, 0x2b, 0x1a, 1, 0, 0, 0,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        28, 0, 0, 0
+    };
+    static const guint8 idb[20] = {
+        1, 0, 0, 0, 20, 0, 0, 0,
+        1, 0, 0, 0, 0, 0, 0, 0,
+        20, 0, 0, 0
+    };
+    GByteArray *contents = g_byte_array_new();
+    char comment[9];
+    char *path;
+
+    g_byte_array_append(contents, shb, sizeof shb);
+    g_byte_array_append(contents, idb, sizeof idb);
+    for (guint i = 0; i < COMMENTED_PACKETS; i++) {
+        pcapng_append_u32(contents, 6);     /* EPB */
+        pcapng_append_u32(contents, 52);
+        pcapng_append_u32(contents, 0);     /* interface ID */
+        pcapng_append_u32(contents, 0);     /* time stamp */
+        pcapng_append_u32(contents, i);
+        pcapng_append_u32(contents, 4);     /* captured length */
+        pcapng_append_u32(contents, 4);     /* original length */
+        pcapng_append_u32(contents, i);     /* packet data */
+        pcapng_append_u32(contents, 1 | 8 << 16);   /* opt_comment */
+        g_snprintf(comment, sizeof comment, "packet %u", i + 1);
+        g_byte_array_append(contents, (const guint8 *)comment, 8);
+        pcapng_append_u32(contents, 0);     /* opt_endofopt */
+        pcapng_append_u32(contents, 52);
+    }
+    path = g_build_filename(dir, "commented.pcapng", NULL);
+    g_assert_true(g_file_set_contents(path, (const gchar *)contents->data, contents->len, NULL));
+    g_byte_array_free(contents, TRUE);
+    return path;
+}
+
+static void
+check_comment(wtap_block_t block, guint i)
+{
+    char *value;
+    char *expected = g_strdup_printf("packet %u", i + 1);
+
+    g_assert_cmpint(wtap_block_get_nth_string_option_value(block, OPT_COMMENT, 0, &value), ==, WTAP_OPTTYPE_SUCCESS);
+    g_assert_cmpstr(value, ==, expected);
+    g_free(expected);
+}
+
+static void
+test_pcapng_kept_options(void)
+{
+    char *dir = g_dir_make_tmp("test_wiretap.XXXXXX", NULL);
+    char *path;
+    wtap *wth;
+    wtap_rec rec;
+    Buffer buf;
+    wtap_block_t kept[COMMENTED_PACKETS];
+    gint64 data_offset;
+    int err;
+    gchar *err_info;
+
+    g_assert_nonnull(dir);
+    path = commented_file_write(dir);
+    wth = wtap_open_offline(path, WTAP_TYPE_AUTO, &err, &err_info, FALSE);
+    g_assert_nonnull(wth);
+    wtap_rec_init(&rec);
+    ws_buffer_init(&buf, 1514);
+    for (guint i = 0; i < COMMENTED_PACKETS; i++) {
+        g_assert_true(wtap_read(wth, &rec, &buf, &err, &err_info, &data_offset));
+        /* Look at the last one only after the record is gone. */
+        if (i == 1)
+            check_comment(rec.block, i);
+        kept[i] = wtap_block_ref(rec.block);
+        wtap_rec_reset(&rec);
+    }
+    wtap_rec_cleanup(&rec);
+    ws_buffer_free(&buf);
+    wtap_close(wth);
+
+    for (guint i = 0; i < COMMENTED_PACKETS; i++) {
+        check_comment(kept[i], i);
+        wtap_block_unref(kept[i]);
+    }
+    g_unlink(path);
+    g_rmdir(dir);
+    g_free(path);
+    g_free(dir);
+}
+
+#ifndef _WIN32
+/*
+ * Random-access reads of an uncompressed file go through a memory
+ * mapping of it (not on Windows).
+ */
+#define MAPPED_PACKETS      3
+#define MAPPED_PACKET_LEN   8000
+
+typedef struct {
+    char *dir;
+    char *path;
+    wtap *wth;
+    gint64 offsets[MAPPED_PACKETS];
+    wtap_rec rec;
+    Buffer buf;
+} mapped_file_t;
+
+/* Write a pcap file whose packets are each filled with their number. */
+static void
+mapped_file_open(mapped_file_t *mf)
+{
+    static const guint8 file_header[24] = {
+        0xd4, 0xc3, 0xb2, 0xa1, 2, 0, 4, 0,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0xff, 0xff, 0, 0, 1, 0, 0, 0
+    };
+    GByteArray *contents = g_byte_array_new();
+    guint8 packet[MAPPED_PACKET_LEN];
+    guint32 header[4];
+    gint64 data_offset;
+    int err;
+    gchar *err_info;
+
+    g_byte_array_append(contents, file_header, sizeof file_header);
+    for (guint i = 0; i < MAPPED_PACKETS; i++) {
+        header[0] = GUINT32_TO_LE(i);
+        header[1] = 0;
+        header[2] = header[3] = GUINT32_TO_LE(MAPPED_PACKET_LEN);
+        memset(packet, i + 1, sizeof packet);
+        g_byte_array_append(contents, (const guint8 *)header, sizeof header);
+        g_byte_array_append(contents, packet, sizeof packet);
+    }
+    mf->dir = g_dir_make_tmp("test_wiretap.XXXXXX", NULL);
+    g_assert_nonnull(mf->dir);
+    mf->path = g_build_filename(mf->dir, "mapped.pcap", NULL);
+    g_assert_true(g_file_set_contents(mf->path, (const gchar *)contents->data, contents->len, NULL));
+    g_byte_array_free(contents, TRUE);
+
+    mf->wth = wtap_open_offline(mf->path, WTAP_TYPE_AUTO, &err, &err_info, TRUE);
+    g_assert_nonnull(mf->wth);
+    wtap_rec_init(&mf->rec);
+    ws_buffer_init(&mf->buf, 1514);
+    for (guint i = 0; i < MAPPED_PACKETS; i++) {
+        g_assert_true(wtap_read(mf->wth, &mf->rec, &mf->buf, &err, &err_info, &data_offset));
+        mf->offsets[i] = data_offset;
+    }
+}
+
+static void
+mapped_file_close(mapped_file_t *mf)
+{
+    wtap_close(mf->wth);
+    wtap_rec_cleanup(&mf->rec);
+    ws_buffer_free(&mf->buf);
+    g_unlink(mf->path);
+    g_rmdir(mf->dir);
+    g_free(mf->path);
+    g_free(mf->dir);
+}
+
+static const guint8 *
+mapped_file_read(mapped_file_t *mf, guint i)
+{
+    const guint8 *data;
+    int err;
+    gchar *err_info = NULL;
+
+    if (!wtap_seek_read_ptr(mf->wth, mf->offsets[i], &mf->rec, &mf->buf, &data, &err, &err_info)) {
+        g_free(err_info);
+        return NULL;
+    }
+    g_assert_cmpuint(mf->rec.rec_header.packet_header.caplen, ==, MAPPED_PACKET_LEN);
+    g_assert_cmpuint(data[0], ==, i + 1);
+    g_assert_cmpuint(data[MAPPED_PACKET_LEN - 1], ==, i + 1);
+    return data;
+}
+
+static void
+test_file_mapped_read(void)
+{
+    mapped_file_t mf;
+    const guint8 *data[MAPPED_PACKETS];
+
+    /* The data is in the mapping, not copied into the buffer, and it
+     * stays put for later reads. */
+    mapped_file_open(&mf);
+    g_assert_true(wtap_is_mapped(mf.wth));
+    for (guint i = 0; i < MAPPED_PACKETS; i++) {
+        data[i] = mapped_file_read(&mf, i);
+        g_assert_nonnull(data[i]);
+        g_assert_true(data[i] != ws_buffer_start_ptr(&mf.buf));
+    }
+    g_assert_true(mapped_file_read(&mf, 0) == data[0]);
+    g_assert_cmpuint(data[2][0], ==, 3);
+    mapped_file_close(&mf);
+}
+
+static void
+test_file_mapped_truncated(void)
+{
+    mapped_file_t mf;
+
+    /* Another process truncates the file to its first page. Reading
+     * the packets that were in the pages past it must fail, not raise
+     * SIGBUS. */
+    mapped_file_open(&mf);
+    g_assert_nonnull(mapped_file_read(&mf, 0));
+    g_assert_cmpint(truncate(mf.path, 4096), ==, 0);
+    g_assert_null(mapped_file_read(&mf, 2));
+    g_assert_null(mapped_file_read(&mf, 1));
+    mapped_file_close(&mf);
+}
+
+static void
+test_file_mapped_cleareof(void)
+{
+    mapped_file_t mf;
+    const guint8 *data;
+
+    /* A file that's still being written is read through the buffer. */
+    mapped_file_open(&mf);
+    wtap_cleareof(mf.wth);
+    g_assert_false(wtap_is_mapped(mf.wth));
+    data = mapped_file_read(&mf, 1);
+    g_assert_true(data == ws_buffer_start_ptr(&mf.buf));
+    mapped_file_close(&mf);
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    int ret;
+
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/flow_key/ethernet", test_flow_key_ethernet);
+    g_test_add_func("/flow_key/vlan", test_flow_key_vlan);
+    g_test_add_func("/flow_key/mpls", test_flow_key_mpls);
+    g_test_add_func("/flow_key/pppoe", test_flow_key_pppoe);
+    g_test_add_func("/flow_key/sll", test_flow_key_sll);
+    g_test_add_func("/flow_key/loopback", test_flow_key_loopback);
+    g_test_add_func("/flow_key/raw_ip", test_flow_key_raw_ip);
+    g_test_add_func("/flow_key/ipv6_ext", test_flow_key_ipv6_ext);
+    g_test_add_func("/flow_key/ipv4_fragment", test_flow_key_ipv4_fragment);
+    g_test_add_func("/flow_key/gre", test_flow_key_gre);
+    g_test_add_func("/flow_key/vxlan", test_flow_key_vxlan);
+    g_test_add_func("/flow_key/gtpu", test_flow_key_gtpu);
+    g_test_add_func("/flow_key/ip_in_ip", test_flow_key_ip_in_ip);
+    g_test_add_func("/flow_key/truncated", test_flow_key_truncated);
+    g_test_add_func("/flow_key/hash", test_flow_key_hash);
+
+#ifndef _WIN32
+    g_test_add_func("/file/mapped_read", test_file_mapped_read);
+    g_test_add_func("/file/mapped_truncated", test_file_mapped_truncated);
+    g_test_add_func("/file/mapped_cleareof", test_file_mapped_cleareof);
+#endif
+    g_test_add_func("/pcapng/kept_options", test_pcapng_kept_options);
+
+    wtap_init(FALSE);
+
+    ret = g_test_run();
+
+    wtap_cleanup();
+
+    return ret;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -29,6 +29,9 @@ typedef gboolean (*subtype_read_func)(struct wtap*, wtap_rec *,
                                       Buffer *, int *, char **, gint64 *);
 typedef gboolean (*subtype_seek_read_func)(struct wtap*, gint64, wtap_rec *,
                                            Buffer *, int *, char **);
+typedef gboolean (*subtype_seek_read_ptr_func)(struct wtap*, gint64, wtap_rec *,
+                                               Buffer *, const guint8 **, int *, char **);
+typedef GArray *(*subtype_get_trailing_if_stats_func)(struct wtap*, int *, char **);
 
 /**
  * Struct holding data of the currently read file.
@@ -53,8 +56,11 @@ struct wtap {
 
     subtype_read_func           subtype_read;
     subtype_seek_read_func      subtype_seek_read;
+    subtype_seek_read_ptr_func  subtype_seek_read_ptr;  /**< Optional; NULL if the file type always copies the data */
+    gboolean                    subtype_read_appends;   /**< TRUE if subtype_read appends the data to the buffer rather than overwriting it */
     void                        (*subtype_sequential_close)(struct wtap*);
     void                        (*subtype_close)(struct wtap*);
+    subtype_get_trailing_if_stats_func subtype_get_trailing_if_stats; /**< Optional; NULL if the file type can't do it cheaply */
     int                         file_encap;    /* per-file, for those
                                                 * file formats that have
                                                 * per-file encapsulation
@@ -75,6 +81,8 @@ struct wtap {
     wtap_new_ipv6_callback_t    add_new_ipv6;
     wtap_new_secrets_callback_t add_new_secrets;
     GPtrArray                   *fast_seek;
+    int                         batch_err;              /**< error to report from the next wtap_read_batch() */
+    gchar                       *batch_err_info;
 };
 
 struct wtap_dumper;
@@ -328,6 +336,17 @@ gboolean
 wtap_read_packet_bytes(FILE_T fh, Buffer *buf, guint length, int *err,
     gchar **err_info);
 
+/*
+ * Read packet data as wtap_read_packet_bytes() does, but, if the data
+ * is all in a memory-mapped region of the file, don't copy it into the
+ * buffer.  On success, *data points to the data, either in the mapping
+ * or at the start of the buffer, which must have been empty.
+ */
+WS_DLL_PUBLIC
+gboolean
+wtap_read_packet_bytes_ptr(FILE_T fh, Buffer *buf, guint length,
+    const guint8 **data, int *err, gchar **err_info);
+
 /*
  * Implementation of wth->subtype_read that reads the full file contents
  * as a single packet.
@@ -432,6 +451,31 @@ wtap_block_t wtap_dump_params_generate_idb(const wtap_dump_params *params);
  */
 wtap_block_t wtap_rec_generate_idb(const wtap_rec *rec);
 
+/**
+ * @brief Get the record's options buffer, emptied, to read the options
+ *      of a block into without decoding them.
+ * @details If a block borrowed what was in it before, the loan ends
+ *      first (see wtap_block_end_options_loan()).
+ *
+ * @param rec The record.
+ * @return rec->options_buf.
+ */
+Buffer *wtap_rec_get_options_buf(wtap_rec *rec);
+
+/**
+ * @brief Defer decoding the options of a block of the record, which are
+ *      at the start of the record's options buffer.
+ * @details The block borrows them until the buffer is wanted again or
+ *      the record is cleaned up, which saves allocating memory for them
+ *      for each record.
+ *
+ * @param rec The record.
+ * @param block The block whose options are deferred.
+ * @param decode_options Function that adds the options to the block.
+ */
+void wtap_rec_lend_options_buf(wtap_rec *rec, wtap_block_t block,
+    wtap_block_decode_options_func decode_options);
+
 /**
  * @brief Gets new name resolution info for new file, based on existing info.
  * @details Creates a new wtap_block_t of name resolution info and only
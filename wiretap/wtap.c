@@ -178,6 +178,18 @@ wtap_file_get_idb_info(wtap *wth)
 	return idb_info;
 }
 
+GArray *
+wtap_file_get_trailing_if_stats(wtap *wth, int *err, gchar **err_info)
+{
+	*err = 0;
+	*err_info = NULL;
+
+	if (wth->subtype_get_trailing_if_stats == NULL || wth->ispipe)
+		return NULL;
+
+	return wth->subtype_get_trailing_if_stats(wth, err, err_info);
+}
+
 wtap_block_t
 wtap_get_next_interface_description(wtap *wth)
 {
@@ -1544,6 +1556,7 @@ wtap_close(wtap *wth)
 	wtap_block_array_free(wth->dsbs);
 	wtap_block_array_free(wth->meta_events);
 
+	g_free(wth->batch_err_info);
 	g_free(wth);
 }
 
@@ -1551,6 +1564,10 @@ void
 wtap_cleareof(wtap *wth) {
 	/* Reset EOF */
 	file_clearerr(wth->fh);
+	/* The file is still being written, and its writer could also
+	   truncate it, so don't read it through a mapping. */
+	if (wth->random_fh != NULL)
+		file_unmap(wth->random_fh);
 }
 
 static inline void
@@ -1730,6 +1747,135 @@ wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
 	return TRUE;	/* success */
 }
 
+void
+wtap_batch_init(wtap_batch_t *batch, guint max_count)
+{
+	guint i;
+
+	ws_assert(max_count != 0);
+	batch->count = 0;
+	batch->max_count = max_count;
+	batch->recs = g_new(wtap_rec, max_count);
+	for (i = 0; i < max_count; i++)
+		wtap_rec_init(&batch->recs[i]);
+	batch->offsets = g_new(gint64, max_count);
+	batch->data_offsets = g_new(gsize, max_count + 1);
+	batch->data_offsets[0] = 0;
+	ws_buffer_init(&batch->data, (gsize)max_count * 1514);
+	ws_buffer_init(&batch->scratch, 1514);
+}
+
+static void
+wtap_batch_reset(wtap_batch_t *batch)
+{
+	guint i;
+
+	for (i = 0; i < batch->count; i++)
+		wtap_rec_reset(&batch->recs[i]);
+	batch->count = 0;
+	batch->data_offsets[0] = 0;
+	ws_buffer_clean(&batch->data);
+}
+
+void
+wtap_batch_cleanup(wtap_batch_t *batch)
+{
+	guint i;
+
+	wtap_batch_reset(batch);
+	for (i = 0; i < batch->max_count; i++)
+		wtap_rec_cleanup(&batch->recs[i]);
+	g_free(batch->recs);
+	g_free(batch->offsets);
+	g_free(batch->data_offsets);
+	ws_buffer_free(&batch->data);
+	ws_buffer_free(&batch->scratch);
+}
+
+const guint8 *
+wtap_batch_rec_data(wtap_batch_t *batch, guint i)
+{
+	ws_assert(i < batch->count);
+	return ws_buffer_start_ptr(&batch->data) + batch->data_offsets[i];
+}
+
+gsize
+wtap_batch_rec_data_len(const wtap_batch_t *batch, guint i)
+{
+	ws_assert(i < batch->count);
+	return batch->data_offsets[i + 1] - batch->data_offsets[i];
+}
+
+gboolean
+wtap_read_batch(wtap *wth, wtap_batch_t *batch, int *err, gchar **err_info)
+{
+	wtap_rec *rec;
+
+	wtap_batch_reset(batch);
+
+	/*
+	 * Report an error we got after reading the records we
+	 * returned last time.
+	 */
+	if (wth->batch_err != 0) {
+		*err = wth->batch_err;
+		*err_info = wth->batch_err_info;
+		wth->batch_err = 0;
+		wth->batch_err_info = NULL;
+		return FALSE;
+	}
+
+	while (batch->count < batch->max_count) {
+		rec = &batch->recs[batch->count];
+		if (wth->subtype_read_appends) {
+			/*
+			 * The reader puts the data after what's already
+			 * in the buffer, so it can read straight into
+			 * the batch.
+			 */
+			wtap_init_rec(wth, rec);
+			*err = 0;
+			*err_info = NULL;
+			if (!wth->subtype_read(wth, rec, &batch->data, err,
+			    err_info, &batch->offsets[batch->count])) {
+				if (*err == 0)
+					*err = file_error(wth->fh, err_info);
+				if (rec->block != NULL) {
+					wtap_block_unref(rec->block);
+					rec->block = NULL;
+				}
+				/* Drop any data for the partial record. */
+				ws_buffer_truncate(&batch->data,
+				    batch->data_offsets[batch->count]);
+				break;
+			}
+			if (rec->rec_type == REC_TYPE_PACKET) {
+				ws_assert(rec->rec_header.packet_header.pkt_encap != WTAP_ENCAP_PER_PACKET);
+				ws_assert(rec->rec_header.packet_header.pkt_encap != WTAP_ENCAP_NONE);
+			}
+		} else {
+			if (!wtap_read(wth, rec, &batch->scratch, err, err_info,
+			    &batch->offsets[batch->count]))
+				break;
+			ws_buffer_append_buffer(&batch->data, &batch->scratch);
+		}
+		batch->count++;
+		batch->data_offsets[batch->count] = ws_buffer_length(&batch->data);
+	}
+
+	if (batch->count == 0)
+		return FALSE;	/* EOF or error */
+
+	if (batch->count < batch->max_count && *err != 0) {
+		/* Hand this back next time, after these records. */
+		wth->batch_err = *err;
+		wth->batch_err_info = *err_info;
+	}
+	*err = 0;
+	*err_info = NULL;
+	return TRUE;
+}
+
 /*
  * Read a given number of bytes from a file into a buffer or, if
  * buf is NULL, just discard them.
@@ -1814,6 +1960,20 @@ wtap_read_packet_bytes(FILE_T fh, Buffer *buf, guint length, int *err,
 	return rv;
 }
 
+gboolean
+wtap_read_packet_bytes_ptr(FILE_T fh, Buffer *buf, guint length,
+    const guint8 **data, int *err, gchar **err_info)
+{
+	*data = file_read_mapped(fh, length);
+	if (*data != NULL)
+		return TRUE;
+
+	if (!wtap_read_packet_bytes(fh, buf, length, err, err_info))
+		return FALSE;
+	*data = ws_buffer_start_ptr(buf);
+	return TRUE;
+}
+
 /*
  * Return an approximation of the amount of data we've read sequentially
  * from the file so far.  (gint64, in case that's 64 bits.)
@@ -1845,11 +2005,39 @@ wtap_rec_reset(wtap_rec *rec)
 	rec->block_was_modified = FALSE;
 }
 
+static void
+wtap_rec_end_options_loan(wtap_rec *rec)
+{
+	if (rec->options_buf_block != NULL) {
+		wtap_block_end_options_loan(rec->options_buf_block);
+		rec->options_buf_block = NULL;
+	}
+}
+
+Buffer *
+wtap_rec_get_options_buf(wtap_rec *rec)
+{
+	wtap_rec_end_options_loan(rec);
+	ws_buffer_clean(&rec->options_buf);
+	return &rec->options_buf;
+}
+
+void
+wtap_rec_lend_options_buf(wtap_rec *rec, wtap_block_t block,
+    wtap_block_decode_options_func decode_options)
+{
+	ws_assert(rec->options_buf_block == NULL);
+	wtap_block_set_borrowed_options(block, decode_options,
+	    ws_buffer_start_ptr(&rec->options_buf));
+	rec->options_buf_block = wtap_block_ref(block);
+}
+
 /* clean up record metadata */
 void
 wtap_rec_cleanup(wtap_rec *rec)
 {
 	wtap_rec_reset(rec);
+	wtap_rec_end_options_loan(rec);
 	ws_buffer_free(&rec->options_buf);
 }
 
@@ -1867,10 +2055,12 @@ wtap_rec_generate_idb(const wtap_rec *rec)
 	return wtap_generate_idb(rec->rec_header.packet_header.pkt_encap, tsprec, 0);
 }
 
-gboolean
-wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
-    int *err, gchar **err_info)
+static gboolean
+wtap_seek_read_internal(wtap *wth, gint64 seek_off, wtap_rec *rec,
+    Buffer *buf, const guint8 **data, int *err, gchar **err_info)
 {
+	gboolean ok;
+
 	/*
 	 * Initialize the record to default values.
 	 */
@@ -1879,7 +2069,19 @@ wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
 
 	*err = 0;
 	*err_info = NULL;
-	if (!wth->subtype_seek_read(wth, seek_off, rec, buf, err, err_info)) {
+	/*
+	 * Readers only set *data for records whose data they can
+	 * leave in place; for other records, the data is in the buffer.
+	 */
+	if (data != NULL)
+		*data = NULL;
+	if (data != NULL && wth->subtype_seek_read_ptr != NULL) {
+		ok = wth->subtype_seek_read_ptr(wth, seek_off, rec, buf, data,
+		    err, err_info);
+	} else
+		ok = wth->subtype_seek_read(wth, seek_off, rec, buf, err,
+		    err_info);
+	if (!ok) {
 		if (rec->block != NULL) {
 			/*
 			 * Unreference any block created for this record.
@@ -1889,6 +2091,8 @@ wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
 		}
 		return FALSE;
 	}
+	if (data != NULL && *data == NULL)
+		*data = ws_buffer_start_ptr(buf);
 
 	/*
 	 * Is this a packet record?
@@ -1907,6 +2111,28 @@ wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
 	return TRUE;
 }
 
+gboolean
+wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
+    int *err, gchar **err_info)
+{
+	return wtap_seek_read_internal(wth, seek_off, rec, buf, NULL, err,
+	    err_info);
+}
+
+gboolean
+wtap_seek_read_ptr(wtap *wth, gint64 seek_off, wtap_rec *rec, Buffer *buf,
+    const guint8 **data, int *err, gchar **err_info)
+{
+	return wtap_seek_read_internal(wth, seek_off, rec, buf, data, err,
+	    err_info);
+}
+
+gboolean
+wtap_is_mapped(wtap *wth)
+{
+	return wth->random_fh != NULL && file_is_mapped(wth->random_fh);
+}
+
 static gboolean
 wtap_full_file_read_file(wtap *wth, FILE_T fh, wtap_rec *rec, Buffer *buf, int *err, gchar **err_info)
 {
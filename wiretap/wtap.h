@@ -1414,6 +1414,7 @@ typedef struct wtap_rec {
      * a buffer for the options for each record.
      */
     Buffer    options_buf;       /* file-type specific data */
+    wtap_block_t options_buf_block; /* block whose undecoded options are in options_buf, if any */
 } wtap_rec;
 
 /*
@@ -1864,6 +1865,57 @@ WS_DLL_PUBLIC
 gboolean wtap_read(wtap *wth, wtap_rec *rec, Buffer *buf, int *err,
     gchar **err_info, gint64 *offset);
 
+/**
+ * A batch of records read by wtap_read_batch(), with the data for all
+ * of them stored back to back in one buffer.
+ */
+typedef struct wtap_batch {
+    guint     count;          /**< number of records in the batch */
+    guint     max_count;      /**< number of records the batch can hold */
+    wtap_rec *recs;           /**< the records */
+    gint64   *offsets;        /**< offset of each record, for wtap_seek_read() */
+    gsize    *data_offsets;   /**< offset of each record's data in data; count + 1 entries */
+    Buffer    data;           /**< data for all the records */
+    Buffer    scratch;        /**< for file types that can't read straight into data */
+} wtap_batch_t;
+
+/** Initialize a batch to hold up to max_count records. */
+WS_DLL_PUBLIC
+void wtap_batch_init(wtap_batch_t *batch, guint max_count);
+
+/** Free what wtap_batch_init() allocated, and any records in the batch. */
+WS_DLL_PUBLIC
+void wtap_batch_cleanup(wtap_batch_t *batch);
+
+/** Get a pointer to the data for the record with index i in a batch. */
+WS_DLL_PUBLIC
+const guint8 *wtap_batch_rec_data(wtap_batch_t *batch, guint i);
+
+/** Get the length of the data for the record with index i in a batch. */
+WS_DLL_PUBLIC
+gsize wtap_batch_rec_data_len(const wtap_batch_t *batch, guint i);
+
+/** Read the next records in the file, up to the size of the batch,
+ * replacing what was in the batch.  This is equivalent to calling
+ * wtap_read() for each record, but, for some file types, the data
+ * is read straight into the batch's buffer.
+ *
+ * If an error occurs after some records have been read, those records
+ * are returned, and the error is reported by the next call.
+ *
+ * @wth a wtap * returned by a call that opened a file for reading.
+ * @batch a batch initialized by wtap_batch_init().
+ * @param err a positive "errno" value, or a negative number indicating
+ * the type of error, if the read failed.
+ * @param err_info for some errors, a string giving more details of
+ * the error
+ * @return TRUE if at least one record was read, FALSE on an EOF or
+ * failure (with *err set to 0 on an EOF).
+ */
+WS_DLL_PUBLIC
+gboolean wtap_read_batch(wtap *wth, wtap_batch_t *batch, int *err,
+    gchar **err_info);
+
 /** Read the record at a specified offset in a capture file, filling in
  * *phdr and *buf.
  *
@@ -1884,6 +1936,47 @@ WS_DLL_PUBLIC
 gboolean wtap_seek_read(wtap *wth, gint64 seek_off, wtap_rec *rec,
     Buffer *buf, int *err, gchar **err_info);
 
+/** Read the record at a specified offset in a capture file, as
+ * wtap_seek_read() does, but, if the file is memory-mapped and the
+ * record's data can be used as it is in the file, don't copy the data
+ * into *buf.
+ *
+ * @wth a wtap * returned by a call that opened a file for random-access
+ * reading.
+ * @seek_off a gint64 giving an offset value returned by a previous
+ * wtap_read() call.
+ * @rec a pointer to a struct wtap_rec, filled in with information
+ * about the record.
+ * @buf a pointer to a Buffer, filled in with data from the record if
+ * it has to be copied.
+ * @data set to point to the record's data, either in the mapping of the
+ * file, where it remains valid until the file is closed, or in *buf.
+ * If another process truncates the file, data in the mapping that is
+ * past the new end of the file can't be touched without a SIGBUS;
+ * later reads notice the truncation, but pointers already handed out
+ * don't.
+ * @param err a positive "errno" value, or a negative number indicating
+ * the type of error, if the read failed.
+ * @param err_info for some errors, a string giving more details of
+ * the error
+ * @return TRUE on success, FALSE on failure.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_seek_read_ptr(wtap *wth, gint64 seek_off, wtap_rec *rec,
+    Buffer *buf, const guint8 **data, int *err, gchar **err_info);
+
+/** Are random-access reads of a capture file made from a memory mapping
+ * of it?  If so, wtap_seek_read_ptr() hands out the data of records
+ * without copying it and without a system call.  This can change from
+ * TRUE to FALSE, e.g. after wtap_cleareof().
+ *
+ * @wth a wtap * returned by a call that opened a file for random-access
+ * reading.
+ * @return TRUE if the file is memory-mapped.
+ */
+WS_DLL_PUBLIC
+gboolean wtap_is_mapped(wtap *wth);
+
 /*** initialize a wtap_rec structure ***/
 WS_DLL_PUBLIC
 void wtap_rec_init(wtap_rec *rec);
@@ -1983,6 +2076,27 @@ void wtap_write_shb_comment(wtap *wth, gchar *comment);
 WS_DLL_PUBLIC
 wtapng_iface_descriptions_t *wtap_file_get_idb_info(wtap *wth);
 
+/**
+ * @brief Gets the interface statistics recorded at the end of the file.
+ * @details For file types that record per-interface statistics in
+ *          trailer blocks (e.g. pcapng Interface Statistics Blocks)
+ *          and that can locate them without reading every record,
+ *          this returns those statistics without changing the
+ *          current read position.  This lets tools such as capinfos
+ *          report counts and times without a full scan of the file.
+ *
+ * @param wth The wiretap session.
+ * @param[out] err Set to a WTAP_ERR_ code if an error occurred.
+ * @param[out] err_info Set to a string giving further details of the error.
+ * @return A new array of WTAP_BLOCK_IF_STATISTICS blocks, in file order,
+ *         which must be freed with wtap_block_array_free(), or NULL if the
+ *         file type doesn't support this, the statistics couldn't be
+ *         located cheaply, or an error occurred (in which case *err is
+ *         non-zero).
+ */
+WS_DLL_PUBLIC
+GArray *wtap_file_get_trailing_if_stats(wtap *wth, int *err, gchar **err_info);
+
 /**
  * @brief Gets next interface description.
  *
@@ -86,6 +86,10 @@ struct wtap_block
     wtap_blocktype_t* info;
     void* mandatory_data;
     GArray* options;
+    /* Options not decoded yet; see wtap_block_set_deferred_options() */
+    wtap_block_decode_options_func decode_options;
+    void* raw_options;
+    gboolean raw_options_borrowed; /* raw_options isn't ours to free */
     gint ref_count;
 #ifdef DEBUG_COUNT_REFS
     guint id;
@@ -287,6 +291,62 @@ void* wtap_block_get_mandatory_data(wtap_block_t block)
     return block->mandatory_data;
 }
 
+void wtap_block_set_deferred_options(wtap_block_t block,
+        wtap_block_decode_options_func decode_options, void* raw_options)
+{
+    ws_assert(block->decode_options == NULL);
+    block->decode_options = decode_options;
+    block->raw_options = raw_options;
+    block->raw_options_borrowed = FALSE;
+}
+
+void wtap_block_set_borrowed_options(wtap_block_t block,
+        wtap_block_decode_options_func decode_options, void* raw_options)
+{
+    ws_assert(block->decode_options == NULL);
+    block->decode_options = decode_options;
+    block->raw_options = raw_options;
+    block->raw_options_borrowed = TRUE;
+}
+
+/*
+ * Decode the options the reader handed us in raw form, if it hasn't been
+ * done yet.  Everything that looks at or changes block->options calls
+ * this first.
+ */
+static inline void wtap_block_decode_deferred_options(wtap_block_t block)
+{
+    wtap_block_decode_options_func decode_options = block->decode_options;
+    void* raw_options;
+
+    if (G_LIKELY(decode_options == NULL))
+        return;
+
+    /* The decoder adds the options, so clear this first. */
+    raw_options = block->raw_options;
+    block->decode_options = NULL;
+    block->raw_options = NULL;
+    decode_options(block, raw_options);
+    if (!block->raw_options_borrowed)
+        g_free(raw_options);
+    block->raw_options_borrowed = FALSE;
+}
+
+void wtap_block_end_options_loan(wtap_block_t block)
+{
+    if (block->decode_options != NULL && block->raw_options_borrowed) {
+        if (g_atomic_int_get(&block->ref_count) == 1) {
+            /* Only the lender holds the block; nobody will look. */
+            block->decode_options = NULL;
+            block->raw_options = NULL;
+            block->raw_options_borrowed = FALSE;
+        } else {
+            wtap_block_decode_deferred_options(block);
+        }
+    }
+    wtap_block_unref(block);
+}
+
 static wtap_optval_t *
 wtap_block_get_option(wtap_block_t block, guint option_id)
 {
@@ -297,6 +357,7 @@ wtap_block_get_option(wtap_block_t block, guint option_id)
         return NULL;
     }
 
+    wtap_block_decode_deferred_options(block);
     for (i = 0; i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
         if (opt->option_id == option_id)
@@ -317,6 +378,7 @@ wtap_block_get_nth_option(wtap_block_t block, guint option_id, guint idx)
         return NULL;
     }
 
+    wtap_block_decode_deferred_options(block);
     opt_idx = 0;
     for (i = 0; i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
@@ -340,6 +402,9 @@ wtap_block_t wtap_block_create(wtap_block_type_t block_type)
     block = g_new(struct wtap_block, 1);
     block->info = blocktype_list[block_type];
     block->options = g_array_new(FALSE, FALSE, sizeof(wtap_option_t));
+    block->decode_options = NULL;
+    block->raw_options = NULL;
+    block->raw_options_borrowed = FALSE;
     block->info->create(block);
     block->ref_count = 1;
 #ifdef DEBUG_COUNT_REFS
@@ -440,6 +505,8 @@ void wtap_block_unref(wtap_block_t block)
                 block->info->free_mand(block);
 
             g_free(block->mandatory_data);
+            if (!block->raw_options_borrowed)
+                g_free(block->raw_options);
             wtap_block_free_options(block);
             g_array_free(block->options, TRUE);
             g_free(block);
@@ -484,6 +551,7 @@ wtap_block_copy(wtap_block_t dest_block, wtap_block_t src_block)
     /* Copy the options.  For now, don't remove any options that are in destination
      * but not source.
      */
+    wtap_block_decode_deferred_options(src_block);
     for (i = 0; i < src_block->options->len; i++)
     {
         src_opt = &g_array_index(src_block->options, wtap_option_t, i);
@@ -565,6 +633,7 @@ wtap_block_count_option(wtap_block_t block, guint option_id)
         return 0;
     }
 
+    wtap_block_decode_deferred_options(block);
     for (i = 0; i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
         if (opt->option_id == option_id)
@@ -585,6 +654,7 @@ gboolean wtap_block_foreach_option(wtap_block_t block, wtap_block_foreach_func f
         return TRUE;
     }
 
+    wtap_block_decode_deferred_options(block);
     for (i = 0; i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
         opttype = GET_OPTION_TYPE(block->info->options, opt->option_id);
@@ -605,6 +675,9 @@ wtap_block_add_option_common(wtap_block_t block, guint option_id, wtap_opttype_e
         return WTAP_OPTTYPE_BAD_BLOCK;
     }
 
+    /* Keep the options in the order they were added. */
+    wtap_block_decode_deferred_options(block);
+
     opttype = GET_OPTION_TYPE(block->info->options, option_id);
     if (opttype == NULL) {
         /* There's no option for this block with that option ID */
@@ -1225,6 +1298,7 @@ wtap_block_get_nflx_custom_option(wtap_block_t block, guint32 nflx_type, char *n
         return WTAP_OPTTYPE_TYPE_MISMATCH;
     }
 
+    wtap_block_decode_deferred_options(block);
     for (i = 0; i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
         if ((opt->option_id == OPT_CUSTOM_BIN_COPY) &&
@@ -1517,6 +1591,7 @@ wtap_block_remove_option(wtap_block_t block, guint option_id)
         return WTAP_OPTTYPE_NUMBER_MISMATCH;
     }
 
+    wtap_block_decode_deferred_options(block);
     for (i = 0; i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
         if (opt->option_id == option_id) {
@@ -1561,6 +1636,7 @@ wtap_block_remove_nth_option_instance(wtap_block_t block, guint option_id,
         return WTAP_OPTTYPE_NUMBER_MISMATCH;
     }
 
+    wtap_block_decode_deferred_options(block);
     opt_idx = 0;
     for (i = 0; i < block->options->len; i++) {
         opt = &g_array_index(block->options, wtap_option_t, i);
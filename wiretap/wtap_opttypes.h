@@ -551,6 +551,7 @@ struct nflx_tcpinfo {
 typedef void (*wtap_block_create_func)(wtap_block_t block);
 typedef void (*wtap_mand_free_func)(wtap_block_t block);
 typedef void (*wtap_mand_copy_func)(wtap_block_t dest_block, wtap_block_t src_block);
+typedef void (*wtap_block_decode_options_func)(wtap_block_t block, void* raw_options);
 
 /** Initialize block types.
  *
@@ -617,6 +618,46 @@ wtap_block_get_type(wtap_block_t block);
 WS_DLL_PUBLIC void*
 wtap_block_get_mandatory_data(wtap_block_t block);
 
+/** Defer decoding of a block's options
+ *
+ * Lets a file reader hand over a block's options in the form they have
+ * in the file, and decode them only if somebody asks for them.  The
+ * first call that looks at, adds or removes an option of the block calls
+ * decode_options, which adds the options to the block; raw_options is
+ * then freed with g_free(), as it is if the block is freed first.
+ *
+ * @param[in] block Block whose options are deferred
+ * @param[in] decode_options Function that adds the options to the block
+ * @param[in] raw_options Data for decode_options, allocated with g_malloc()
+ */
+WS_DLL_PUBLIC void
+wtap_block_set_deferred_options(wtap_block_t block,
+        wtap_block_decode_options_func decode_options, void* raw_options);
+
+/** Defer decoding of a block's options, which are in somebody else's memory
+ *
+ * As wtap_block_set_deferred_options(), but raw_options isn't freed;
+ * whoever lent it holds a reference to the block, and calls
+ * wtap_block_end_options_loan() before raw_options is overwritten or freed.
+ *
+ * @param[in] block Block whose options are deferred
+ * @param[in] decode_options Function that adds the options to the block
+ * @param[in] raw_options Data for decode_options
+ */
+WS_DLL_PUBLIC void
+wtap_block_set_borrowed_options(wtap_block_t block,
+        wtap_block_decode_options_func decode_options, void* raw_options);
+
+/** Take back options lent with wtap_block_set_borrowed_options()
+ *
+ * If anybody else holds the block, its options are decoded now, while
+ * the lent data is still there.  Then the lender's reference is dropped.
+ *
+ * @param[in] block Block whose options were lent
+ */
+WS_DLL_PUBLIC void
+wtap_block_end_options_loan(wtap_block_t block);
+
 /** Count the number of times the given option appears in the block
  *
  * @param[in] block Block to which to add the option
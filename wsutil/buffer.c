@@ -127,6 +127,25 @@ ws_buffer_remove_start(Buffer* buffer, size_t bytes)
 	}
 }
 
+/* Drop the data past the first "length" bytes. */
+void
+ws_buffer_truncate(Buffer* buffer, size_t length)
+{
+	ws_assert(buffer);
+	if (length > buffer->first_free - buffer->start) {
+		ws_error("ws_buffer_truncate trying to truncate to %" PRIu64 " bytes. s=%" PRIu64 " ff=%" PRIu64 "!\n",
+			(uint64_t)length, (uint64_t)buffer->start,
+			(uint64_t)buffer->first_free);
+		/** ws_error() does an abort() and thus never returns **/
+	}
+	buffer->first_free = buffer->start + length;
+
+	if (buffer->start == buffer->first_free) {
+		buffer->start = 0;
+		buffer->first_free = 0;
+	}
+}
+
 
 #ifndef SOME_FUNCTIONS_ARE_DEFINES
 void
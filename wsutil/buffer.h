@@ -37,6 +37,8 @@ void ws_buffer_append(Buffer* buffer, uint8_t *from, size_t bytes);
 WS_DLL_PUBLIC
 void ws_buffer_remove_start(Buffer* buffer, size_t bytes);
 WS_DLL_PUBLIC
+void ws_buffer_truncate(Buffer* buffer, size_t length);
+WS_DLL_PUBLIC
 void ws_buffer_cleanup(void);
 
 #ifdef SOME_FUNCTIONS_ARE_DEFINES
@@ -0,0 +1,241 @@
+/*
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "config.h"
+#include "multisearch.h"
+
+#include <wsutil/ws_assert.h>
+#include <wsutil/wmem/wmem_strutl.h>
+
+/*
+ * An Aho-Corasick automaton over bytes. The trie of the patterns is
+ * turned into a DFA by resolving the failure links at compile time, so
+ * the search does one table lookup per byte of the haystack and never
+ * backtracks.
+ *
+ * To keep the table small, bytes that don't occur in any pattern share
+ * one equivalence class (they always lead back to the root), and the
+ * other bytes get a class each. A row of the table has one entry per
+ * class. Entries hold the offset of the target row, with the top bit
+ * set if reaching that state means some pattern has been seen.
+ */
+
+#define ACCEPT_BIT      0x80000000U
+
+struct _ws_multisearch {
+    GPtrArray *patterns;        /* of GBytes */
+    bool compiled;
+    /* The only non-empty pattern, if there is just one. */
+    GBytes *single;
+    uint16_t byte_class[256];  /* up to 256 classes besides class 0 */
+    unsigned num_classes;
+    uint32_t *delta;
+};
+
+
+ws_multisearch_t *
+ws_multisearch_new(void)
+{
+    ws_multisearch_t *ms = g_new0(ws_multisearch_t, 1);
+
+    ms->patterns = g_ptr_array_new_with_free_func((GDestroyNotify)g_bytes_unref);
+    return ms;
+}
+
+
+void
+ws_multisearch_add(ws_multisearch_t *ms, const uint8_t *pattern, size_t length)
+{
+    ws_assert(!ms->compiled);
+    g_ptr_array_add(ms->patterns, g_bytes_new(pattern, length));
+}
+
+
+/* Searches for each pattern in turn. Used if the automaton would be
+ * too big to build. */
+static bool
+find_each(const ws_multisearch_t *ms, const uint8_t *haystack, size_t length)
+{
+    const void *data;
+    size_t size;
+
+    for (unsigned i = 0; i < ms->patterns->len; i++) {
+        data = g_bytes_get_data(g_ptr_array_index(ms->patterns, i), &size);
+        if (size > 0 && ws_memmem(haystack, length, data, size) != NULL)
+            return true;
+    }
+    return false;
+}
+
+
+void
+ws_multisearch_compile(ws_multisearch_t *ms)
+{
+    GArray *delta;
+    GArray *fail;
+    GQueue queue = G_QUEUE_INIT;
+    const uint8_t *data;
+    size_t size, total = 0;
+    unsigned nonempty = 0;
+    unsigned nc, row, next, fail_row;
+
+    ws_assert(!ms->compiled);
+    ms->compiled = true;
+
+    /* Assign the byte classes. Class 0 is for the unused bytes. */
+    nc = 1;
+    for (unsigned i = 0; i < ms->patterns->len; i++) {
+        data = g_bytes_get_data(g_ptr_array_index(ms->patterns, i), &size);
+        for (size_t j = 0; j < size; j++) {
+            if (ms->byte_class[data[j]] == 0)
+                ms->byte_class[data[j]] = nc++;
+        }
+        if (size > 0) {
+            nonempty++;
+            ms->single = g_ptr_array_index(ms->patterns, i);
+        }
+        total += size;
+    }
+    ms->num_classes = nc;
+
+    if (nonempty != 1)
+        ms->single = NULL;
+    if (nonempty <= 1)
+        return;
+
+    /* There are at most total + 1 states. Give up on the automaton if
+     * the offsets wouldn't fit. */
+    if (total >= (ACCEPT_BIT - 1) / nc)
+        return;
+
+    /* Build the trie. 0 is the root, which is never the target of a
+     * trie edge, so 0 also means no edge. */
+    delta = g_array_new(false, true, sizeof(uint32_t));
+    g_array_set_size(delta, nc);
+    for (unsigned i = 0; i < ms->patterns->len; i++) {
+        data = g_bytes_get_data(g_ptr_array_index(ms->patterns, i), &size);
+        if (size == 0)
+            continue;
+        row = 0;
+        for (size_t j = 0; j < size; j++) {
+            uint32_t *entry = &g_array_index(delta, uint32_t, row + ms->byte_class[data[j]]);
+            next = *entry & ~ACCEPT_BIT;
+            if (next == 0) {
+                next = delta->len;
+                *entry = next;
+                g_array_set_size(delta, delta->len + nc);
+            }
+            if (j == size - 1) {
+                /* Reaching this state from anywhere is a match. */
+                g_array_index(delta, uint32_t, row + ms->byte_class[data[j]]) |= ACCEPT_BIT;
+            }
+            row = next;
+        }
+    }
+
+    /* Resolve the failure links breadth first, filling in the missing
+     * transitions of each state from its failure state, whose row is
+     * already complete since it is closer to the root. fail[] holds
+     * the row of each state's failure state. A state accepts if its
+     * failure state does. */
+    fail = g_array_new(false, true, sizeof(uint32_t));
+    g_array_set_size(fail, delta->len / nc);
+    for (unsigned c = 0; c < nc; c++) {
+        next = g_array_index(delta, uint32_t, c) & ~ACCEPT_BIT;
+        if (next != 0)
+            g_queue_push_tail(&queue, GUINT_TO_POINTER(next));
+    }
+    while (!g_queue_is_empty(&queue)) {
+        row = GPOINTER_TO_UINT(g_queue_pop_head(&queue));
+        fail_row = g_array_index(fail, uint32_t, row / nc);
+        for (unsigned c = 0; c < nc; c++) {
+            uint32_t *entry = &g_array_index(delta, uint32_t, row + c);
+            uint32_t fallback = g_array_index(delta, uint32_t, fail_row + c);
+
+            next = *entry & ~ACCEPT_BIT;
+            if (next != 0) {
+                g_array_index(fail, uint32_t, next / nc) = fallback & ~ACCEPT_BIT;
+                *entry |= fallback & ACCEPT_BIT;
+                g_queue_push_tail(&queue, GUINT_TO_POINTER(next));
+            }
+            else {
+                *entry = fallback;
+            }
+        }
+    }
+    g_array_free(fail, true);
+
+    ms->delta = (uint32_t *)(void *)g_array_free(delta, false);
+}
+
+
+bool
+ws_multisearch_find(const ws_multisearch_t *ms,
+                        const uint8_t *haystack, size_t length)
+{
+    const uint32_t *delta = ms->delta;
+    const uint16_t *byte_class = ms->byte_class;
+    uint32_t row = 0;
+
+    ws_assert(ms->compiled);
+
+    if (delta == NULL) {
+        if (ms->single != NULL) {
+            const void *data;
+            size_t size;
+
+            data = g_bytes_get_data(ms->single, &size);
+            return ws_memmem(haystack, length, data, size) != NULL;
+        }
+        return find_each(ms, haystack, length);
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        row = delta[row + byte_class[haystack[i]]];
+        if (row & ACCEPT_BIT)
+            return true;
+    }
+    return false;
+}
+
+
+unsigned
+ws_multisearch_count(const ws_multisearch_t *ms)
+{
+    return ms->patterns->len;
+}
+
+
+const uint8_t *
+ws_multisearch_pattern(const ws_multisearch_t *ms, unsigned idx, size_t *length)
+{
+    ws_assert(idx < ms->patterns->len);
+    return g_bytes_get_data(g_ptr_array_index(ms->patterns, idx), length);
+}
+
+
+void
+ws_multisearch_free(ws_multisearch_t *ms)
+{
+    g_ptr_array_free(ms->patterns, true);
+    g_free(ms->delta);
+    g_free(ms);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,59 @@
+/** @file
+ *
+ * Search for any of a set of byte strings in a single pass.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __WSUTIL_MULTISEARCH_H__
+#define __WSUTIL_MULTISEARCH_H__
+
+#include <wireshark.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct _ws_multisearch;
+typedef struct _ws_multisearch ws_multisearch_t;
+
+/** Creates an empty pattern set. Add the patterns with
+ * ws_multisearch_add() and then call ws_multisearch_compile()
+ * before searching. */
+WS_DLL_PUBLIC ws_multisearch_t *
+ws_multisearch_new(void);
+
+/** Adds a pattern. An empty pattern never matches. */
+WS_DLL_PUBLIC void
+ws_multisearch_add(ws_multisearch_t *ms, const uint8_t *pattern, size_t length);
+
+/** Builds the automaton. No patterns may be added afterwards. */
+WS_DLL_PUBLIC void
+ws_multisearch_compile(ws_multisearch_t *ms);
+
+/** Returns true if the haystack contains any of the patterns.
+ * A compiled pattern set can be searched from several threads. */
+WS_DLL_PUBLIC bool
+ws_multisearch_find(const ws_multisearch_t *ms,
+                        const uint8_t *haystack, size_t length);
+
+/** Number of patterns added, including empty ones. */
+WS_DLL_PUBLIC unsigned
+ws_multisearch_count(const ws_multisearch_t *ms);
+
+/** Returns the pattern with the given index and sets *length. */
+WS_DLL_PUBLIC const uint8_t *
+ws_multisearch_pattern(const ws_multisearch_t *ms, unsigned idx, size_t *length);
+
+WS_DLL_PUBLIC void
+ws_multisearch_free(ws_multisearch_t *ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WSUTIL_MULTISEARCH_H__ */
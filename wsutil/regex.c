@@ -11,14 +11,39 @@
 #include "regex.h"
 
 #include <wsutil/str_util.h>
+#include <wsutil/wmem/wmem_strutl.h>
 #include <pcre2.h>
 
 
 struct _ws_regex {
     pcre2_code *code;
     char *pattern;
+    /* A literal string every match contains, or NULL. */
+    char *literal;
+    size_t literal_len;
+    /* The pattern matches the literal string and nothing else. */
+    bool literal_only;
 };
 
+/*
+ * We don't use the matched substrings but pcre2_match requires at least
+ * one pair of offsets, so each thread keeps one pcre2_match_data with a
+ * single pair around for all the matches it does.
+ */
+static GPrivate match_data_key = G_PRIVATE_INIT((GDestroyNotify)pcre2_match_data_free);
+
+static pcre2_match_data *
+get_match_data(void)
+{
+    pcre2_match_data *match_data = g_private_get(&match_data_key);
+
+    if (match_data == NULL) {
+        match_data = pcre2_match_data_create(1, NULL);
+        g_private_set(&match_data_key, match_data);
+    }
+    return match_data;
+}
+
 #define ERROR_MAXLEN_IN_CODE_UNITS   128
 
 static char *
@@ -76,10 +101,235 @@ compile_pcre2(const char *patt, ssize_t size, char **errmsg, unsigned flags)
         return NULL;
     }
 
+    /* pcre2_match() uses the JIT code if there is any. If JIT isn't
+     * available, or the pattern can't be JIT compiled, this fails and
+     * we keep using the interpreter. */
+    pcre2_jit_compile(code, PCRE2_JIT_COMPLETE);
+
     return code;
 }
 
 
+/*
+ * Skip a quantifier at patt[*pos], if there is one. Returns false if
+ * there's a brace that isn't a quantifier we understand; otherwise sets
+ * *min to the minimum repeat count (1 if there's no quantifier).
+ */
+static bool
+skip_quantifier(const char *patt, size_t size, size_t *pos, unsigned *min)
+{
+    size_t i = *pos;
+
+    *min = 1;
+    if (i >= size)
+        return true;
+    switch (patt[i]) {
+        case '?':
+        case '*':
+            *min = 0;
+            i++;
+            break;
+        case '+':
+            i++;
+            break;
+        case '{':
+            i++;
+            *min = 0;
+            while (i < size && g_ascii_isdigit(patt[i]))
+                *min = *min * 10 + (patt[i++] - '0');
+            if (i < size && patt[i] == ',') {
+                i++;
+                while (i < size && g_ascii_isdigit(patt[i]))
+                    i++;
+            }
+            if (i >= size || patt[i] != '}' || i == *pos + 1)
+                return false;
+            i++;
+            break;
+        default:
+            return true;
+    }
+    /* Lazy or possessive. */
+    if (i < size && (patt[i] == '?' || patt[i] == '+'))
+        i++;
+    *pos = i;
+    return true;
+}
+
+/* Skip a character class starting at patt[*pos]. */
+static bool
+skip_class(const char *patt, size_t size, size_t *pos)
+{
+    size_t i = *pos + 1;
+
+    if (i < size && patt[i] == '^')
+        i++;
+    /* A ']' first is literal. */
+    if (i < size && patt[i] == ']')
+        i++;
+    while (i < size && patt[i] != ']') {
+        if (patt[i] == '\\')
+            i++;
+        else if (patt[i] == '[' && i + 1 < size && patt[i + 1] == ':') {
+            /* POSIX class such as [:alpha:] */
+            i += 2;
+            while (i + 1 < size && !(patt[i] == ':' && patt[i + 1] == ']'))
+                i++;
+            i++;
+        }
+        i++;
+    }
+    if (i >= size)
+        return false;
+    *pos = i + 1;
+    return true;
+}
+
+/* Skip a group starting at patt[*pos]. */
+static bool
+skip_group(const char *patt, size_t size, size_t *pos)
+{
+    size_t i = *pos + 1;
+    unsigned depth = 1;
+
+    while (i < size) {
+        switch (patt[i]) {
+            case '\\':
+                i += 2;
+                break;
+            case '[':
+                if (!skip_class(patt, size, &i))
+                    return false;
+                break;
+            case '(':
+                depth++;
+                i++;
+                break;
+            case ')':
+                i++;
+                if (--depth == 0) {
+                    *pos = i;
+                    return true;
+                }
+                break;
+            default:
+                i++;
+                break;
+        }
+    }
+    return false;
+}
+
+/*
+ * Find the longest run of literal characters that every match of a
+ * pattern contains, by a simple scan of the pattern, so we can skip
+ * running the regex engine on subjects that don't contain it. We give
+ * up on patterns with alternatives or anything else that makes it hard
+ * to tell: inline options, verbs, \Q...\E quoting or caseless matching.
+ */
+static void
+find_required_literal(ws_regex_t *re, const char *patt, size_t size, unsigned flags)
+{
+    GString *run, *best;
+    size_t i, next;
+    unsigned min;
+    bool literal_only = true;
+    char c;
+
+    if (flags & (WS_REGEX_CASELESS | WS_REGEX_ANCHORED))
+        return;
+    for (i = 0; i + 1 < size; i++) {
+        if ((patt[i] == '(' && (patt[i + 1] == '?' || patt[i + 1] == '*')) ||
+                (patt[i] == '\\' && patt[i + 1] == 'Q')) {
+            /* Either an inline option or verb, or possibly harmless
+             * but not worth telling apart. */
+            return;
+        }
+        if (patt[i] == '\\')
+            i++;
+    }
+
+    run = g_string_new(NULL);
+    best = g_string_new(NULL);
+    i = 0;
+    while (i < size) {
+        c = patt[i];
+        next = i + 1;
+        switch (c) {
+            case '|':
+            case ')':
+                goto give_up;
+
+            case '(':
+                if (!skip_group(patt, size, &next))
+                    goto give_up;
+                c = '\0';
+                break;
+
+            case '[':
+                if (!skip_class(patt, size, &next))
+                    goto give_up;
+                c = '\0';
+                break;
+
+            case '\\':
+                if (next >= size)
+                    goto give_up;
+                c = patt[next++];
+                if (g_ascii_isalnum(c)) {
+                    /* An escape sequence, not a literal. Give up on
+                     * the ones that take arguments (\x41, \cA, \p{L},
+                     * back references and so on). */
+                    if (strchr("dDwWsSbBAzZGhHvVRXKntrfea", c) == NULL)
+                        goto give_up;
+                    c = '\0';
+                }
+                break;
+
+            case '.':
+            case '^':
+            case '$':
+            case '?':
+            case '*':
+            case '+':
+            case '{':
+                c = '\0';
+                break;
+
+            default:
+                break;
+        }
+        if (!skip_quantifier(patt, size, &next, &min))
+            goto give_up;
+
+        if (c != '\0' && min > 0)
+            g_string_append_c(run, c);
+        if (c == '\0' || next != i + 1 + (patt[i] == '\\')) {
+            /* Not a literal, or a quantified one; end of the run. */
+            literal_only = false;
+            if (run->len > best->len)
+                g_string_assign(best, run->str);
+            g_string_truncate(run, 0);
+        }
+        i = next;
+    }
+    if (run->len > best->len)
+        g_string_assign(best, run->str);
+
+    if (best->len > 0) {
+        re->literal_len = best->len;
+        re->literal = g_string_free(best, FALSE);
+        re->literal_only = literal_only;
+        best = NULL;
+    }
+
+give_up:
+    g_string_free(run, TRUE);
+    if (best != NULL)
+        g_string_free(best, TRUE);
+}
+
+
 ws_regex_t *
 ws_regex_compile_ex(const char *patt, ssize_t size, char **errmsg, unsigned flags)
 {
@@ -89,9 +339,10 @@ ws_regex_compile_ex(const char *patt, ssize_t size, char **errmsg, unsigned flag
     if (code == NULL)
         return NULL;
 
-    ws_regex_t *re = g_new(ws_regex_t, 1);
+    ws_regex_t *re = g_new0(ws_regex_t, 1);
     re->code = code;
     re->pattern = ws_escape_string_len(NULL, patt, size, false);
+    find_required_literal(re, patt, size < 0 ? strlen(patt) : (size_t)size, flags);
     return re;
 }
 
@@ -147,22 +398,40 @@ ws_regex_matches(const ws_regex_t *re, const char *subj)
 }
 
 
+/*
+ * Look for the pattern's required literal in the subject, starting at
+ * subj_offset. Returns a pointer to it, or NULL if it isn't there.
+ */
+static const char *
+find_literal(const ws_regex_t *re, const char *subj, ssize_t subj_length,
+                size_t subj_offset)
+{
+    size_t length;
+
+    length = subj_length < 0 ? strlen(subj) : (size_t)subj_length;
+    if (subj_offset > length)
+        return NULL;
+    return (const char *)ws_memmem(subj + subj_offset, length - subj_offset,
+                                    re->literal, re->literal_len);
+}
+
+
 bool
 ws_regex_matches_length(const ws_regex_t *re,
                         const char *subj, ssize_t subj_length)
 {
-    bool matched;
-    pcre2_match_data *match_data;
+    const char *found;
 
     ws_return_val_if(!re, false);
     ws_return_val_if(!subj, false);
 
-    /* We don't use the matched substring but pcre2_match requires
-     * at least one pair of offsets. */
-    match_data = pcre2_match_data_create(1, NULL);
-    matched = match_pcre2(re->code, subj, subj_length, 0, match_data);
-    pcre2_match_data_free(match_data);
-    return matched;
+    if (re->literal != NULL) {
+        found = find_literal(re, subj, subj_length, 0);
+        if (found == NULL || re->literal_only)
+            return found != NULL;
+    }
+
+    return match_pcre2(re->code, subj, subj_length, 0, get_match_data());
 }
 
 
@@ -173,18 +442,31 @@ ws_regex_matches_pos(const ws_regex_t *re,
 {
     bool matched;
     pcre2_match_data *match_data;
+    const char *found;
 
     ws_return_val_if(!re, false);
     ws_return_val_if(!subj, false);
 
-    match_data = pcre2_match_data_create(1, NULL);
+    if (re->literal != NULL) {
+        found = find_literal(re, subj, subj_length, subj_offset);
+        if (found == NULL)
+            return false;
+        if (re->literal_only) {
+            if (pos_vect) {
+                pos_vect[0] = found - subj;
+                pos_vect[1] = pos_vect[0] + re->literal_len;
+            }
+            return true;
+        }
+    }
+
+    match_data = get_match_data();
     matched = match_pcre2(re->code, subj, subj_length, subj_offset, match_data);
     if (matched && pos_vect) {
         PCRE2_SIZE *ovect = pcre2_get_ovector_pointer(match_data);
         pos_vect[0] = ovect[0];
         pos_vect[1] = ovect[1];
     }
-    pcre2_match_data_free(match_data);
     return matched;
 }
 
@@ -194,6 +476,7 @@ ws_regex_free(ws_regex_t *re)
 {
     pcre2_code_free(re->code);
     g_free(re->pattern);
+    g_free(re->literal);
     g_free(re);
 }
 
@@ -827,6 +827,132 @@ static void test_getopt_opterr1(void)
     g_test_trap_assert_stderr("/bin/ls: unrecognized option: z\n");
 }
 
+#include "regex.h"
+
+static void check_regex(const char *patt, unsigned flags, const char *subj,
+                        bool expect_match, size_t expect_start, size_t expect_end)
+{
+    ws_regex_t *re;
+    char *errmsg = NULL;
+    size_t pos[2];
+
+    re = ws_regex_compile_ex(patt, -1, &errmsg, flags);
+    g_assert_null(errmsg);
+    g_assert_nonnull(re);
+    g_assert_true(ws_regex_matches(re, subj) == expect_match);
+    g_assert_true(ws_regex_matches_pos(re, subj, -1, 0, pos) == expect_match);
+    if (expect_match) {
+        g_assert_cmpuint(pos[0], ==, expect_start);
+        g_assert_cmpuint(pos[1], ==, expect_end);
+    }
+    ws_regex_free(re);
+}
+
+static void test_regex_literal(void)
+{
+    /* Nothing but a literal. */
+    check_regex("abc", 0, "xxabcxx", true, 2, 5);
+    check_regex("abc", 0, "xxabxcx", false, 0, 0);
+    check_regex("a\\.b", 0, "a.b", true, 0, 3);
+    check_regex("a\\.b", 0, "axb", false, 0, 0);
+    /* Required literals around other things. */
+    check_regex("^GET /", 0, "GET /index.html", true, 0, 5);
+    check_regex("^GET /", 0, "xGET /", false, 0, 0);
+    check_regex("ab+c", 0, "xabbbc", true, 1, 6);
+    check_regex("ab?c", 0, "xacx", true, 1, 3);
+    check_regex("ab*c", 0, "ac", true, 0, 2);
+    check_regex("ab{0,2}c", 0, "ac", true, 0, 2);
+    check_regex("x(ab)?yz", 0, "xyz", true, 0, 3);
+    check_regex("[abc]+def", 0, "ccdef", true, 0, 5);
+    check_regex("\\d+ms", 0, "took 15ms", true, 5, 9);
+    check_regex("\\x41BC", 0, "ABC", true, 0, 3);
+    /* Patterns we can't take a literal from. */
+    check_regex("abc|def", 0, "xdefx", true, 1, 4);
+    check_regex("(?i)abc", 0, "ABC", true, 0, 3);
+    check_regex("abc", WS_REGEX_CASELESS, "xABC", true, 1, 4);
+    check_regex("\\Qa.b\\E", 0, "a.b", true, 0, 3);
+}
+
+static void test_regex_offset(void)
+{
+    ws_regex_t *re;
+    char *errmsg = NULL;
+    size_t pos[2];
+
+    re = ws_regex_compile("abc", &errmsg);
+    g_assert_nonnull(re);
+    g_assert_true(ws_regex_matches_pos(re, "abcabc", -1, 1, pos));
+    g_assert_cmpuint(pos[0], ==, 3);
+    g_assert_cmpuint(pos[1], ==, 6);
+    g_assert_false(ws_regex_matches_pos(re, "abcabc", -1, 4, pos));
+    g_assert_false(ws_regex_matches_pos(re, "abcabc", 6, 7, pos));
+    g_assert_true(ws_regex_matches_length(re, "ab\0abc", 6));
+    ws_regex_free(re);
+}
+
+#include "multisearch.h"
+
+static bool
+multisearch_find_str(ws_multisearch_t *ms, const char *haystack)
+{
+    return ws_multisearch_find(ms, (const uint8_t *)haystack, strlen(haystack));
+}
+
+static void test_multisearch(void)
+{
+    ws_multisearch_t *ms;
+    const char *patterns[] = { "he", "she", "his", "hers", "" };
+    uint8_t pair[2];
+    uint8_t all_bytes[256];
+
+    ms = ws_multisearch_new();
+    for (size_t i = 0; i < G_N_ELEMENTS(patterns); i++)
+        ws_multisearch_add(ms, (const uint8_t *)patterns[i], strlen(patterns[i]));
+    ws_multisearch_compile(ms);
+    g_assert_cmpuint(ws_multisearch_count(ms), ==, 5);
+
+    g_assert_true(multisearch_find_str(ms, "ushers"));
+    g_assert_true(multisearch_find_str(ms, "xxhis"));
+    g_assert_true(multisearch_find_str(ms, "she"));
+    g_assert_true(multisearch_find_str(ms, "hhe"));
+    g_assert_false(multisearch_find_str(ms, "hxsxe"));
+    g_assert_false(multisearch_find_str(ms, "h"));
+    g_assert_false(multisearch_find_str(ms, ""));
+    g_assert_true(ws_multisearch_find(ms, (const uint8_t *)"\0\0she", 5));
+    ws_multisearch_free(ms);
+
+    /* One pattern. */
+    ms = ws_multisearch_new();
+    ws_multisearch_add(ms, (const uint8_t *)"abc", 3);
+    ws_multisearch_compile(ms);
+    g_assert_true(multisearch_find_str(ms, "xabcx"));
+    g_assert_false(multisearch_find_str(ms, "xabx"));
+    ws_multisearch_free(ms);
+
+    /* Only empty patterns. */
+    ms = ws_multisearch_new();
+    ws_multisearch_add(ms, (const uint8_t *)"", 0);
+    ws_multisearch_compile(ms);
+    g_assert_false(multisearch_find_str(ms, "abc"));
+    ws_multisearch_free(ms);
+
+    /* Every byte value, each doubled, so that every byte needs a class
+     * of its own. */
+    ms = ws_multisearch_new();
+    for (unsigned i = 0; i < 256; i++) {
+        pair[0] = pair[1] = (uint8_t)i;
+        ws_multisearch_add(ms, pair, 2);
+        all_bytes[i] = (uint8_t)i;
+    }
+    ws_multisearch_compile(ms);
+    g_assert_false(ws_multisearch_find(ms, all_bytes, sizeof all_bytes));
+    g_assert_false(ws_multisearch_find(ms, (const uint8_t *)"\x00\xff", 2));
+    g_assert_false(ws_multisearch_find(ms, (const uint8_t *)"\xfe\xff", 2));
+    g_assert_true(ws_multisearch_find(ms, (const uint8_t *)"\x01\xff\xff", 3));
+    g_assert_true(ws_multisearch_find(ms, (const uint8_t *)"\x00\x00", 2));
+    ws_multisearch_free(ms);
+}
+
 int main(int argc, char **argv)
 {
     int ret;
@@ -872,6 +998,11 @@ int main(int argc, char **argv)
 
     g_test_add_func("/nstime/from_iso8601", test_nstime_from_iso8601);
 
+    g_test_add_func("/multisearch/find", test_multisearch);
+
+    g_test_add_func("/regex/literal", test_regex_literal);
+    g_test_add_func("/regex/offset", test_regex_offset);
+
     g_test_add_func("/ws_getopt/basic1", test_getopt_long_basic1);
     g_test_add_func("/ws_getopt/basic2", test_getopt_long_basic2);
     g_test_add_func("/ws_getopt/optional1", test_getopt_optional_argument1);